@@ -1,27 +1,45 @@
-#version 430
-
-// Input attributes
-layout(location = 0) in vec3 iPosition;
-layout(location = 1) in vec3 iColor;
-layout(location = 2) in vec3 iNormal;
-layout(location = 3) in vec2 iTexCoord;
-
-// Uniforms
-layout(location = 0) uniform mat4 uProjCameraWorld;
-layout(location = 1) uniform mat3 uNormalMatrix;
-
-// Output attributes
-out vec3 v2fNormal;
-out vec2 v2fTexCoord;
-out vec3 fragPos;
-
-void main()
-{
-    fragPos = iPosition;
-    // Copy input color to the output color attribute.
-    v2fTexCoord = iTexCoord;
-    v2fNormal = normalize(uNormalMatrix * iNormal);
-
-    // Transform the input position with the uniform matrix
-    gl_Position = uProjCameraWorld * vec4(iPosition, 1.0);
-}
+#version 430
+
+// Input attributes
+layout(location = 0) in vec3 iPosition;
+layout(location = 1) in vec3 iColor;
+layout(location = 2) in vec3 iNormal;
+layout(location = 4) in vec2 iNormalOct; // octahedral, see vmlib/packing.hpp
+layout(location = 3) in vec2 iTexCoord;
+
+// Uniforms: per object, streamed each frame (see main/uniform_blocks.hpp)
+layout(std140, row_major, binding = 0) uniform ObjectBlock
+{
+    mat4 uProjCameraWorld;
+    mat4 uModel;
+    mat3 uNormalMatrix;
+};
+
+// Output attributes
+out vec3 v2fNormal;
+out vec2 v2fTexCoord;
+out vec3 fragPos;
+
+// Inverse of the octahedral mapping (same as oct_decode() in vmlib)
+vec3 oct_decode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return n;
+}
+
+void main()
+{
+    // Meshes with octahedral normals leave location 2 disabled, so iNormal
+    // reads as zero (see create_vao()).
+    vec3 normal = dot(iNormal, iNormal) > 0.0 ? iNormal : oct_decode(iNormalOct);
+
+    fragPos = iPosition;
+    // Copy input color to the output color attribute.
+    v2fTexCoord = iTexCoord;
+    v2fNormal = normalize(uNormalMatrix * normal);
+
+    // Transform the input position with the uniform matrix
+    gl_Position = uProjCameraWorld * vec4(iPosition, 1.0);
+}
@@ -5,22 +5,28 @@ in vec3 v2fColor;
 in vec3 v2fNormal;
 in vec3 fragPos;
 
-// Diffuse and Ambient for uniform light 
-layout(location = 2) uniform vec3 uLightDir;
-layout(location = 3) uniform vec3 uLightDiffuse;
-layout(location = 4) uniform vec3 uSceneAmbient;
+// Directional and point lights, streamed once per frame (see
+// main/uniform_blocks.hpp)
+layout(std140, binding = 1) uniform LightBlock
+{
+    vec3 uLightDir; // should be normalized! ||uLightDir|| = 1
+    vec3 uLightDiffuse;
 
-// Point 1
-layout(location = 5) uniform vec3 pointLightPos1;
-layout(location = 6) uniform vec3 pointLightViewPos1;
+    // Point 1
+    vec3 pointLightPos1;
+    vec3 pointLightViewPos1;
 
-// Point 2
-layout(location = 7) uniform vec3 pointLightPos2;
-layout(location = 8) uniform vec3 pointLightViewPos2;
+    // Point 2
+    vec3 pointLightPos2;
+    vec3 pointLightViewPos2;
 
-// Point 3
-layout(location = 9) uniform vec3 pointLightPos3;
-layout(location = 10) uniform vec3 pointLightViewPos3;
+    // Point 3
+    vec3 pointLightPos3;
+    vec3 pointLightViewPos3;
+};
+
+// Ambient, per program
+layout(location = 4) uniform vec3 uSceneAmbient;
 
 // Fragment shader outputs
 layout(location = 0) out vec3 oColor;
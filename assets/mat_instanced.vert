@@ -0,0 +1,50 @@
+#version 430
+
+// Same as mat.vert, for parts made of instanced unit primitives (see
+// main/primitive_cache.hpp). The part transform, normal matrix and colour
+// are per instance; the uniforms are those of the whole model.
+
+// Input attributes
+layout(location = 0) in vec3 iPosition;
+layout(location = 1) in vec3 iColor; // per instance
+layout(location = 2) in vec3 iNormal;
+
+// Per instance: rows of the part's transform and normal matrix
+layout(location = 5) in vec4 iPartRow0;
+layout(location = 6) in vec4 iPartRow1;
+layout(location = 7) in vec4 iPartRow2;
+layout(location = 8) in vec3 iPartNormalRow0;
+layout(location = 9) in vec3 iPartNormalRow1;
+layout(location = 10) in vec3 iPartNormalRow2;
+
+// Uniforms: per object, streamed each frame (see main/uniform_blocks.hpp)
+layout(std140, row_major, binding = 0) uniform ObjectBlock
+{
+    mat4 uProjCameraWorld;
+    mat4 uModel;
+    mat3 uNormalMatrix;
+};
+
+// Output attributes
+out vec3 v2fColor; // v2f = vertex to fragment
+out vec3 v2fNormal;
+out vec3 fragPos; 
+
+void main()
+{
+    // Part to model. The rows are given, so transpose.
+    vec4 position = vec4(iPosition, 1.0);
+    vec4 partPosition = vec4(
+        dot(iPartRow0, position),
+        dot(iPartRow1, position),
+        dot(iPartRow2, position),
+        1.0
+    );
+    mat3 partNormalMatrix = transpose(mat3(iPartNormalRow0, iPartNormalRow1, iPartNormalRow2));
+
+    fragPos = vec3(uModel * partPosition);
+    v2fColor = iColor;
+    v2fNormal = normalize(uNormalMatrix * (partNormalMatrix * iNormal));
+
+    gl_Position = uProjCameraWorld * partPosition;
+}
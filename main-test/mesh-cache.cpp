@@ -0,0 +1,162 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <fstream>
+#include <filesystem>
+
+#include "../main/loadobj.hpp"
+#include "../main/mesh_cache.hpp"
+
+namespace
+{
+	// A directory of its own below the system's temporary directory,
+	// removed with everything in it.
+	struct ScratchDir_
+	{
+		explicit ScratchDir_( char const* aName )
+			: path( std::filesystem::temp_directory_path() / aName )
+		{
+			std::filesystem::remove_all( path );
+			std::filesystem::create_directories( path );
+		}
+		~ScratchDir_()
+		{
+			std::error_code err;
+			std::filesystem::remove_all( path, err );
+		}
+
+		std::filesystem::path path;
+	};
+
+	void write_file_( std::filesystem::path const& aPath, std::string const& aText )
+	{
+		std::ofstream out( aPath, std::ios::binary | std::ios::trunc );
+		out << aText;
+		REQUIRE( out.good() );
+	}
+
+	std::string material_library_( char const* aAmbient )
+	{
+		return std::string( "newmtl paint\nKa " ) + aAmbient + "\nKd 0.5 0.5 0.5\nKs 0 0 0\nNs 1\n";
+	}
+
+	ProcessedMesh process_( SimpleMeshData&& aMesh )
+	{
+		ProcessedMesh ret;
+		ret.mesh = std::move(aMesh);
+		return ret;
+	}
+
+	char const* const kTriangle_ =
+		"mtllib tri.mtl\n"
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+		"vn 0 0 1\n"
+		"usemtl paint\n"
+		"f 1//1 2//1 3//1\n";
+}
+
+TEST_CASE( "Mesh cache", "[cache]" )
+{
+	ScratchDir_ const dir( "main-test-mesh-cache-obj" );
+	auto const obj = (dir.path / "tri.obj").string();
+
+	write_file_( obj, "v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//1\n" );
+
+	bool hit = true;
+	{
+		CachedMesh const mesh = load_wavefront_obj_cached( obj.c_str(), process_, &hit );
+		REQUIRE( !hit );
+		REQUIRE( mesh.mapped() );
+	}
+
+	SECTION( "Unchanged" )
+	{
+		CachedMesh const mesh = load_wavefront_obj_cached( obj.c_str(), process_, &hit );
+		REQUIRE( hit );
+		REQUIRE( mesh.mapped() );
+	}
+
+	SECTION( "OBJ changed" )
+	{
+		write_file_( obj, "v 0 0 0\nv 2 0 0\nv 0 2 0\nvn 0 0 1\nf 1//1 2//1 3//1\n" );
+
+		load_wavefront_obj_cached( obj.c_str(), process_, &hit );
+		REQUIRE( !hit );
+
+		load_wavefront_obj_cached( obj.c_str(), process_, &hit );
+		REQUIRE( hit );
+	}
+}
+
+TEST_CASE( "Material libraries of OBJ files", "[cache]" )
+{
+	ScratchDir_ const dir( "main-test-mtllib" );
+	auto const obj = dir.path / "a.obj";
+
+	write_file_( obj,
+		"# mtllib commented.mtl\n"
+		"mtllib first.mtl\n"
+		"  mtllib\tsecond name.mtl  \r\n"
+		"v 0 0 0\n"
+		"mtllib first.mtl\n"
+		"usemtl mtllibish\n"
+	);
+
+	auto const names = wavefront_material_libraries( obj.string().c_str() );
+	REQUIRE( 2 == names.size() );
+	REQUIRE( "first.mtl" == names[0] );
+	REQUIRE( "second name.mtl" == names[1] );
+}
+
+TEST_CASE( "Mesh cache dependencies", "[cache]" )
+{
+	ScratchDir_ const dir( "main-test-mesh-cache" );
+	auto const obj = (dir.path / "tri.obj").string();
+	auto const mtl = dir.path / "tri.mtl";
+
+	write_file_( obj, kTriangle_ );
+	write_file_( mtl, material_library_( "0.1 0.2 0.3" ) );
+
+	bool hit = true;
+	{
+		CachedMesh const mesh = load_wavefront_obj_cached( obj.c_str(), process_, &hit );
+		REQUIRE( !hit );
+		REQUIRE( mesh.mapped() );
+		REQUIRE( 1 == mesh.dependencies().size() );
+		REQUIRE( "tri.mtl" == mesh.dependencies()[0].name );
+		REQUIRE( 1 == mesh.materials().size() );
+		REQUIRE( 0.2f == mesh.materials()[0].ambient.y );
+	}
+
+	SECTION( "Unchanged" )
+	{
+		CachedMesh const mesh = load_wavefront_obj_cached( obj.c_str(), process_, &hit );
+		REQUIRE( hit );
+		REQUIRE( 0.2f == mesh.materials()[0].ambient.y );
+	}
+
+	SECTION( "Material library changed" )
+	{
+		// Only the .mtl; the OBJ is as it was
+		write_file_( mtl, material_library_( "0.7 0.8 0.9" ) );
+
+		CachedMesh const mesh = load_wavefront_obj_cached( obj.c_str(), process_, &hit );
+		REQUIRE( !hit );
+		REQUIRE( 0.8f == mesh.materials()[0].ambient.y );
+
+		load_wavefront_obj_cached( obj.c_str(), process_, &hit );
+		REQUIRE( hit );
+	}
+
+	SECTION( "Same size, same time" )
+	{
+		// Only the hash tells the two apart
+		auto const time = std::filesystem::last_write_time( mtl );
+		write_file_( mtl, material_library_( "0.1 0.4 0.3" ) );
+		std::filesystem::last_write_time( mtl, time );
+
+		CachedMesh const mesh = load_wavefront_obj_cached( obj.c_str(), process_, &hit );
+		REQUIRE( !hit );
+		REQUIRE( 0.4f == mesh.materials()[0].ambient.y );
+	}
+}
@@ -0,0 +1,118 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+
+#include "../main/texture_cache.hpp"
+#include "../main/texture_stream.hpp"
+
+namespace
+{
+	// The levels are all zero; only their sizes matter here.
+	CachedTexture texture_( BlockFormat aFormat, std::size_t aWidth, std::size_t aHeight )
+	{
+		BakedTexture baked{ aFormat, aWidth, aHeight, {} };
+
+		std::size_t w = aWidth, h = aHeight;
+		for( std::size_t i = 0; i < mip_level_count( aWidth, aHeight ); ++i )
+		{
+			baked.levels.emplace_back( compressed_size( aFormat, w, h ) );
+			w = mip_extent( w );
+			h = mip_extent( h );
+		}
+
+		return CachedTexture( std::move(baked), CacheSource{} );
+	}
+
+	// Every strip within [0, aEnd), aligned to the block size, after the
+	// previous one
+	void check_frame_( std::vector<TextureStrip> const& aStrips, BlockFormat aFormat, std::size_t aEnd )
+	{
+		std::size_t head = 0;
+		for( auto const& strip : aStrips )
+		{
+			REQUIRE( 0 == strip.offset % block_bytes( aFormat ) );
+			REQUIRE( strip.offset >= head );
+			REQUIRE( strip.offset + strip.size <= aEnd );
+			head = strip.offset + strip.size;
+		}
+	}
+}
+
+TEST_CASE( "Texture streaming plans", "[texture]" )
+{
+	SECTION( "BC1 chain that fills a frame exactly" )
+	{
+		// 8x8: 32 bytes, then 4x4, 2x2 and 1x1 of one 8-byte block each
+		CachedTexture const texture = texture_( BlockFormat::bc1, 8, 8 );
+		REQUIRE( 56 == texture.size() );
+
+		TextureStreamPosition position = texture_stream_start( texture );
+		std::vector<TextureStrip> strips;
+		std::size_t const head = plan_texture_strips( texture, position, 0, texture.size(), strips );
+
+		REQUIRE( position.complete );
+		REQUIRE( 56 == head );
+		REQUIRE( 4 == strips.size() );
+		check_frame_( strips, BlockFormat::bc1, texture.size() );
+
+		// Smallest first, each level complete
+		for( std::size_t i = 0; i < strips.size(); ++i )
+		{
+			REQUIRE( 3 - i == strips[i].level );
+			REQUIRE( strips[i].completesLevel );
+		}
+	}
+
+	SECTION( "After another texture" )
+	{
+		// The BC7 texture's strips start at multiples of 16
+		CachedTexture const first = texture_( BlockFormat::bc1, 4, 4 );
+		CachedTexture const second = texture_( BlockFormat::bc7, 4, 4 );
+
+		TextureStreamPosition a = texture_stream_start( first ), b = texture_stream_start( second );
+		std::vector<TextureStrip> strips;
+		std::size_t head = plan_texture_strips( first, a, 0, 64, strips );
+		REQUIRE( 24 == head );
+
+		strips.clear();
+		head = plan_texture_strips( second, b, head, 64, strips );
+		REQUIRE( 32 == strips.front().offset );
+		REQUIRE( !b.complete ); // 1x1 and 2x2 fit, 4x4 does not
+		REQUIRE( 64 == head );
+	}
+
+	SECTION( "4K BC7 over several frames" )
+	{
+		std::size_t const budget = 2*1024*1024;
+		CachedTexture const texture = texture_( BlockFormat::bc7, 4096, 4096 );
+
+		TextureStreamPosition position = texture_stream_start( texture );
+		std::vector<std::size_t> rows( texture.level_count() );
+		std::size_t frames = 0, bytes = 0, level = texture.level_count();
+
+		std::vector<TextureStrip> strips;
+		while( !position.complete )
+		{
+			strips.clear();
+			plan_texture_strips( texture, position, 0, budget, strips );
+			REQUIRE( !strips.empty() );
+			check_frame_( strips, BlockFormat::bc7, budget );
+
+			for( auto const& strip : strips )
+			{
+				// Levels in order, rows in order
+				REQUIRE( strip.level <= level );
+				level = strip.level;
+				REQUIRE( rows[level] == strip.firstBlockRow );
+				rows[level] += strip.blockRows;
+				bytes += strip.size;
+			}
+			++frames;
+		}
+
+		REQUIRE( 11 == frames );
+		REQUIRE( texture.size() == bytes );
+		for( std::size_t i = 0; i < rows.size(); ++i )
+			REQUIRE( block_count( texture.level( i ).height ) == rows[i] );
+	}
+}
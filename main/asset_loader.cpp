@@ -0,0 +1,154 @@
+#include "asset_loader.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+#include <cstdio>
+
+namespace
+{
+	using Clock_ = std::chrono::steady_clock;
+
+	double milliseconds_since_( Clock_::time_point aStart ) noexcept
+	{
+		return std::chrono::duration<double, std::milli>( Clock_::now() - aStart ).count();
+	}
+}
+
+AssetLoader::AssetLoader( std::size_t aWorkers )
+{
+	aWorkers = std::max( aWorkers, std::size_t(1) );
+
+	mWorkers.reserve( aWorkers );
+	for( std::size_t i = 0; i < aWorkers; ++i )
+		mWorkers.emplace_back( [this] { worker_(); } );
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock( mQueueMutex );
+		mStop = true;
+		mQueue.clear();
+	}
+	mWake.notify_all();
+
+	for( auto& worker : mWorkers )
+		worker.join();
+
+	for( Task_* task = take_done_(); task; )
+	{
+		Task_* const next = task->next;
+		delete task;
+		task = next;
+	}
+}
+
+AssetUploadStats const& AssetLoader::pump( double aBudgetMilliseconds )
+{
+	auto const start = Clock_::now();
+
+	for( Task_* task = take_done_(); task; )
+	{
+		Task_* const next = task->next;
+		mReady.emplace_back( task );
+		task = next;
+	}
+
+	std::size_t uploads = 0;
+	while( !mReady.empty() && (0 == uploads || milliseconds_since_( start ) < aBudgetMilliseconds) )
+	{
+		std::unique_ptr<Task_> task = std::move(mReady.front());
+		mReady.pop_front();
+
+		mPending.fetch_sub( 1, std::memory_order_acq_rel );
+
+		if( task->error )
+			std::rethrow_exception( task->error );
+
+		auto const uploadStart = Clock_::now();
+		task->upload();
+		++uploads;
+		++mStats.loaded;
+
+		std::printf( "asset '%s': loaded in %.1f ms, uploaded in %.1f ms\n", task->name.c_str(), task->workMilliseconds, milliseconds_since_( uploadStart ) );
+	}
+
+	double const ms = milliseconds_since_( start );
+
+	++mStats.frames;
+	mStats.uploadsLastFrame = uploads;
+	mStats.millisecondsLastFrame = ms;
+	mStats.millisecondsPeak = std::max( mStats.millisecondsPeak, ms );
+	mStats.pending = mPending.load( std::memory_order_acquire );
+
+	return mStats;
+}
+
+void AssetLoader::submit_( std::unique_ptr<Task_> aTask )
+{
+	mPending.fetch_add( 1, std::memory_order_acq_rel );
+
+	{
+		std::lock_guard<std::mutex> lock( mQueueMutex );
+		mQueue.emplace_back( std::move(aTask) );
+	}
+	mWake.notify_one();
+}
+
+void AssetLoader::worker_()
+{
+	for( ;; )
+	{
+		std::unique_ptr<Task_> task;
+		{
+			std::unique_lock<std::mutex> lock( mQueueMutex );
+			mWake.wait( lock, [this] { return mStop || !mQueue.empty(); } );
+
+			if( mStop )
+				return;
+
+			task = std::move(mQueue.front());
+			mQueue.pop_front();
+		}
+
+		auto const start = Clock_::now();
+		try
+		{
+			task->work();
+		}
+		catch( ... )
+		{
+			task->error = std::current_exception();
+		}
+		task->workMilliseconds = milliseconds_since_( start );
+
+		push_done_( task.release() );
+	}
+}
+
+void AssetLoader::push_done_( Task_* aTask ) noexcept
+{
+	Task_* head = mDone.load( std::memory_order_relaxed );
+	do
+	{
+		aTask->next = head;
+	} while( !mDone.compare_exchange_weak( head, aTask, std::memory_order_release, std::memory_order_relaxed ) );
+}
+
+AssetLoader::Task_* AssetLoader::take_done_() noexcept
+{
+	// The stack is newest first; reverse it.
+	Task_* task = mDone.exchange( nullptr, std::memory_order_acquire );
+
+	Task_* oldest = nullptr;
+	while( task )
+	{
+		Task_* const next = task->next;
+		task->next = oldest;
+		oldest = task;
+		task = next;
+	}
+
+	return oldest;
+}
@@ -0,0 +1,147 @@
+#ifndef ASSET_LOADER_HPP_363CBF8C_76A9_4522_9496_4731B2C106B6
+#define ASSET_LOADER_HPP_363CBF8C_76A9_4522_9496_4731B2C106B6
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <exception>
+#include <type_traits>
+#include <condition_variable>
+
+#include <cstddef>
+#include <cstdint>
+
+struct AssetUploadStats
+{
+	std::uint64_t frames;        // pump() calls
+	std::size_t uploadsLastFrame;
+	double millisecondsLastFrame;
+	double millisecondsPeak;     // longest pump()
+
+	std::size_t loaded;          // assets uploaded so far
+	std::size_t pending;         // requested, but not uploaded yet
+};
+
+/** AssetLoader: loads assets on worker threads, uploads them on the GL thread
+ *
+ * load( name, work, upload ) runs work() on a worker thread; it returns the
+ * asset's CPU payload (e.g., a parsed mesh or decoded image). The finished
+ * payload is pushed onto a lock-free queue, from which pump() on the GL
+ * thread takes it and calls upload( std::move(payload) ), which may make GL
+ * calls. pump() stops taking payloads once its time budget is used up, but
+ * always uploads at least one, so that every asset eventually arrives.
+ *
+ *   AssetLoader loader;
+ *   loader.load( "terrain", [] { return parse(...); }, [&] (Mesh&& m) { ... } );
+ *   while( running )
+ *   {
+ *       loader.pump( 2.0 );
+ *       // ... draw what is there so far
+ *   }
+ *
+ * load() may be called from any thread, including from a work() function.
+ * If work() throws, the exception is rethrown from the pump() that would
+ * have uploaded the asset. Destroying the loader waits for the work that
+ * is running and drops what has not started; payloads that were not
+ * uploaded are discarded without calling upload().
+ */
+class AssetLoader final
+{
+	public:
+		explicit AssetLoader( std::size_t aWorkers = 2 );
+		~AssetLoader();
+
+		AssetLoader( AssetLoader const& ) = delete;
+		AssetLoader& operator= (AssetLoader const&) = delete;
+
+	public:
+		template< typename tWork, typename tUpload >
+		void load( std::string aName, tWork&& aWork, tUpload&& aUpload );
+
+		// Uploads finished assets for up to aBudgetMilliseconds. GL thread
+		// only.
+		AssetUploadStats const& pump( double aBudgetMilliseconds );
+
+		bool idle() const noexcept { return 0 == mPending.load( std::memory_order_acquire ); }
+
+		AssetUploadStats const& stats() const noexcept { return mStats; }
+
+	private:
+		struct Task_
+		{
+			virtual ~Task_() = default;
+
+			virtual void work() = 0;
+			virtual void upload() = 0;
+
+			std::string name;
+			std::exception_ptr error;
+			double workMilliseconds = 0.0;
+
+			Task_* next = nullptr; // in mDone
+		};
+
+		template< typename tWork, typename tUpload >
+		struct TaskImpl_ final : Task_
+		{
+			using Payload = std::invoke_result_t<tWork&>;
+
+			TaskImpl_( tWork aWork, tUpload aUpload )
+				: mWork( std::move(aWork) )
+				, mUpload( std::move(aUpload) )
+			{}
+
+			void work() override { mPayload = std::make_unique<Payload>( mWork() ); }
+			void upload() override { mUpload( std::move(*mPayload) ); }
+
+			tWork mWork;
+			tUpload mUpload;
+			std::unique_ptr<Payload> mPayload;
+		};
+
+		void submit_( std::unique_ptr<Task_> );
+		void worker_();
+
+		// Push onto mDone (any thread); take everything from it, oldest
+		// first (GL thread).
+		void push_done_( Task_* ) noexcept;
+		Task_* take_done_() noexcept;
+
+	private:
+		// Work not started yet; workers sleep on mWake
+		std::mutex mQueueMutex;
+		std::condition_variable mWake;
+		std::deque<std::unique_ptr<Task_>> mQueue;
+		bool mStop = false;
+
+		std::vector<std::thread> mWorkers;
+
+		// Finished work: a lock-free stack, newest first
+		std::atomic<Task_*> mDone{ nullptr };
+
+		// Taken from mDone but not uploaded yet (over budget), oldest first
+		std::deque<std::unique_ptr<Task_>> mReady;
+
+		std::atomic<std::size_t> mPending{ 0 };
+		AssetUploadStats mStats{};
+};
+
+
+
+// Template implementations:
+template< typename tWork, typename tUpload >
+void AssetLoader::load( std::string aName, tWork&& aWork, tUpload&& aUpload )
+{
+	using Task = TaskImpl_<std::decay_t<tWork>, std::decay_t<tUpload>>;
+
+	auto task = std::make_unique<Task>( std::forward<tWork>(aWork), std::forward<tUpload>(aUpload) );
+	task->name = std::move(aName);
+	submit_( std::move(task) );
+}
+
+#endif // ASSET_LOADER_HPP_363CBF8C_76A9_4522_9496_4731B2C106B6
@@ -0,0 +1,223 @@
+#include "buffer_arena.hpp"
+
+#include <utility>
+#include <algorithm>
+
+#include <cassert>
+
+BufferArena::BufferArena( VertexLayout const& aLayout, std::size_t aBlockSize )
+	: mLayout( aLayout )
+	, mBlockSize( aBlockSize )
+{
+	assert( aLayout.stride > 0 && aLayout.stride % 4 == 0 );
+}
+
+BufferArena::~BufferArena()
+{
+	release_();
+}
+
+BufferArena::BufferArena( BufferArena&& aOther ) noexcept
+	: mLayout( aOther.mLayout )
+	, mBlockSize( aOther.mBlockSize )
+	, mMeshes( std::exchange( aOther.mMeshes, 0 ) )
+	, mBlocks( std::exchange( aOther.mBlocks, {} ) )
+{}
+BufferArena& BufferArena::operator= (BufferArena&& aOther) noexcept
+{
+	std::swap( mLayout, aOther.mLayout );
+	std::swap( mBlockSize, aOther.mBlockSize );
+	std::swap( mMeshes, aOther.mMeshes );
+	std::swap( mBlocks, aOther.mBlocks );
+	return *this;
+}
+
+ArenaMesh BufferArena::add( InterleavedVertices const& aVertices, ArrayView<std::uint32_t> aIndices )
+{
+	assert( aVertices.layout == mLayout );
+	assert( aVertices.count > 0 );
+
+	std::size_t const vertexBytes = aVertices.count * mLayout.stride;
+	std::size_t const indexBytes = aIndices.size() * sizeof(std::uint32_t);
+
+	// Vertices start at a whole vertex, indices at a whole index.
+	auto const place = [&] (Block_& aBlock, RangeAllocation& aOutVertices, RangeAllocation& aOutIndices) {
+		aOutVertices = aBlock.ranges.allocate( vertexBytes, mLayout.stride );
+		if( RangeAllocator::kInvalidOffset == aOutVertices.offset )
+			return false;
+
+		aOutIndices = RangeAllocation{ 0, 0 };
+		if( 0 == indexBytes )
+			return true;
+
+		aOutIndices = aBlock.ranges.allocate( indexBytes, sizeof(std::uint32_t) );
+		if( RangeAllocator::kInvalidOffset == aOutIndices.offset )
+		{
+			aBlock.ranges.free( aOutVertices );
+			return false;
+		}
+		return true;
+	};
+
+	RangeAllocation vertices{}, indices{};
+
+	std::size_t block = 0;
+	while( block < mBlocks.size() && !place( mBlocks[block], vertices, indices ) )
+		++block;
+
+	if( block == mBlocks.size() )
+	{
+		// Room for the mesh in any case, including worst case alignment
+		create_block_( std::max( mBlockSize, vertexBytes + mLayout.stride + indexBytes + sizeof(std::uint32_t) ) );
+
+		bool const placed = place( mBlocks.back(), vertices, indices );
+		assert( placed );
+		(void)placed;
+	}
+
+	Block_ const& target = mBlocks[block];
+	glNamedBufferSubData( target.buffer, GLintptr(vertices.offset), GLsizeiptr(vertexBytes), aVertices.data.data() );
+	if( indexBytes )
+		glNamedBufferSubData( target.buffer, GLintptr(indices.offset), GLsizeiptr(indexBytes), aIndices.data() );
+
+	++mMeshes;
+
+	ArenaMesh ret{};
+	ret.vao = target.vao;
+	ret.baseVertex = GLint(vertices.offset / mLayout.stride);
+	ret.firstIndex = indices.offset / sizeof(std::uint32_t);
+	ret.vertexCount = aVertices.count;
+	ret.indexCount = aIndices.size();
+	ret.block = std::uint32_t(block);
+	ret.vertexBytes = vertices;
+	ret.indexBytes = indices;
+	return ret;
+}
+
+void BufferArena::remove( ArenaMesh const& aMesh )
+{
+	assert( aMesh.block < mBlocks.size() );
+	assert( mMeshes > 0 );
+
+	Block_& block = mBlocks[aMesh.block];
+	assert( block.vao == aMesh.vao );
+
+	block.ranges.free( aMesh.vertexBytes );
+	if( aMesh.indexBytes.size )
+		block.ranges.free( aMesh.indexBytes );
+
+	--mMeshes;
+}
+
+ArenaStats BufferArena::stats() const noexcept
+{
+	ArenaStats ret{};
+	ret.blocks = mBlocks.size();
+	ret.meshes = mMeshes;
+
+	for( auto const& block : mBlocks )
+	{
+		ret.capacity += block.ranges.capacity();
+		ret.used += block.ranges.used();
+		ret.largestFree = std::max( ret.largestFree, block.ranges.largest_free() );
+	}
+
+	std::size_t const freeSize = ret.capacity - ret.used;
+	ret.fragmentation = freeSize ? 1.f - float(ret.largestFree) / float(freeSize) : 0.f;
+	return ret;
+}
+
+void BufferArena::create_block_( std::size_t aSize )
+{
+	Block_ block{ 0, 0, RangeAllocator( aSize ) };
+
+	// Immutable storage; meshes are uploaded with glNamedBufferSubData().
+	glCreateBuffers( 1, &block.buffer );
+	glNamedBufferStorage( block.buffer, GLsizeiptr(aSize), nullptr, GL_DYNAMIC_STORAGE_BIT );
+
+	// Vertices and indices come from the same buffer. All attributes read
+	// from binding point 0.
+	glCreateVertexArrays( 1, &block.vao );
+	glVertexArrayVertexBuffer( block.vao, 0, block.buffer, 0, GLsizei(mLayout.stride) );
+
+	for( std::size_t i = 0; i < mLayout.attribCount; ++i )
+	{
+		InterleavedAttrib const& attrib = mLayout.attribs[i];
+		glEnableVertexArrayAttrib( block.vao, attrib.location );
+		glVertexArrayAttribFormat( block.vao, attrib.location, attrib.components, attrib.type, attrib.normalized, attrib.offset );
+		glVertexArrayAttribBinding( block.vao, attrib.location, 0 );
+	}
+
+	glVertexArrayElementBuffer( block.vao, block.buffer );
+
+	mBlocks.emplace_back( std::move(block) );
+}
+
+void BufferArena::release_() noexcept
+{
+	for( auto const& block : mBlocks )
+	{
+		glDeleteVertexArrays( 1, &block.vao );
+		glDeleteBuffers( 1, &block.buffer );
+	}
+	mBlocks.clear();
+}
+
+
+MeshArenas::MeshArenas( std::size_t aBlockSize )
+	: mBlockSize( aBlockSize )
+{}
+
+void MeshArenas::remove( ArenaMesh const& aMesh )
+{
+	assert( aMesh.arena < mArenas.size() );
+	mArenas[aMesh.arena].remove( aMesh );
+}
+
+ArenaStats MeshArenas::stats() const noexcept
+{
+	ArenaStats ret{};
+
+	std::size_t freeSize = 0;
+	for( auto const& arena : mArenas )
+	{
+		ArenaStats const s = arena.stats();
+		ret.blocks += s.blocks;
+		ret.meshes += s.meshes;
+		ret.capacity += s.capacity;
+		ret.used += s.used;
+		ret.largestFree = std::max( ret.largestFree, s.largestFree );
+		freeSize += s.capacity - s.used;
+	}
+
+	ret.fragmentation = freeSize ? 1.f - float(ret.largestFree) / float(freeSize) : 0.f;
+	return ret;
+}
+
+ArenaMesh MeshArenas::add_( InterleavedVertices const& aVertices, ArrayView<std::uint32_t> aIndices )
+{
+	auto it = std::find_if( mArenas.begin(), mArenas.end(), [&aVertices] (BufferArena const& aArena) {
+		return aArena.layout() == aVertices.layout;
+	} );
+
+	if( mArenas.end() == it )
+	{
+		mArenas.emplace_back( aVertices.layout, mBlockSize );
+		it = mArenas.end() - 1;
+	}
+
+	ArenaMesh ret = it->add( aVertices, aIndices );
+	ret.arena = std::uint32_t(it - mArenas.begin());
+	return ret;
+}
+
+
+void draw_arena_mesh( ArenaMesh const& aMesh, std::size_t aFirstIndex, std::size_t aIndexCount )
+{
+	assert( aFirstIndex + aIndexCount <= aMesh.indexCount );
+
+	glDrawElementsBaseVertex( GL_TRIANGLES, GLsizei(aIndexCount), GL_UNSIGNED_INT,
+		reinterpret_cast<void const*>((aMesh.firstIndex + aFirstIndex) * sizeof(std::uint32_t)),
+		aMesh.baseVertex
+	);
+}
@@ -0,0 +1,137 @@
+#ifndef BUFFER_ARENA_HPP_BF2DE695_1924_48F9_AD3F_F6C358030ACD
+#define BUFFER_ARENA_HPP_BF2DE695_1924_48F9_AD3F_F6C358030ACD
+
+#include <glad.h>
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simple_mesh.hpp"
+#include "vertex_format.hpp"
+
+#include "../vmlib/range_allocator.hpp"
+
+// Where a mesh lives in a BufferArena: the VAO of its block, the offset of
+// its vertices (glDrawElementsBaseVertex()'s basevertex) and of its indices
+// (in indices from the start of the block's buffer).
+struct ArenaMesh
+{
+	GLuint vao;
+	GLint baseVertex;
+	std::size_t firstIndex;
+
+	std::size_t vertexCount, indexCount;
+
+	std::uint32_t arena, block;
+	RangeAllocation vertexBytes, indexBytes;
+};
+
+// Usage of one arena, or of all arenas of a MeshArenas. Sizes in bytes.
+struct ArenaStats
+{
+	std::size_t blocks, meshes;
+	std::size_t capacity, used;
+	std::size_t largestFree;
+	float fragmentation; // See RangeAllocator; of all free space in all blocks
+};
+
+/** BufferArena: the meshes of one vertex layout in shared GPU buffers
+ *
+ * Meshes are sub-allocated from a few large blocks. Each block is one
+ * immutable buffer (glNamedBufferStorage()) that holds both vertices and
+ * indices, with one VAO; all meshes of a block are drawn from that VAO with
+ * glDrawElementsBaseVertex(). Vertex ranges are aligned to the stride, so
+ * that each mesh starts at a whole vertex. Blocks are aBlockSize bytes, or
+ * larger for a mesh that does not fit into one.
+ *
+ * remove() returns a mesh's ranges to its block. The blocks (buffers and
+ * VAOs) are deleted with the arena, which must happen while the OpenGL
+ * context is current.
+ */
+constexpr std::size_t kDefaultArenaBlockSize = std::size_t(1) << 20;
+
+class BufferArena final
+{
+	public:
+		explicit BufferArena( VertexLayout const&, std::size_t aBlockSize = kDefaultArenaBlockSize );
+		~BufferArena();
+
+		BufferArena( BufferArena const& ) = delete;
+		BufferArena& operator= (BufferArena const&) = delete;
+
+		BufferArena( BufferArena&& ) noexcept;
+		BufferArena& operator= (BufferArena&&) noexcept;
+
+	public:
+		ArenaMesh add( InterleavedVertices const&, ArrayView<std::uint32_t> aIndices );
+		void remove( ArenaMesh const& );
+
+	public:
+		VertexLayout const& layout() const noexcept { return mLayout; }
+		ArenaStats stats() const noexcept;
+
+	private:
+		struct Block_
+		{
+			GLuint buffer, vao;
+			RangeAllocator ranges;
+		};
+
+		void create_block_( std::size_t aSize );
+		void release_() noexcept;
+
+		VertexLayout mLayout;
+		std::size_t mBlockSize;
+		std::size_t mMeshes = 0;
+		std::vector<Block_> mBlocks;
+};
+
+/** MeshArenas: one BufferArena per vertex layout
+ *
+ * add() interleaves a mesh like create_vao() and places it into the arena
+ * of its layout, creating that arena on first use. Meshes with the same
+ * format and the same attributes share an arena.
+ */
+class MeshArenas final
+{
+	public:
+		explicit MeshArenas( std::size_t aBlockSize = kDefaultArenaBlockSize );
+
+	public:
+		template< typename... tAttribs >
+		ArenaMesh add( MeshView const&, VertexFormat<tAttribs...> );
+
+		void remove( ArenaMesh const& );
+
+	public:
+		std::vector<BufferArena> const& arenas() const noexcept { return mArenas; }
+		ArenaStats stats() const noexcept;
+
+	private:
+		ArenaMesh add_( InterleavedVertices const&, ArrayView<std::uint32_t> );
+
+		std::size_t mBlockSize;
+		std::vector<BufferArena> mArenas;
+};
+
+// Draws aIndexCount indices of the (indexed) mesh, starting at aFirstIndex
+// of the mesh's own indices. The mesh's VAO must be bound.
+void draw_arena_mesh( ArenaMesh const&, std::size_t aFirstIndex, std::size_t aIndexCount );
+
+inline
+void draw_arena_mesh( ArenaMesh const& aMesh )
+{
+	draw_arena_mesh( aMesh, 0, aMesh.indexCount );
+}
+
+
+// Template implementations:
+template< typename... tAttribs >
+ArenaMesh MeshArenas::add( MeshView const& aMeshData, VertexFormat<tAttribs...> aFormat )
+{
+	return add_( interleave_vertices( aMeshData, aFormat ), aMeshData.indices );
+}
+
+#endif // BUFFER_ARENA_HPP_BF2DE695_1924_48F9_AD3F_F6C358030ACD
@@ -0,0 +1,74 @@
+#include "cache_source.hpp"
+
+#include <filesystem>
+#include <system_error>
+
+#include <cstring>
+
+#include "mapped_file.hpp"
+
+#include "../support/error.hpp"
+
+namespace
+{
+	// Not cryptographic; detects edits to the source. FNV-1a over 64-bit
+	// words (the tail byte by byte), with a final avalanche.
+	std::uint64_t hash_bytes_( void const* aData, std::size_t aSize ) noexcept
+	{
+		constexpr std::uint64_t kPrime = 0x100000001b3ull;
+
+		auto const* bytes = static_cast<unsigned char const*>(aData);
+		std::uint64_t hash = 0xcbf29ce484222325ull ^ aSize;
+
+		std::size_t i = 0;
+		for( ; i + 8 <= aSize; i += 8 )
+		{
+			std::uint64_t word;
+			std::memcpy( &word, bytes + i, 8 );
+			hash = (hash ^ word) * kPrime;
+			hash ^= hash >> 29;
+		}
+		for( ; i < aSize; ++i )
+			hash = (hash ^ bytes[i]) * kPrime;
+
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	std::int64_t file_time_( std::filesystem::path const& aPath, std::error_code& aErr )
+	{
+		return std::int64_t(std::filesystem::last_write_time( aPath, aErr ).time_since_epoch().count());
+	}
+}
+
+CacheSource cache_source( char const* aPath )
+{
+	std::error_code err;
+	std::int64_t const time = file_time_( aPath, err );
+	if( err )
+		throw Error( "cache_source(): unable to get the modification time of '%s': %s", aPath, err.message().c_str() );
+
+	MappedFile const file( aPath );
+	return CacheSource{ file.size(), time, hash_bytes_( file.data(), file.size() ) };
+}
+
+bool cache_source_current( CacheSource const& aCached, char const* aSourcePath, std::optional<CacheSource>* aSource )
+{
+	// Size and time first: hashing means reading the whole source.
+	std::error_code err;
+	std::uintmax_t const size = std::filesystem::file_size( aSourcePath, err );
+	if( err || size != aCached.size )
+		return false;
+
+	std::int64_t const time = file_time_( aSourcePath, err );
+	if( err || time != aCached.time )
+		return false;
+
+	CacheSource const source = cache_source( aSourcePath );
+	if( aSource )
+		*aSource = source;
+
+	return source.hash == aCached.hash;
+}
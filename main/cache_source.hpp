@@ -0,0 +1,26 @@
+#ifndef CACHE_SOURCE_HPP_3DB03E96_6AA5_4C5A_9E91_A9FAD190333D
+#define CACHE_SOURCE_HPP_3DB03E96_6AA5_4C5A_9E91_A9FAD190333D
+
+#include <optional>
+
+#include <cstdint>
+
+// Identifies the source of a cache (mesh_cache.hpp, texture_cache.hpp): the
+// file's size, modification time (in ticks of std::filesystem's clock) and
+// a 64-bit hash of its contents.
+struct CacheSource
+{
+	std::uint64_t size;
+	std::int64_t time;
+	std::uint64_t hash;
+};
+
+// Reads and hashes the file. Throws if it cannot be read.
+CacheSource cache_source( char const* aPath );
+
+// True if the file at aSourcePath still matches aCached in size,
+// modification time and hash. Fills aSource with the file's current
+// description if it had to hash it.
+bool cache_source_current( CacheSource const& aCached, char const* aSourcePath, std::optional<CacheSource>* aSource = nullptr );
+
+#endif // CACHE_SOURCE_HPP_3DB03E96_6AA5_4C5A_9E91_A9FAD190333D
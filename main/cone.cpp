@@ -1,52 +1,74 @@
 #include "cone.hpp"
 
+#include <algorithm>
+
+#include <cassert>
+
+#include "../vmlib/batch.hpp"
+#include "../vmlib/trig.hpp"
+
+std::size_t cone_vertex_count( bool aCapped, std::size_t aSubdivs ) noexcept
+{
+	return (aCapped ? 6 : 3) * aSubdivs;
+}
+
 SimpleMeshData make_cone( bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform )
 {
-	std::vector<Vec3f> pos;
-	std::vector<Vec3f> norm;
+	MeshBuilder builder;
+	add_cone( builder, aCapped, aSubdivs, aColor, aPreTransform );
+	return builder.release();
+}
+
+MeshRange add_cone( MeshBuilder& aBuilder, bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform )
+{
+	std::size_t const count = cone_vertex_count( aCapped, aSubdivs );
+	MeshBuilder::Part const part = aBuilder.add_part( count );
+	Vec3f* pos = part.positions;
+	Vec3f* norm = part.normals;
 	float prevY = std::cos( 0.f );
 	float prevZ = std::sin( 0.f );
+
+	// Compute the sines and cosines of all angles at once.
+	std::vector<float> sines( aSubdivs ), cosines( aSubdivs );
+	for( std::size_t i = 0; i < aSubdivs; ++i )
+		sines[i] = (i+1) / float(aSubdivs) * 2.f * 3.1415926f;
+
+	sincos_batch( sines.data(), aSubdivs, sines.data(), cosines.data() );
 	
 	for( std::size_t i = 0; i < aSubdivs; ++i ) {
-		float const angle = (i+1) / float(aSubdivs) * 2.f * 3.1415926f;
-
-		float y = std::cos( angle );
-		float z = std::sin( angle );
+		float y = cosines[i];
+		float z = sines[i];
 
-		pos.emplace_back( Vec3f{ 0.f, prevY, prevZ } );
-        pos.emplace_back( Vec3f{ 0.f, y, z } );
-        pos.emplace_back( Vec3f{ 1.f, 0.f, 0.f } ); 
+		*pos++ = Vec3f{ 0.f, prevY, prevZ };
+        *pos++ = Vec3f{ 0.f, y, z };
+        *pos++ = Vec3f{ 1.f, 0.f, 0.f }; 
 
 		Vec3f normal = cross(Vec3f{0.f, y, z} - Vec3f{0.f, prevY, prevZ}, Vec3f{1.f, 0.f, 0.f} - Vec3f{0.f, prevY, prevZ});
-        normal = normalize(normal);
-        norm.emplace_back(normal);
-        norm.emplace_back(normal);
-        norm.emplace_back(normal);
+        normal = normalize<FastMath>(normal);
+        *norm++ = normal;
+        *norm++ = normal;
+        *norm++ = normal;
 
 		if (aCapped)
 		{
-			pos.emplace_back( Vec3f{ 0.f, prevY, prevZ } );
-			pos.emplace_back( Vec3f{ 0.f, 0.f, 0.f } );
-			pos.emplace_back( Vec3f{ 0.f, y, z } );
+			*pos++ = Vec3f{ 0.f, prevY, prevZ };
+			*pos++ = Vec3f{ 0.f, 0.f, 0.f };
+			*pos++ = Vec3f{ 0.f, y, z };
 
-			norm.emplace_back( Vec3f{ -1.f, 0.f, 0.f } );
-			norm.emplace_back( Vec3f{ -1.f, 0.f, 0.f } );
-			norm.emplace_back( Vec3f{ -1.f, 0.f, 0.f } );
+			*norm++ = Vec3f{ -1.f, 0.f, 0.f };
+			*norm++ = Vec3f{ -1.f, 0.f, 0.f };
+			*norm++ = Vec3f{ -1.f, 0.f, 0.f };
 		}
 
 		prevY = y;
 		prevZ = z;
 	}
 
-	for( auto& p : pos )
-    {
-        Vec4f p4{ p.x, p.y, p.z, 1.f };
-        Vec4f t = aPreTransform * p4;
-        t /= t.w;
-        p = Vec3f{ t.x, t.y, t.z };
-    }
+	assert( part.positions + count == pos );
+
+	transform_points( aPreTransform, part.positions, pos );
 
-	std::vector col( pos.size(), aColor );
-	return SimpleMeshData{ std::move(pos), std::move(col), std::move(norm)};
+	std::fill_n( part.colors, count, aColor );
+	return part.range;
 }
 
@@ -6,6 +6,7 @@
 #include <cstdlib>
 
 #include "simple_mesh.hpp"
+#include "mesh_builder.hpp"
 
 #include "../vmlib/vec3.hpp"
 #include "../vmlib/mat44.hpp"
@@ -17,4 +18,16 @@ SimpleMeshData make_cone(
 	Mat44f aPreTransform = kIdentity44f
 );
 
+// Number of vertices generated by make_cone() and add_cone().
+std::size_t cone_vertex_count( bool aCapped, std::size_t aSubdivs ) noexcept;
+
+// Generates the cone directly into the builder's storage as a new part.
+MeshRange add_cone(
+	MeshBuilder& aBuilder,
+	bool aCapped = true,
+	std::size_t aSubdivs = 16,
+	Vec3f aColor = { 1.f, 1.f, 1.f },
+	Mat44f aPreTransform = kIdentity44f
+);
+
 #endif // CONE_HPP_CB812C27_5E45_4ED9_9A7F_D66774954C29
@@ -1,10 +1,23 @@
-#include "cylinder.hpp"
+#include "cube.hpp"
 #include <array>
+#include <algorithm>
+
+#include <cassert>
+
+#include "../vmlib/batch.hpp"
 
 SimpleMeshData make_cube(Vec3f aColor, Mat44f aPreTransform)
 {
-    std::vector<Vec3f> pos;
-    std::vector<Vec3f> norm;
+    MeshBuilder builder;
+    add_cube(builder, aColor, aPreTransform);
+    return builder.release();
+}
+
+MeshRange add_cube(MeshBuilder& aBuilder, Vec3f aColor, Mat44f aPreTransform)
+{
+    MeshBuilder::Part const part = aBuilder.add_part(kCubeVertexCount);
+    Vec3f* pos = part.positions;
+    Vec3f* norm = part.normals;
 
     // Define cube vertices
     std::vector<Vec3f> cubeVertices = {
@@ -41,21 +54,16 @@ SimpleMeshData make_cube(Vec3f aColor, Mat44f aPreTransform)
         // Assign normals to vertices of the face
         for (int vertexIndex : face)
         {
-            pos.push_back(cubeVertices[vertexIndex]);
-            norm.push_back(faceNormal);
+            *pos++ = cubeVertices[vertexIndex];
+            *norm++ = faceNormal;
         }
     }
 
-    // Apply transformation to positions
-    for (auto &p : pos)
-    {
-        Vec4f p4{p.x, p.y, p.z, 1.f};
-        Vec4f t = aPreTransform * p4;
-        t /= t.w;
+    assert(part.positions + kCubeVertexCount == pos);
 
-        p = Vec3f{t.x, t.y, t.z};
-    }
+    // Apply transformation to positions
+    transform_points( aPreTransform, part.positions, pos );
 
-    std::vector col( pos.size(), aColor );
-    return SimpleMeshData{std::move(pos), std::move(col), std::move(norm)};
+    std::fill_n(part.colors, kCubeVertexCount, aColor);
+    return part.range;
 }
@@ -6,6 +6,7 @@
 #include <cstdlib>
 
 #include "simple_mesh.hpp"
+#include "mesh_builder.hpp"
 
 #include "../vmlib/vec3.hpp"
 #include "../vmlib/mat44.hpp"
@@ -16,4 +17,14 @@ SimpleMeshData make_cube(
 	Mat44f aPreTransform = kIdentity44f
 );
 
+// Number of vertices generated by make_cube() and add_cube().
+constexpr std::size_t kCubeVertexCount = 36;
+
+// Generates the cube directly into the builder's storage as a new part.
+MeshRange add_cube(
+	MeshBuilder& aBuilder,
+	Vec3f aColor = { 1.f, 1.f, 1.f },
+	Mat44f aPreTransform = kIdentity44f
+);
+
 #endif // CUBE_HPP_6874B39C_112D_4D34_BD85_AB81A730955B
\ No newline at end of file
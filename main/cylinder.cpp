@@ -1,74 +1,93 @@
 #include "cylinder.hpp"
 
+#include <algorithm>
+
+#include <cassert>
+
 #include "../vmlib/mat33.hpp"
+#include "../vmlib/batch.hpp"
+#include "../vmlib/trig.hpp"
+
+std::size_t cylinder_vertex_count( bool aCapped, std::size_t aSubdivs ) noexcept
+{
+	return (aCapped ? 12 : 6) * aSubdivs;
+}
 
 SimpleMeshData make_cylinder( bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform )
 {
-	std::vector<Vec3f> pos;
-	std::vector<Vec3f> norm;
+	MeshBuilder builder;
+	add_cylinder( builder, aCapped, aSubdivs, aColor, aPreTransform );
+	return builder.release();
+}
+
+MeshRange add_cylinder( MeshBuilder& aBuilder, bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform )
+{
+	// Generate directly into the builder's storage
+	std::size_t const count = cylinder_vertex_count( aCapped, aSubdivs );
+	MeshBuilder::Part const part = aBuilder.add_part( count );
+	Vec3f* pos = part.positions;
+	Vec3f* norm = part.normals;
 	float prevY = std::cos( 0.f );
 	float prevZ = std::sin( 0.f );
+
+	// Compute the sines and cosines of all angles at once.
+	std::vector<float> sines( aSubdivs ), cosines( aSubdivs );
+	for( std::size_t i = 0; i < aSubdivs; ++i )
+		sines[i] = (i+1) / float(aSubdivs) * 2.f * 3.1415926f;
+
+	sincos_batch( sines.data(), aSubdivs, sines.data(), cosines.data() );
 	
 	for( std::size_t i = 0; i < aSubdivs; ++i ) {
-		float const angle = (i+1) / float(aSubdivs) * 2.f * 3.1415926f;
+		float y = cosines[i];
+		float z = sines[i];
 
-		float y = std::cos( angle );
-		float z = std::sin( angle );
+		*pos++ = Vec3f{ 0.f, prevY, prevZ };
+		*pos++ = Vec3f{ 0.f, y, z };
+		*pos++ = Vec3f{ 1.f, prevY, prevZ };
 
-		pos.emplace_back( Vec3f{ 0.f, prevY, prevZ } );
-		pos.emplace_back( Vec3f{ 0.f, y, z } );
-		pos.emplace_back( Vec3f{ 1.f, prevY, prevZ } );
+		*norm++ = Vec3f{ 0.f, prevY, prevZ };
+		*norm++ = Vec3f{ 0.f, y, z };
+		*norm++ = Vec3f{ 0.f, prevY, prevZ };
 
-		norm.emplace_back( Vec3f{ 0.f, prevY, prevZ } );
-		norm.emplace_back( Vec3f{ 0.f, y, z } );
-		norm.emplace_back( Vec3f{ 0.f, prevY, prevZ } );
+		*pos++ = Vec3f{ 0.f, y, z };
+		*pos++ = Vec3f{ 1.f, y, z };
+		*pos++ = Vec3f{ 1.f, prevY, prevZ };
 
-		pos.emplace_back( Vec3f{ 0.f, y, z } );
-		pos.emplace_back( Vec3f{ 1.f, y, z } );
-		pos.emplace_back( Vec3f{ 1.f, prevY, prevZ } );
-
-		norm.emplace_back( Vec3f{ 0.f, y, z } );
-		norm.emplace_back( Vec3f{ 0.f, y, z } );
-		norm.emplace_back( Vec3f{ 0.f, prevY, prevZ } );
+		*norm++ = Vec3f{ 0.f, y, z };
+		*norm++ = Vec3f{ 0.f, y, z };
+		*norm++ = Vec3f{ 0.f, prevY, prevZ };
 
 		if (aCapped)
 		{
-			pos.emplace_back( Vec3f{ 0.f, prevY, prevZ } );
-			pos.emplace_back( Vec3f{ 0.f, 0.f, 0.f } );
-			pos.emplace_back( Vec3f{ 0.f, y, z } );
+			*pos++ = Vec3f{ 0.f, prevY, prevZ };
+			*pos++ = Vec3f{ 0.f, 0.f, 0.f };
+			*pos++ = Vec3f{ 0.f, y, z };
 
-			norm.emplace_back( Vec3f{ -1.f, 0.f, 0.f } );
-			norm.emplace_back( Vec3f{ -1.f, 0.f, 0.f } );
-			norm.emplace_back( Vec3f{ -1.f, 0.f, 0.f } );
+			*norm++ = Vec3f{ -1.f, 0.f, 0.f };
+			*norm++ = Vec3f{ -1.f, 0.f, 0.f };
+			*norm++ = Vec3f{ -1.f, 0.f, 0.f };
 
-			pos.emplace_back( Vec3f{ 1.f, 0.f, 0.f } );
-			pos.emplace_back( Vec3f{ 1.f, prevY, prevZ } );
-			pos.emplace_back( Vec3f{ 1.f, y, z } );
+			*pos++ = Vec3f{ 1.f, 0.f, 0.f };
+			*pos++ = Vec3f{ 1.f, prevY, prevZ };
+			*pos++ = Vec3f{ 1.f, y, z };
 
-			norm.emplace_back( Vec3f{ 1.f, 0.f, 0.f } );
-			norm.emplace_back( Vec3f{ 1.f, 0.f, 0.f } );
-			norm.emplace_back( Vec3f{ 1.f, 0.f, 0.f } );
+			*norm++ = Vec3f{ 1.f, 0.f, 0.f };
+			*norm++ = Vec3f{ 1.f, 0.f, 0.f };
+			*norm++ = Vec3f{ 1.f, 0.f, 0.f };
 		}
 
 		prevY = y;
 		prevZ = z;
 	}
 
-	for( auto& p : pos )
-    {
-        Vec4f p4{ p.x, p.y, p.z, 1.f };
-        Vec4f t = aPreTransform * p4;
-        t /= t.w;
-        p = Vec3f{ t.x, t.y, t.z };
-    }
+	assert( part.positions + count == pos );
+
+	transform_points( aPreTransform, part.positions, pos );
 
-	Mat33f const N = mat44_to_mat33( transpose(invert(aPreTransform)) );
+	Mat33f const N = make_normal_matrix( aPreTransform );
 
-	for( auto& n : norm )
-    {
-        n = N * n;
-    }
+	transform_normals( N, part.normals, norm );
 
-	std::vector col( pos.size(), aColor );
-	return SimpleMeshData{ std::move(pos), std::move(col), std::move(norm) };
+	std::fill_n( part.colors, count, aColor );
+	return part.range;
 }
\ No newline at end of file
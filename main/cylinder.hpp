@@ -6,6 +6,7 @@
 #include <cstdlib>
 
 #include "simple_mesh.hpp"
+#include "mesh_builder.hpp"
 
 #include "../vmlib/vec3.hpp"
 #include "../vmlib/mat44.hpp"
@@ -18,4 +19,16 @@ SimpleMeshData make_cylinder(
 	Mat44f aPreTransform = kIdentity44f
 );
 
+// Number of vertices generated by make_cylinder() and add_cylinder().
+std::size_t cylinder_vertex_count( bool aCapped, std::size_t aSubdivs ) noexcept;
+
+// Generates the cylinder directly into the builder's storage as a new part.
+MeshRange add_cylinder(
+	MeshBuilder& aBuilder,
+	bool aCapped = true,
+	std::size_t aSubdivs = 16,
+	Vec3f aColor = { 1.f, 1.f, 1.f },
+	Mat44f aPreTransform = kIdentity44f
+);
+
 #endif // CYLINDER_HPP_E4D1E8EC_6CDA_4800_ABDD_264F643AF5DB
@@ -1,9 +1,33 @@
 #include "loadobj.hpp"
 
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
 #include <rapidobj/rapidobj.hpp>
 
 #include "../support/error.hpp"
 
+#include "parallel.hpp"
+#include "mapped_file.hpp"
+#include "mesh_optimize.hpp"
+
+namespace {
+    // Faces per conversion task
+    constexpr std::size_t kFacesPerTask_ = 1 << 14;
+
+    // A range of faces of one shape
+    struct ConvertTask_ {
+        rapidobj::Shape const* shape;
+        std::size_t firstFace, faceCount;
+    };
+
+    bool is_blank_(char aChar) {
+        return ' ' == aChar || '\t' == aChar || '\r' == aChar;
+    }
+}
+
 SimpleMeshData load_wavefront_obj(char const* aPath) {
     // Ask rapidobj to load the requested file
     auto result = rapidobj::ParseFile(aPath);
@@ -16,43 +40,157 @@ SimpleMeshData load_wavefront_obj(char const* aPath) {
     // OBJ files can define faces that are not triangles. Triangulate any non-triangular faces.
     rapidobj::Triangulate(result);
 
-    // Convert the OBJ data into a SimpleMeshData structure
+    // Split the faces of all shapes into tasks. Always triangles after
+    // triangulation, so each face has three corners.
+    std::vector<ConvertTask_> tasks;
+    for (auto const& shape : result.shapes) {
+        std::size_t const faceCount = shape.mesh.indices.size() / 3;
+        for (std::size_t face = 0; face < faceCount; face += kFacesPerTask_)
+            tasks.push_back(ConvertTask_{ &shape, face, std::min(kFacesPerTask_, faceCount - face) });
+    }
+
+    // The faces are grouped by material, in the order of the materials and
+    // then in file order. Group materialCount holds the faces without a
+    // material.
+    std::size_t const materialCount = result.materials.size();
+    std::size_t const groupCount = materialCount + 1;
+
+    auto const group_of = [materialCount](std::int32_t aMaterialId) {
+        return aMaterialId >= 0 ? std::size_t(aMaterialId) : materialCount;
+    };
+
+    // Faces per task and group, then where each task writes each group
+    std::vector<std::size_t> cursors(tasks.size() * groupCount);
+
+    parallel_for(tasks.size(), 1, [&](std::size_t aBegin, std::size_t aEnd) {
+        for (std::size_t t = aBegin; t < aEnd; ++t) {
+            auto const& ids = tasks[t].shape->mesh.material_ids;
+            for (std::size_t face = tasks[t].firstFace; face < tasks[t].firstFace + tasks[t].faceCount; ++face)
+                ++cursors[t * groupCount + group_of(ids[face])];
+        }
+    });
+
     SimpleMeshData ret;
 
-    for (auto const& shape : result.shapes) {
-        for (std::size_t i = 0; i < shape.mesh.indices.size(); ++i) {
-            auto const& idx = shape.mesh.indices[i];
-
-            // Extract position, normals and textcoords information
-            ret.positions.emplace_back(Vec3f{
-                result.attributes.positions[idx.position_index * 3 + 0],
-                result.attributes.positions[idx.position_index * 3 + 1],
-                result.attributes.positions[idx.position_index * 3 + 2]
-            });
+    std::size_t faceCount = 0;
+    for (std::size_t g = 0; g < groupCount; ++g) {
+        std::size_t const groupFirst = faceCount;
+        for (std::size_t t = 0; t < tasks.size(); ++t) {
+            std::size_t const count = cursors[t * groupCount + g];
+            cursors[t * groupCount + g] = faceCount;
+            faceCount += count;
+        }
 
-            ret.normals.emplace_back(Vec3f{
-                result.attributes.normals[idx.normal_index * 3 + 0],
-                result.attributes.normals[idx.normal_index * 3 + 1],
-                result.attributes.normals[idx.normal_index * 3 + 2]
+        if (faceCount != groupFirst) {
+            ret.submeshes.push_back(MeshSubmesh{
+                g < materialCount ? std::uint32_t(g) : kNoMaterial,
+                std::uint32_t(groupFirst * 3),
+                std::uint32_t((faceCount - groupFirst) * 3)
             });
+        }
+    }
 
-            if (idx.texcoord_index >= 0) {
-                ret.texcoords.emplace_back(Vec2f{
-                    result.attributes.texcoords[idx.texcoord_index * 2 + 0],
-                    result.attributes.texcoords[idx.texcoord_index * 2 + 1]
-                });
-            }
+    // Faces without texture coordinates get (0,0) if the file has any, so
+    // that all arrays stay the same length.
+    bool const hasTexcoords = !result.attributes.texcoords.empty();
 
-            // Always triangles, so find the face index by dividing the vertex index by three
-            auto const& mat = result.materials[shape.mesh.material_ids[i / 3]];
+    auto const& positions = result.attributes.positions;
+    auto const& normals = result.attributes.normals;
+    auto const& texcoords = result.attributes.texcoords;
 
-            // Replicate the material ambient color for each vertex
-            ret.colors.emplace_back(Vec3f{
-                mat.ambient[0],
-                mat.ambient[1],
-                mat.ambient[2]
-            });
+    // Convert every corner in parallel, then weld identical vertices. The
+    // vertices of different materials are kept apart, so that each vertex
+    // belongs to one submesh.
+    std::vector<WeldVertex> corners(faceCount * 3);
+
+    parallel_for(tasks.size(), 1, [&](std::size_t aBegin, std::size_t aEnd) {
+        for (std::size_t t = aBegin; t < aEnd; ++t) {
+            ConvertTask_ const& task = tasks[t];
+            auto const& mesh = task.shape->mesh;
+
+            std::size_t* const cursor = cursors.data() + t * groupCount;
+
+            for (std::size_t face = task.firstFace; face < task.firstFace + task.faceCount; ++face) {
+                std::size_t const group = group_of(mesh.material_ids[face]);
+                WeldVertex* out = corners.data() + 3 * cursor[group]++;
+
+                // Extract position, normals and textcoords information
+                for (std::size_t corner = 0; corner < 3; ++corner) {
+                    auto const& idx = mesh.indices[face * 3 + corner];
+
+                    *out++ = WeldVertex{
+                        Vec3f{
+                            positions[idx.position_index * 3 + 0],
+                            positions[idx.position_index * 3 + 1],
+                            positions[idx.position_index * 3 + 2]
+                        },
+                        Vec3f{
+                            normals[idx.normal_index * 3 + 0],
+                            normals[idx.normal_index * 3 + 1],
+                            normals[idx.normal_index * 3 + 2]
+                        },
+                        idx.texcoord_index >= 0 ? Vec2f{
+                            texcoords[idx.texcoord_index * 2 + 0],
+                            texcoords[idx.texcoord_index * 2 + 1]
+                        } : Vec2f{ 0.f, 0.f },
+                        Vec3f{ 0.f, 0.f, 0.f },
+                        std::uint32_t(group)
+                    };
+                }
+            }
         }
+    });
+
+    SimpleMeshData welded = weld_vertices(corners, hasTexcoords, false);
+    ret.positions = std::move(welded.positions);
+    ret.normals = std::move(welded.normals);
+    ret.texcoords = std::move(welded.texcoords);
+    ret.indices = std::move(welded.indices);
+
+    // One table entry per material. Texture paths are relative to the OBJ.
+    std::filesystem::path const directory = std::filesystem::path(aPath).parent_path();
+
+    ret.materials.reserve(materialCount);
+    for (auto const& mat : result.materials) {
+        ret.materials.push_back(MeshMaterial{
+            mat.name,
+            Vec3f{ mat.ambient[0], mat.ambient[1], mat.ambient[2] },
+            Vec3f{ mat.diffuse[0], mat.diffuse[1], mat.diffuse[2] },
+            Vec3f{ mat.specular[0], mat.specular[1], mat.specular[2] },
+            mat.shininess,
+            mat.diffuse_texname.empty() ? std::string() : (directory / mat.diffuse_texname).generic_string()
+        });
+    }
+
+    return ret;
+}
+
+std::vector<std::string> wavefront_material_libraries(char const* aPath) {
+    MappedFile const file(aPath);
+    std::string_view const text(static_cast<char const*>(file.data()), file.size());
+
+    // As rapidobj reads it: the rest of the line, trimmed, is one name.
+    std::vector<std::string> ret;
+    for (std::size_t at = text.find("mtllib"); std::string_view::npos != at; at = text.find("mtllib", at + 1)) {
+        std::size_t start = at;
+        while (start > 0 && is_blank_(text[start - 1]))
+            --start;
+        if (start > 0 && '\n' != text[start - 1])
+            continue;
+
+        std::size_t begin = at + 6;
+        if (begin >= text.size() || !is_blank_(text[begin]))
+            continue;
+
+        std::size_t end = std::min(text.find('\n', begin), text.size());
+        while (begin < end && is_blank_(text[begin]))
+            ++begin;
+        while (end > begin && is_blank_(text[end - 1]))
+            --end;
+
+        std::string name(text.substr(begin, end - begin));
+        if (!name.empty() && ret.end() == std::find(ret.begin(), ret.end(), name))
+            ret.push_back(std::move(name));
     }
 
     return ret;
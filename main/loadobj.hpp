@@ -1,8 +1,15 @@
 #ifndef LOADOBJ_HPP_2CF735BE_6624_413E_B6DC_B5BBA337F96F
 #define LOADOBJ_HPP_2CF735BE_6624_413E_B6DC_B5BBA337F96F
 
+#include <string>
+#include <vector>
+
 #include "simple_mesh.hpp"
 
 SimpleMeshData load_wavefront_obj( char const* aPath );
 
+// The material libraries (mtllib) that the OBJ file names, relative to its
+// directory, each once. Reads the file; throws if it cannot be read.
+std::vector<std::string> wavefront_material_libraries( char const* aPath );
+
 #endif // LOADOBJ_HPP_2CF735BE_6624_413E_B6DC_B5BBA337F96F
@@ -1,11 +1,15 @@
 #include <glad.h>
 #include <GLFW/glfw3.h>
 
+#include <string>
+#include <optional>
 #include <typeinfo>
 #include <stdexcept>
+#include <utility>
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstddef>
 
 #include "../support/error.hpp"
 #include "../support/program.hpp"
@@ -15,12 +19,26 @@
 #include "../vmlib/vec4.hpp"
 #include "../vmlib/mat44.hpp"
 #include "../vmlib/mat33.hpp"
+#include "../vmlib/transform.hpp"
+#include "../vmlib/mat44_expr.hpp"
 
 #include "defaults.hpp"
 #include "loadobj.hpp"
 #include "cylinder.hpp"
 #include "cone.hpp"
 #include "cube.hpp"
+#include "primitive_cache.hpp"
+#include "mesh_optimize.hpp"
+#include "mesh_lod.hpp"
+#include "mesh_cluster.hpp"
+#include "buffer_arena.hpp"
+#include "asset_loader.hpp"
+#include "material_table.hpp"
+#include "mesh_cache.hpp"
+#include "stream_ring.hpp"
+#include "texture_cache.hpp"
+#include "texture_stream.hpp"
+#include "uniform_blocks.hpp"
 
 
 namespace
@@ -34,6 +52,10 @@ namespace
 	float kMovementPerSecond_ = 5.f; // units per second
 	// Mouse sensitivity
 	constexpr float kMouseSensitivity_ = 0.01f; // radians per pixel
+	// Time per frame for uploading loaded assets (at least one per frame)
+	constexpr double kAssetUploadBudgetMs_ = 2.0;
+	// Texture data uploaded per frame (a 4K BC7 texture takes 11 frames)
+	constexpr std::size_t kTextureStreamBytesPerFrame_ = 2*1024*1024;
 
 	// Struct to manage different states the applications will be in
 	struct State_
@@ -76,6 +98,14 @@ namespace
 	};
 
 	
+	// A mesh from an OBJ file, once loaded and uploaded
+	struct SceneMesh_
+	{
+		CachedMesh data;
+		ArenaMesh gpu;
+		MaterialTable materials;
+	};
+
 	void glfw_callback_error_( int, char const* );
 
 	void glfw_callback_key_( GLFWwindow*, int, int, int, int );
@@ -96,6 +126,8 @@ namespace
 
 int main() try
 {
+	auto const startupStart = Clock::now();
+
 	// Initialize GLFW
 	if( GLFW_TRUE != glfwInit() )
 	{
@@ -116,7 +148,7 @@ int main() try
 	//glfwWindowHint( GLFW_RESIZABLE, GLFW_FALSE );
 
 	glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
-	glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 3 );
+	glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 5 );
 	glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE );
 	glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
 
@@ -203,6 +235,11 @@ int main() try
 		{ GL_FRAGMENT_SHADER, "assets/mat.frag" }
 	} );
 
+	ShaderProgram progInstanced( {
+		{ GL_VERTEX_SHADER, "assets/mat_instanced.vert" },
+		{ GL_FRAGMENT_SHADER, "assets/mat.frag" }
+	} );
+
 	// Define the shader programs
 	state.prog = &prog;
 	state.progMat = &progMat;
@@ -217,73 +254,196 @@ int main() try
 	OGL_CHECKPOINT_ALWAYS();
 	
 
-// ***************************************************************
-	auto land = load_wavefront_obj("assets/parlahti.obj");
-	auto pad = load_wavefront_obj("assets/landingpad.obj");
-	GLuint tex = load_texture_2d("assets/L4343A-4k.jpeg");
-
 // SPACESHIP CODE
 // ----------------------------------------------------------------
-	// Make the objects for the ship and concatenate them
-	auto mainBody = make_cylinder( true, 16, {0.9098f, 0.5137f, 0.0627f},
-		make_scaling( 0.7f, 0.1f, 0.1f )
-	);
-	auto topCone = make_cone( true, 16, {1.f, 1.f, 1.f},
-		make_scaling( 0.13f, 0.1f, 0.1f ) * make_translation( { 5.385f, 0.f, 0.f } )
-	);
-	auto topConnect = concatenate( std::move(mainBody), topCone );
+	// The ship is made of unit primitives, each generated once and drawn
+	// instanced with a per-part transform and colour.
+	PrimitiveCache primitives;
+	MeshRange const cylinder = primitives.get( PrimitiveShape::cylinder, 16, true );
+	MeshRange const cone = primitives.get( PrimitiveShape::cone, 16, true );
+	MeshRange const cube = primitives.get( PrimitiveShape::cube );
+
+	PrimitiveParts shipParts;
+
+	// Main body
+	shipParts.add( cylinder, make_scaling( 0.7f, 0.1f, 0.1f ), {0.9098f, 0.5137f, 0.0627f} );
+	shipParts.add( cone, make_scaling( 0.13f, 0.1f, 0.1f ) * make_translation( { 5.385f, 0.f, 0.f } ), {1.f, 1.f, 1.f} );
+	shipParts.add( cube, make_scaling( 0.24f, 0.2f, 0.2f ) * make_translation( { -0.5f, 0.f, 0.f } ), {0.9098f, 0.5137f, 0.0627f} );
+	shipParts.add( cone, make_scaling( 0.2f, 0.1f, 0.1f ) * make_translation( { -1.6f, 0.f, 0.f } ), {0.01f, 0.01f, 0.01f} );
+
+	// Side rockets
+	shipParts.add( cylinder, make_scaling( 0.7f, 0.08f, 0.08f ) * make_translation( { -0.4f, 2.25f, 0.f } ), {1.f, 1.f, 1.f} );
+	shipParts.add( cone, make_scaling( 0.08f, 0.08f, 0.08f ) * make_translation( { 5.25f, 2.25f, 0.f } ), {0.01f, 0.01f, 0.01f} );
+	shipParts.add( cone, make_scaling( 0.2f, 0.08f, 0.08f ) * make_translation( { -1.8f, 2.25f, 0.f } ), {0.01f, 0.01f, 0.01f} );
+
+	shipParts.add( cylinder, make_scaling( 0.7f, 0.08f, 0.08f ) * make_translation( { -0.4f, -2.25f, 0.f } ), {1.f, 1.f, 1.f} );
+	shipParts.add( cone, make_scaling( 0.08f, 0.08f, 0.08f ) * make_translation( { 5.25f, -2.25f, 0.f } ), {0.01f, 0.01f, 0.01f} );
+	shipParts.add( cone, make_scaling( 0.2f, 0.08f, 0.08f ) * make_translation( { -1.8f, -2.25f, 0.f } ), {0.01f, 0.01f, 0.01f} );
+
+	// The terrain and the pad are processed once and cached beside their
+	// OBJ files (see mesh_cache.hpp). Processing:
+	//   - optimize for the vertex cache, overdraw and vertex fetch,
+	//   - split into clusters that are culled on their own (only the full
+	//     detail level is clustered),
+	//   - build the levels of detail; the indices of all levels end up in
+	//     one element buffer per mesh.
+	// (The primitives of the ship are optimized by the primitive cache.)
+	auto const processMesh = [] (char const* aName) {
+		return [aName] (SimpleMeshData&& aMesh) {
+			MeshOptimizeReport const report = optimize_mesh( aMesh );
+			std::printf( "%s: %zu -> %zu vertices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", aName,
+				report.verticesBefore, report.verticesAfter,
+				report.before.acmr, report.after.acmr,
+				report.before.atvr, report.after.atvr
+			);
 
-	auto baseCube = make_cube( {0.9098f, 0.5137f, 0.0627f},
-		make_scaling( 0.24f, 0.2f, 0.2f ) * make_translation( { -0.5f, 0.f, 0.f } )
-	);
-	auto bottomConnect = concatenate( std::move(topConnect), baseCube );
+			ClusteredMeshData clustered = make_clustered_mesh( std::move(aMesh) );
 
-	auto mainThruster = make_cone( true, 16, {0.01f, 0.01f, 0.01f},
-		make_scaling( 0.2f, 0.1f, 0.1f ) * make_translation( { -1.6f, 0.f, 0.f } )
-	);
-	auto mainRocket = concatenate( std::move(bottomConnect), mainThruster );
+			ProcessedMesh ret;
+			ret.lods = build_lod_chain( clustered.mesh );
+			ret.mesh = std::move(clustered.mesh);
+			ret.clusters = std::move(clustered.clusters);
+			return ret;
+		};
+	};
 
-	auto sideBody1 = make_cylinder( true, 16, {1.f, 1.f, 1.f},
-		make_scaling( 0.7f, 0.08f, 0.08f ) * make_translation( { -0.4f, 2.25f, 0.f } )
-	);
-	auto sideRocketStep1 = concatenate( std::move(mainRocket), sideBody1 );
+	auto const loadMesh = [&] (char const* aName, char const* aPath) {
+		auto const start = Clock::now();
 
-	auto sideCone1 = make_cone( true, 16, {0.01f, 0.01f, 0.01f},
-		make_scaling( 0.08f, 0.08f, 0.08f ) * make_translation( { 5.25f, 2.25f, 0.f } )
-	);
-	auto sideRocketStep2 = concatenate( std::move(sideRocketStep1), sideCone1 );
+		bool hit = false;
+		CachedMesh ret = load_wavefront_obj_cached( aPath, processMesh( aName ), &hit );
 
-	auto sideThruster1 = make_cone( true, 16, {0.01f, 0.01f, 0.01f},
-		make_scaling( 0.2f, 0.08f, 0.08f ) * make_translation( { -1.8f, 2.25f, 0.f } )
-	);
-	auto sideRocketStep3 = concatenate( std::move(sideRocketStep2), sideThruster1 );
+		float const ms = std::chrono::duration_cast<Secondsf>(Clock::now() - start).count() * 1000.f;
+		std::printf( "%s: %s in %.1f ms (%zu clusters)\n", aName,
+			hit ? "mapped from cache" : "parsed and processed OBJ", ms, ret.clusters().size()
+		);
+		return ret;
+	};
 
-	auto sideBody2 = make_cylinder( true, 16, {1.f, 1.f, 1.f},
-		make_scaling( 0.7f, 0.08f, 0.08f ) * make_translation( { -0.4f, -2.25f, 0.f } )
-	);
-	auto sideRocketStep4 = concatenate( std::move(sideRocketStep3), sideBody2 );
+	auto const printLods = [] (char const* aName, MeshLodChain const& aChain) {
+		for( std::size_t i = 0; i < aChain.levels.size(); ++i )
+		{
+			std::printf( "%s LOD %zu: %zu triangles, error %g\n", aName, i,
+				aChain.levels[i].indexCount / 3, aChain.levels[i].error
+			);
+		}
+	};
+
+	auto const printMeshSize = [] (char const* aName, MeshView const& aMesh, auto aFormat) {
+		std::printf( "%s: %zu vertices, %zu indices, %zu bytes\n", aName,
+			aMesh.positions.size(), aMesh.indices.size(),
+			aMesh.positions.size() * vertex_size( aMesh, aFormat ) + aMesh.indices.size() * sizeof(std::uint32_t)
+		);
+	};
+
+	auto const printArenas = [] (MeshArenas const& aArenas) {
+		ArenaStats const arenaStats = aArenas.stats();
+		std::printf( "arenas: %zu meshes in %zu blocks, %zu of %zu bytes used, largest free %zu bytes, fragmentation %.2f\n",
+			arenaStats.meshes, arenaStats.blocks, arenaStats.used, arenaStats.capacity, arenaStats.largestFree, arenaStats.fragmentation
+		);
+	};
 
-	auto sideCone2 = make_cone( true, 16, {0.01f, 0.01f, 0.01f},
-		make_scaling( 0.08f, 0.08f, 0.08f ) * make_translation( { 5.25f, -2.25f, 0.f } )
+	// Upload the objects into shared buffers, one arena per vertex layout.
+	// The terrain is too large for half float positions; the pad (within
+	// +-0.5) and the unit primitives are not.
+	MeshArenas arenas;
+	ArenaMesh const shipGpu = arenas.add( primitives.mesh(), PrimitiveVertexFormat{} );
+	attach_instances( shipGpu.vao, shipParts.instances() );
+
+	MeshView const primitiveMesh = primitives.mesh();
+	std::printf( "primitives: %zu vertices, %zu indices, %zu bytes; ship: %zu instances, %zu bytes\n",
+		primitiveMesh.positions.size(), primitiveMesh.indices.size(),
+		primitiveMesh.positions.size() * vertex_size( primitiveMesh, PrimitiveVertexFormat{} ) + primitiveMesh.indices.size() * sizeof(std::uint32_t),
+		shipParts.instances().size(), shipParts.instances().size() * sizeof(PrimitiveInstance)
 	);
-	auto sideRocketStep5 = concatenate( std::move(sideRocketStep4), sideCone2 );
 
-	auto sideThruster2 = make_cone( true, 16, {0.01f, 0.01f, 0.01f},
-		make_scaling( 0.2f, 0.08f, 0.08f ) * make_translation( { -1.8f, -2.25f, 0.f } )
+	// The terrain, the pad and the terrain's texture are loaded in the
+	// background while the window is up. Until they arrive, the terrain is
+	// textured with a plain white placeholder and the meshes are skipped.
+	std::optional<SceneMesh_> land, pad;
+	GLuint tex = load_texture_2d( "assets/white.png" );
+
+	auto const diffuseMap = [] (CachedMesh const& aMesh, char const* aFallback) {
+		for( auto const& mat : aMesh.materials() )
+		{
+			if( !mat.diffuseMap.empty() )
+				return mat.diffuseMap;
+		}
+		return std::string( aFallback );
+	};
+
+	// Uploads the mesh into the arenas, with its material table (each
+	// submesh is drawn with its material).
+	auto const uploadMesh = [&] (char const* aName, CachedMesh&& aMesh, auto aFormat) {
+		printLods( aName, aMesh.lods() );
+		printMeshSize( aName, aMesh.mesh(), aFormat );
+
+		ArenaMesh const gpu = arenas.add( aMesh.mesh(), aFormat );
+		MaterialTable materials( aMesh.materials() );
+		printArenas( arenas );
+
+		return SceneMesh_{ std::move(aMesh), gpu, std::move(materials) };
+	};
+
+	// Textures are baked to a block compressed mip chain once and cached
+	// beside the image; the format depends on the context (GL thread).
+	BlockFormat const textureFormat = preferred_block_format();
+	std::printf( "Textures: %s\n", BlockFormat::bc1 == textureFormat ? "BC1" : "BC7" );
+
+	// Textures are streamed in from their smallest level once loaded; tex
+	// is sampled while it sharpens.
+	TextureStreamer textures( kTextureStreamBytesPerFrame_ );
+
+	AssetLoader loader;
+
+	// The terrain's texture is the diffuse map of its material; it is
+	// loaded as soon as the terrain is known.
+	loader.load( "terrain",
+		[&] {
+			CachedMesh mesh = loadMesh( "terrain", "assets/parlahti.obj" );
+			loader.load( "terrain texture",
+				[path = diffuseMap( mesh, "assets/L4343A-4k.jpeg" ), textureFormat] {
+					bool hit = false;
+					CachedTexture texture = load_texture_cached( path.c_str(), textureFormat, &hit );
+					std::printf( "Texture '%s': %zux%zu, %zu levels, %.1f MB (%s)\n", path.c_str(), texture.width(), texture.height(), texture.level_count(), texture.size() / (1024.0 * 1024.0), hit ? "cached" : "baked" );
+					return texture;
+				},
+				[&] (CachedTexture&& aTexture) {
+					glDeleteTextures( 1, &tex );
+					tex = textures.add( std::move(aTexture) );
+				}
+			);
+			return mesh;
+		},
+		[&] (CachedMesh&& aMesh) { land.emplace( uploadMesh( "terrain", std::move(aMesh), VertexPacked{} ) ); }
+	);
+	loader.load( "pad",
+		[&] { return loadMesh( "pad", "assets/landingpad.obj" ); },
+		[&] (CachedMesh&& aMesh) { pad.emplace( uploadMesh( "pad", std::move(aMesh), VertexCompact{} ) ); }
 	);
-	auto ship = concatenate( std::move(sideRocketStep5), sideThruster2 );
 
-	 
+	// All meshes are indexed after optimize_mesh(); the terrain and the pad
+	// are drawn per level of detail, one draw per submesh. At full detail,
+	// only their visible clusters are drawn.
+	auto const drawLod = [] (SceneMesh_ const& aMesh, std::size_t aLevel, ClusterDrawList const& aVisible) {
+		if( 0 == aLevel )
+		{
+			aVisible.draw( aMesh.gpu, aMesh.materials );
+			return;
+		}
 
-	// Create the vaos for the objects
-	GLuint vao = create_vao( land );
-	GLuint vaoPad =  create_vao( pad );
-	GLuint vaoShip = create_vao( ship );
+		for( auto const& submesh : aMesh.data.lods().levels[aLevel].submeshes )
+		{
+			aMesh.materials.bind( submesh.material );
+			draw_arena_mesh( aMesh.gpu, submesh.firstIndex, submesh.indexCount );
+		}
+	};
+
+	ClusterDrawList landVisible, padVisible2, padVisible3;
 
-	// Assign vertex counts
-	std::size_t vertexCount = land.positions.size();
-	std::size_t vertexCountPad = pad.positions.size();
-	std::size_t vertexCountShip = ship.positions.size();
+	// Uniform blocks of each frame (one light block, four object blocks);
+	// triple buffered.
+	StreamRing ring( 16*1024 );
 
 	OGL_CHECKPOINT_ALWAYS();
 
@@ -308,6 +468,10 @@ int main() try
 
 		// Let GLFW process events
 		glfwPollEvents();
+
+		// Upload the assets that have finished loading
+		AssetUploadStats const& uploads = loader.pump( kAssetUploadBudgetMs_ );
+		TextureStreamStats const& streamed = textures.pump();
 		
 		// Check if window was resized.
 		float fbwidth, fbheight;
@@ -350,7 +514,7 @@ int main() try
 		if( state.camControl.actionMoveForward )
 		{
 			// this vector points in the direction the camera is facing
-			Vec3f directionVector = normalize(Vec3f
+			Vec3f directionVector = normalize<FastMath>(Vec3f
 			{
 				std::sin(state.camControl.phi),
 			 	std::sin(state.camControl.theta),
@@ -367,7 +531,7 @@ int main() try
 		if( state.camControl.actionMoveBack )
 		{
 			// this vector points in the direction the camera is facing
-			Vec3f directionVector = normalize(Vec3f
+			Vec3f directionVector = normalize<FastMath>(Vec3f
 			{
 				std::sin(state.camControl.phi),
 			 	std::sin(state.camControl.theta),
@@ -388,7 +552,7 @@ int main() try
 			// initialise the up vector of the camera this will be constant
 			Vec3f upVector = {0.0f, 1.0f, 0.0f};
 			// initialise the direction vector like before
-			Vec3f directionVector = normalize(Vec3f
+			Vec3f directionVector = normalize<FastMath>(Vec3f
 			{
 				std::sin(state.camControl.phi),
 			 	std::sin(state.camControl.theta),
@@ -410,7 +574,7 @@ int main() try
 			// initialise the up vector of the camera this will be constant
 			Vec3f upVector = {0.0f, 1.0f, 0.0f};
 			// initialise the direction vector like before
-			Vec3f directionVector = normalize(Vec3f
+			Vec3f directionVector = normalize<FastMath>(Vec3f
 			{
 				std::sin(state.camControl.phi),
 			 	std::sin(state.camControl.theta),
@@ -446,8 +610,9 @@ int main() try
 			kMovementPerSecond_ = kMovementPerSecond_ * 0.5;
 		}
 
-		// Model to world for the spaceship
-		Mat44f model2world4 ;
+		// Model to world for the spaceship. Kept as a Transform during the
+		// animation and converted to a matrix once below.
+		Transform ship2world{ {}, make_quat_rotation_z(1.5708f), { 1.f, 1.f, 1.f } };
 
 		if (state.animationActive)
 		{
@@ -464,8 +629,7 @@ int main() try
 
 			// Updating positions and rotaions for the first 5 seconds
 			if(animationTime < 5) {
-				model2world4 =  make_translation( { -5.7f, -0.6f + animationDistance, -2.f} );
-				model2world4 = model2world4 * make_rotation_z(1.5708f);
+				ship2world.t = { -5.7f, -0.6f + animationDistance, -2.f};
 				// Fixed following camera
 				if((state.currentCam == 1)) {
 					state.camControl.cameraPos.x = -11.7f;
@@ -485,9 +649,8 @@ int main() try
 			}
 			// Positions for the next 5 seconds
 			else if(animationTime > 5 && animationTime < 10) {
-				model2world4 =  make_translation( { -5.7f, -0.6f + animationDistance, -2.f- zIncrease} );
-				model2world4 = model2world4 * make_rotation_z(1.5708f);
-				model2world4 = model2world4 * make_rotation_y(rotationIncrease);
+				ship2world.t = { -5.7f, -0.6f + animationDistance, -2.f- zIncrease};
+				ship2world.r = ship2world.r * make_quat_rotation_y(rotationIncrease);
 				// Fixed camera
 				if((state.currentCam == 1)) {
 					state.camControl.cameraPos.x = -11.7f;
@@ -508,9 +671,8 @@ int main() try
 			else{
 				// Rest of the animation
 				rotationIncrease = 5.f * std::atan(0.0125f*(5));
-				model2world4 =  make_translation( { -5.7f, -0.6f + animationDistance, -2.f - zIncrease} );
-				model2world4 = model2world4 * make_rotation_z(1.5708f);
-				model2world4 = model2world4 * make_rotation_y(rotationIncrease);
+				ship2world.t = { -5.7f, -0.6f + animationDistance, -2.f - zIncrease};
+				ship2world.r = ship2world.r * make_quat_rotation_y(rotationIncrease);
 				// FIxed camera
 				if((state.currentCam == 1)) {
 					state.camControl.cameraPos.x = -11.7f;
@@ -537,31 +699,33 @@ int main() try
 		}
 		else {
 			// Reset ship positions
-			model2world4 =  make_translation( { -5.7f, -0.6f, -2.f } );
-			model2world4 = model2world4 * make_rotation_z(1.5708f);
+			ship2world.t = { -5.7f, -0.6f, -2.f };
 		}
 
+		Mat44f model2world4 = to_mat44( ship2world );
+
 		// Model for the map
 		Mat44f model2world =  make_translation( { 0.f, 0.f, 0.f } );
-		Mat33f normalMatrix = mat44_to_mat33( transpose(invert(model2world)) );
+		Mat33f normalMatrix = make_normal_matrix( model2world );
 		
 		// Components for the cameras translation matrix
-		Mat44f Rx = make_rotation_x( state.camControl.theta );
-		Mat44f Ry = make_rotation_y( state.camControl.phi );
-		Mat44f T = make_translation(-state.camControl.cameraPos);
+		Quatf camRotation = make_quat_rotation_x( state.camControl.theta ) * make_quat_rotation_y( state.camControl.phi );
 
 		// Translatuion matrix for the xamera
-		Mat44f world2camera = Rx * Ry * T;
+		Mat44f world2camera = to_mat44( Transform{ camRotation * -state.camControl.cameraPos, camRotation, { 1.f, 1.f, 1.f } } );
 
 		// Projection
-		Mat44f projection = make_perspective_projection(
+		Perspective44f projection = make_perspective44f(
 			60.f * 3.1415926f / 180.f,
 			fbwidth/float(fbheight),
 			0.1f, 100.0f
 		);
 
+		// Projection and camera are the same for all objects
+		Mat44f projCamera = projection * world2camera;
+
 		// ProjcameraWorld to be added to the uniform matrix
-		Mat44f projCameraWorld = projection * world2camera * model2world;
+		Mat44f projCameraWorld = projCamera * model2world;
 
 		// End query to track task 2 render time
 		glEndQuery(GL_TIME_ELAPSED);
@@ -578,14 +742,16 @@ int main() try
 		glBeginQuery(GL_TIME_ELAPSED, task4Time);
 
 		// Add the first launchpad to the world
-		Mat44f model2world2 =  make_translation( { -24.5f, -0.97f, -54.f } );
-		Mat33f normalMatrix2 = mat44_to_mat33( transpose(invert(model2world2)) );
-		Mat44f projCameraWorld2 = projection * world2camera * model2world2;
+		Translation44f launchpad2world2{ { -24.5f, -0.97f, -54.f } };
+		Mat44f model2world2 =  to_mat44( launchpad2world2 );
+		Mat33f normalMatrix2 = make_normal_matrix( model2world2 );
+		Mat44f projCameraWorld2 = projCamera * launchpad2world2;
 
 		// Add the second launchpad to the world
-		Mat44f model2world3 =  make_translation( { -5.7f, -0.97f, -2.f } );
-		Mat33f normalMatrix3 = mat44_to_mat33( transpose(invert(model2world3)) );
-		Mat44f projCameraWorld3 = projection * world2camera * model2world3;
+		Translation44f launchpad2world3{ { -5.7f, -0.97f, -2.f } };
+		Mat44f model2world3 =  to_mat44( launchpad2world3 );
+		Mat33f normalMatrix3 = make_normal_matrix( model2world3 );
+		Mat44f projCameraWorld3 = projCamera * launchpad2world3;
 
 		// End query to track task 4 render time
 		glEndQuery(GL_TIME_ELAPSED);
@@ -600,8 +766,8 @@ int main() try
 		glBeginQuery(GL_TIME_ELAPSED, task5Time);
 
 		// nNOrmal matrix to be passed into shader
-		Mat33f normalMatrix4 = mat44_to_mat33( transpose(invert(model2world4)) );
-		Mat44f projCameraWorld4 = projection * world2camera * model2world4;
+		Mat33f normalMatrix4 = make_normal_matrix( model2world4 );
+		Mat44f projCameraWorld4 = projCamera * model2world4;
 
 		// End query to track task 5 render time
 		glEndQuery(GL_TIME_ELAPSED);
@@ -617,291 +783,112 @@ int main() try
 		// Defining variable for CPU clock
 		auto renderCommandsStart = std::chrono::high_resolution_clock::now();
 
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Using default frag/vert
-		glUseProgram(prog.programId());
-		
-		// Main world
-		glUniformMatrix4fv(
-			0,
-			1, GL_TRUE, projCameraWorld.v
-		);
-
-		// Applying textures
-		glActiveTexture( GL_TEXTURE0 );
-		glBindTexture( GL_TEXTURE_2D, tex );
-
-		// Normals for main world
-		glUniformMatrix3fv(
-			1,
-			1, GL_TRUE, normalMatrix.v
-		);
-
-		// Bind vao and draw
-		glBindVertexArray(vao);
-		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertexCount));
-		glBindVertexArray(0);
-
-		// Set uniform values for lighting in the fragment shader
-		Vec3f lightDir = normalize(Vec3f{ 0.f, 1.f, -1.f });
-		glUniform3fv(2, 1, &lightDir.x);
-		glUniform3f(3, 0.9f, 0.9f, 0.6f);
-		glUniform3f(4, 0.1f, 0.1f, 0.1f);
-
-		// Define positions for point lights and pass into default shader
-		Vec3f pointLightPos{ model2world4(0,3), model2world4(1,3), model2world4(2,3)};  // Replace with the actual position of your point light 
-		Vec3f pointLightViewPos1{model2world4(0,3), model2world4(1,3), model2world4(2,3)};
-		glUniform3fv(5, 1, &pointLightPos.x);
-		glUniform3fv(6, 1, &pointLightViewPos1.x);
-
-
-		Vec3f pointLightPos2{model2world4(0,3), model2world4(1,3)+2.25f, model2world4(2,3)};
-		Vec3f pointLightViewPos2{model2world4(0,3), model2world4(1,3), model2world4(2,3)};
-		glUniform3fv(7, 1, &pointLightPos2.x);
-		glUniform3fv(8, 1, &pointLightViewPos2.x);
-
-		Vec3f pointLightPos3{model2world4(0,3), model2world4(1,3)-2.25f, model2world4(2,3)};
-		Vec3f pointLightViewPos3{model2world4(0,3), model2world4(1,3), model2world4(2,3)};
-		glUniform3fv(9, 1, &pointLightPos3.x);
-		glUniform3fv(10, 1, &pointLightViewPos3.x);
-
-
-		// Using mat frag/vert
-		glUseProgram(progMat.programId());
-
-
-		// Landing pad 1 
-		glUniformMatrix4fv(
-			0,
-			1, GL_TRUE, projCameraWorld2.v
-		);
-
-		glUniformMatrix3fv(
-			1,
-			1, GL_TRUE, normalMatrix2.v
-		);
-
-		glUniformMatrix4fv(
-			11,
-			1, GL_TRUE, model2world2.v
-		);
-
-
-		// Bind vao and draw
-		glBindVertexArray(vaoPad);
-		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertexCountPad));
-		glBindVertexArray(0);
-
-
-		// Landing pad 2
-		glUniformMatrix4fv(
-			0,
-			1, GL_TRUE, projCameraWorld3.v
-		);
-
-		glUniformMatrix3fv(
-			1,
-			1, GL_TRUE, normalMatrix3.v
-		);
+		// Pick the levels of detail from the projected error. Both views of
+		// the split screen use the same camera and viewport height.
+		float const lodPixelScale = lod_pixel_scale( 60.f * 3.1415926f / 180.f, fbheight );
+		std::size_t landLod = 0, padLod2 = 0, padLod3 = 0;
 
-		glUniformMatrix4fv(
-			11,
-			1, GL_TRUE, model2world3.v
-		);
-
-		// Bind vao and draw
-		glBindVertexArray(vaoPad);
-		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertexCountPad));
-		glBindVertexArray(0);
-
-
-		// Ship
-		glUniformMatrix4fv(
-			0,
-			1, GL_TRUE, projCameraWorld4.v
-		);
-
-		glUniformMatrix3fv(
-			1,
-			1, GL_TRUE, normalMatrix4.v
-		);
-
-		glUniformMatrix4fv(
-			11,
-			1, GL_TRUE, model2world4.v
-		);
-
-		// Bind vao and draw
-		glBindVertexArray(vaoShip);
-		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertexCountShip));
-		glBindVertexArray(0);
-		
-		// Set uniform values for lighting in the fragment shader
-		Vec3f lightDir2 = normalize(Vec3f{ 0.f, 1.f, -1.f });
-		glUniform3fv(2, 1, &lightDir2.x);
-
-		// Directional light for materials
-		glUniform3f(3, 0.9f, 0.9f, 0.6f);
-		glUniform3f(4, 0.05f, 0.05f, 0.05f); 
-
-
-		// Reference positions for point lights and pass into mat shader
-		glUniform3fv(5, 1, &pointLightPos.x);
-		glUniform3fv(6, 1, &pointLightViewPos1.x);
-
-		glUniform3fv(7, 1, &pointLightPos2.x);
-		glUniform3fv(8, 1, &pointLightViewPos2.x);
-
-		glUniform3fv(9, 1, &pointLightPos3.x);
-		glUniform3fv(10, 1, &pointLightViewPos3.x);
-
-
-		// If split screen is active
-		if (state.splitActive) {
-			// Change viewport
-			glViewport( nwidth/2, 0, nwidth/2, nheight );
-			
-			// Draw everything again in that viewport
+		// Cull the clusters of the objects at full detail. Both views of the
+		// split screen use the same matrices.
+		if( land )
+		{
+			landLod = select_lod( land->data.lods(), model2world, state.camControl.cameraPos, lodPixelScale );
+			if( 0 == landLod )
+				landVisible.cull( land->data.clusters(), land->data.submeshes(), projCameraWorld, model2world, state.camControl.cameraPos );
+		}
+		if( pad )
+		{
+			padLod2 = select_lod( pad->data.lods(), model2world2, state.camControl.cameraPos, lodPixelScale );
+			padLod3 = select_lod( pad->data.lods(), model2world3, state.camControl.cameraPos, lodPixelScale );
+			if( 0 == padLod2 )
+				padVisible2.cull( pad->data.clusters(), pad->data.submeshes(), projCameraWorld2, model2world2, state.camControl.cameraPos );
+			if( 0 == padLod3 )
+				padVisible3.cull( pad->data.clusters(), pad->data.submeshes(), projCameraWorld3, model2world3, state.camControl.cameraPos );
+		}
 
+		// Lights and per-object uniforms for this frame, written straight
+		// into the stream ring. Both views of the split screen use the same
+		// blocks.
+		ring.begin_frame();
+
+		// Directional light, and point lights around the ship
+		LightUniforms lights;
+		lights.lightDir = to_std140( normalize(Vec3f{ 0.f, 1.f, -1.f }) );
+		lights.lightDiffuse = to_std140( { 0.9f, 0.9f, 0.6f } );
+
+		Vec3f const shipPos{ model2world4(0,3), model2world4(1,3), model2world4(2,3) };
+		lights.pointLightPos1 = to_std140( shipPos );
+		lights.pointLightViewPos1 = to_std140( shipPos );
+		lights.pointLightPos2 = to_std140( shipPos + Vec3f{ 0.f, 2.25f, 0.f } );
+		lights.pointLightViewPos2 = to_std140( shipPos );
+		lights.pointLightPos3 = to_std140( shipPos - Vec3f{ 0.f, 2.25f, 0.f } );
+		lights.pointLightViewPos3 = to_std140( shipPos );
+
+		StreamAllocation const lightBlock = stream_uniforms( ring, lights );
+		StreamAllocation const landBlock = stream_object_uniforms( ring, projCameraWorld, model2world, normalMatrix );
+		StreamAllocation const padBlock2 = stream_object_uniforms( ring, projCameraWorld2, model2world2, normalMatrix2 );
+		StreamAllocation const padBlock3 = stream_object_uniforms( ring, projCameraWorld3, model2world3, normalMatrix3 );
+		StreamAllocation const shipBlock = stream_object_uniforms( ring, projCameraWorld4, model2world4, normalMatrix4 );
+
+		bind_uniforms( kLightBlockBinding, ring, lightBlock );
+
+		auto const drawScene = [&] {
 			// Using default frag/vert
 			glUseProgram(prog.programId());
-			
-			// Main world
-			glUniformMatrix4fv(
-				0,
-				1, GL_TRUE, projCameraWorld.v
-			);
+			glUniform3f(4, 0.1f, 0.1f, 0.1f);
 
 			// Applying textures
 			glActiveTexture( GL_TEXTURE0 );
 			glBindTexture( GL_TEXTURE_2D, tex );
 
-			// Normals for main world
-			glUniformMatrix3fv(
-				1,
-				1, GL_TRUE, normalMatrix.v
-			);
-
-			// Bind vao and draw
-			glBindVertexArray(vao);
-			glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertexCount));
-			glBindVertexArray(0);
-
-			// Set uniform values for lighting in the fragment shader
-			Vec3f lightDir = normalize(Vec3f{ 0.f, 1.f, -1.f });
-			glUniform3fv(2, 1, &lightDir.x);
-			glUniform3f(3, 0.9f, 0.9f, 0.6f);
-			glUniform3f(4, 0.1f, 0.1f, 0.1f);
-
-			// Define positions for point lights and pass into default shader
-			Vec3f pointLightPos{ model2world4(0,3), model2world4(1,3), model2world4(2,3)};  // Replace with the actual position of your point light 
-			Vec3f pointLightViewPos1{model2world4(0,3), model2world4(1,3), model2world4(2,3)};
-			glUniform3fv(5, 1, &pointLightPos.x);
-			glUniform3fv(6, 1, &pointLightViewPos1.x);
-
-
-			Vec3f pointLightPos2{model2world4(0,3), model2world4(1,3)+2.25f, model2world4(2,3)};
-			Vec3f pointLightViewPos2{model2world4(0,3), model2world4(1,3), model2world4(2,3)};
-			glUniform3fv(7, 1, &pointLightPos2.x);
-			glUniform3fv(8, 1, &pointLightViewPos2.x);
-
-			Vec3f pointLightPos3{model2world4(0,3), model2world4(1,3)-2.25f, model2world4(2,3)};
-			Vec3f pointLightViewPos3{model2world4(0,3), model2world4(1,3), model2world4(2,3)};
-			glUniform3fv(9, 1, &pointLightPos3.x);
-			glUniform3fv(10, 1, &pointLightViewPos3.x);
-
+			// Main world
+			if( land )
+			{
+				bind_uniforms( kObjectBlockBinding, ring, landBlock );
+				glBindVertexArray(land->gpu.vao);
+				drawLod( *land, landLod, landVisible );
+				glBindVertexArray(0);
+			}
 
 			// Using mat frag/vert
 			glUseProgram(progMat.programId());
+			glUniform3f(4, 0.05f, 0.05f, 0.05f);
 
+			if( pad )
+			{
+				// Landing pad 1
+				bind_uniforms( kObjectBlockBinding, ring, padBlock2 );
+				glBindVertexArray(pad->gpu.vao);
+				drawLod( *pad, padLod2, padVisible2 );
+
+				// Landing pad 2
+				bind_uniforms( kObjectBlockBinding, ring, padBlock3 );
+				drawLod( *pad, padLod3, padVisible3 );
+				glBindVertexArray(0);
+			}
 
-			// Landing pad 1 
-			glUniformMatrix4fv(
-				0,
-				1, GL_TRUE, projCameraWorld2.v
-			);
-
-			glUniformMatrix3fv(
-				1,
-				1, GL_TRUE, normalMatrix2.v
-			);
-
-			glUniformMatrix4fv(
-				11,
-				1, GL_TRUE, model2world2.v
-			);
-
-
-			// Bind vao and draw
-			glBindVertexArray(vaoPad);
-			glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertexCountPad));
-			glBindVertexArray(0);
-
-
-			// Landing pad 2
-			glUniformMatrix4fv(
-				0,
-				1, GL_TRUE, projCameraWorld3.v
-			);
-
-			glUniformMatrix3fv(
-				1,
-				1, GL_TRUE, normalMatrix3.v
-			);
-
-			glUniformMatrix4fv(
-				11,
-				1, GL_TRUE, model2world3.v
-			);
-
-			// Bind vao and draw
-			glBindVertexArray(vaoPad);
-			glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertexCountPad));
-			glBindVertexArray(0);
-
-
-			// Ship
-			glUniformMatrix4fv(
-				0,
-				1, GL_TRUE, projCameraWorld4.v
-			);
-
-			glUniformMatrix3fv(
-				1,
-				1, GL_TRUE, normalMatrix4.v
-			);
-
-			glUniformMatrix4fv(
-				11,
-				1, GL_TRUE, model2world4.v
-			);
+			// Ship, drawn from instanced primitives with the material lighting
+			glUseProgram(progInstanced.programId());
+			glUniform3f(4, 0.05f, 0.05f, 0.05f);
 
-			// Bind vao and draw
-			glBindVertexArray(vaoShip);
-			glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertexCountShip));
+			bind_uniforms( kObjectBlockBinding, ring, shipBlock );
+			glBindVertexArray(shipGpu.vao);
+			draw_instanced( shipParts, shipGpu );
 			glBindVertexArray(0);
-			
-			// Set uniform values for lighting in the fragment shader
-			Vec3f lightDir2 = normalize(Vec3f{ 0.f, 1.f, -1.f });
-			glUniform3fv(2, 1, &lightDir2.x);
-
-			// Directional light for materials
-			glUniform3f(3, 0.9f, 0.9f, 0.6f);
-			glUniform3f(4, 0.05f, 0.05f, 0.05f); 
-
+		};
 
-			// Reference positions for point lights and pass into mat shader
-			glUniform3fv(5, 1, &pointLightPos.x);
-			glUniform3fv(6, 1, &pointLightViewPos1.x);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			glUniform3fv(7, 1, &pointLightPos2.x);
-			glUniform3fv(8, 1, &pointLightViewPos2.x);
+		drawScene();
 
-			glUniform3fv(9, 1, &pointLightPos3.x);
-			glUniform3fv(10, 1, &pointLightViewPos3.x);
+		// If split screen is active, draw everything again in the other
+		// half of the window
+		if (state.splitActive) {
+			glViewport( nwidth/2, 0, nwidth/2, nheight );
+			drawScene();
 		}
 
+		ring.end_frame();
 		OGL_CHECKPOINT_DEBUG();
 
 		// End query to track frame render time
@@ -913,6 +900,22 @@ int main() try
 		// Print time to render frame in terminal
 		std::printf("Frame - Full Rendering Time: %.9f ms\n", frameTimeFloat * 1e-6);
 
+		StreamStats const& ringStats = ring.stats();
+		std::printf("Frame - Streamed uniforms: %zu bytes (peak %zu of %zu), %llu stalls (%.3f ms)\n",
+			ringStats.bytesLastFrame, ringStats.bytesPeak, ringStats.bytesPerFrame,
+			static_cast<unsigned long long>(ringStats.stalls), ringStats.stallMilliseconds
+		);
+
+		std::printf("Frame - Asset uploads: %zu (%.3f ms, peak %.3f ms), %zu loaded, %zu pending\n",
+			uploads.uploadsLastFrame, uploads.millisecondsLastFrame, uploads.millisecondsPeak,
+			uploads.loaded, uploads.pending
+		);
+
+		std::printf("Frame - Texture streaming: %zu bytes (%.3f ms, peak %.3f ms), %zu bytes and %zu levels so far, %zu pending\n",
+			streamed.bytesLastFrame, streamed.millisecondsLastFrame, streamed.millisecondsPeak,
+			streamed.bytesTotal, streamed.levelsTotal, streamed.pending
+		);
+
 		// Logic to get cpu tick rate, convert to ms and print to term
 		auto frameToFrameEnd = std::chrono::high_resolution_clock::now();
 		std::chrono::duration<float> frameToFrameTime = frameToFrameEnd - frameToFramePrev;
@@ -927,6 +930,9 @@ int main() try
 		// Display results
 		glfwSwapBuffers( window );
 
+		if( 1 == uploads.frames )
+			std::printf( "first frame after %.1f ms\n", std::chrono::duration_cast<Secondsf>(Clock::now() - startupStart).count() * 1000.f );
+
 		// Logic to get cpu tick rate, convert to ms and print to term
 		auto renderCommandsEnd = std::chrono::high_resolution_clock::now();
 		std::chrono::duration<float> renderCommandsTime = renderCommandsEnd - renderCommandsStart;
@@ -0,0 +1,114 @@
+#include "mapped_file.hpp"
+
+#include <utility>
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+
+#include "../support/error.hpp"
+
+#if defined(_WIN32)
+MappedFile::MappedFile( char const* aPath )
+{
+	HANDLE file = CreateFileA( aPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( INVALID_HANDLE_VALUE == file )
+		throw Error( "MappedFile: unable to open '%s' (%lu)", aPath, GetLastError() );
+
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx( file, &size ) )
+	{
+		CloseHandle( file );
+		throw Error( "MappedFile: unable to get the size of '%s' (%lu)", aPath, GetLastError() );
+	}
+
+	mSize = std::size_t(size.QuadPart);
+	if( 0 == mSize )
+	{
+		CloseHandle( file );
+		return;
+	}
+
+	// The view keeps the file open; the handles are not needed after this.
+	HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	CloseHandle( file );
+	if( !mapping )
+		throw Error( "MappedFile: unable to map '%s' (%lu)", aPath, GetLastError() );
+
+	mData = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );
+	if( !mData )
+		throw Error( "MappedFile: unable to map '%s' (%lu)", aPath, GetLastError() );
+}
+
+void MappedFile::release_() noexcept
+{
+	if( mData )
+		UnmapViewOfFile( mData );
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+#else // POSIX
+MappedFile::MappedFile( char const* aPath )
+{
+	int const fd = ::open( aPath, O_RDONLY );
+	if( -1 == fd )
+		throw Error( "MappedFile: unable to open '%s'", aPath );
+
+	struct stat st;
+	if( -1 == ::fstat( fd, &st ) )
+	{
+		::close( fd );
+		throw Error( "MappedFile: unable to stat '%s'", aPath );
+	}
+
+	mSize = std::size_t(st.st_size);
+	if( 0 == mSize )
+	{
+		::close( fd );
+		return;
+	}
+
+	// The mapping keeps the file open; the descriptor is not needed after this.
+	void* data = ::mmap( nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+	::close( fd );
+	if( MAP_FAILED == data )
+		throw Error( "MappedFile: unable to map '%s'", aPath );
+
+	mData = data;
+}
+
+void MappedFile::release_() noexcept
+{
+	if( mData )
+		::munmap( mData, mSize );
+
+	mData = nullptr;
+	mSize = 0;
+}
+#endif // ~ _WIN32
+
+MappedFile::~MappedFile()
+{
+	release_();
+}
+
+MappedFile::MappedFile( MappedFile&& aOther ) noexcept
+	: mData( std::exchange( aOther.mData, nullptr ) )
+	, mSize( std::exchange( aOther.mSize, 0 ) )
+{}
+MappedFile& MappedFile::operator= (MappedFile&& aOther) noexcept
+{
+	std::swap( mData, aOther.mData );
+	std::swap( mSize, aOther.mSize );
+	return *this;
+}
@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_HPP_78E673C1_2804_4651_AB11_39229E8A29EA
+#define MAPPED_FILE_HPP_78E673C1_2804_4651_AB11_39229E8A29EA
+
+#include <cstddef>
+
+/** MappedFile: read-only memory mapping of a whole file
+ *
+ * Maps the file with mmap() (or CreateFileMapping() on Windows). The pages
+ * are read from disk on first access, so data() can be handed to OpenGL or
+ * parsed without reading the file first. Throws if the file cannot be
+ * opened or mapped. An empty file maps to data() == nullptr.
+ */
+class MappedFile final
+{
+	public:
+		MappedFile() noexcept = default;
+		explicit MappedFile( char const* aPath );
+		~MappedFile();
+
+		MappedFile( MappedFile const& ) = delete;
+		MappedFile& operator= (MappedFile const&) = delete;
+
+		MappedFile( MappedFile&& ) noexcept;
+		MappedFile& operator= (MappedFile&&) noexcept;
+
+	public:
+		void const* data() const noexcept { return mData; }
+		std::size_t size() const noexcept { return mSize; }
+
+	private:
+		void release_() noexcept;
+
+		void* mData = nullptr;
+		std::size_t mSize = 0;
+};
+
+#endif // MAPPED_FILE_HPP_78E673C1_2804_4651_AB11_39229E8A29EA
@@ -0,0 +1,69 @@
+#include "material_table.hpp"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include <cassert>
+#include <cstring>
+
+#include "uniform_blocks.hpp"
+
+MaterialTable::MaterialTable( ArrayView<MeshMaterial> aMaterials )
+	: mCount( aMaterials.size() )
+{
+	GLint alignment = 0;
+	glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment );
+
+	std::size_t const align = std::size_t(std::max( alignment, 1 ));
+	mStride = (sizeof(MaterialUniforms) + align - 1) / align * align;
+
+	// The materials, then the default
+	std::vector<unsigned char> data( (mCount + 1) * mStride );
+
+	auto const write = [&] (std::size_t aIndex, Vec3f aAmbient, Vec3f aDiffuse, Vec3f aSpecular, float aShininess) {
+		MaterialUniforms const record{
+			Vec4f{ aAmbient.x, aAmbient.y, aAmbient.z, 1.f },
+			Vec4f{ aDiffuse.x, aDiffuse.y, aDiffuse.z, 1.f },
+			Vec4f{ aSpecular.x, aSpecular.y, aSpecular.z, aShininess }
+		};
+		std::memcpy( data.data() + aIndex * mStride, &record, sizeof(record) );
+	};
+
+	for( std::size_t i = 0; i < mCount; ++i )
+	{
+		MeshMaterial const& mat = aMaterials[i];
+		write( i, mat.ambient, mat.diffuse, mat.specular, mat.shininess );
+	}
+
+	write( mCount, Vec3f{ 1.f, 1.f, 1.f }, Vec3f{ 1.f, 1.f, 1.f }, Vec3f{ 0.f, 0.f, 0.f }, 1.f );
+
+	glCreateBuffers( 1, &mBuffer );
+	glNamedBufferStorage( mBuffer, GLsizeiptr(data.size()), data.data(), 0 );
+}
+
+MaterialTable::~MaterialTable()
+{
+	glDeleteBuffers( 1, &mBuffer );
+}
+
+MaterialTable::MaterialTable( MaterialTable&& aOther ) noexcept
+	: mBuffer( std::exchange( aOther.mBuffer, 0 ) )
+	, mStride( aOther.mStride )
+	, mCount( aOther.mCount )
+{}
+MaterialTable& MaterialTable::operator= (MaterialTable&& aOther) noexcept
+{
+	std::swap( mBuffer, aOther.mBuffer );
+	std::swap( mStride, aOther.mStride );
+	std::swap( mCount, aOther.mCount );
+	return *this;
+}
+
+void MaterialTable::bind( std::uint32_t aMaterial ) const
+{
+	assert( kNoMaterial == aMaterial || aMaterial < mCount );
+
+	std::size_t const index = kNoMaterial == aMaterial ? mCount : aMaterial;
+	glBindBufferRange( GL_UNIFORM_BUFFER, kMaterialBlockBinding, mBuffer, GLintptr(index * mStride), GLsizeiptr(sizeof(MaterialUniforms)) );
+}
@@ -0,0 +1,40 @@
+#ifndef MATERIAL_TABLE_HPP_55853ABB_EF6F_44E8_8E09_01B4C2D48600
+#define MATERIAL_TABLE_HPP_55853ABB_EF6F_44E8_8E09_01B4C2D48600
+
+#include <glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simple_mesh.hpp"
+
+/** MaterialTable: the materials of a mesh in one uniform buffer
+ *
+ * One MaterialUniforms record (see uniform_blocks.hpp) per material, and a
+ * white default for kNoMaterial, each at the uniform buffer offset
+ * alignment. bind() binds one record to kMaterialBlockBinding before the
+ * submeshes of that material are drawn. Static; requires OpenGL 4.5.
+ */
+class MaterialTable final
+{
+	public:
+		explicit MaterialTable( ArrayView<MeshMaterial> );
+		~MaterialTable();
+
+		MaterialTable( MaterialTable const& ) = delete;
+		MaterialTable& operator= (MaterialTable const&) = delete;
+
+		MaterialTable( MaterialTable&& ) noexcept;
+		MaterialTable& operator= (MaterialTable&&) noexcept;
+
+	public:
+		void bind( std::uint32_t aMaterial ) const;
+
+		std::size_t size() const noexcept { return mCount; }
+
+	private:
+		GLuint mBuffer = 0;
+		std::size_t mStride = 0, mCount = 0;
+};
+
+#endif // MATERIAL_TABLE_HPP_55853ABB_EF6F_44E8_8E09_01B4C2D48600
@@ -0,0 +1,113 @@
+#include "mesh_builder.hpp"
+
+#include <utility>
+
+#include <cassert>
+
+MeshBuilder::MeshBuilder( SimpleMeshData aMesh )
+	: mMesh( std::move(aMesh) )
+{
+	if( !mMesh.positions.empty() )
+		mParts.emplace_back( MeshRange{ 0, mMesh.positions.size(), 0, mMesh.indices.size() } );
+}
+
+void MeshBuilder::reserve( std::size_t aVertexCount, std::size_t aIndexCount )
+{
+	mMesh.positions.reserve( aVertexCount );
+	mMesh.colors.reserve( aVertexCount );
+	mMesh.normals.reserve( aVertexCount );
+	if( !mMesh.texcoords.empty() )
+		mMesh.texcoords.reserve( aVertexCount );
+	if( aIndexCount )
+		mMesh.indices.reserve( aIndexCount );
+}
+
+MeshBuilder::Part MeshBuilder::add_part( std::size_t aVertexCount )
+{
+	std::size_t const first = mMesh.positions.size();
+	std::size_t const firstIndex = mMesh.indices.size();
+
+	mMesh.positions.resize( first + aVertexCount );
+	mMesh.colors.resize( first + aVertexCount );
+	mMesh.normals.resize( first + aVertexCount );
+	if( !mMesh.texcoords.empty() )
+		mMesh.texcoords.resize( first + aVertexCount, Vec2f{ 0.f, 0.f } );
+
+	if( !mMesh.indices.empty() )
+		index_vertices_( first, aVertexCount );
+
+	MeshRange const range{ first, aVertexCount, firstIndex, mMesh.indices.size() - firstIndex };
+	mParts.emplace_back( range );
+
+	return Part{
+		range,
+		mMesh.positions.data() + first,
+		mMesh.colors.data() + first,
+		mMesh.normals.data() + first,
+		mMesh.texcoords.empty() ? nullptr : mMesh.texcoords.data() + first
+	};
+}
+
+MeshRange MeshBuilder::append( MeshView const& aMesh )
+{
+	std::size_t const first = mMesh.positions.size();
+	std::size_t const count = aMesh.positions.size();
+
+	assert( aMesh.colors.size() == count );
+	assert( aMesh.normals.size() == count );
+	assert( aMesh.texcoords.empty() || aMesh.texcoords.size() == count );
+
+	// Indices first: if this is the first indexed part, the existing
+	// vertices need indices too.
+	if( !aMesh.indices.empty() && mMesh.indices.empty() )
+	{
+		index_vertices_( 0, first );
+		for( auto& part : mParts )
+		{
+			part.firstIndex = part.firstVertex;
+			part.indexCount = part.vertexCount;
+		}
+	}
+
+	std::size_t const firstIndex = mMesh.indices.size();
+	if( !aMesh.indices.empty() )
+	{
+		for( auto const i : aMesh.indices )
+			mMesh.indices.emplace_back( std::uint32_t(first + i) );
+	}
+	else if( !mMesh.indices.empty() )
+	{
+		index_vertices_( first, count );
+	}
+
+	// Texture coordinates: same as above
+	if( !aMesh.texcoords.empty() && mMesh.texcoords.empty() )
+		mMesh.texcoords.resize( first, Vec2f{ 0.f, 0.f } );
+
+	if( !aMesh.texcoords.empty() )
+		mMesh.texcoords.insert( mMesh.texcoords.end(), aMesh.texcoords.begin(), aMesh.texcoords.end() );
+	else if( !mMesh.texcoords.empty() )
+		mMesh.texcoords.resize( first + count, Vec2f{ 0.f, 0.f } );
+
+	mMesh.positions.insert( mMesh.positions.end(), aMesh.positions.begin(), aMesh.positions.end() );
+	mMesh.colors.insert( mMesh.colors.end(), aMesh.colors.begin(), aMesh.colors.end() );
+	mMesh.normals.insert( mMesh.normals.end(), aMesh.normals.begin(), aMesh.normals.end() );
+
+	MeshRange const range{ first, count, firstIndex, mMesh.indices.size() - firstIndex };
+	mParts.emplace_back( range );
+	return range;
+}
+
+SimpleMeshData MeshBuilder::release()
+{
+	SimpleMeshData ret = std::move(mMesh);
+	mMesh = SimpleMeshData{};
+	mParts.clear();
+	return ret;
+}
+
+void MeshBuilder::index_vertices_( std::size_t aFirst, std::size_t aCount )
+{
+	for( std::size_t i = 0; i < aCount; ++i )
+		mMesh.indices.emplace_back( std::uint32_t(aFirst + i) );
+}
@@ -0,0 +1,86 @@
+#ifndef MESH_BUILDER_HPP_D5DB4525_D79C_4D9C_A46B_ED48C31ECA45
+#define MESH_BUILDER_HPP_D5DB4525_D79C_4D9C_A46B_ED48C31ECA45
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simple_mesh.hpp"
+
+// Vertices [firstVertex, firstVertex+vertexCount) and, for indexed meshes,
+// indices [firstIndex, firstIndex+indexCount) of one part of a mesh. For
+// non-indexed meshes, indexCount is zero.
+struct MeshRange
+{
+	std::size_t firstVertex, vertexCount;
+	std::size_t firstIndex, indexCount;
+};
+
+/** MeshBuilder: assembles one mesh from many parts
+ *
+ * Replaces chains of concatenate(), which copy the growing mesh for every
+ * part. Reserve once for all parts, then either let generators write
+ * directly into the storage (add_part(), used by add_cylinder() & co.) or
+ * append existing meshes (append()). Each part's range is recorded.
+ *
+ * Texture coordinates and indices are kept consistent across parts: once a
+ * part has texture coordinates, parts without get (0,0); once a part is
+ * indexed, non-indexed parts get the indices 0, 1, 2, ... (offset to their
+ * first vertex).
+ *
+ * Example:
+ *   MeshBuilder builder;
+ *   builder.reserve( cylinder_vertex_count( true, 16 ) + kCubeVertexCount );
+ *   add_cylinder( builder, true, 16, color, T0 );
+ *   add_cube( builder, color, T1 );
+ *   GLuint vao = create_vao( builder.view() );
+ */
+class MeshBuilder final
+{
+	public:
+		// Storage for a part that is generated in place. The pointers are
+		// valid until the next change to the builder. texcoords is null if
+		// the mesh has no texture coordinates.
+		struct Part
+		{
+			MeshRange range;
+			Vec3f* positions;
+			Vec3f* colors;
+			Vec3f* normals;
+			Vec2f* texcoords;
+		};
+
+	public:
+		MeshBuilder() = default;
+
+		// Starts with aMesh as the first part.
+		explicit MeshBuilder( SimpleMeshData aMesh );
+
+	public:
+		void reserve( std::size_t aVertexCount, std::size_t aIndexCount = 0 );
+
+		// Adds a non-indexed part with aVertexCount vertices. The caller
+		// fills in the returned storage.
+		Part add_part( std::size_t aVertexCount );
+
+		// Adds a copy of aMesh as a new part.
+		MeshRange append( MeshView const& aMesh );
+
+	public:
+		std::vector<MeshRange> const& parts() const noexcept { return mParts; }
+
+		MeshView view() const noexcept { return MeshView( mMesh ); }
+
+		// Moves the mesh out. The builder is empty afterwards.
+		SimpleMeshData release();
+
+	private:
+		void index_vertices_( std::size_t aFirst, std::size_t aCount );
+
+	private:
+		SimpleMeshData mMesh;
+		std::vector<MeshRange> mParts;
+};
+
+#endif // MESH_BUILDER_HPP_D5DB4525_D79C_4D9C_A46B_ED48C31ECA45
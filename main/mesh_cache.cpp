@@ -0,0 +1,436 @@
+#include "mesh_cache.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <type_traits>
+#include <system_error>
+
+#include <cstring>
+
+namespace
+{
+	constexpr char kMagic_[8] = { 'M', 'E', 'S', 'H', 'C', 'A', 'C', 'H' };
+	constexpr std::size_t kAlignment_ = 16;
+
+	enum Section_ : std::size_t
+	{
+		positions_,
+		colors_,
+		normals_,
+		texcoords_,
+		indices_,
+		clusters_,
+		lods_,
+		submeshes_,
+		lodSubmeshes_,
+		materials_,
+		dependencies_,
+		strings_,
+		sectionCount_
+	};
+
+	struct SectionHeader_
+	{
+		std::uint64_t offset, count, elementSize;
+	};
+
+	struct FileHeader_
+	{
+		char magic[8];
+		std::uint32_t version, headerSize;
+
+		std::uint64_t sourceSize;
+		std::int64_t sourceTime;
+		std::uint64_t sourceHash;
+
+		float aabbMin[3], aabbMax[3];
+		float lodCenter[3], lodRadius;
+
+		SectionHeader_ sections[sectionCount_];
+	};
+
+	// MeshLod with fixed-size fields; its submeshes are in lodSubmeshes_.
+	struct LodRecord_
+	{
+		std::uint64_t firstIndex, indexCount;
+		std::uint32_t firstSubmesh, submeshCount;
+		float error;
+		std::uint32_t pad;
+	};
+
+	// MeshMaterial with fixed-size fields; the strings are in strings_.
+	struct MaterialRecord_
+	{
+		float ambient[3], diffuse[3], specular[3];
+		float shininess;
+
+		std::uint64_t nameOffset, nameSize;
+		std::uint64_t diffuseMapOffset, diffuseMapSize;
+	};
+
+	// MeshCacheDependency with fixed-size fields; the name is in strings_.
+	struct DependencyRecord_
+	{
+		std::uint64_t size;
+		std::int64_t time;
+		std::uint64_t hash;
+
+		std::uint64_t nameOffset, nameSize;
+	};
+
+	static_assert( std::is_trivially_copyable_v<Meshlet> && std::is_trivially_copyable_v<MeshSubmesh> );
+	static_assert( sizeof(Vec3f) == 3*sizeof(float) && sizeof(Vec2f) == 2*sizeof(float) );
+
+	constexpr std::size_t kElementSizes_[sectionCount_] = {
+		sizeof(Vec3f), sizeof(Vec3f), sizeof(Vec3f), sizeof(Vec2f),
+		sizeof(std::uint32_t), sizeof(Meshlet), sizeof(LodRecord_),
+		sizeof(MeshSubmesh), sizeof(MeshSubmesh), sizeof(MaterialRecord_), sizeof(DependencyRecord_),
+		sizeof(char)
+	};
+
+	std::size_t align_( std::size_t aOffset ) noexcept
+	{
+		return (aOffset + kAlignment_ - 1) / kAlignment_ * kAlignment_;
+	}
+
+	void bounds_( ArrayView<Vec3f> aPositions, Vec3f& aMin, Vec3f& aMax ) noexcept
+	{
+		aMin = aMax = aPositions.empty() ? Vec3f{} : aPositions[0];
+		for( auto const& p : aPositions )
+		{
+			aMin = Vec3f{ std::min( aMin.x, p.x ), std::min( aMin.y, p.y ), std::min( aMin.z, p.z ) };
+			aMax = Vec3f{ std::max( aMax.x, p.x ), std::max( aMax.y, p.y ), std::max( aMax.z, p.z ) };
+		}
+	}
+
+	template< typename tType >
+	ArrayView<tType> section_view_( MappedFile const& aFile, SectionHeader_ const& aSection ) noexcept
+	{
+		auto const* base = static_cast<unsigned char const*>(aFile.data());
+		return ArrayView<tType>( reinterpret_cast<tType const*>(base + aSection.offset), std::size_t(aSection.count) );
+	}
+
+	// Throws unless the submeshes lie within the indices and use one of the
+	// materials.
+	void check_submeshes_( ArrayView<MeshSubmesh> aSubmeshes, std::size_t aIndexCount, std::size_t aMaterialCount, char const* aPath )
+	{
+		for( auto const& submesh : aSubmeshes )
+		{
+			if( submesh.firstIndex > aIndexCount || submesh.indexCount > aIndexCount - submesh.firstIndex )
+				throw Error( "CachedMesh: submesh out of range in '%s'", aPath );
+			if( kNoMaterial != submesh.material && submesh.material >= aMaterialCount )
+				throw Error( "CachedMesh: submesh with unknown material in '%s'", aPath );
+		}
+	}
+
+	void write_padding_( std::FILE* aOut, std::size_t& aOffset )
+	{
+		static constexpr char kZeros[kAlignment_] = {};
+
+		std::size_t const aligned = align_( aOffset );
+		if( aligned != aOffset && 1 != std::fwrite( kZeros, aligned - aOffset, 1, aOut ) )
+			throw Error( "write_mesh_cache(): write failed" );
+
+		aOffset = aligned;
+	}
+}
+
+std::vector<MeshCacheDependency> mesh_cache_dependencies( char const* aObjPath )
+{
+	std::filesystem::path const directory = std::filesystem::path( aObjPath ).parent_path();
+
+	std::vector<MeshCacheDependency> ret;
+	for( auto& name : wavefront_material_libraries( aObjPath ) )
+	{
+		CacheSource const source = cache_source( (directory / name).string().c_str() );
+		ret.emplace_back( MeshCacheDependency{ std::move(name), source } );
+	}
+
+	return ret;
+}
+
+
+CachedMesh::CachedMesh( char const* aCachePath )
+	: mFile( aCachePath )
+{
+	FileHeader_ header;
+	if( mFile.size() < sizeof(header) )
+		throw Error( "CachedMesh: '%s' is too small for a mesh cache", aCachePath );
+
+	std::memcpy( &header, mFile.data(), sizeof(header) );
+	if( 0 != std::memcmp( header.magic, kMagic_, sizeof(kMagic_) ) )
+		throw Error( "CachedMesh: '%s' is not a mesh cache", aCachePath );
+	if( kMeshCacheVersion != header.version || sizeof(header) != header.headerSize )
+		throw Error( "CachedMesh: '%s' has version %u, expected %u", aCachePath, header.version, kMeshCacheVersion );
+
+	for( std::size_t i = 0; i < sectionCount_; ++i )
+	{
+		SectionHeader_ const& section = header.sections[i];
+		if( kElementSizes_[i] != section.elementSize || 0 != section.offset % kAlignment_ )
+			throw Error( "CachedMesh: section %zu of '%s' has an unexpected layout", i, aCachePath );
+		if( section.offset > mFile.size() || section.count > (mFile.size() - section.offset) / section.elementSize )
+			throw Error( "CachedMesh: section %zu of '%s' is truncated", i, aCachePath );
+	}
+
+	mSource = CacheSource{ header.sourceSize, header.sourceTime, header.sourceHash };
+
+	mMesh.positions = section_view_<Vec3f>( mFile, header.sections[positions_] );
+	mMesh.colors = section_view_<Vec3f>( mFile, header.sections[colors_] );
+	mMesh.normals = section_view_<Vec3f>( mFile, header.sections[normals_] );
+	mMesh.texcoords = section_view_<Vec2f>( mFile, header.sections[texcoords_] );
+	mMesh.indices = section_view_<std::uint32_t>( mFile, header.sections[indices_] );
+	mClusters = section_view_<Meshlet>( mFile, header.sections[clusters_] );
+	mSubmeshes = section_view_<MeshSubmesh>( mFile, header.sections[submeshes_] );
+
+	// Optional streams are empty or have one element per vertex.
+	std::size_t const vertexCount = mMesh.positions.size();
+	for( std::size_t count : { mMesh.colors.size(), mMesh.normals.size(), mMesh.texcoords.size() } )
+	{
+		if( 0 != count && vertexCount != count )
+			throw Error( "CachedMesh: '%s' has %zu vertices but a stream with %zu", aCachePath, vertexCount, count );
+	}
+
+	std::size_t const indexCount = mMesh.indices.size();
+	for( auto const& cluster : mClusters )
+	{
+		if( cluster.firstIndex > indexCount || cluster.indexCount > indexCount - cluster.firstIndex )
+			throw Error( "CachedMesh: cluster out of range in '%s'", aCachePath );
+	}
+
+	auto const strings = section_view_<char>( mFile, header.sections[strings_] );
+	auto const string = [&] (std::uint64_t aOffset, std::uint64_t aSize) {
+		if( aOffset > strings.size() || aSize > strings.size() - aOffset )
+			throw Error( "CachedMesh: name out of range in '%s'", aCachePath );
+		return std::string( strings.data() + aOffset, std::size_t(aSize) );
+	};
+
+	for( auto const& record : section_view_<MaterialRecord_>( mFile, header.sections[materials_] ) )
+	{
+		mMaterials.emplace_back( MeshMaterial{
+			string( record.nameOffset, record.nameSize ),
+			Vec3f{ record.ambient[0], record.ambient[1], record.ambient[2] },
+			Vec3f{ record.diffuse[0], record.diffuse[1], record.diffuse[2] },
+			Vec3f{ record.specular[0], record.specular[1], record.specular[2] },
+			record.shininess,
+			string( record.diffuseMapOffset, record.diffuseMapSize )
+		} );
+	}
+
+	for( auto const& record : section_view_<DependencyRecord_>( mFile, header.sections[dependencies_] ) )
+	{
+		mDependencies.emplace_back( MeshCacheDependency{
+			string( record.nameOffset, record.nameSize ),
+			CacheSource{ record.size, record.time, record.hash }
+		} );
+	}
+
+	check_submeshes_( mSubmeshes, indexCount, mMaterials.size(), aCachePath );
+
+	auto const lodSubmeshes = section_view_<MeshSubmesh>( mFile, header.sections[lodSubmeshes_] );
+	check_submeshes_( lodSubmeshes, indexCount, mMaterials.size(), aCachePath );
+
+	for( auto const& record : section_view_<LodRecord_>( mFile, header.sections[lods_] ) )
+	{
+		if( record.firstIndex > indexCount || record.indexCount > indexCount - record.firstIndex )
+			throw Error( "CachedMesh: level of detail out of range in '%s'", aCachePath );
+		if( record.firstSubmesh > lodSubmeshes.size() || record.submeshCount > lodSubmeshes.size() - record.firstSubmesh )
+			throw Error( "CachedMesh: level of detail with submeshes out of range in '%s'", aCachePath );
+
+		auto const* submeshes = lodSubmeshes.data() + record.firstSubmesh;
+		mLods.levels.emplace_back( MeshLod{
+			std::size_t(record.firstIndex), std::size_t(record.indexCount), record.error,
+			std::vector<MeshSubmesh>( submeshes, submeshes + record.submeshCount )
+		} );
+	}
+
+	mLods.center = Vec3f{ header.lodCenter[0], header.lodCenter[1], header.lodCenter[2] };
+	mLods.radius = header.lodRadius;
+
+	mAabbMin = Vec3f{ header.aabbMin[0], header.aabbMin[1], header.aabbMin[2] };
+	mAabbMax = Vec3f{ header.aabbMax[0], header.aabbMax[1], header.aabbMax[2] };
+}
+
+CachedMesh::CachedMesh( ProcessedMesh&& aMesh, CacheSource const& aSource, std::vector<MeshCacheDependency> aDependencies )
+	: mOwned( std::make_unique<ProcessedMesh>( std::move(aMesh) ) )
+	, mSource( aSource )
+	, mDependencies( std::move(aDependencies) )
+	, mMesh( mOwned->mesh )
+	, mClusters( mOwned->clusters )
+	, mSubmeshes( mOwned->mesh.submeshes )
+	, mMaterials( mOwned->mesh.materials )
+	, mLods( mOwned->lods )
+{
+	bounds_( mMesh.positions, mAabbMin, mAabbMax );
+}
+
+
+void write_mesh_cache( char const* aCachePath, CacheSource const& aSource, std::vector<MeshCacheDependency> const& aDependencies, ProcessedMesh const& aMesh )
+{
+	SimpleMeshData const& mesh = aMesh.mesh;
+
+	std::vector<LodRecord_> lods;
+	std::vector<MeshSubmesh> lodSubmeshes;
+	lods.reserve( aMesh.lods.levels.size() );
+	for( auto const& level : aMesh.lods.levels )
+	{
+		lods.emplace_back( LodRecord_{
+			level.firstIndex, level.indexCount,
+			std::uint32_t(lodSubmeshes.size()), std::uint32_t(level.submeshes.size()),
+			level.error, 0
+		} );
+		lodSubmeshes.insert( lodSubmeshes.end(), level.submeshes.begin(), level.submeshes.end() );
+	}
+
+	std::vector<MaterialRecord_> materials;
+	std::string strings;
+	materials.reserve( mesh.materials.size() );
+	for( auto const& mat : mesh.materials )
+	{
+		MaterialRecord_ record{
+			{ mat.ambient.x, mat.ambient.y, mat.ambient.z },
+			{ mat.diffuse.x, mat.diffuse.y, mat.diffuse.z },
+			{ mat.specular.x, mat.specular.y, mat.specular.z },
+			mat.shininess,
+			strings.size(), mat.name.size(),
+			strings.size() + mat.name.size(), mat.diffuseMap.size()
+		};
+		materials.emplace_back( record );
+		strings += mat.name;
+		strings += mat.diffuseMap;
+	}
+
+	std::vector<DependencyRecord_> dependencies;
+	dependencies.reserve( aDependencies.size() );
+	for( auto const& dep : aDependencies )
+	{
+		dependencies.emplace_back( DependencyRecord_{
+			dep.source.size, dep.source.time, dep.source.hash,
+			strings.size(), dep.name.size()
+		} );
+		strings += dep.name;
+	}
+
+	struct Stream_ { void const* data; std::size_t count; };
+	Stream_ const streams[sectionCount_] = {
+		{ mesh.positions.data(), mesh.positions.size() },
+		{ mesh.colors.data(), mesh.colors.size() },
+		{ mesh.normals.data(), mesh.normals.size() },
+		{ mesh.texcoords.data(), mesh.texcoords.size() },
+		{ mesh.indices.data(), mesh.indices.size() },
+		{ aMesh.clusters.data(), aMesh.clusters.size() },
+		{ lods.data(), lods.size() },
+		{ mesh.submeshes.data(), mesh.submeshes.size() },
+		{ lodSubmeshes.data(), lodSubmeshes.size() },
+		{ materials.data(), materials.size() },
+		{ dependencies.data(), dependencies.size() },
+		{ strings.data(), strings.size() }
+	};
+
+	// Header
+	FileHeader_ header{};
+	std::memcpy( header.magic, kMagic_, sizeof(kMagic_) );
+	header.version = kMeshCacheVersion;
+	header.headerSize = sizeof(header);
+
+	header.sourceSize = aSource.size;
+	header.sourceTime = aSource.time;
+	header.sourceHash = aSource.hash;
+
+	Vec3f lo, hi;
+	bounds_( mesh.positions, lo, hi );
+
+	header.aabbMin[0] = lo.x; header.aabbMin[1] = lo.y; header.aabbMin[2] = lo.z;
+	header.aabbMax[0] = hi.x; header.aabbMax[1] = hi.y; header.aabbMax[2] = hi.z;
+	header.lodCenter[0] = aMesh.lods.center.x;
+	header.lodCenter[1] = aMesh.lods.center.y;
+	header.lodCenter[2] = aMesh.lods.center.z;
+	header.lodRadius = aMesh.lods.radius;
+
+	std::size_t offset = align_( sizeof(header) );
+	for( std::size_t i = 0; i < sectionCount_; ++i )
+	{
+		header.sections[i] = SectionHeader_{ offset, streams[i].count, kElementSizes_[i] };
+		offset = align_( offset + streams[i].count * kElementSizes_[i] );
+	}
+
+	// Write to a temporary file, then replace the cache
+	std::string const tempPath = std::string(aCachePath) + ".tmp";
+
+	std::FILE* out = std::fopen( tempPath.c_str(), "wb" );
+	if( !out )
+		throw Error( "write_mesh_cache(): unable to open '%s' for writing", tempPath.c_str() );
+
+	try
+	{
+		if( 1 != std::fwrite( &header, sizeof(header), 1, out ) )
+			throw Error( "write_mesh_cache(): write to '%s' failed", tempPath.c_str() );
+
+		std::size_t written = sizeof(header);
+		for( std::size_t i = 0; i < sectionCount_; ++i )
+		{
+			write_padding_( out, written );
+
+			std::size_t const bytes = streams[i].count * kElementSizes_[i];
+			if( bytes && 1 != std::fwrite( streams[i].data, bytes, 1, out ) )
+				throw Error( "write_mesh_cache(): write to '%s' failed", tempPath.c_str() );
+
+			written += bytes;
+		}
+		write_padding_( out, written );
+	}
+	catch( ... )
+	{
+		std::fclose( out );
+		std::remove( tempPath.c_str() );
+		throw;
+	}
+
+	if( 0 != std::fclose( out ) )
+	{
+		std::remove( tempPath.c_str() );
+		throw Error( "write_mesh_cache(): unable to finish writing '%s'", tempPath.c_str() );
+	}
+
+	std::error_code err;
+	std::filesystem::rename( tempPath, aCachePath, err );
+	if( err )
+	{
+		std::remove( tempPath.c_str() );
+		throw Error( "write_mesh_cache(): unable to replace '%s': %s", aCachePath, err.message().c_str() );
+	}
+}
+
+std::optional<CachedMesh> open_mesh_cache( char const* aCachePath, char const* aSourcePath, std::optional<CacheSource>* aSource )
+{
+	std::error_code err;
+	if( !std::filesystem::is_regular_file( aCachePath, err ) )
+		return std::nullopt;
+
+	std::optional<CachedMesh> ret;
+	try
+	{
+		ret.emplace( aCachePath );
+	}
+	catch( Error const& )
+	{
+		// Invalid or from an older version; rebuilt by the caller
+		return std::nullopt;
+	}
+
+	if( !cache_source_current( ret->source(), aSourcePath, aSource ) )
+		return std::nullopt;
+
+	std::filesystem::path const directory = std::filesystem::path( aSourcePath ).parent_path();
+	for( auto const& dep : ret->dependencies() )
+	{
+		if( !cache_source_current( dep.source, (directory / dep.name).string().c_str() ) )
+			return std::nullopt;
+	}
+
+	return ret;
+}
+
+std::string mesh_cache_path( char const* aSourcePath )
+{
+	return std::string(aSourcePath) + ".meshcache";
+}
@@ -0,0 +1,169 @@
+#ifndef MESH_CACHE_HPP_F40A2D6E_6718_4937_9750_EC31D356BDD1
+#define MESH_CACHE_HPP_F40A2D6E_6718_4937_9750_EC31D356BDD1
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+#include <utility>
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#include "loadobj.hpp"
+#include "cache_source.hpp"
+#include "mesh_lod.hpp"
+#include "simple_mesh.hpp"
+#include "mapped_file.hpp"
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/meshlet.hpp"
+
+#include "../support/error.hpp"
+
+// Another file that the cache was built from (an OBJ's material library):
+// its name relative to the source file's directory, and its state then.
+struct MeshCacheDependency
+{
+	std::string name;
+	CacheSource source;
+};
+
+// The material libraries of the OBJ file, as they are now. Throws if one
+// cannot be read.
+std::vector<MeshCacheDependency> mesh_cache_dependencies( char const* aObjPath );
+
+// A mesh after everything main.cpp does to it before the upload: indexed
+// and optimized, split into clusters, with the indices of the coarser
+// levels of detail appended.
+struct ProcessedMesh
+{
+	SimpleMeshData mesh;
+	std::vector<Meshlet> clusters;
+	MeshLodChain lods;
+};
+
+/** CachedMesh: a ProcessedMesh, mapped from a cache file or held in memory
+ *
+ * The views point straight into the mapping (or into the ProcessedMesh),
+ * so the streams can be uploaded without reading the file first; only the
+ * few materials are copied out. Valid as
+ * long as the CachedMesh exists; moving it keeps them valid.
+ *
+ * Cache files (version kMeshCacheVersion) have a header followed by the
+ * streams, each 16-byte aligned, in native byte order. Besides the source,
+ * they record the dependencies (the .mtl files, which hold the materials
+ * and colours).
+ */
+constexpr std::uint32_t kMeshCacheVersion = 3;
+
+class CachedMesh final
+{
+	public:
+		// Maps the cache file; throws if it is not a valid cache file of
+		// this version.
+		explicit CachedMesh( char const* aCachePath );
+
+		// Keeps the mesh in memory (e.g., when the cache cannot be written).
+		explicit CachedMesh( ProcessedMesh&&, CacheSource const&, std::vector<MeshCacheDependency> );
+
+		CachedMesh( CachedMesh&& ) noexcept = default;
+		CachedMesh& operator= (CachedMesh&&) noexcept = default;
+
+	public:
+		bool mapped() const noexcept { return nullptr != mFile.data(); }
+
+		CacheSource const& source() const noexcept { return mSource; }
+		std::vector<MeshCacheDependency> const& dependencies() const noexcept { return mDependencies; }
+
+		MeshView const& mesh() const noexcept { return mMesh; }
+		ArrayView<Meshlet> clusters() const noexcept { return mClusters; }
+		ArrayView<MeshSubmesh> submeshes() const noexcept { return mSubmeshes; }
+		std::vector<MeshMaterial> const& materials() const noexcept { return mMaterials; }
+		MeshLodChain const& lods() const noexcept { return mLods; }
+
+		Vec3f aabb_min() const noexcept { return mAabbMin; }
+		Vec3f aabb_max() const noexcept { return mAabbMax; }
+
+	private:
+		MappedFile mFile;
+		std::unique_ptr<ProcessedMesh> mOwned;
+
+		CacheSource mSource{};
+		std::vector<MeshCacheDependency> mDependencies;
+
+		MeshView mMesh;
+		ArrayView<Meshlet> mClusters;
+		ArrayView<MeshSubmesh> mSubmeshes;
+		std::vector<MeshMaterial> mMaterials;
+		MeshLodChain mLods;
+		Vec3f mAabbMin{}, mAabbMax{};
+};
+
+// Writes the cache file (to a temporary file that then replaces aCachePath,
+// so that a failed write never leaves a partial cache). Throws on failure.
+void write_mesh_cache( char const* aCachePath, CacheSource const&, std::vector<MeshCacheDependency> const&, ProcessedMesh const& );
+
+// Maps the cache file if it is valid and its source still matches the file
+// at aSourcePath in size, modification time and hash, as do its
+// dependencies (found beside aSourcePath). Otherwise (including
+// when there is no cache file) returns nothing; fills aSource with the
+// source file's current description if it had to hash it.
+std::optional<CachedMesh> open_mesh_cache( char const* aCachePath, char const* aSourcePath, std::optional<CacheSource>* aSource = nullptr );
+
+// Path of the cache file of a source file: beside it, with ".meshcache"
+// appended.
+std::string mesh_cache_path( char const* aSourcePath );
+
+/* Loads the processed OBJ file: from its cache if that is current, and
+ * otherwise by parsing the OBJ and calling aProcess( SimpleMeshData&& ),
+ * which returns the ProcessedMesh. A new cache is written beside the OBJ
+ * and mapped; if it cannot be written, the mesh is kept in memory instead.
+ * aCacheHit, if given, tells which path was taken.
+ */
+template< typename tProcess >
+CachedMesh load_wavefront_obj_cached( char const* aPath, tProcess&& aProcess, bool* aCacheHit = nullptr );
+
+
+
+// Template implementations:
+template< typename tProcess >
+CachedMesh load_wavefront_obj_cached( char const* aPath, tProcess&& aProcess, bool* aCacheHit )
+{
+	std::string const cachePath = mesh_cache_path( aPath );
+
+	std::optional<CacheSource> source;
+	if( auto cached = open_mesh_cache( cachePath.c_str(), aPath, &source ) )
+	{
+		if( aCacheHit )
+			*aCacheHit = true;
+
+		return std::move(*cached);
+	}
+
+	if( aCacheHit )
+		*aCacheHit = false;
+
+	if( !source )
+		source = cache_source( aPath );
+
+	// After parsing, which fails if a material library is missing
+	SimpleMeshData parsed = load_wavefront_obj( aPath );
+	std::vector<MeshCacheDependency> dependencies = mesh_cache_dependencies( aPath );
+
+	ProcessedMesh processed = std::forward<tProcess>(aProcess)( std::move(parsed) );
+
+	try
+	{
+		write_mesh_cache( cachePath.c_str(), *source, dependencies, processed );
+		return CachedMesh( cachePath.c_str() );
+	}
+	catch( Error const& eErr )
+	{
+		std::fprintf( stderr, "Mesh cache for '%s' not used: %s\n", aPath, eErr.what() );
+		return CachedMesh( std::move(processed), *source, std::move(dependencies) );
+	}
+}
+
+#endif // MESH_CACHE_HPP_F40A2D6E_6718_4937_9750_EC31D356BDD1
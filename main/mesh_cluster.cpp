@@ -0,0 +1,98 @@
+#include "mesh_cluster.hpp"
+
+#include <utility>
+
+#include <cassert>
+#include <cstdint>
+
+#include "../vmlib/vec4.hpp"
+
+ClusteredMeshData make_clustered_mesh( SimpleMeshData&& aMesh )
+{
+	assert( !aMesh.indices.empty() );
+
+	ClusteredMeshData ret;
+	ret.mesh = std::move(aMesh);
+
+	// Clusters do not cross submeshes
+	for( auto const& submesh : submesh_ranges( ret.mesh ) )
+	{
+		auto clusters = build_meshlets( ret.mesh.indices.data() + submesh.firstIndex, submesh.indexCount, ret.mesh.positions.data(), ret.mesh.positions.size() );
+		for( auto& cluster : clusters )
+		{
+			cluster.firstIndex += submesh.firstIndex;
+			ret.clusters.emplace_back( cluster );
+		}
+	}
+
+	return ret;
+}
+
+
+void ClusterDrawList::cull( ArrayView<Meshlet> aClusters, ArrayView<MeshSubmesh> aSubmeshes, Mat44f const& aProjCameraWorld, Mat44f const& aModel2World, Vec3f aCameraPos )
+{
+	mCounts.clear();
+	mFirsts.clear();
+	mGroups.clear();
+	mClusters = mTriangles = 0;
+
+	// Both tests run in model space.
+	Frustum const frustum = make_frustum( aProjCameraWorld );
+
+	Vec4f const eye = invert_affine( aModel2World ) * Vec4f{ aCameraPos.x, aCameraPos.y, aCameraPos.z, 1.f };
+	Vec3f const camera{ eye.x, eye.y, eye.z };
+
+	// Without submeshes, everything is one group without a material.
+	std::size_t submesh = 0;
+	std::size_t groupSubmesh = ~std::size_t(0);
+
+	std::uint32_t rangeEnd = ~std::uint32_t(0);
+	for( auto const& cluster : aClusters )
+	{
+		if( !sphere_in_frustum( frustum, cluster.center, cluster.radius ) || meshlet_backfacing( cluster, camera ) )
+			continue;
+
+		++mClusters;
+		mTriangles += cluster.indexCount / 3;
+
+		while( submesh + 1 < aSubmeshes.size() && cluster.firstIndex >= aSubmeshes[submesh].firstIndex + aSubmeshes[submesh].indexCount )
+			++submesh;
+
+		if( submesh != groupSubmesh )
+		{
+			std::uint32_t const material = submesh < aSubmeshes.size() ? aSubmeshes[submesh].material : kNoMaterial;
+			mGroups.emplace_back( Group_{ material, mCounts.size(), 0 } );
+			groupSubmesh = submesh;
+			rangeEnd = ~std::uint32_t(0);
+		}
+
+		if( cluster.firstIndex == rangeEnd )
+			mCounts.back() += static_cast<GLsizei>(cluster.indexCount);
+		else
+		{
+			mCounts.emplace_back( static_cast<GLsizei>(cluster.indexCount) );
+			mFirsts.emplace_back( cluster.firstIndex );
+			++mGroups.back().rangeCount;
+		}
+
+		rangeEnd = cluster.firstIndex + cluster.indexCount;
+	}
+}
+
+void ClusterDrawList::draw( ArenaMesh const& aMesh, MaterialTable const& aMaterials ) const
+{
+	if( mCounts.empty() )
+		return;
+
+	mOffsets.clear();
+	for( auto const first : mFirsts )
+		mOffsets.emplace_back( reinterpret_cast<void const*>((aMesh.firstIndex + first) * sizeof(std::uint32_t)) );
+
+	mBaseVertices.assign( mCounts.size(), aMesh.baseVertex );
+
+	for( auto const& group : mGroups )
+	{
+		aMaterials.bind( group.material );
+		glMultiDrawElementsBaseVertex( GL_TRIANGLES, mCounts.data() + group.firstRange, GL_UNSIGNED_INT, mOffsets.data() + group.firstRange, static_cast<GLsizei>(group.rangeCount), mBaseVertices.data() + group.firstRange );
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef MESH_CLUSTER_HPP_7324C0A8_3344_4D88_B720_0CB3BDA467BF
+#define MESH_CLUSTER_HPP_7324C0A8_3344_4D88_B720_0CB3BDA467BF
+
+#include <glad.h>
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simple_mesh.hpp"
+#include "buffer_arena.hpp"
+#include "material_table.hpp"
+#include "vertex_format.hpp"
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/meshlet.hpp"
+
+/** ClusteredMeshData: an indexed mesh split into clusters for culling
+ *
+ * The clusters (see vmlib/meshlet.hpp) cover the first indices of
+ * mesh.indices, in order. Indices appended later, such as the coarser
+ * levels from build_lod_chain(), are not part of any cluster.
+ */
+struct ClusteredMeshData
+{
+	SimpleMeshData mesh;
+	std::vector<Meshlet> clusters;
+};
+
+// Splits the indexed mesh into clusters of up to kMeshletMaxTriangles
+// triangles. Reorders the triangles, so call it after optimize_mesh().
+ClusteredMeshData make_clustered_mesh( SimpleMeshData&& );
+
+// Uploads the mesh like a SimpleMeshData (see simple_mesh.hpp).
+template< typename... tAttribs > inline
+GLuint create_vao( ClusteredMeshData const& aMeshData, VertexFormat<tAttribs...> aFormat )
+{
+	return create_vao( MeshView( aMeshData.mesh ), aFormat );
+}
+
+/** ClusterDrawList: the visible clusters of one object
+ *
+ * cull() keeps the clusters whose bounding sphere intersects the view
+ * frustum and that are not entirely back-facing. Runs of consecutive kept
+ * clusters of the same submesh become one index range; draw() binds each
+ * submesh's material and submits its ranges with one
+ * glMultiDrawElementsBaseVertex(). The storage is reused from frame to
+ * frame.
+ */
+class ClusterDrawList final
+{
+	public:
+		// The clusters must be in the order of the submeshes, as built by
+		// make_clustered_mesh().
+		void cull(
+			ArrayView<Meshlet>,
+			ArrayView<MeshSubmesh>,
+			Mat44f const& aProjCameraWorld,
+			Mat44f const& aModel2World,
+			Vec3f aCameraPos
+		);
+
+		// Draws the kept ranges of the mesh (uploaded to a BufferArena) with
+		// the materials of the table. The mesh's VAO must be bound.
+		void draw( ArenaMesh const&, MaterialTable const& ) const;
+
+	public:
+		std::size_t cluster_count() const noexcept { return mClusters; }
+		std::size_t triangle_count() const noexcept { return mTriangles; }
+
+	private:
+		// The ranges [firstRange, firstRange+rangeCount) of one submesh
+		struct Group_
+		{
+			std::uint32_t material;
+			std::size_t firstRange, rangeCount;
+		};
+
+		std::vector<GLsizei> mCounts;
+		std::vector<std::uint32_t> mFirsts;
+		std::vector<Group_> mGroups;
+
+		// Scratch for draw()
+		mutable std::vector<void const*> mOffsets;
+		mutable std::vector<GLint> mBaseVertices;
+
+		std::size_t mClusters = 0, mTriangles = 0;
+};
+
+#endif // MESH_CLUSTER_HPP_7324C0A8_3344_4D88_B720_0CB3BDA467BF
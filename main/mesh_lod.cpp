@@ -0,0 +1,162 @@
+#include "mesh_lod.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/mesh_opt.hpp"
+#include "../vmlib/mesh_simplify.hpp"
+
+namespace
+{
+	// Weight of the normals (see SimplifyAttributes), relative to the
+	// radius: collapsing across a normal difference of 0.1 costs as much as
+	// a deviation of 0.05% of the radius.
+	constexpr float kNormalWeight_ = 0.005f;
+
+	// Appends the triangles to aOut, grouped by submesh (the one that most
+	// of their vertices belong to; ties go to the first vertex), and
+	// optimizes each group for the vertex cache.
+	void append_by_submesh_(
+		std::vector<std::uint32_t>& aOut,
+		std::uint32_t const* aIndices, std::size_t aCount,
+		std::vector<std::uint32_t> const& aVertexSubmesh,
+		std::vector<MeshSubmesh> const& aSubmeshes,
+		std::size_t aVertexCount,
+		std::vector<MeshSubmesh>& aRanges )
+	{
+		std::vector<std::uint32_t> triSubmesh( aCount / 3 );
+		std::vector<std::size_t> counts( aSubmeshes.size(), 0 );
+		for( std::size_t t = 0; t < triSubmesh.size(); ++t )
+		{
+			std::uint32_t const a = aVertexSubmesh[aIndices[3*t+0]];
+			std::uint32_t const b = aVertexSubmesh[aIndices[3*t+1]];
+			std::uint32_t const c = aVertexSubmesh[aIndices[3*t+2]];
+			triSubmesh[t] = (b == c && b != a) ? b : a;
+			++counts[triSubmesh[t]];
+		}
+
+		std::vector<std::size_t> cursor( aSubmeshes.size() );
+		std::size_t const base = aOut.size();
+		std::size_t next = base;
+		for( std::size_t s = 0; s < aSubmeshes.size(); ++s )
+		{
+			cursor[s] = next;
+			if( counts[s] )
+				aRanges.emplace_back( MeshSubmesh{ aSubmeshes[s].material, std::uint32_t(next), std::uint32_t(counts[s] * 3) } );
+			next += counts[s] * 3;
+		}
+
+		aOut.resize( next );
+		for( std::size_t t = 0; t < triSubmesh.size(); ++t )
+		{
+			std::size_t& at = cursor[triSubmesh[t]];
+			std::copy_n( aIndices + 3*t, 3, aOut.data() + at );
+			at += 3;
+		}
+
+		for( auto const& range : aRanges )
+			optimize_vertex_cache( aOut.data() + range.firstIndex, range.indexCount, aVertexCount );
+	}
+}
+
+MeshLodChain build_lod_chain( SimpleMeshData& aMesh, std::size_t aMaxLevels, float aRatio, float aMaxRelativeError )
+{
+	assert( !aMesh.indices.empty() );
+	assert( aMesh.normals.size() == aMesh.positions.size() );
+
+	MeshLodChain ret{};
+
+	// Bounding sphere around the center of the bounding box
+	Vec3f lo = aMesh.positions.front(), hi = lo;
+	for( auto const& p : aMesh.positions )
+	{
+		lo = Vec3f{ std::min( lo.x, p.x ), std::min( lo.y, p.y ), std::min( lo.z, p.z ) };
+		hi = Vec3f{ std::max( hi.x, p.x ), std::max( hi.y, p.y ), std::max( hi.z, p.z ) };
+	}
+
+	ret.center = 0.5f * (lo + hi);
+	for( auto const& p : aMesh.positions )
+		ret.radius = std::max( ret.radius, length( p - ret.center ) );
+
+	std::size_t const baseCount = aMesh.indices.size();
+	std::vector<MeshSubmesh> const submeshes = submesh_ranges( aMesh );
+	ret.levels.emplace_back( MeshLod{ 0, baseCount, 0.f, submeshes } );
+
+	// Submesh of each vertex (the last one that uses it)
+	std::vector<std::uint32_t> vertexSubmesh( aMesh.positions.size(), 0 );
+	for( std::size_t s = 0; s < submeshes.size(); ++s )
+	{
+		for( std::size_t i = 0; i < submeshes[s].indexCount; ++i )
+			vertexSubmesh[aMesh.indices[submeshes[s].firstIndex + i]] = std::uint32_t(s);
+	}
+
+	// Normals are the attribute to preserve. Texture coordinates are kept
+	// intact at seams; elsewhere they follow the positions.
+	float const normalWeight = kNormalWeight_ * ret.radius;
+	float const weights[3] = { normalWeight, normalWeight, normalWeight };
+
+	SimplifyAttributes attribs;
+	attribs.data = &aMesh.normals.front().x;
+	attribs.stride = sizeof(Vec3f) / sizeof(float);
+	attribs.weights = weights;
+	attribs.count = 3;
+
+	// Always simplify the full mesh, so that each level's error is relative
+	// to the original.
+	std::vector<std::uint32_t> const base( aMesh.indices );
+	std::vector<std::uint32_t> level( baseCount );
+
+	float const maxError = aMaxRelativeError * ret.radius;
+	std::size_t target = baseCount;
+	while( ret.levels.size() < aMaxLevels )
+	{
+		MeshLod const& prev = ret.levels.back();
+		target = std::size_t(float(target) * aRatio) / 3 * 3;
+
+		float error = 0.f;
+		std::size_t const count = simplify_mesh( level.data(), base.data(), baseCount, aMesh.positions.data(), aMesh.positions.size(), target, maxError, &error, attribs );
+
+		if( 0 == count || float(count) > 0.9f * float(prev.indexCount) )
+			break;
+
+		MeshLod lod{ aMesh.indices.size(), count, std::max( error, prev.error ), {} };
+		append_by_submesh_( aMesh.indices, level.data(), count, vertexSubmesh, submeshes, aMesh.positions.size(), lod.submeshes );
+
+		ret.levels.emplace_back( std::move(lod) );
+	}
+
+	return ret;
+}
+
+float lod_pixel_scale( float aFovInRadians, float aViewportHeight ) noexcept
+{
+	return aViewportHeight / (2.f * std::tan( 0.5f * aFovInRadians ));
+}
+
+std::size_t select_lod( MeshLodChain const& aChain, Mat44f const& aModel2World, Vec3f aCameraPos, float aPixelScale, float aMaxPixelError ) noexcept
+{
+	// Largest scale factor of the model transform
+	float const scale = std::sqrt( std::max( {
+		aModel2World(0,0)*aModel2World(0,0) + aModel2World(1,0)*aModel2World(1,0) + aModel2World(2,0)*aModel2World(2,0),
+		aModel2World(0,1)*aModel2World(0,1) + aModel2World(1,1)*aModel2World(1,1) + aModel2World(2,1)*aModel2World(2,1),
+		aModel2World(0,2)*aModel2World(0,2) + aModel2World(1,2)*aModel2World(1,2) + aModel2World(2,2)*aModel2World(2,2)
+	} ) );
+
+	Vec4f const c = aModel2World * Vec4f{ aChain.center.x, aChain.center.y, aChain.center.z, 1.f };
+	float const distance = length( Vec3f{ c.x, c.y, c.z } - aCameraPos ) - aChain.radius * scale;
+	if( distance <= 0.f )
+		return 0;
+
+	// Projected error: error * scale * aPixelScale / distance
+	float const maxError = aMaxPixelError * distance / (scale * aPixelScale);
+
+	std::size_t ret = 0;
+	while( ret + 1 < aChain.levels.size() && aChain.levels[ret+1].error <= maxError )
+		++ret;
+
+	return ret;
+}
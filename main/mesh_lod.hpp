@@ -0,0 +1,68 @@
+#ifndef MESH_LOD_HPP_2415E412_BCDC_479F_939C_78DC24C7B09B
+#define MESH_LOD_HPP_2415E412_BCDC_479F_939C_78DC24C7B09B
+
+#include <vector>
+
+#include <cstddef>
+
+#include "simple_mesh.hpp"
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/mat44.hpp"
+
+// One level of detail: a range of the mesh's index buffer, and its error
+// in model space (see vmlib/mesh_simplify.hpp). The submeshes split the
+// range by material, like SimpleMeshData::submeshes.
+struct MeshLod
+{
+	std::size_t firstIndex, indexCount;
+	float error;
+
+	std::vector<MeshSubmesh> submeshes;
+};
+
+/** MeshLodChain: levels of detail of one mesh
+ *
+ * All levels index the same vertices; only the index ranges differ. Level 0
+ * is the full mesh, later levels are coarser. The bounding sphere is used
+ * to find the distance to the camera.
+ */
+struct MeshLodChain
+{
+	std::vector<MeshLod> levels;
+	Vec3f center;
+	float radius;
+};
+
+// Builds up to aMaxLevels levels by simplifying the (indexed) mesh, each
+// with about aRatio times the triangles of the one before. The indices of
+// the coarser levels are appended to aMesh.indices, so that create_vao()
+// uploads all levels into one element buffer. Stops early when a level
+// would save less than 10% or exceed aMaxRelativeError times the radius.
+// The whole mesh is simplified at once, so that the borders between
+// submeshes stay closed; each remaining triangle keeps the submesh of most
+// of its vertices.
+MeshLodChain build_lod_chain(
+	SimpleMeshData& aMesh,
+	std::size_t aMaxLevels = 5,
+	float aRatio = 0.5f,
+	float aMaxRelativeError = 0.05f
+);
+
+// Size in pixels of one unit of length at distance one, for a perspective
+// projection with the given vertical field of view and viewport height.
+float lod_pixel_scale( float aFovInRadians, float aViewportHeight ) noexcept;
+
+// Index of the coarsest level whose error, projected to the screen at the
+// distance between the camera and the (transformed) bounding sphere, is at
+// most aMaxPixelError pixels. Returns level 0 when the camera is inside the
+// bounding sphere.
+std::size_t select_lod(
+	MeshLodChain const&,
+	Mat44f const& aModel2World,
+	Vec3f aCameraPos,
+	float aPixelScale,
+	float aMaxPixelError = 1.f
+) noexcept;
+
+#endif // MESH_LOD_HPP_2415E412_BCDC_479F_939C_78DC24C7B09B
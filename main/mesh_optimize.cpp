@@ -0,0 +1,204 @@
+#include "mesh_optimize.hpp"
+
+#include <utility>
+
+#include <cassert>
+#include <cstring>
+
+#include "parallel.hpp"
+
+namespace
+{
+	static_assert( sizeof(WeldVertex) == 12 * sizeof(float), "WeldVertex must not have padding" );
+
+	bool same_( WeldVertex const& aA, WeldVertex const& aB ) noexcept
+	{
+		return 0 == std::memcmp( &aA, &aB, sizeof(WeldVertex) );
+	}
+
+	// FxHash-style word-at-a-time hash with a final avalanche step.
+	std::uint32_t hash_( WeldVertex const& aV ) noexcept
+	{
+		std::uint32_t words[sizeof(WeldVertex) / sizeof(std::uint32_t)];
+		std::memcpy( words, &aV, sizeof(WeldVertex) );
+
+		std::uint32_t h = 0;
+		for( auto const w : words )
+			h = (((h << 5) | (h >> 27)) ^ w) * 0x27d4eb2du;
+
+		h ^= h >> 15;
+		h *= 0x2c1b3c6du;
+		h ^= h >> 13;
+		return h;
+	}
+
+	template< typename tType >
+	void apply_remap_( std::vector<tType>& aData, std::vector<std::uint32_t> const& aRemap, std::size_t aUsed )
+	{
+		if( aData.empty() )
+			return;
+
+		std::vector<tType> ret( aUsed );
+		for( std::size_t i = 0; i < aRemap.size(); ++i )
+		{
+			if( kUnusedVertex != aRemap[i] )
+				ret[aRemap[i]] = aData[i];
+		}
+
+		aData = std::move(ret);
+	}
+}
+
+SimpleMeshData weld_vertices( ArrayView<WeldVertex> aVertices, bool aWithTexcoords, bool aWithColors )
+{
+	std::size_t const count = aVertices.size();
+	assert( count < kUnusedVertex );
+
+	constexpr std::size_t kGrain = 1 << 14;
+
+	std::vector<std::uint32_t> hashes( count );
+	parallel_for( count, kGrain, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t i = aBegin; i < aEnd; ++i )
+			hashes[i] = hash_( aVertices[i] );
+	} );
+
+	// first[i]: the first vertex identical to vertex i. Each partition of the
+	// hash range has its own table (linear probing, load factor at most 0.5)
+	// and visits its vertices in order, so first[i] <= i.
+	std::vector<std::uint32_t> first( count );
+
+	std::size_t const partitions = count < kGrain ? 1 : worker_count();
+	auto const partition = [partitions] (std::uint32_t aHash) {
+		return std::size_t((std::uint64_t(aHash) * partitions) >> 32);
+	};
+
+	parallel_for( partitions, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+		std::vector<std::uint32_t> slots;
+		for( std::size_t p = aBegin; p < aEnd; ++p )
+		{
+			std::size_t members = 0;
+			for( auto const hash : hashes )
+				members += (partition( hash ) == p);
+
+			std::size_t slotCount = 16;
+			while( slotCount < 2 * members )
+				slotCount *= 2;
+
+			slots.assign( slotCount, kUnusedVertex );
+
+			std::size_t const mask = slotCount - 1;
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				if( partition( hashes[i] ) != p )
+					continue;
+
+				std::size_t slot = hashes[i] & mask;
+				while( kUnusedVertex != slots[slot] && !same_( aVertices[slots[slot]], aVertices[i] ) )
+					slot = (slot + 1) & mask;
+
+				if( kUnusedVertex == slots[slot] )
+					slots[slot] = std::uint32_t(i);
+
+				first[i] = slots[slot];
+			}
+		}
+	} );
+
+	// Number the kept vertices in order. This turns first[] into the index
+	// buffer.
+	std::vector<std::uint32_t> kept;
+	kept.reserve( count );
+	for( std::size_t i = 0; i < count; ++i )
+	{
+		std::uint32_t const f = first[i];
+		if( f == i )
+		{
+			first[i] = std::uint32_t(kept.size());
+			kept.emplace_back( f );
+		}
+		else
+			first[i] = first[f];
+	}
+
+	SimpleMeshData ret;
+	ret.positions.resize( kept.size() );
+	ret.normals.resize( kept.size() );
+	if( aWithColors )
+		ret.colors.resize( kept.size() );
+	if( aWithTexcoords )
+		ret.texcoords.resize( kept.size() );
+
+	parallel_for( kept.size(), kGrain, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t i = aBegin; i < aEnd; ++i )
+		{
+			WeldVertex const& v = aVertices[kept[i]];
+			ret.positions[i] = v.position;
+			ret.normals[i] = v.normal;
+			if( aWithColors )
+				ret.colors[i] = v.color;
+			if( aWithTexcoords )
+				ret.texcoords[i] = v.texcoord;
+		}
+	} );
+
+	ret.indices = std::move(first);
+	return ret;
+}
+
+
+MeshOptimizeReport optimize_mesh( SimpleMeshData& aMesh )
+{
+	MeshOptimizeReport report{};
+	report.verticesBefore = aMesh.positions.size();
+
+	if( aMesh.indices.empty() )
+	{
+		// Not indexed: three new vertices per triangle
+		report.before = VertexCacheStats{ 3.f, aMesh.positions.empty() ? 0.f : 1.f };
+
+		assert( aMesh.normals.size() == aMesh.positions.size() );
+		assert( aMesh.colors.size() == aMesh.positions.size() );
+
+		bool const hasTexcoords = !aMesh.texcoords.empty();
+
+		std::vector<WeldVertex> vertices( aMesh.positions.size() );
+		for( std::size_t i = 0; i < vertices.size(); ++i )
+		{
+			vertices[i] = WeldVertex{
+				aMesh.positions[i],
+				aMesh.normals[i],
+				hasTexcoords ? aMesh.texcoords[i] : Vec2f{ 0.f, 0.f },
+				aMesh.colors[i],
+				0
+			};
+		}
+
+		SimpleMeshData welded = weld_vertices( vertices, hasTexcoords );
+		aMesh = std::move(welded);
+	}
+	else
+	{
+		report.before = analyze_vertex_cache( aMesh.indices.data(), aMesh.indices.size(), aMesh.positions.size() );
+	}
+
+	// Triangles stay in their submesh
+	auto& indices = aMesh.indices;
+	for( auto const& submesh : submesh_ranges( aMesh ) )
+	{
+		std::uint32_t* const first = indices.data() + submesh.firstIndex;
+		optimize_vertex_cache( first, submesh.indexCount, aMesh.positions.size() );
+		optimize_overdraw( first, submesh.indexCount, aMesh.positions.data(), aMesh.positions.size() );
+	}
+
+	std::vector<std::uint32_t> remap( aMesh.positions.size() );
+	std::size_t const used = optimize_vertex_fetch_remap( indices.data(), indices.size(), aMesh.positions.size(), remap.data() );
+
+	apply_remap_( aMesh.positions, remap, used );
+	apply_remap_( aMesh.colors, remap, used );
+	apply_remap_( aMesh.normals, remap, used );
+	apply_remap_( aMesh.texcoords, remap, used );
+
+	report.verticesAfter = aMesh.positions.size();
+	report.after = analyze_vertex_cache( indices.data(), indices.size(), aMesh.positions.size() );
+	return report;
+}
@@ -0,0 +1,51 @@
+#ifndef MESH_OPTIMIZE_HPP_76076BB5_106B_42C6_AB83_800523ECC68B
+#define MESH_OPTIMIZE_HPP_76076BB5_106B_42C6_AB83_800523ECC68B
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simple_mesh.hpp"
+
+#include "../vmlib/mesh_opt.hpp"
+
+// One vertex with all attributes of a SimpleMeshData. Used for welding.
+// Vertices of different groups (e.g., submeshes) are never welded.
+struct WeldVertex
+{
+	Vec3f position;
+	Vec3f normal;
+	Vec2f texcoord;
+	Vec3f color;
+	std::uint32_t group;
+};
+
+/* Builds an indexed mesh from a stream of vertices: the first of each set
+ * of bitwise identical vertices is kept, in order, and aVertices[i] becomes
+ * index i. Texture coordinates and colours are only stored if
+ * aWithTexcoords and aWithColors are true (they are still compared).
+ *
+ * Runs on worker_count() threads (see parallel.hpp): the vertices are
+ * hashed in parallel and looked up in one hash table per partition of the
+ * hash range. The result does not depend on the number of threads.
+ */
+SimpleMeshData weld_vertices( ArrayView<WeldVertex> aVertices, bool aWithTexcoords, bool aWithColors = true );
+
+struct MeshOptimizeReport
+{
+	std::size_t verticesBefore, verticesAfter;
+	VertexCacheStats before, after;
+};
+
+// Optimizes a mesh for rendering (see vmlib/mesh_opt.hpp):
+//   - welds identical vertices if the mesh has no indices,
+//   - reorders the triangles for the vertex cache and then for overdraw,
+//     within each submesh,
+//   - reorders the vertices in order of first use.
+// The report holds the vertex counts and the cache statistics before
+// (as drawn with the original indices, or with glDrawArrays() if there were
+// none) and after.
+MeshOptimizeReport optimize_mesh( SimpleMeshData& );
+
+#endif // MESH_OPTIMIZE_HPP_76076BB5_106B_42C6_AB83_800523ECC68B
@@ -0,0 +1,84 @@
+#ifndef PARALLEL_HPP_CFCFAF41_90F3_4FF4_B69C_368048525A6A
+#define PARALLEL_HPP_CFCFAF41_90F3_4FF4_B69C_368048525A6A
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <exception>
+#include <algorithm>
+
+#include <cstddef>
+
+// Number of threads that parallel_for() uses: one per hardware thread.
+inline
+std::size_t worker_count() noexcept
+{
+	return std::max( std::size_t(std::thread::hardware_concurrency()), std::size_t(1) );
+}
+
+/* Calls aFn( aBegin, aEnd ) for consecutive chunks of [0, aCount), each of
+ * at most aGrain items, on up to worker_count() threads (the calling thread
+ * is one of them). The chunks are handed out in order, but may run in any
+ * order and concurrently. Returns when all chunks are done; rethrows the
+ * first exception thrown by aFn, after the other threads have stopped.
+ *
+ * Meant for coarse work (e.g., converting a mesh while loading): threads
+ * are started per call.
+ */
+template< typename tFn >
+void parallel_for( std::size_t aCount, std::size_t aGrain, tFn&& aFn )
+{
+	if( 0 == aCount )
+		return;
+
+	aGrain = std::max( aGrain, std::size_t(1) );
+
+	std::size_t const chunks = (aCount + aGrain - 1) / aGrain;
+	std::size_t const threads = std::min( worker_count(), chunks );
+	if( 1 == threads )
+	{
+		aFn( std::size_t(0), aCount );
+		return;
+	}
+
+	std::atomic<std::size_t> next{ 0 };
+	std::exception_ptr error;
+	std::mutex errorMutex;
+
+	auto const work = [&] {
+		try
+		{
+			for( std::size_t chunk; (chunk = next.fetch_add( 1, std::memory_order_relaxed )) < chunks; )
+			{
+				std::size_t const begin = chunk * aGrain;
+				aFn( begin, std::min( begin + aGrain, aCount ) );
+			}
+		}
+		catch( ... )
+		{
+			// Stop handing out chunks; keep the first error
+			next.store( chunks, std::memory_order_relaxed );
+
+			std::lock_guard<std::mutex> lock( errorMutex );
+			if( !error )
+				error = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> pool;
+	pool.reserve( threads - 1 );
+	for( std::size_t i = 1; i < threads; ++i )
+		pool.emplace_back( work );
+
+	work();
+
+	for( auto& thread : pool )
+		thread.join();
+
+	if( error )
+		std::rethrow_exception( error );
+}
+
+#endif // PARALLEL_HPP_CFCFAF41_90F3_4FF4_B69C_368048525A6A
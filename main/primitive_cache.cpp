@@ -0,0 +1,113 @@
+#include "primitive_cache.hpp"
+
+#include <algorithm>
+
+#include <cassert>
+
+#include "../vmlib/mat33.hpp"
+
+#include "cone.hpp"
+#include "cube.hpp"
+#include "cylinder.hpp"
+#include "mesh_optimize.hpp"
+
+MeshRange PrimitiveCache::get( PrimitiveShape aShape, std::size_t aSubdivs, bool aCapped )
+{
+	// The cube has no parameters
+	if( PrimitiveShape::cube == aShape )
+	{
+		aSubdivs = 0;
+		aCapped = true;
+	}
+
+	for( auto const& entry : mEntries )
+	{
+		if( entry.shape == aShape && entry.subdivs == aSubdivs && entry.capped == aCapped )
+			return entry.range;
+	}
+
+	SimpleMeshData unit;
+	switch( aShape )
+	{
+		case PrimitiveShape::cylinder: unit = make_cylinder( aCapped, aSubdivs ); break;
+		case PrimitiveShape::cone: unit = make_cone( aCapped, aSubdivs ); break;
+		case PrimitiveShape::cube: unit = make_cube(); break;
+	}
+
+	optimize_mesh( unit );
+
+	MeshRange const range = mBuilder.append( unit );
+	mEntries.emplace_back( Entry_{ aShape, aSubdivs, aCapped, range } );
+	return range;
+}
+
+
+void PrimitiveParts::add( MeshRange const& aPrimitive, Mat44f const& aTransform, Vec3f aColor )
+{
+	PrimitiveInstance instance;
+	std::copy( aTransform.v, aTransform.v + 12, instance.transform );
+
+	Mat33f const normalMatrix = make_normal_matrix( aTransform );
+	std::copy( normalMatrix.v, normalMatrix.v + 9, instance.normalMatrix );
+
+	instance.color = aColor;
+
+	// Append to the batch of this primitive, and move the later batches
+	auto batch = std::find_if( mBatches.begin(), mBatches.end(), [&] (PrimitiveBatch const& aB) {
+		return aB.range.firstIndex == aPrimitive.firstIndex && aB.range.firstVertex == aPrimitive.firstVertex;
+	} );
+
+	if( batch == mBatches.end() )
+	{
+		mBatches.emplace_back( PrimitiveBatch{ aPrimitive, std::uint32_t(mInstances.size()), 0 } );
+		batch = mBatches.end() - 1;
+	}
+
+	std::uint32_t const at = batch->firstInstance + batch->instanceCount;
+	mInstances.insert( mInstances.begin() + at, instance );
+	++batch->instanceCount;
+
+	for( auto it = batch + 1; it != mBatches.end(); ++it )
+		++it->firstInstance;
+}
+
+
+void attach_instances( GLuint aVao, std::vector<PrimitiveInstance> const& aInstances )
+{
+	assert( !aInstances.empty() );
+
+	GLuint buffer = 0;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, aInstances.size() * sizeof(PrimitiveInstance), aInstances.data(), 0);
+
+	glVertexArrayVertexBuffer(aVao, 1, buffer, 0, sizeof(PrimitiveInstance));
+	glVertexArrayBindingDivisor(aVao, 1, 1);
+
+	auto const attrib = [aVao] (GLuint aLocation, GLint aComponents, std::size_t aOffset) {
+		glEnableVertexArrayAttrib(aVao, aLocation);
+		glVertexArrayAttribFormat(aVao, aLocation, aComponents, GL_FLOAT, GL_FALSE, GLuint(aOffset));
+		glVertexArrayAttribBinding(aVao, aLocation, 1);
+	};
+
+	for( GLuint row = 0; row < 3; ++row )
+	{
+		attrib( 5 + row, 4, offsetof(PrimitiveInstance, transform) + row * 4 * sizeof(float) );
+		attrib( 8 + row, 3, offsetof(PrimitiveInstance, normalMatrix) + row * 3 * sizeof(float) );
+	}
+	attrib( 1, 3, offsetof(PrimitiveInstance, color) );
+
+	// The VAO keeps the buffer alive.
+	glDeleteBuffers(1, &buffer);
+}
+
+void draw_instanced( PrimitiveParts const& aParts, ArenaMesh const& aPrimitives )
+{
+	for( auto const& batch : aParts.batches() )
+	{
+		glDrawElementsInstancedBaseVertexBaseInstance( GL_TRIANGLES,
+			static_cast<GLsizei>(batch.range.indexCount), GL_UNSIGNED_INT,
+			reinterpret_cast<void const*>((aPrimitives.firstIndex + batch.range.firstIndex) * sizeof(std::uint32_t)),
+			static_cast<GLsizei>(batch.instanceCount), aPrimitives.baseVertex, batch.firstInstance
+		);
+	}
+}
@@ -0,0 +1,106 @@
+#ifndef PRIMITIVE_CACHE_HPP_535CCBF9_C453_4A54_B460_CDB5E1D7CCBF
+#define PRIMITIVE_CACHE_HPP_535CCBF9_C453_4A54_B460_CDB5E1D7CCBF
+
+#include <glad.h>
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simple_mesh.hpp"
+#include "mesh_builder.hpp"
+#include "buffer_arena.hpp"
+#include "vertex_format.hpp"
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/mat44.hpp"
+
+enum class PrimitiveShape : std::uint8_t
+{
+	cylinder,
+	cone,
+	cube
+};
+
+/** PrimitiveCache: unit primitives, each generated once
+ *
+ * get() returns the range of the unit primitive (no pre-transform, white)
+ * in the cache's mesh, generating, welding and optimizing it on first use.
+ * All primitives share one indexed mesh, so one VAO holds all of them.
+ * Upload the mesh after the last get(), e.g.
+ *   ArenaMesh mesh = arenas.add( cache.mesh(), PrimitiveVertexFormat{} );
+ */
+class PrimitiveCache final
+{
+	public:
+		MeshRange get( PrimitiveShape, std::size_t aSubdivs = 16, bool aCapped = true );
+
+		MeshView mesh() const noexcept { return mBuilder.view(); }
+
+	private:
+		struct Entry_
+		{
+			PrimitiveShape shape;
+			std::size_t subdivs;
+			bool capped;
+			MeshRange range;
+		};
+
+		MeshBuilder mBuilder;
+		std::vector<Entry_> mEntries;
+};
+
+// Vertex format of the cached primitives. The colour is per instance and
+// uses location 1 from the instance buffer (see attach_instances()).
+using PrimitiveVertexFormat = VertexFormat<Pos4h, Nrm10>;
+
+// Per-instance data of a part, as read by assets/mat_instanced.vert: the
+// first three rows of the part's transform, its normal matrix (rows) and
+// its colour.
+struct PrimitiveInstance
+{
+	float transform[12];
+	float normalMatrix[9];
+	Vec3f color;
+};
+
+// Instances of one primitive: instances [firstInstance, firstInstance +
+// instanceCount) of the PrimitiveParts.
+struct PrimitiveBatch
+{
+	MeshRange range;
+	std::uint32_t firstInstance, instanceCount;
+};
+
+/** PrimitiveParts: a model made of transformed, coloured primitives
+ *
+ * Replaces meshes where each part was generated with a pre-transform baked
+ * into its vertices. The instances are kept grouped by primitive, so that
+ * draw_instanced() issues one instanced draw call per primitive.
+ */
+class PrimitiveParts final
+{
+	public:
+		void add( MeshRange const& aPrimitive, Mat44f const& aTransform, Vec3f aColor );
+
+	public:
+		std::vector<PrimitiveInstance> const& instances() const noexcept { return mInstances; }
+		std::vector<PrimitiveBatch> const& batches() const noexcept { return mBatches; }
+
+	private:
+		std::vector<PrimitiveInstance> mInstances;
+		std::vector<PrimitiveBatch> mBatches;
+};
+
+// Uploads the instances and adds them to the VAO (binding 1, divisor 1) at
+// locations 5-7 (transform rows), 8-10 (normal matrix rows) and 1 (colour).
+// For a VAO of a BufferArena, this affects all meshes of the VAO's block.
+// Requires OpenGL 4.5 (direct state access).
+void attach_instances( GLuint aVao, std::vector<PrimitiveInstance> const& );
+
+// Draws all parts from the uploaded primitive mesh. The VAO from
+// attach_instances() must be bound.
+void draw_instanced( PrimitiveParts const&, ArenaMesh const& aPrimitives );
+
+#endif // PRIMITIVE_CACHE_HPP_535CCBF9_C453_4A54_B460_CDB5E1D7CCBF
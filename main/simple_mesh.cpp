@@ -1,112 +1,116 @@
 #include "simple_mesh.hpp"
 
+#include <utility>
+
 #include <cassert>
+#include <cstdint>
 
 #include <stb_image.h>
 
 #include "../support/error.hpp"
 
+#include "mesh_builder.hpp"
+
+std::vector<MeshSubmesh> submesh_ranges( SimpleMeshData const& aMesh )
+{
+	if( !aMesh.submeshes.empty() )
+		return aMesh.submeshes;
+
+	return { MeshSubmesh{ kNoMaterial, 0, std::uint32_t(aMesh.indices.size()) } };
+}
+
 SimpleMeshData concatenate( SimpleMeshData aM, SimpleMeshData const& aN )
 {
-	aM.positions.insert( aM.positions.end(), aN.positions.begin(), aN.positions.end() );
-	aM.colors.insert( aM.colors.end(), aN.colors.begin(), aN.colors.end() );
-	aM.normals.insert( aM.normals.end(), aN.normals.begin(), aN.normals.end() );
-	return aM;
+	aM.submeshes.clear();
+	aM.materials.clear();
+
+	MeshBuilder builder( std::move(aM) );
+	builder.append( aN );
+	return builder.release();
 }
 
 
-GLuint create_vao( SimpleMeshData const& aMeshData )
+bool operator==( VertexLayout const& aA, VertexLayout const& aB ) noexcept
 {
-	// Creating and binding buffers
-	GLuint positionVBO = 0;
-	glGenBuffers(1, &positionVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
-	glBufferData(GL_ARRAY_BUFFER, aMeshData.positions.size() * sizeof(Vec3f), aMeshData.positions.data(), GL_STATIC_DRAW);
-
-	GLuint colorVBO = 0;
-	glGenBuffers(1, &colorVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
-	glBufferData(GL_ARRAY_BUFFER, aMeshData.colors.size() * sizeof(Vec3f), aMeshData.colors.data(), GL_STATIC_DRAW);
-
-	GLuint normalVBO = 0;
-	glGenBuffers(1, &normalVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, normalVBO);
-	glBufferData(GL_ARRAY_BUFFER, aMeshData.normals.size() * sizeof(Vec3f), aMeshData.normals.data(), GL_STATIC_DRAW);
-
-	GLuint texCoordVBO = 0;
-	glGenBuffers(1, &texCoordVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, texCoordVBO);
-	glBufferData(GL_ARRAY_BUFFER, aMeshData.texcoords.size() * sizeof(Vec2f), aMeshData.texcoords.data(), GL_STATIC_DRAW);
-
-	// Generating vao
+	if( aA.stride != aB.stride || aA.attribCount != aB.attribCount )
+		return false;
+
+	for( std::size_t i = 0; i < aA.attribCount; ++i )
+	{
+		InterleavedAttrib const& a = aA.attribs[i];
+		InterleavedAttrib const& b = aB.attribs[i];
+		if( a.location != b.location || a.components != b.components || a.type != b.type || a.normalized != b.normalized || a.offset != b.offset )
+			return false;
+	}
+
+	return true;
+}
+
+GLuint create_interleaved_vao( void const* aData, std::size_t aVertexCount, std::size_t aStride, InterleavedAttrib const* aAttribs, std::size_t aAttribCount, ArrayView<std::uint32_t> aIndices )
+{
+	// Creating the buffers. Static data, so immutable storage is enough.
+	GLuint vbo = 0;
+	glCreateBuffers(1, &vbo);
+	if( 0 != aVertexCount * aStride )
+		glNamedBufferStorage(vbo, GLsizeiptr(aVertexCount * aStride), aData, 0);
+
+	GLuint ibo = 0;
+	if( !aIndices.empty() )
+	{
+		glCreateBuffers(1, &ibo);
+		glNamedBufferStorage(ibo, GLsizeiptr(aIndices.size() * sizeof(std::uint32_t)), aIndices.data(), 0);
+	}
+
+	// Generating vao. All attributes read from binding point 0.
 	GLuint vao = 0;
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
-
-	// Binding data into buffers
-	glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
-	glVertexAttribPointer(
-		0,
-		3, GL_FLOAT, GL_FALSE,
-		0,
-		0
-	);
-	glEnableVertexAttribArray(0);
-
-	glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
-	glVertexAttribPointer(
-		1,
-		3, GL_FLOAT, GL_FALSE,
-		0,
-		0
-	);
-	glEnableVertexAttribArray(1);
-
-	glBindBuffer(GL_ARRAY_BUFFER, normalVBO);
-	glVertexAttribPointer(
-		2,
-		3, GL_FLOAT, GL_FALSE,
-		0,
-		0
-	);
-	glEnableVertexAttribArray(2);
-
-	glBindBuffer(GL_ARRAY_BUFFER, texCoordVBO);
-	glVertexAttribPointer(
-		3,
-		2, GL_FLOAT, GL_FALSE,
-		0,
-		0
-	);
-	glEnableVertexAttribArray(3);
-
-	// Binding array and binding that to buffer
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Cleanup
-	glDeleteBuffers(1, &colorVBO);
-	glDeleteBuffers(1, &positionVBO);
-	glDeleteBuffers(1, &normalVBO);
-	glDeleteBuffers(1, &texCoordVBO);
-	
+	glCreateVertexArrays(1, &vao);
+	glVertexArrayVertexBuffer(vao, 0, vbo, 0, GLsizei(aStride));
+
+	for( std::size_t i = 0; i < aAttribCount; ++i )
+	{
+		InterleavedAttrib const& attrib = aAttribs[i];
+		glEnableVertexArrayAttrib(vao, attrib.location);
+		glVertexArrayAttribFormat(vao, attrib.location, attrib.components, attrib.type, attrib.normalized, attrib.offset);
+		glVertexArrayAttribBinding(vao, attrib.location, 0);
+	}
+
+	if( ibo )
+		glVertexArrayElementBuffer(vao, ibo);
+
+	// Cleanup. The VAO keeps the buffers alive (it is not bound, so deleting
+	// does not detach them).
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &ibo);
+
 	return vao;
 }
 
-GLuint load_texture_2d( char const* aPath )
+void ImageFree::operator() ( unsigned char* aPixels ) const noexcept
+{
+	stbi_image_free( aPixels );
+}
+
+ImageData decode_image( char const* aPath )
 {
 	assert( aPath );
-	stbi_set_flip_vertically_on_load( true );
+	// Per thread, so that images can be decoded on several threads at once
+	stbi_set_flip_vertically_on_load_thread( true );
 	int w, h, channels;
 	stbi_uc* ptr = stbi_load( aPath, &w, &h, &channels, 4 );
 	if( !ptr )
 		throw Error( "Unable to load image ’%s’\n", aPath );
+
+	return ImageData{ w, h, std::unique_ptr<unsigned char, ImageFree>( ptr ) };
+}
+
+GLuint create_texture_2d( ImageData const& aImage )
+{
+	assert( aImage.pixels );
 		// Generate texture object and initialize texture with image
 	GLuint tex = 0;
 	glGenTextures( 1, &tex );
 	glBindTexture( GL_TEXTURE_2D, tex );
-	glTexImage2D( GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, ptr );
-	stbi_image_free( ptr );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, aImage.width, aImage.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, aImage.pixels.get() );
 	// Generate mipmap hierarchy
 	glGenerateMipmap( GL_TEXTURE_2D );
 	// Configure texture
@@ -117,3 +121,8 @@ GLuint load_texture_2d( char const* aPath )
 	glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, 6.f );
 	return tex;
 }
+
+GLuint load_texture_2d( char const* aPath )
+{
+	return create_texture_2d( decode_image( aPath ) );
+}
@@ -3,24 +3,288 @@
 
 #include <glad.h>
 
+#include <memory>
+#include <string>
 #include <vector>
 
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
 #include "../vmlib/vec2.hpp"
 #include "../vmlib/vec3.hpp"
 
+#include "vertex_format.hpp"
+
+// Surface properties of a material (from an OBJ's MTL file). diffuseMap is
+// the path of the diffuse texture, relative to the working directory, or
+// empty.
+struct MeshMaterial
+{
+	std::string name;
+
+	Vec3f ambient, diffuse, specular;
+	float shininess;
+
+	std::string diffuseMap;
+};
+
+// Submesh without a material (drawn with the default material)
+constexpr std::uint32_t kNoMaterial = ~std::uint32_t(0);
+
+// The triangles of one material: indices [firstIndex, firstIndex+indexCount)
+struct MeshSubmesh
+{
+	std::uint32_t material;
+	std::uint32_t firstIndex, indexCount;
+};
+
 struct SimpleMeshData
 {
 	std::vector<Vec3f> positions;
 	std::vector<Vec3f> colors;
 	std::vector<Vec3f> normals;
 	std::vector<Vec2f> texcoords;
+
+	// Optional. If not empty, every three indices form a triangle (draw with
+	// glDrawElements()). Otherwise every three vertices do.
+	std::vector<std::uint32_t> indices;
+
+	// Optional, for indexed meshes. If not empty, the triangles are grouped
+	// by material: the submeshes cover the indices in order and index into
+	// materials (or are kNoMaterial). Meshes loaded from OBJ files use these
+	// instead of per-vertex colours.
+	std::vector<MeshSubmesh> submeshes;
+	std::vector<MeshMaterial> materials;
 };
 
+// The submeshes of the (indexed) mesh, or one submesh with kNoMaterial that
+// covers all of its indices if it has none.
+std::vector<MeshSubmesh> submesh_ranges( SimpleMeshData const& );
+
+// Appends the second mesh to the first. Prefer MeshBuilder (mesh_builder.hpp)
+// when assembling many parts; each concatenate() copies the growing mesh.
+// Submeshes and materials are not carried over.
 SimpleMeshData concatenate( SimpleMeshData, SimpleMeshData const& );
 
 
-GLuint create_vao( SimpleMeshData const& );
+/** ArrayView: non-owning, read-only view of a contiguous array
+ *
+ * Like C++20's std::span<tType const>. The viewed array must outlive the
+ * view.
+ */
+template< typename tType >
+class ArrayView final
+{
+	public:
+		constexpr ArrayView() noexcept = default;
+		constexpr ArrayView( tType const* aData, std::size_t aSize ) noexcept
+			: mData( aData )
+			, mSize( aSize )
+		{}
+
+		ArrayView( std::vector<tType> const& aVector ) noexcept
+			: mData( aVector.data() )
+			, mSize( aVector.size() )
+		{}
+
+	public:
+		constexpr tType const* data() const noexcept { return mData; }
+		constexpr std::size_t size() const noexcept { return mSize; }
+		constexpr bool empty() const noexcept { return 0 == mSize; }
+
+		constexpr tType const* begin() const noexcept { return mData; }
+		constexpr tType const* end() const noexcept { return mData + mSize; }
+
+		constexpr tType const& operator[] (std::size_t aI) const noexcept
+		{
+			assert( aI < mSize );
+			return mData[aI];
+		}
+
+	private:
+		tType const* mData = nullptr;
+		std::size_t mSize = 0;
+};
+
+/** MeshView: non-owning view of the streams of a mesh
+ *
+ * Same layout as SimpleMeshData, but the streams may live anywhere (e.g., in
+ * a MeshBuilder). A SimpleMeshData converts to a MeshView implicitly, so
+ * functions that only read a mesh take a MeshView.
+ */
+struct MeshView
+{
+	ArrayView<Vec3f> positions;
+	ArrayView<Vec3f> colors;
+	ArrayView<Vec3f> normals;
+	ArrayView<Vec2f> texcoords;
+	ArrayView<std::uint32_t> indices;
+
+	MeshView() = default;
+
+	MeshView( SimpleMeshData const& aMesh ) noexcept
+		: positions( aMesh.positions )
+		, colors( aMesh.colors )
+		, normals( aMesh.normals )
+		, texcoords( aMesh.texcoords )
+		, indices( aMesh.indices )
+	{}
+};
+
+
+// Creates a VAO with the mesh's vertex data in the given format (see
+// vertex_format.hpp), interleaved in a single buffer. Attributes that the
+// mesh does not have (e.g., texcoords of procedural meshes) are skipped.
+// If the mesh has indices, the VAO also gets an element buffer
+// (GL_UNSIGNED_INT). Requires OpenGL 4.5 (direct state access).
+template< typename... tAttribs >
+GLuint create_vao( MeshView const&, VertexFormat<tAttribs...> );
+
+inline
+GLuint create_vao( MeshView const& aMeshData )
+{
+	return create_vao( aMeshData, VertexFloat32{} );
+}
+
+// Size of one vertex of the mesh in the given format, i.e., the number of
+// bytes that create_vao() uploads per vertex.
+template< typename... tAttribs >
+std::size_t vertex_size( MeshView const&, VertexFormat<tAttribs...> ) noexcept;
+
+// One attribute of an interleaved vertex buffer. Used by create_vao().
+struct InterleavedAttrib
+{
+	GLuint location;
+	GLint components;
+	GLenum type;
+	GLboolean normalized;
+	GLuint offset;
+};
+
+// Layout of an interleaved vertex: its attributes and its size in bytes.
+constexpr std::size_t kMaxInterleavedAttribs = 8;
 
+struct VertexLayout
+{
+	std::size_t stride = 0;
+	std::size_t attribCount = 0;
+	InterleavedAttrib attribs[kMaxInterleavedAttribs] = {};
+};
+
+bool operator==( VertexLayout const&, VertexLayout const& ) noexcept;
+
+// The vertices of a mesh encoded in a VertexFormat and interleaved. The
+// layout only contains the attributes that the mesh has.
+struct InterleavedVertices
+{
+	VertexLayout layout;
+	std::size_t count = 0;
+	std::vector<unsigned char> data;
+};
+
+template< typename... tAttribs >
+InterleavedVertices interleave_vertices( MeshView const&, VertexFormat<tAttribs...> );
+
+// Creates a VAO from interleaved vertex data (aVertexCount vertices of
+// aStride bytes each) and optional indices. Used by create_vao().
+GLuint create_interleaved_vao(
+	void const* aData,
+	std::size_t aVertexCount,
+	std::size_t aStride,
+	InterleavedAttrib const* aAttribs,
+	std::size_t aAttribCount,
+	ArrayView<std::uint32_t> aIndices
+);
+
+// Decoded image: RGBA8, rows from the bottom up (as glTexImage2D() expects)
+struct ImageFree
+{
+	void operator() (unsigned char*) const noexcept;
+};
+
+struct ImageData
+{
+	int width, height;
+	std::unique_ptr<unsigned char, ImageFree> pixels;
+};
+
+// Decodes the image file; throws if it cannot be read. Safe to call from
+// any thread.
+ImageData decode_image( char const* );
+
+// Creates a mipmapped sRGB texture from the image.
+GLuint create_texture_2d( ImageData const& );
+
+// decode_image(), then create_texture_2d().
 GLuint load_texture_2d(char const*);
 
+
+
+// Template implementations:
+template< typename... tAttribs >
+GLuint create_vao( MeshView const& aMeshData, VertexFormat<tAttribs...> aFormat )
+{
+	InterleavedVertices const vertices = interleave_vertices( aMeshData, aFormat );
+	return create_interleaved_vao( vertices.data.data(), vertices.count, vertices.layout.stride, vertices.layout.attribs, vertices.layout.attribCount, aMeshData.indices );
+}
+
+template< typename... tAttribs >
+InterleavedVertices interleave_vertices( MeshView const& aMeshData, VertexFormat<tAttribs...> )
+{
+	static_assert( sizeof...(tAttribs) <= kMaxInterleavedAttribs );
+
+	std::size_t const count = aMeshData.positions.size();
+
+	// Layout: the attributes that the mesh has, in the order of the format
+	bool const has[] = { !tAttribs::source( aMeshData ).empty()... };
+	std::size_t const sizes[] = { sizeof(typename tAttribs::Type)... };
+
+	std::size_t stride = 0;
+	for( std::size_t i = 0; i < sizeof...(tAttribs); ++i )
+		stride += has[i] ? sizes[i] : 0;
+
+	// Encode and interleave
+	InterleavedVertices ret;
+	ret.layout.stride = stride;
+	ret.count = count;
+	ret.data.resize( count * stride );
+
+	std::size_t offset = 0, index = 0;
+
+	auto const interleave = [&] (auto aAttrib) {
+		using Attrib_ = decltype(aAttrib);
+		if( has[index++] )
+		{
+			auto const& src = Attrib_::source( aMeshData );
+			assert( src.size() == count );
+
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				auto const packed = Attrib_::encode( src[i] );
+				std::memcpy( ret.data.data() + i*stride + offset, &packed, sizeof(packed) );
+			}
+
+			ret.layout.attribs[ret.layout.attribCount++] = InterleavedAttrib{
+				Attrib_::kLocation,
+				Attrib_::kComponents,
+				Attrib_::kGLType,
+				Attrib_::kNormalized,
+				GLuint(offset)
+			};
+			offset += sizeof(typename Attrib_::Type);
+		}
+	};
+	( interleave( tAttribs{} ), ... );
+
+	return ret;
+}
+
+template< typename... tAttribs >
+std::size_t vertex_size( MeshView const& aMeshData, VertexFormat<tAttribs...> ) noexcept
+{
+	return ((tAttribs::source( aMeshData ).empty() ? 0 : sizeof(typename tAttribs::Type)) + ...);
+}
+
 #endif // SIMPLE_MESH_HPP_C6B749D6_C83B_434C_9E58_F05FC27FEFC9
@@ -0,0 +1,156 @@
+#include "stream_ring.hpp"
+
+#include <chrono>
+#include <utility>
+#include <algorithm>
+
+#include <cassert>
+
+#include "../support/error.hpp"
+
+namespace
+{
+	constexpr GLbitfield kMapFlags_ = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	// Timeout per glClientWaitSync() while stalling, in nanoseconds
+	constexpr GLuint64 kWaitTimeout_ = 1000000;
+}
+
+StreamRing::StreamRing( std::size_t aBytesPerFrame, std::size_t aFrames )
+	: mFrames( aFrames )
+{
+	assert( aBytesPerFrame > 0 && aFrames >= 2 );
+
+	GLint alignment = 0;
+	glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment );
+	mUniformAlignment = std::size_t(std::max( alignment, 1 ));
+
+	// Each region starts at a uniform block boundary
+	mFrameSize = (aBytesPerFrame + mUniformAlignment - 1) / mUniformAlignment * mUniformAlignment;
+
+	std::size_t const size = mFrameSize * mFrames;
+	glCreateBuffers( 1, &mBuffer );
+	glNamedBufferStorage( mBuffer, GLsizeiptr(size), nullptr, kMapFlags_ );
+
+	mMapped = static_cast<unsigned char*>(glMapNamedBufferRange( mBuffer, 0, GLsizeiptr(size), kMapFlags_ ));
+	if( !mMapped )
+	{
+		glDeleteBuffers( 1, &mBuffer );
+		throw Error( "StreamRing: unable to map %zu bytes persistently", size );
+	}
+
+	mFences.assign( mFrames, nullptr );
+	mStats.bytesPerFrame = mFrameSize;
+}
+
+StreamRing::~StreamRing()
+{
+	release_();
+}
+
+StreamRing::StreamRing( StreamRing&& aOther ) noexcept
+	: mBuffer( std::exchange( aOther.mBuffer, 0 ) )
+	, mMapped( std::exchange( aOther.mMapped, nullptr ) )
+	, mFrameSize( aOther.mFrameSize )
+	, mFrames( aOther.mFrames )
+	, mUniformAlignment( aOther.mUniformAlignment )
+	, mCurrent( aOther.mCurrent )
+	, mHead( aOther.mHead )
+	, mInFrame( aOther.mInFrame )
+	, mFences( std::move(aOther.mFences) )
+	, mStats( aOther.mStats )
+{}
+StreamRing& StreamRing::operator= (StreamRing&& aOther) noexcept
+{
+	std::swap( mBuffer, aOther.mBuffer );
+	std::swap( mMapped, aOther.mMapped );
+	std::swap( mFrameSize, aOther.mFrameSize );
+	std::swap( mFrames, aOther.mFrames );
+	std::swap( mUniformAlignment, aOther.mUniformAlignment );
+	std::swap( mCurrent, aOther.mCurrent );
+	std::swap( mHead, aOther.mHead );
+	std::swap( mInFrame, aOther.mInFrame );
+	std::swap( mFences, aOther.mFences );
+	std::swap( mStats, aOther.mStats );
+	return *this;
+}
+
+void StreamRing::begin_frame()
+{
+	assert( !mInFrame );
+
+	// Wait until the GPU is done with the commands that last read this
+	// region. Normally it is, and the first check returns immediately.
+	if( GLsync fence = mFences[mCurrent] )
+	{
+		GLenum status = glClientWaitSync( fence, 0, 0 );
+		if( GL_TIMEOUT_EXPIRED == status )
+		{
+			++mStats.stalls;
+
+			auto const start = std::chrono::steady_clock::now();
+			do
+			{
+				status = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, kWaitTimeout_ );
+			} while( GL_TIMEOUT_EXPIRED == status );
+
+			mStats.stallMilliseconds += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+		}
+
+		if( GL_WAIT_FAILED == status )
+			throw Error( "StreamRing: glClientWaitSync() failed" );
+
+		glDeleteSync( fence );
+		mFences[mCurrent] = nullptr;
+	}
+
+	mHead = 0;
+	mInFrame = true;
+}
+
+StreamAllocation StreamRing::allocate( std::size_t aSize, std::size_t aAlignment )
+{
+	assert( mInFrame );
+	assert( aAlignment > 0 );
+
+	std::size_t const offset = (mHead + aAlignment - 1) / aAlignment * aAlignment;
+	if( offset + aSize > mFrameSize )
+		throw Error( "StreamRing: %zu more bytes do not fit into the %zu bytes of a frame", aSize, mFrameSize );
+
+	mHead = offset + aSize;
+
+	std::size_t const at = mCurrent * mFrameSize + offset;
+	return StreamAllocation{ mMapped + at, GLintptr(at), aSize };
+}
+
+void StreamRing::end_frame()
+{
+	assert( mInFrame );
+
+	mFences[mCurrent] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+	++mStats.frames;
+	mStats.bytesLastFrame = mHead;
+	mStats.bytesPeak = std::max( mStats.bytesPeak, mHead );
+
+	mCurrent = (mCurrent + 1) % mFrames;
+	mInFrame = false;
+}
+
+void StreamRing::release_() noexcept
+{
+	for( auto& fence : mFences )
+	{
+		if( fence )
+			glDeleteSync( fence );
+	}
+	mFences.clear();
+
+	if( mBuffer )
+	{
+		glUnmapNamedBuffer( mBuffer );
+		glDeleteBuffers( 1, &mBuffer );
+		mBuffer = 0;
+	}
+	mMapped = nullptr;
+}
@@ -0,0 +1,94 @@
+#ifndef STREAM_RING_HPP_2D6D1128_2E42_499E_ADF8_5F93E731BB52
+#define STREAM_RING_HPP_2D6D1128_2E42_499E_ADF8_5F93E731BB52
+
+#include <glad.h>
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+// Memory for one frame's data in a StreamRing: write aSize bytes to data;
+// the GPU reads them from offset in the ring's buffer.
+struct StreamAllocation
+{
+	void* data;
+	GLintptr offset;
+	std::size_t size;
+};
+
+struct StreamStats
+{
+	std::uint64_t frames;
+	std::uint64_t stalls;        // begin_frame() calls that had to wait
+	double stallMilliseconds;    // total time spent waiting
+
+	std::size_t bytesLastFrame;  // allocated in the last completed frame
+	std::size_t bytesPeak;       // most in any frame
+	std::size_t bytesPerFrame;   // capacity of one frame
+};
+
+/** StreamRing: persistently mapped ring buffer for per-frame data
+ *
+ * One buffer of aFrames regions (triple buffering by default), mapped once
+ * with GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT. Each frame writes into
+ * its own region directly, without glBufferSubData() or glUniform*()
+ * copies, while the GPU may still read the regions of earlier frames.
+ * end_frame() puts a fence after the frame's commands; begin_frame() waits
+ * for the fence of the region that it is about to reuse, which only
+ * happens if the GPU is aFrames - 1 frames behind (a stall).
+ *
+ *   ring.begin_frame();
+ *   auto a = ring.allocate( sizeof(Data), ring.uniform_alignment() );
+ *   std::memcpy( a.data, &data, sizeof(Data) );
+ *   glBindBufferRange( GL_UNIFORM_BUFFER, 0, ring.buffer(), a.offset, a.size );
+ *   // ... draw
+ *   ring.end_frame();
+ *
+ * allocate() throws if the frame's region is full. Requires OpenGL 4.4
+ * (buffer storage) and a current context for the lifetime of the ring.
+ */
+class StreamRing final
+{
+	public:
+		explicit StreamRing( std::size_t aBytesPerFrame, std::size_t aFrames = 3 );
+		~StreamRing();
+
+		StreamRing( StreamRing const& ) = delete;
+		StreamRing& operator= (StreamRing const&) = delete;
+
+		StreamRing( StreamRing&& ) noexcept;
+		StreamRing& operator= (StreamRing&&) noexcept;
+
+	public:
+		void begin_frame();
+		StreamAllocation allocate( std::size_t aSize, std::size_t aAlignment = 16 );
+		void end_frame();
+
+	public:
+		GLuint buffer() const noexcept { return mBuffer; }
+
+		// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, for uniform block ranges
+		std::size_t uniform_alignment() const noexcept { return mUniformAlignment; }
+
+		StreamStats const& stats() const noexcept { return mStats; }
+
+	private:
+		void release_() noexcept;
+
+		GLuint mBuffer = 0;
+		unsigned char* mMapped = nullptr;
+
+		std::size_t mFrameSize = 0, mFrames = 0;
+		std::size_t mUniformAlignment = 0;
+
+		std::size_t mCurrent = 0;   // region of the current frame
+		std::size_t mHead = 0;      // bytes allocated in the current frame
+		bool mInFrame = false;
+
+		std::vector<GLsync> mFences; // one per region, or null
+
+		StreamStats mStats{};
+};
+
+#endif // STREAM_RING_HPP_2D6D1128_2E42_499E_ADF8_5F93E731BB52
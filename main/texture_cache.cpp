@@ -0,0 +1,372 @@
+#include "texture_cache.hpp"
+
+#include <utility>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+
+#include "parallel.hpp"
+
+#include "../support/error.hpp"
+
+// Not in our GL loader: the sRGB variant of DXT1 (EXT_texture_sRGB)
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#	define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+
+namespace
+{
+	constexpr char kMagic_[8] = { 'T', 'E', 'X', 'C', 'A', 'C', 'H', 'E' };
+	constexpr std::size_t kAlignment_ = 16;
+
+	// A 2^16 x 2^16 texture has 17 levels
+	constexpr std::size_t kMaxLevels_ = 17;
+
+	struct LevelHeader_
+	{
+		std::uint64_t offset, size;
+		std::uint32_t width, height;
+	};
+
+	struct FileHeader_
+	{
+		char magic[8];
+		std::uint32_t version, headerSize;
+
+		std::uint64_t sourceSize;
+		std::int64_t sourceTime;
+		std::uint64_t sourceHash;
+
+		std::uint32_t format, levelCount;
+		LevelHeader_ levels[kMaxLevels_];
+	};
+
+	constexpr std::size_t align_( std::size_t aOffset ) noexcept
+	{
+		return (aOffset + kAlignment_ - 1) & ~(kAlignment_ - 1);
+	}
+
+	void write_padding_( std::FILE* aOut, std::size_t& aOffset )
+	{
+		static constexpr char kZeros[kAlignment_] = {};
+
+		std::size_t const aligned = align_( aOffset );
+		if( aligned != aOffset && 1 != std::fwrite( kZeros, aligned - aOffset, 1, aOut ) )
+			throw Error( "write_texture_cache(): write failed" );
+
+		aOffset = aligned;
+	}
+}
+
+BakedTexture bake_texture( ImageData const& aImage, BlockFormat aFormat )
+{
+	assert( aImage.pixels && aImage.width > 0 && aImage.height > 0 );
+
+	BakedTexture ret;
+	ret.format = aFormat;
+	ret.width = std::size_t(aImage.width);
+	ret.height = std::size_t(aImage.height);
+
+	std::size_t const levels = mip_level_count( ret.width, ret.height );
+	ret.levels.resize( levels );
+
+	// Only the current level is kept uncompressed; the next is made from
+	// it before it is dropped.
+	std::uint8_t const* src = aImage.pixels.get();
+	std::vector<std::uint8_t> current, next;
+
+	std::size_t w = ret.width, h = ret.height;
+	for( std::size_t i = 0; i < levels; ++i )
+	{
+		auto& level = ret.levels[i];
+		level.resize( compressed_size( aFormat, w, h ) );
+
+		// A block row of a 4K level is 16K pixels
+		parallel_for( block_count( h ), 16, [&] (std::size_t aBegin, std::size_t aEnd) {
+			encode_blocks( aFormat, src, w, h, level.data(), aBegin, aEnd - aBegin );
+		} );
+
+		if( i + 1 == levels )
+			break;
+
+		std::size_t const nw = mip_extent( w ), nh = mip_extent( h );
+		next.resize( 4 * nw * nh );
+
+		parallel_for( nh, 64, [&] (std::size_t aBegin, std::size_t aEnd) {
+			downsample_srgb( src, w, h, next.data(), aBegin, aEnd - aBegin );
+		} );
+
+		std::swap( current, next );
+		src = current.data();
+		w = nw;
+		h = nh;
+	}
+
+	return ret;
+}
+
+
+CachedTexture::CachedTexture( char const* aCachePath )
+	: mFile( aCachePath )
+{
+	FileHeader_ header;
+	if( mFile.size() < sizeof(header) )
+		throw Error( "CachedTexture: '%s' is too small for a texture cache", aCachePath );
+
+	std::memcpy( &header, mFile.data(), sizeof(header) );
+	if( 0 != std::memcmp( header.magic, kMagic_, sizeof(kMagic_) ) )
+		throw Error( "CachedTexture: '%s' is not a texture cache", aCachePath );
+	if( kTextureCacheVersion != header.version || sizeof(header) != header.headerSize )
+		throw Error( "CachedTexture: '%s' has version %u, expected %u", aCachePath, header.version, kTextureCacheVersion );
+
+	if( header.format > std::uint32_t(BlockFormat::bc7) )
+		throw Error( "CachedTexture: '%s' has unknown format %u", aCachePath, header.format );
+	if( 0 == header.levelCount || header.levelCount > kMaxLevels_ )
+		throw Error( "CachedTexture: '%s' has %u levels", aCachePath, header.levelCount );
+
+	mSource = CacheSource{ header.sourceSize, header.sourceTime, header.sourceHash };
+	mFormat = BlockFormat(header.format);
+
+	std::size_t w = header.levels[0].width, h = header.levels[0].height;
+	if( header.levelCount != mip_level_count( w, h ) )
+		throw Error( "CachedTexture: '%s' has %u levels, expected %zu", aCachePath, header.levelCount, mip_level_count( w, h ) );
+
+	mLevels.reserve( header.levelCount );
+	for( std::size_t i = 0; i < header.levelCount; ++i )
+	{
+		LevelHeader_ const& level = header.levels[i];
+		if( w != level.width || h != level.height || compressed_size( mFormat, w, h ) != level.size || 0 != level.offset % kAlignment_ )
+			throw Error( "CachedTexture: level %zu of '%s' has an unexpected layout", i, aCachePath );
+		if( level.offset > mFile.size() || level.size > mFile.size() - level.offset )
+			throw Error( "CachedTexture: level %zu of '%s' is truncated", i, aCachePath );
+
+		auto const* data = static_cast<std::uint8_t const*>(mFile.data()) + level.offset;
+		mLevels.emplace_back( TextureLevel{ data, std::size_t(level.size), w, h } );
+
+		w = mip_extent( w );
+		h = mip_extent( h );
+	}
+}
+
+CachedTexture::CachedTexture( BakedTexture&& aTexture, CacheSource const& aSource )
+	: mOwned( std::make_unique<BakedTexture>( std::move(aTexture) ) )
+	, mSource( aSource )
+	, mFormat( mOwned->format )
+{
+	std::size_t w = mOwned->width, h = mOwned->height;
+
+	mLevels.reserve( mOwned->levels.size() );
+	for( auto const& level : mOwned->levels )
+	{
+		mLevels.emplace_back( TextureLevel{ level.data(), level.size(), w, h } );
+
+		w = mip_extent( w );
+		h = mip_extent( h );
+	}
+}
+
+std::size_t CachedTexture::size() const noexcept
+{
+	std::size_t ret = 0;
+	for( auto const& level : mLevels )
+		ret += level.size;
+	return ret;
+}
+
+
+void write_texture_cache( char const* aCachePath, CacheSource const& aSource, BakedTexture const& aTexture )
+{
+	assert( !aTexture.levels.empty() && aTexture.levels.size() <= kMaxLevels_ );
+
+	FileHeader_ header{};
+	std::memcpy( header.magic, kMagic_, sizeof(kMagic_) );
+	header.version = kTextureCacheVersion;
+	header.headerSize = sizeof(header);
+
+	header.sourceSize = aSource.size;
+	header.sourceTime = aSource.time;
+	header.sourceHash = aSource.hash;
+
+	header.format = std::uint32_t(aTexture.format);
+	header.levelCount = std::uint32_t(aTexture.levels.size());
+
+	std::size_t offset = align_( sizeof(header) );
+	std::size_t w = aTexture.width, h = aTexture.height;
+	for( std::size_t i = 0; i < aTexture.levels.size(); ++i )
+	{
+		std::size_t const bytes = aTexture.levels[i].size();
+		header.levels[i] = LevelHeader_{ offset, bytes, std::uint32_t(w), std::uint32_t(h) };
+		offset = align_( offset + bytes );
+
+		w = mip_extent( w );
+		h = mip_extent( h );
+	}
+
+	// Write to a temporary file, then replace the cache
+	std::string const tempPath = std::string(aCachePath) + ".tmp";
+
+	std::FILE* out = std::fopen( tempPath.c_str(), "wb" );
+	if( !out )
+		throw Error( "write_texture_cache(): unable to open '%s' for writing", tempPath.c_str() );
+
+	try
+	{
+		if( 1 != std::fwrite( &header, sizeof(header), 1, out ) )
+			throw Error( "write_texture_cache(): write to '%s' failed", tempPath.c_str() );
+
+		std::size_t written = sizeof(header);
+		for( auto const& level : aTexture.levels )
+		{
+			write_padding_( out, written );
+
+			if( 1 != std::fwrite( level.data(), level.size(), 1, out ) )
+				throw Error( "write_texture_cache(): write to '%s' failed", tempPath.c_str() );
+
+			written += level.size();
+		}
+		write_padding_( out, written );
+	}
+	catch( ... )
+	{
+		std::fclose( out );
+		std::remove( tempPath.c_str() );
+		throw;
+	}
+
+	if( 0 != std::fclose( out ) )
+	{
+		std::remove( tempPath.c_str() );
+		throw Error( "write_texture_cache(): unable to finish writing '%s'", tempPath.c_str() );
+	}
+
+	std::error_code err;
+	std::filesystem::rename( tempPath, aCachePath, err );
+	if( err )
+	{
+		std::remove( tempPath.c_str() );
+		throw Error( "write_texture_cache(): unable to replace '%s': %s", aCachePath, err.message().c_str() );
+	}
+}
+
+std::optional<CachedTexture> open_texture_cache( char const* aCachePath, char const* aSourcePath, BlockFormat aFormat, std::optional<CacheSource>* aSource )
+{
+	std::error_code err;
+	if( !std::filesystem::is_regular_file( aCachePath, err ) )
+		return std::nullopt;
+
+	std::optional<CachedTexture> ret;
+	try
+	{
+		ret.emplace( aCachePath );
+	}
+	catch( Error const& )
+	{
+		// Invalid or from an older version; rebuilt by the caller
+		return std::nullopt;
+	}
+
+	if( aFormat != ret->format() )
+		return std::nullopt;
+
+	if( !cache_source_current( ret->source(), aSourcePath, aSource ) )
+		return std::nullopt;
+
+	return ret;
+}
+
+std::string texture_cache_path( char const* aSourcePath, BlockFormat aFormat )
+{
+	return std::string(aSourcePath) + (BlockFormat::bc1 == aFormat ? ".bc1.texcache" : ".bc7.texcache");
+}
+
+CachedTexture load_texture_cached( char const* aPath, BlockFormat aFormat, bool* aCacheHit )
+{
+	std::string const cachePath = texture_cache_path( aPath, aFormat );
+
+	std::optional<CacheSource> source;
+	if( auto cached = open_texture_cache( cachePath.c_str(), aPath, aFormat, &source ) )
+	{
+		if( aCacheHit )
+			*aCacheHit = true;
+
+		return std::move(*cached);
+	}
+
+	if( aCacheHit )
+		*aCacheHit = false;
+
+	if( !source )
+		source = cache_source( aPath );
+
+	BakedTexture baked = bake_texture( decode_image( aPath ), aFormat );
+
+	try
+	{
+		write_texture_cache( cachePath.c_str(), *source, baked );
+		return CachedTexture( cachePath.c_str() );
+	}
+	catch( Error const& eErr )
+	{
+		std::fprintf( stderr, "Texture cache for '%s' not used: %s\n", aPath, eErr.what() );
+		return CachedTexture( std::move(baked), *source );
+	}
+}
+
+
+BlockFormat preferred_block_format()
+{
+	bool s3tc = false, srgb = false;
+
+	GLint count = 0;
+	glGetIntegerv( GL_NUM_EXTENSIONS, &count );
+	for( GLint i = 0; i < count; ++i )
+	{
+		auto const* name = reinterpret_cast<char const*>(glGetStringi( GL_EXTENSIONS, GLuint(i) ));
+		if( !name )
+			continue;
+
+		if( 0 == std::strcmp( name, "GL_EXT_texture_compression_s3tc" ) )
+			s3tc = true;
+		else if( 0 == std::strcmp( name, "GL_EXT_texture_sRGB" ) )
+			srgb = true;
+	}
+
+	return s3tc && srgb ? BlockFormat::bc1 : BlockFormat::bc7;
+}
+
+GLenum compressed_texture_format( BlockFormat aFormat ) noexcept
+{
+	return BlockFormat::bc1 == aFormat ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+}
+
+GLuint create_texture_storage_2d( CachedTexture const& aTexture )
+{
+	GLuint tex = 0;
+	glCreateTextures( GL_TEXTURE_2D, 1, &tex );
+	glTextureStorage2D( tex, GLsizei(aTexture.level_count()), compressed_texture_format( aTexture.format() ), GLsizei(aTexture.width()), GLsizei(aTexture.height()) );
+
+	glTextureParameteri( tex, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTextureParameteri( tex, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+	glTextureParameteri( tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTextureParameteri( tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glTextureParameterf( tex, GL_TEXTURE_MAX_ANISOTROPY, 6.f );
+	return tex;
+}
+
+GLuint create_texture_2d( CachedTexture const& aTexture )
+{
+	GLenum const format = compressed_texture_format( aTexture.format() );
+
+	GLuint const tex = create_texture_storage_2d( aTexture );
+	for( std::size_t i = 0; i < aTexture.level_count(); ++i )
+	{
+		TextureLevel const& level = aTexture.level( i );
+		glCompressedTextureSubImage2D( tex, GLint(i), 0, 0, GLsizei(level.width), GLsizei(level.height), format, GLsizei(level.size), level.data );
+	}
+
+	return tex;
+}
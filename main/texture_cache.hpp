@@ -0,0 +1,122 @@
+#ifndef TEXTURE_CACHE_HPP_6DAD99BA_57A7_40BF_A925_058F8E695706
+#define TEXTURE_CACHE_HPP_6DAD99BA_57A7_40BF_A925_058F8E695706
+
+#include <glad.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cache_source.hpp"
+#include "simple_mesh.hpp"
+#include "mapped_file.hpp"
+
+#include "../vmlib/texture_bake.hpp"
+
+// A full mip chain in memory, block compressed; levels[0] is the largest.
+struct BakedTexture
+{
+	BlockFormat format;
+	std::size_t width, height;
+	std::vector<std::vector<std::uint8_t>> levels;
+};
+
+// Makes the mip chain (sRGB-correct box filter) and compresses every level,
+// on parallel_for() threads.
+BakedTexture bake_texture( ImageData const&, BlockFormat );
+
+struct TextureLevel
+{
+	std::uint8_t const* data;
+	std::size_t size;
+	std::size_t width, height;
+};
+
+/** CachedTexture: a BakedTexture, mapped from a cache file or held in memory
+ *
+ * The levels point straight into the mapping, so they can be handed to
+ * glCompressedTextureSubImage2D() without being read first. Valid as long
+ * as the CachedTexture exists; moving it keeps them valid.
+ *
+ * Cache files (version kTextureCacheVersion) have a header with a table of
+ * levels, followed by the levels, each 16-byte aligned.
+ */
+constexpr std::uint32_t kTextureCacheVersion = 1;
+
+class CachedTexture final
+{
+	public:
+		// Maps the cache file; throws if it is not a valid cache file of
+		// this version.
+		explicit CachedTexture( char const* aCachePath );
+
+		// Keeps the texture in memory (e.g., when the cache cannot be
+		// written).
+		explicit CachedTexture( BakedTexture&&, CacheSource const& );
+
+		CachedTexture( CachedTexture&& ) noexcept = default;
+		CachedTexture& operator= (CachedTexture&&) noexcept = default;
+
+	public:
+		bool mapped() const noexcept { return nullptr != mFile.data(); }
+
+		CacheSource const& source() const noexcept { return mSource; }
+
+		BlockFormat format() const noexcept { return mFormat; }
+		std::size_t width() const noexcept { return mLevels.front().width; }
+		std::size_t height() const noexcept { return mLevels.front().height; }
+
+		std::size_t level_count() const noexcept { return mLevels.size(); }
+		TextureLevel const& level( std::size_t aLevel ) const noexcept { return mLevels[aLevel]; }
+
+		// Bytes of all levels
+		std::size_t size() const noexcept;
+
+	private:
+		MappedFile mFile;
+		std::unique_ptr<BakedTexture> mOwned;
+
+		CacheSource mSource{};
+		BlockFormat mFormat = BlockFormat::bc7;
+		std::vector<TextureLevel> mLevels;
+};
+
+// Writes the cache file (to a temporary file that then replaces
+// aCachePath). Throws on failure.
+void write_texture_cache( char const* aCachePath, CacheSource const&, BakedTexture const& );
+
+// Maps the cache file if it is valid, of format aFormat, and its source
+// still matches the image at aSourcePath. Otherwise returns nothing; fills
+// aSource as cache_source_current() does.
+std::optional<CachedTexture> open_texture_cache( char const* aCachePath, char const* aSourcePath, BlockFormat, std::optional<CacheSource>* aSource = nullptr );
+
+// Beside the image, with ".bc1.texcache" or ".bc7.texcache" appended.
+std::string texture_cache_path( char const* aSourcePath, BlockFormat );
+
+/* Loads the baked image: from its cache if that is current, and otherwise
+ * by decoding and baking it, then writing the cache beside the image. Safe
+ * to call from any thread (no GL calls).
+ */
+CachedTexture load_texture_cached( char const* aPath, BlockFormat, bool* aCacheHit = nullptr );
+
+
+// The smallest format that the current context can sample as sRGB: BC1
+// with EXT_texture_compression_s3tc and EXT_texture_sRGB, BC7 (core since
+// OpenGL 4.2) otherwise. GL thread only.
+BlockFormat preferred_block_format();
+
+// The sRGB internal format of the block format
+GLenum compressed_texture_format( BlockFormat ) noexcept;
+
+// Creates an immutable texture of the baked image's size, format and
+// number of levels, without uploading any of them.
+GLuint create_texture_storage_2d( CachedTexture const& );
+
+// Creates an immutable texture with all levels of the baked image.
+GLuint create_texture_2d( CachedTexture const& );
+
+#endif // TEXTURE_CACHE_HPP_6DAD99BA_57A7_40BF_A925_058F8E695706
@@ -0,0 +1,158 @@
+#include "texture_stream.hpp"
+
+#include <chrono>
+#include <utility>
+#include <algorithm>
+
+#include <cassert>
+#include <cstring>
+
+#include "../support/error.hpp"
+
+namespace
+{
+	using Clock_ = std::chrono::steady_clock;
+
+	std::size_t block_row_bytes_( BlockFormat aFormat, std::size_t aWidth ) noexcept
+	{
+		return block_count( aWidth ) * block_bytes( aFormat );
+	}
+}
+
+TextureStreamPosition texture_stream_start( CachedTexture const& aTexture ) noexcept
+{
+	// Smallest level first
+	return TextureStreamPosition{ aTexture.level_count() - 1, 0, false };
+}
+
+std::size_t plan_texture_strips( CachedTexture const& aTexture, TextureStreamPosition& aPosition, std::size_t aHead, std::size_t aEnd, std::vector<TextureStrip>& aStrips )
+{
+	std::size_t const alignment = block_bytes( aTexture.format() );
+
+	while( !aPosition.complete )
+	{
+		TextureLevel const& level = aTexture.level( aPosition.level );
+
+		std::size_t const offset = (aHead + alignment - 1) / alignment * alignment;
+		if( offset >= aEnd )
+			break;
+
+		std::size_t const rowBytes = block_row_bytes_( aTexture.format(), level.width );
+		std::size_t const rows = std::min( block_count( level.height ) - aPosition.blockRow, (aEnd - offset) / rowBytes );
+		if( 0 == rows )
+			break;
+
+		bool const completes = aPosition.blockRow + rows == block_count( level.height );
+		aStrips.emplace_back( TextureStrip{ aPosition.level, aPosition.blockRow, rows, offset, rows * rowBytes, completes } );
+		aHead = offset + rows * rowBytes;
+
+		aPosition.blockRow += rows;
+		if( !completes )
+			continue;
+
+		if( 0 == aPosition.level )
+			aPosition.complete = true;
+		else
+		{
+			--aPosition.level;
+			aPosition.blockRow = 0;
+		}
+	}
+
+	return aHead;
+}
+
+
+TextureStreamer::TextureStreamer( std::size_t aBytesPerFrame, std::size_t aFrames )
+	: mRing( aBytesPerFrame, aFrames )
+	, mBytesPerFrame( aBytesPerFrame )
+{}
+
+GLuint TextureStreamer::add( CachedTexture&& aTexture )
+{
+	// The widest rows are those of level 0
+	std::size_t const rowBytes = block_row_bytes_( aTexture.format(), aTexture.width() );
+	if( rowBytes > mBytesPerFrame )
+		throw Error( "TextureStreamer: a block row of %zu bytes does not fit into the %zu bytes of a frame", rowBytes, mBytesPerFrame );
+
+	GLuint const name = create_texture_storage_2d( aTexture );
+
+	// Nothing is complete yet; the smallest level is uploaded first.
+	TextureStreamPosition const start = texture_stream_start( aTexture );
+	glTextureParameteri( name, GL_TEXTURE_BASE_LEVEL, GLint(start.level) );
+
+	mStreams.emplace_back( Stream_{ std::move(aTexture), name, start } );
+	return name;
+}
+
+TextureStreamStats const& TextureStreamer::pump()
+{
+	auto const start = Clock_::now();
+
+	std::size_t bytes = 0;
+	if( !mStreams.empty() )
+	{
+		mRing.begin_frame();
+		glBindBuffer( GL_PIXEL_UNPACK_BUFFER, mRing.buffer() );
+
+		// The plan places the strips exactly where allocate() does, as the
+		// frame's region is used by nothing else.
+		std::size_t head = 0;
+		while( !mStreams.empty() )
+		{
+			Stream_& stream = mStreams.front();
+			CachedTexture const& texture = stream.texture;
+			GLenum const format = compressed_texture_format( texture.format() );
+
+			mStrips.clear();
+			head = plan_texture_strips( texture, stream.position, head, mBytesPerFrame, mStrips );
+
+			for( auto const& strip : mStrips )
+			{
+				TextureLevel const& level = texture.level( strip.level );
+				std::size_t const rowBytes = strip.size / strip.blockRows;
+
+				StreamAllocation const staging = mRing.allocate( strip.size, block_bytes( texture.format() ) );
+				std::memcpy( staging.data, level.data + strip.firstBlockRow * rowBytes, strip.size );
+
+				// Whole block rows; the last one may be cut off by the edge
+				// of the level.
+				std::size_t const y = 4 * strip.firstBlockRow;
+				std::size_t const height = std::min( 4 * strip.blockRows, level.height - y );
+
+				glCompressedTextureSubImage2D( stream.name, GLint(strip.level),
+					0, GLint(y), GLsizei(level.width), GLsizei(height),
+					format, GLsizei(strip.size), reinterpret_cast<void const*>(staging.offset)
+				);
+
+				bytes += strip.size;
+
+				// Level complete: let the sampler use it
+				if( strip.completesLevel )
+				{
+					glTextureParameteri( stream.name, GL_TEXTURE_BASE_LEVEL, GLint(strip.level) );
+					++mStats.levelsTotal;
+				}
+			}
+
+			if( !stream.position.complete )
+				break; // out of staging memory for this frame
+
+			mStreams.pop_front();
+		}
+
+		glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+		mRing.end_frame();
+	}
+
+	double const ms = std::chrono::duration<double, std::milli>( Clock_::now() - start ).count();
+
+	++mStats.frames;
+	mStats.bytesLastFrame = bytes;
+	mStats.millisecondsLastFrame = ms;
+	mStats.millisecondsPeak = std::max( mStats.millisecondsPeak, ms );
+	mStats.bytesTotal += bytes;
+	mStats.pending = mStreams.size();
+
+	return mStats;
+}
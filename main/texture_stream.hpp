@@ -0,0 +1,125 @@
+#ifndef TEXTURE_STREAM_HPP_17C7102C_3CCD_4894_84DA_F2B56F9F64A9
+#define TEXTURE_STREAM_HPP_17C7102C_3CCD_4894_84DA_F2B56F9F64A9
+
+#include <glad.h>
+
+#include <deque>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "stream_ring.hpp"
+#include "texture_cache.hpp"
+
+struct TextureStreamStats
+{
+	std::uint64_t frames;          // pump() calls
+	std::size_t bytesLastFrame;
+	double millisecondsLastFrame;
+	double millisecondsPeak;       // longest pump()
+
+	std::size_t bytesTotal;        // uploaded so far
+	std::size_t levelsTotal;       // levels completed so far
+	std::size_t pending;           // textures that are not complete yet
+};
+
+// Where the streaming of a texture is: the next block row of the level
+// being uploaded. The levels count down to 0.
+struct TextureStreamPosition
+{
+	std::size_t level;
+	std::size_t blockRow;
+	bool complete;
+};
+
+// Block rows [firstBlockRow, firstBlockRow+blockRows) of a level, staged at
+// offset in the frame's staging memory.
+struct TextureStrip
+{
+	std::size_t level;
+	std::size_t firstBlockRow, blockRows;
+	std::size_t offset, size;
+	bool completesLevel;
+};
+
+// The position of a texture that has nothing uploaded yet
+TextureStreamPosition texture_stream_start( CachedTexture const& ) noexcept;
+
+/* Plans the strips of the texture from aPosition on that fit into the
+ * staging memory from aHead to aEnd, and advances aPosition past them.
+ * Each strip starts at a multiple of the format's block size (as
+ * StreamRing::allocate() places it when given that alignment), so a plan
+ * that fits never makes allocate() throw. Appends to aStrips; returns the
+ * new head.
+ */
+std::size_t plan_texture_strips(
+	CachedTexture const&, TextureStreamPosition& aPosition,
+	std::size_t aHead, std::size_t aEnd,
+	std::vector<TextureStrip>& aStrips
+);
+
+/** TextureStreamer: uploads baked textures a little at a time
+ *
+ * add() creates the texture's immutable storage and returns it at once;
+ * pump() then uploads its levels from the smallest to the largest, at most
+ * aBytesPerFrame bytes per call. Large levels are split into strips of
+ * block rows. Each strip is copied into a StreamRing that is used as a
+ * pixel unpack buffer, so glCompressedTextureSubImage2D() returns without
+ * waiting for the copy to the texture.
+ *
+ * GL_TEXTURE_BASE_LEVEL always names the largest complete level: the
+ * texture can be sampled as soon as its smallest level is there (in the
+ * first pump() after add()) and gets sharper as the larger ones arrive.
+ *
+ *   TextureStreamer streamer( 2*1024*1024 );
+ *   GLuint tex = streamer.add( load_texture_cached( ... ) );
+ *   while( running )
+ *   {
+ *       streamer.pump();
+ *       // ... draw with tex
+ *   }
+ *
+ * The textures belong to the caller, who must not delete them while they
+ * are streamed. One block row of every level must fit into a frame; add()
+ * throws otherwise. Requires a current context for the lifetime of the
+ * streamer.
+ */
+class TextureStreamer final
+{
+	public:
+		explicit TextureStreamer( std::size_t aBytesPerFrame, std::size_t aFrames = 3 );
+
+		TextureStreamer( TextureStreamer const& ) = delete;
+		TextureStreamer& operator= (TextureStreamer const&) = delete;
+
+	public:
+		GLuint add( CachedTexture&& );
+
+		// Uploads up to the per-frame budget. GL thread only.
+		TextureStreamStats const& pump();
+
+		bool idle() const noexcept { return mStreams.empty(); }
+
+		TextureStreamStats const& stats() const noexcept { return mStats; }
+
+	private:
+		struct Stream_
+		{
+			CachedTexture texture;
+			GLuint name;
+
+			TextureStreamPosition position;
+		};
+
+	private:
+		StreamRing mRing;
+		std::size_t mBytesPerFrame;
+
+		std::deque<Stream_> mStreams; // oldest first
+		std::vector<TextureStrip> mStrips; // of the current pump()
+
+		TextureStreamStats mStats{};
+};
+
+#endif // TEXTURE_STREAM_HPP_17C7102C_3CCD_4894_84DA_F2B56F9F64A9
@@ -0,0 +1,96 @@
+#ifndef UNIFORM_BLOCKS_HPP_0FA15D71_F52A_4EFD_A6AA_AE5E765E6CE3
+#define UNIFORM_BLOCKS_HPP_0FA15D71_F52A_4EFD_A6AA_AE5E765E6CE3
+
+#include <glad.h>
+
+#include <cstring>
+
+#include "stream_ring.hpp"
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/mat44.hpp"
+
+// Uniform block bindings, as declared in the shaders in assets/.
+constexpr GLuint kObjectBlockBinding = 0;
+constexpr GLuint kLightBlockBinding = 1;
+constexpr GLuint kMaterialBlockBinding = 2;
+
+// std140 layout of ObjectBlock (row_major). Mat44f and Mat33f are row-major
+// as well; each row of the mat3 is padded to a vec4.
+struct ObjectUniforms
+{
+	float projCameraWorld[16];
+	float model[16];
+	float normalMatrix[12];
+};
+
+static_assert( sizeof(ObjectUniforms) == 176, "std140 layout of ObjectBlock" );
+
+// std140 layout of LightBlock. The vec3s are padded to vec4s.
+struct LightUniforms
+{
+	Vec4f lightDir;
+	Vec4f lightDiffuse;
+
+	Vec4f pointLightPos1, pointLightViewPos1;
+	Vec4f pointLightPos2, pointLightViewPos2;
+	Vec4f pointLightPos3, pointLightViewPos3;
+};
+
+static_assert( sizeof(LightUniforms) == 128, "std140 layout of LightBlock" );
+
+// std140 layout of MaterialBlock (see MaterialTable). specular.w is the
+// shininess.
+struct MaterialUniforms
+{
+	Vec4f ambient;
+	Vec4f diffuse;
+	Vec4f specular;
+};
+
+static_assert( sizeof(MaterialUniforms) == 48, "std140 layout of MaterialBlock" );
+
+
+// Write the block into this frame's region of the ring and return where it
+// is; bind it with bind_uniforms() before each draw that uses it.
+template< typename tBlock > inline
+StreamAllocation stream_uniforms( StreamRing& aRing, tBlock const& aBlock )
+{
+	StreamAllocation const ret = aRing.allocate( sizeof(tBlock), aRing.uniform_alignment() );
+	std::memcpy( ret.data, &aBlock, sizeof(tBlock) );
+	return ret;
+}
+
+inline
+StreamAllocation stream_object_uniforms( StreamRing& aRing, Mat44f const& aProjCameraWorld, Mat44f const& aModel, Mat33f const& aNormalMatrix )
+{
+	StreamAllocation const ret = aRing.allocate( sizeof(ObjectUniforms), aRing.uniform_alignment() );
+
+	// Straight into the mapped buffer
+	auto* block = static_cast<ObjectUniforms*>(ret.data);
+	std::memcpy( block->projCameraWorld, aProjCameraWorld.v, sizeof(block->projCameraWorld) );
+	std::memcpy( block->model, aModel.v, sizeof(block->model) );
+	for( int i = 0; i < 3; ++i )
+	{
+		std::memcpy( block->normalMatrix + 4*i, aNormalMatrix.v + 3*i, 3*sizeof(float) );
+		block->normalMatrix[4*i+3] = 0.f;
+	}
+
+	return ret;
+}
+
+inline
+void bind_uniforms( GLuint aBinding, StreamRing const& aRing, StreamAllocation const& aBlock )
+{
+	glBindBufferRange( GL_UNIFORM_BUFFER, aBinding, aRing.buffer(), aBlock.offset, GLsizeiptr(aBlock.size) );
+}
+
+inline
+Vec4f to_std140( Vec3f aVec ) noexcept
+{
+	return Vec4f{ aVec.x, aVec.y, aVec.z, 0.f };
+}
+
+#endif // UNIFORM_BLOCKS_HPP_0FA15D71_F52A_4EFD_A6AA_AE5E765E6CE3
@@ -0,0 +1,165 @@
+#ifndef VERTEX_FORMAT_HPP_C9F2CB61_7CED_4A54_95E3_3F9C874AE1C6
+#define VERTEX_FORMAT_HPP_C9F2CB61_7CED_4A54_95E3_3F9C874AE1C6
+
+#include <glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/packing.hpp"
+
+/* Compile-time vertex formats
+ *
+ * A VertexFormat lists the attributes that create_vao() (simple_mesh.hpp)
+ * interleaves into a single vertex buffer, in order. Each attribute type
+ * says where its data comes from (a SimpleMeshData stream), how it is
+ * encoded (see vmlib/packing.hpp) and how OpenGL reads it. The locations
+ * are the ones the shaders in assets/ use:
+ *
+ *   0  position   Pos3f (float), Pos4h (half, w = 1)
+ *   1  colour     Col3f (float), Col4u8 (unorm8, a = 1)
+ *   2  normal     Nrm3f (float), Nrm10 (snorm 10:10:10:2)
+ *   3  texcoord   Uv2f (float), Uv2h (half)
+ *   4  normal     NrmOct16 (octahedral, two snorm16)
+ *
+ * The shaders decode octahedral normals when location 2 is not enabled (it
+ * then reads as the default (0,0,0,1)). Half positions have an 11 bit
+ * mantissa and are only meant for meshes with small coordinates (e.g.,
+ * |x| < 1 gives an error below 2.5e-4).
+ *
+ * Example:
+ *   using Fmt = VertexFormat<Pos3f, Nrm3f, Uv2f>;
+ *   GLuint vao = create_vao( mesh, Fmt{} );
+ */
+template< typename... tAttribs >
+struct VertexFormat
+{
+	static_assert( sizeof...(tAttribs) > 0, "VertexFormat needs at least one attribute" );
+};
+
+// Attributes:
+// Four half floats (see Pos4h)
+struct Half4
+{
+	std::uint16_t x, y, z, w;
+};
+
+struct Pos3f
+{
+	using Type = Vec3f;
+	static constexpr GLuint kLocation = 0;
+	static constexpr GLint kComponents = 3;
+	static constexpr GLenum kGLType = GL_FLOAT;
+	static constexpr GLboolean kNormalized = GL_FALSE;
+
+	template< typename tMesh > static auto const& source( tMesh const& aMesh ) noexcept { return aMesh.positions; }
+	static Type encode( Vec3f aV ) noexcept { return aV; }
+};
+struct Pos4h
+{
+	using Type = Half4;
+	static constexpr GLuint kLocation = 0;
+	static constexpr GLint kComponents = 4;
+	static constexpr GLenum kGLType = GL_HALF_FLOAT;
+	static constexpr GLboolean kNormalized = GL_FALSE;
+
+	template< typename tMesh > static auto const& source( tMesh const& aMesh ) noexcept { return aMesh.positions; }
+	static Type encode( Vec3f aV ) noexcept
+	{
+		return Half4{ pack_half( aV.x ), pack_half( aV.y ), pack_half( aV.z ), pack_half( 1.f ) };
+	}
+};
+
+struct Col3f
+{
+	using Type = Vec3f;
+	static constexpr GLuint kLocation = 1;
+	static constexpr GLint kComponents = 3;
+	static constexpr GLenum kGLType = GL_FLOAT;
+	static constexpr GLboolean kNormalized = GL_FALSE;
+
+	template< typename tMesh > static auto const& source( tMesh const& aMesh ) noexcept { return aMesh.colors; }
+	static Type encode( Vec3f aC ) noexcept { return aC; }
+};
+struct Col4u8
+{
+	using Type = std::uint32_t;
+	static constexpr GLuint kLocation = 1;
+	static constexpr GLint kComponents = 4;
+	static constexpr GLenum kGLType = GL_UNSIGNED_BYTE;
+	static constexpr GLboolean kNormalized = GL_TRUE;
+
+	template< typename tMesh > static auto const& source( tMesh const& aMesh ) noexcept { return aMesh.colors; }
+	static Type encode( Vec3f aC ) noexcept { return pack_unorm8x4( { aC.x, aC.y, aC.z, 1.f } ); }
+};
+
+struct Nrm3f
+{
+	using Type = Vec3f;
+	static constexpr GLuint kLocation = 2;
+	static constexpr GLint kComponents = 3;
+	static constexpr GLenum kGLType = GL_FLOAT;
+	static constexpr GLboolean kNormalized = GL_FALSE;
+
+	template< typename tMesh > static auto const& source( tMesh const& aMesh ) noexcept { return aMesh.normals; }
+	static Type encode( Vec3f aN ) noexcept { return aN; }
+};
+struct Nrm10
+{
+	using Type = std::uint32_t;
+	static constexpr GLuint kLocation = 2;
+	static constexpr GLint kComponents = 4;
+	static constexpr GLenum kGLType = GL_INT_2_10_10_10_REV;
+	static constexpr GLboolean kNormalized = GL_TRUE;
+
+	template< typename tMesh > static auto const& source( tMesh const& aMesh ) noexcept { return aMesh.normals; }
+	static Type encode( Vec3f aN ) noexcept { return pack_snorm_2_10_10_10_rev( { aN.x, aN.y, aN.z, 0.f } ); }
+};
+struct NrmOct16
+{
+	using Type = std::uint32_t;
+	static constexpr GLuint kLocation = 4;
+	static constexpr GLint kComponents = 2;
+	static constexpr GLenum kGLType = GL_SHORT;
+	static constexpr GLboolean kNormalized = GL_TRUE;
+
+	template< typename tMesh > static auto const& source( tMesh const& aMesh ) noexcept { return aMesh.normals; }
+	static Type encode( Vec3f aN ) noexcept { return pack_oct_snorm16( aN ); }
+};
+
+struct Uv2f
+{
+	using Type = Vec2f;
+	static constexpr GLuint kLocation = 3;
+	static constexpr GLint kComponents = 2;
+	static constexpr GLenum kGLType = GL_FLOAT;
+	static constexpr GLboolean kNormalized = GL_FALSE;
+
+	template< typename tMesh > static auto const& source( tMesh const& aMesh ) noexcept { return aMesh.texcoords; }
+	static Type encode( Vec2f aT ) noexcept { return aT; }
+};
+struct Uv2h
+{
+	using Type = std::uint32_t;
+	static constexpr GLuint kLocation = 3;
+	static constexpr GLint kComponents = 2;
+	static constexpr GLenum kGLType = GL_HALF_FLOAT;
+	static constexpr GLboolean kNormalized = GL_FALSE;
+
+	template< typename tMesh > static auto const& source( tMesh const& aMesh ) noexcept { return aMesh.texcoords; }
+	static Type encode( Vec2f aT ) noexcept
+	{
+		return std::uint32_t(pack_half( aT.x )) | (std::uint32_t(pack_half( aT.y )) << 16);
+	}
+};
+
+
+// Formats used by main. 44, 24 and 20 bytes per vertex, respectively (36,
+// 20 and 16 without texture coordinates).
+using VertexFloat32 = VertexFormat<Pos3f, Col3f, Nrm3f, Uv2f>;
+using VertexPacked = VertexFormat<Pos3f, Col4u8, NrmOct16, Uv2h>;
+using VertexCompact = VertexFormat<Pos4h, Col4u8, Nrm10, Uv2h>;
+
+#endif // VERTEX_FORMAT_HPP_C9F2CB61_7CED_4A54_95E3_3F9C874AE1C6
@@ -134,6 +134,14 @@ project "vmlib"
 
 	files( sources )
 
+	-- Don't fuse multiplies and adds into FMA instructions (which -march=
+	-- native otherwise allows). vmlib relies on the scalar code giving the
+	-- same results as its SIMD versions (see vmlib/simd.hpp). Only vmlib
+	-- and its tests and benchmarks are built this way.
+	filter "toolset:gcc or toolset:clang"
+		buildoptions { "-ffp-contract=off" }
+	filter "*"
+
 project "vmlib-test"
 	local sources = { 
 		"vmlib-test/**.cpp",
@@ -152,4 +160,59 @@ project "vmlib-test"
 
 	files( sources )
 
+	-- As vmlib: the tests compare its SIMD results with scalar code built here
+	filter "toolset:gcc or toolset:clang"
+		buildoptions { "-ffp-contract=off" }
+	filter "*"
+
+project "vmlib-bench"
+	local sources = { 
+		"vmlib-bench/**.cpp",
+		"vmlib-bench/**.hpp",
+		"vmlib-bench/**.hxx",
+		"vmlib-bench/**.inl"
+	}
+
+	kind "ConsoleApp"
+	location "vmlib-bench"
+
+	files( sources )
+
+	links "vmlib"
+	links "x-catch2-nomain"
+
+	files( sources )
+
+	-- As vmlib, so that the scalar code timed here is the tested one
+	filter "toolset:gcc or toolset:clang"
+		buildoptions { "-ffp-contract=off" }
+	filter "*"
+
+project "main-test"
+	local sources = { 
+		"main-test/**.cpp",
+		"main-test/**.hpp",
+		"main-test/**.hxx",
+		"main-test/**.inl"
+	}
+
+	kind "ConsoleApp"
+	location "main-test"
+
+	files( sources )
+
+	-- main's code without its entry point. The tests do not open a window
+	-- or create a GL context, so they only cover the code that needs none.
+	files( "main/**.cpp" )
+	removefiles( "main/main.cpp" )
+
+	links "vmlib"
+	links "support"
+
+	links "x-stb"
+	links "x-glad"
+	links "x-catch2"
+
+	files( sources )
+
 --EOF
@@ -128,6 +128,17 @@ project( "x-catch2" )
 
 	files( "catch2/src/*.cpp" )
 
+-- Same as x-catch2, but without Catch2's main(). For programs that need to
+-- handle the command line or the results themselves (e.g., vmlib-bench).
+project( "x-catch2-nomain" )
+	kind "StaticLib"
+
+	location "."
+
+	files( "catch2/src/*.cpp" )
+
+	defines { "CATCH_AMALGAMATED_CUSTOM_MAIN=1" }
+
 project( "x-fontstash" )
 	kind "StaticLib"
 
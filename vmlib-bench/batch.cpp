@@ -0,0 +1,130 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <vector>
+
+#include "inputs.hpp"
+
+#include "../vmlib/batch.hpp"
+
+namespace
+{
+	std::vector<Vec3f> make_vectors_( std::size_t aCount )
+	{
+		std::vector<Vec3f> ret;
+		ret.reserve( aCount );
+		for( std::size_t i = 0; i < aCount; ++i )
+			ret.emplace_back( random_vec3() );
+		return ret;
+	}
+
+	std::string name_( char const* aName, std::size_t aCount )
+	{
+		return std::string(aName) + " n=" + std::to_string( aCount );
+	}
+}
+
+/* Benchmarks for the batched functions (batch.hpp)
+ *
+ * The data is transformed in place, repeatedly. The matrices are therefore
+ * chosen such that the values stay bounded: rotations, a tiny translation
+ * and a (nearly) affine projective matrix.
+ */
+TEST_CASE( "Batched", "[batch]" )
+{
+	Mat44f const rigid = make_translation( { 1e-3f, 0.f, -1e-3f } )
+		* make_rotation_x( 0.3f ) * make_rotation_y( -1.1f );
+
+	Mat44f projective = rigid;
+	projective.v[14] = 1e-7f; // not affine, but w stays close to 1
+
+	Mat33f const normalMatrix = make_normal_matrix( rigid );
+
+	for( std::size_t const count : kBatchSizes )
+	{
+		auto aos = make_vectors_( count );
+		auto soa = to_soa( aos.data(), aos.data() + aos.size() );
+		std::vector<Vec3f> out( count );
+		std::vector<float> lengths( count );
+
+		BENCHMARK( name_( "transform_points (affine, AoS)", count ) )
+		{
+			transform_points( rigid, aos.data(), aos.data() + aos.size() );
+			return aos.back();
+		};
+		BENCHMARK( name_( "transform_points (projective, AoS)", count ) )
+		{
+			transform_points( projective, aos.data(), aos.data() + aos.size() );
+			return aos.back();
+		};
+		BENCHMARK( name_( "transform_normals (AoS)", count ) )
+		{
+			transform_normals( normalMatrix, aos.data(), aos.data() + aos.size() );
+			return aos.back();
+		};
+		BENCHMARK( name_( "compute_bounds (AoS)", count ) )
+		{
+			return compute_bounds( aos.data(), aos.data() + aos.size() );
+		};
+		BENCHMARK( name_( "normalize (AoS)", count ) )
+		{
+			normalize( aos.data(), aos.data() + aos.size() );
+			return aos.back();
+		};
+		BENCHMARK( name_( "normalize<FastMath> (AoS)", count ) )
+		{
+			normalize<FastMath>( aos.data(), aos.data() + aos.size() );
+			return aos.back();
+		};
+
+		BENCHMARK( name_( "transform_points (affine, SoA)", count ) )
+		{
+			transform_points( rigid, soa );
+			return soa.x()[0];
+		};
+		BENCHMARK( name_( "transform_points (projective, SoA)", count ) )
+		{
+			transform_points( projective, soa );
+			return soa.x()[0];
+		};
+		BENCHMARK( name_( "transform_normals (SoA)", count ) )
+		{
+			transform_normals( normalMatrix, soa );
+			return soa.x()[0];
+		};
+		BENCHMARK( name_( "compute_bounds (SoA)", count ) )
+		{
+			return compute_bounds( soa );
+		};
+		BENCHMARK( name_( "normalize (SoA)", count ) )
+		{
+			normalize( soa );
+			return soa.x()[0];
+		};
+		BENCHMARK( name_( "normalize<FastMath> (SoA)", count ) )
+		{
+			normalize<FastMath>( soa );
+			return soa.x()[0];
+		};
+		BENCHMARK( name_( "length (SoA)", count ) )
+		{
+			length( soa, lengths.data() );
+			return lengths.back();
+		};
+		BENCHMARK( name_( "length<FastMath> (SoA)", count ) )
+		{
+			length<FastMath>( soa, lengths.data() );
+			return lengths.back();
+		};
+
+		BENCHMARK( name_( "to_soa", count ) )
+		{
+			return to_soa( aos.data(), aos.data() + aos.size() );
+		};
+		BENCHMARK( name_( "from_soa", count ) )
+		{
+			from_soa( soa, out.data() );
+			return out.back();
+		};
+	}
+}
@@ -0,0 +1,65 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "inputs.hpp"
+
+#include "../vmlib/mat44_expr.hpp"
+
+namespace
+{
+	// The projection * view * model product as one would write it by hand
+	// for a perspective projection and a translation-only model matrix.
+	Mat44f hand_written_( Perspective44f const& aP, Mat44f const& aV, Vec3f aT ) noexcept
+	{
+		Mat44f ret;
+		for( std::size_t j = 0; j < 4; ++j )
+		{
+			ret(0,j) = aP.sx * aV(0,j);
+			ret(1,j) = aP.sy * aV(1,j);
+			ret(2,j) = aP.a * aV(2,j) + aP.b * aV(3,j);
+			ret(3,j) = -aV(2,j);
+		}
+		for( std::size_t i = 0; i < 4; ++i )
+			ret(i,3) = ret(i,0) * aT.x + ret(i,1) * aT.y + ret(i,2) * aT.z + ret(i,3);
+		return ret;
+	}
+}
+
+// Benchmarks for mat44_expr.hpp: projection * view * model, as used per
+// object in main.cpp.
+TEST_CASE( "Mat44f expressions", "[mat44][expr]" )
+{
+	auto const views = make_inputs( random_affine );
+	auto const models = make_inputs( random_affine );
+	auto const translations = make_inputs( [] { return random_vec3(); } );
+	auto const vectors = make_inputs( [] { auto const v = random_vec3(); return Vec4f{ v.x, v.y, v.z, 1.f }; } );
+
+	Perspective44f const proj = make_perspective44f( 1.0472f, 1280.f/720.f, 0.1f, 100.f );
+	Mat44f const projFull = to_mat44( proj );
+
+	BENCHMARK( "P*V*T (Mat44f)", i )
+	{
+		return projFull * pick( views, i ) * make_translation( pick( translations, i ) );
+	};
+	BENCHMARK( "P*V*T (hand-written)", i )
+	{
+		return hand_written_( proj, pick( views, i ), pick( translations, i ) );
+	};
+	BENCHMARK( "P*V*T (structured)", i )
+	{
+		return proj * pick( views, i ) * Translation44f{ pick( translations, i ) };
+	};
+	BENCHMARK( "P*V*T (lazy)", i )
+	{
+		Mat44f const m = lazy( proj ) * pick( views, i ) * Translation44f{ pick( translations, i ) };
+		return m;
+	};
+
+	BENCHMARK( "P*V*M*v (Mat44f)", i )
+	{
+		return projFull * pick( views, i ) * pick( models, i ) * pick( vectors, i );
+	};
+	BENCHMARK( "P*V*M*v (lazy)", i )
+	{
+		return lazy( proj ) * pick( views, i ) * pick( models, i ) * pick( vectors, i );
+	};
+}
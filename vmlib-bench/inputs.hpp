@@ -0,0 +1,90 @@
+#ifndef INPUTS_HPP_BA0869AB_94B9_4D24_A85F_AF9678373B4C
+#define INPUTS_HPP_BA0869AB_94B9_4D24_A85F_AF9678373B4C
+
+#include <random>
+#include <vector>
+
+#include <cstddef>
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/mat44.hpp"
+
+/* Inputs for the benchmarks
+ *
+ * Each benchmark cycles through kInputs different (random) inputs, indexed
+ * by the iteration number that Catch2 passes to the measured function. This
+ * keeps the compiler from evaluating the function once and hoisting it out of
+ * the timing loop. The generator is seeded with a fixed value so that all
+ * runs see the same data.
+ */
+constexpr std::size_t kInputs = 64;
+
+// Batch sizes for the batched functions: a tiny mesh, a typical mesh that
+// fits into L1/L2 and a large one that does not.
+constexpr std::size_t kBatchSizes[] = { 16, 1024, 65536 };
+
+inline
+std::minstd_rand& input_rng()
+{
+	static std::minstd_rand rng( 3811 );
+	return rng;
+}
+
+inline
+float random_float( float aMin, float aMax )
+{
+	std::uniform_real_distribution<float> dist( aMin, aMax );
+	return dist( input_rng() );
+}
+
+inline
+Vec3f random_vec3( float aMin = -10.f, float aMax = 10.f )
+{
+	float const x = random_float( aMin, aMax );
+	float const y = random_float( aMin, aMax );
+	float const z = random_float( aMin, aMax );
+	return Vec3f{ x, y, z };
+}
+
+// Rotation + translation + (non-uniform) scaling; i.e., the kind of matrix
+// used for model transforms.
+inline
+Mat44f random_affine()
+{
+	float const ax = random_float( -3.f, 3.f );
+	float const ay = random_float( -3.f, 3.f );
+	float const sx = random_float( 0.5f, 2.f );
+	float const sy = random_float( 0.5f, 2.f );
+	float const sz = random_float( 0.5f, 2.f );
+	return make_translation( random_vec3() )
+		* make_rotation_x( ax ) * make_rotation_y( ay )
+		* make_scaling( sx, sy, sz );
+}
+
+// Perspective projection times an affine transform.
+inline
+Mat44f random_projective()
+{
+	float const fov = random_float( 0.5f, 1.5f );
+	return make_perspective_projection( fov, 1280.f/720.f, 0.1f, 100.f ) * random_affine();
+}
+
+template< typename tGen >
+auto make_inputs( tGen&& aGen )
+{
+	std::vector<decltype(aGen())> ret;
+	ret.reserve( kInputs );
+	for( std::size_t i = 0; i < kInputs; ++i )
+		ret.emplace_back( aGen() );
+	return ret;
+}
+
+// Input for iteration aI
+template< typename tType >
+tType const& pick( std::vector<tType> const& aInputs, int aI )
+{
+	return aInputs[std::size_t(aI) % kInputs];
+}
+
+#endif // INPUTS_HPP_BA0869AB_94B9_4D24_A85F_AF9678373B4C
@@ -0,0 +1,136 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <cstdio>
+
+#include "results.hpp"
+
+/* vmlib micro benchmarks
+ *
+ * Runs the Catch2 benchmarks (see the other files in this directory), writes
+ * the results to a CSV file and compares them against a stored baseline. The
+ * program exits with a non-zero status if any benchmark is slower than the
+ * baseline by more than the tolerance.
+ *
+ * Additional command line options (on top of Catch2's):
+ *   --results <file>      where to write the results
+ *                         (default: vmlib-bench-results.csv)
+ *   --baseline <file>     baseline to compare against
+ *                         (default: vmlib-bench/baseline.csv)
+ *   --tolerance <x>       allowed relative slowdown (default: 0.25)
+ *   --update-baseline     overwrite the baseline with the new results
+ *
+ * Only meaningful with the release configuration. The stored baseline is
+ * machine specific; run with --update-baseline after changing machines.
+ *
+ * Use e.g. --benchmark-samples to trade accuracy for run time, and the usual
+ * Catch2 test specs to run a subset, e.g. "[batch]".
+ */
+
+namespace
+{
+	// Records the results of each benchmark in bench_results().
+	class ResultListener_ final : public Catch::EventListenerBase
+	{
+		public:
+			using Catch::EventListenerBase::EventListenerBase;
+
+			void testCaseStarting( Catch::TestCaseInfo const& aInfo ) override
+			{
+				mTestCase = aInfo.name;
+			}
+
+			void benchmarkEnded( Catch::BenchmarkStats<> const& aStats ) override
+			{
+				std::vector<double> samples;
+				for( auto const& sample : aStats.samples )
+					samples.emplace_back( sample.count() );
+
+				auto const mid = samples.begin() + samples.size()/2;
+				std::nth_element( samples.begin(), mid, samples.end() );
+
+				bench_results().emplace_back( BenchResult{
+					mTestCase + "/" + aStats.info.name,
+					samples.empty() ? 0.0 : *mid,
+					aStats.mean.point.count(),
+					aStats.mean.lower_bound.count(),
+					aStats.mean.upper_bound.count(),
+					aStats.standardDeviation.point.count(),
+					aStats.samples.size()
+				} );
+			}
+
+		private:
+			std::string mTestCase;
+	};
+}
+
+CATCH_REGISTER_LISTENER( ResultListener_ )
+
+int main( int aArgc, char* aArgv[] )
+{
+	std::string resultsPath = "vmlib-bench-results.csv";
+	std::string baselinePath = "vmlib-bench/baseline.csv";
+	double tolerance = 0.25;
+	bool updateBaseline = false;
+
+	Catch::Session session;
+
+	using namespace Catch::Clara;
+	auto cli = session.cli()
+		| Opt( resultsPath, "file" )["--results"]( "where to write the results (CSV)" )
+		| Opt( baselinePath, "file" )["--baseline"]( "baseline to compare against (CSV)" )
+		| Opt( tolerance, "x" )["--tolerance"]( "allowed relative slowdown, e.g. 0.25" )
+		| Opt( updateBaseline )["--update-baseline"]( "overwrite the baseline with the results" )
+	;
+	session.cli( cli );
+
+	if( int const ret = session.applyCommandLine( aArgc, aArgv ); 0 != ret )
+		return ret;
+
+	int const failed = session.run();
+	if( 0 != failed )
+		return failed;
+
+	auto const& results = bench_results();
+	if( results.empty() )
+		return 0;
+
+	if( !write_results( resultsPath.c_str(), results ) )
+	{
+		std::fprintf( stderr, "Unable to write results to '%s'\n", resultsPath.c_str() );
+		return 1;
+	}
+	std::printf( "Wrote %zu results to '%s'\n", results.size(), resultsPath.c_str() );
+
+	if( updateBaseline )
+	{
+		if( !write_results( baselinePath.c_str(), results ) )
+		{
+			std::fprintf( stderr, "Unable to write baseline '%s'\n", baselinePath.c_str() );
+			return 1;
+		}
+		std::printf( "Updated baseline '%s'\n", baselinePath.c_str() );
+		return 0;
+	}
+
+	std::vector<BenchResult> baseline;
+	if( !read_results( baselinePath.c_str(), baseline ) )
+	{
+		std::printf( "No baseline '%s'; nothing to compare against\n", baselinePath.c_str() );
+		return 0;
+	}
+
+	std::printf( "\nComparing against '%s' (tolerance %.0f%%)\n", baselinePath.c_str(), 100.0 * tolerance );
+	std::size_t const regressions = compare_results( results, baseline, tolerance, stdout );
+	if( regressions )
+	{
+		std::printf( "%zu benchmark(s) regressed\n", regressions );
+		return 2;
+	}
+
+	return 0;
+}
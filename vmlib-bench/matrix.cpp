@@ -0,0 +1,87 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "inputs.hpp"
+
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/mat44.hpp"
+
+// Benchmarks for the Mat44f operations
+TEST_CASE( "Mat44f", "[mat44]" )
+{
+	auto const affine = make_inputs( random_affine );
+	auto const projective = make_inputs( random_projective );
+	auto const vectors = make_inputs( [] { auto const v = random_vec3(); return Vec4f{ v.x, v.y, v.z, 1.f }; } );
+
+	BENCHMARK( "operator*(Mat44f,Mat44f)", i )
+	{
+		return pick( projective, i ) * pick( affine, i+1 );
+	};
+	BENCHMARK( "operator*(Mat44f,Vec4f)", i )
+	{
+		return pick( projective, i ) * pick( vectors, i );
+	};
+
+	BENCHMARK( "transpose", i )
+	{
+		return transpose( pick( projective, i ) );
+	};
+
+	BENCHMARK( "invert (general)", i )
+	{
+		return invert( pick( projective, i ) );
+	};
+	BENCHMARK( "invert (affine)", i )
+	{
+		return invert( pick( affine, i ) );
+	};
+	BENCHMARK( "invert_affine", i )
+	{
+		return invert_affine( pick( affine, i ) );
+	};
+	BENCHMARK( "invert_rigid", i )
+	{
+		return invert_rigid( pick( affine, i ) );
+	};
+
+	BENCHMARK( "make_normal_matrix", i )
+	{
+		return make_normal_matrix( pick( affine, i ) );
+	};
+}
+
+// Benchmarks for the functions that construct matrices
+TEST_CASE( "Mat44f builders", "[mat44][make]" )
+{
+	auto const angles = make_inputs( [] { return random_float( -3.f, 3.f ); } );
+	auto const vectors = make_inputs( [] { return random_vec3(); } );
+
+	BENCHMARK( "make_rotation_x", i )
+	{
+		return make_rotation_x( pick( angles, i ) );
+	};
+	BENCHMARK( "make_rotation_y", i )
+	{
+		return make_rotation_y( pick( angles, i ) );
+	};
+	BENCHMARK( "make_rotation_z", i )
+	{
+		return make_rotation_z( pick( angles, i ) );
+	};
+	BENCHMARK( "make_translation", i )
+	{
+		return make_translation( pick( vectors, i ) );
+	};
+	BENCHMARK( "make_scaling", i )
+	{
+		auto const& s = pick( vectors, i );
+		return make_scaling( s.x, s.y, s.z );
+	};
+	BENCHMARK( "make_perspective_projection", i )
+	{
+		return make_perspective_projection( 1.f + 0.01f*pick( angles, i ), 1280.f/720.f, 0.1f, 100.f );
+	};
+	BENCHMARK( "lookAt", i )
+	{
+		return lookAt( pick( vectors, i ), pick( vectors, i+1 ), Vec3f{ 0.f, 1.f, 0.f } );
+	};
+}
@@ -0,0 +1,50 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "inputs.hpp"
+
+#include "../vmlib/quat.hpp"
+#include "../vmlib/transform.hpp"
+
+// Benchmarks for Quatf and Transform
+TEST_CASE( "Quatf", "[quat]" )
+{
+	auto const quats = make_inputs( [] { 
+		auto const axis = normalize( random_vec3() );
+		return make_quat_rotation( axis, random_float( -3.f, 3.f ) );
+	} );
+	auto const vectors = make_inputs( [] { return random_vec3(); } );
+	auto const transforms = make_inputs( [&, n = std::size_t(0)] () mutable {
+		auto const s = random_float( 0.5f, 2.f );
+		return Transform{ random_vec3(), quats[n++], { s, s, s } };
+	} );
+
+	BENCHMARK( "operator*(Quatf,Quatf)", i )
+	{
+		return pick( quats, i ) * pick( quats, i+1 );
+	};
+	BENCHMARK( "operator*(Quatf,Vec3f)", i )
+	{
+		return pick( quats, i ) * pick( vectors, i );
+	};
+	BENCHMARK( "nlerp", i )
+	{
+		return nlerp( pick( quats, i ), pick( quats, i+1 ), 0.3f );
+	};
+	BENCHMARK( "slerp", i )
+	{
+		return slerp( pick( quats, i ), pick( quats, i+1 ), 0.3f );
+	};
+	BENCHMARK( "to_mat44(Quatf)", i )
+	{
+		return to_mat44( pick( quats, i ) );
+	};
+
+	BENCHMARK( "operator*(Transform,Transform)", i )
+	{
+		return pick( transforms, i ) * pick( transforms, i+1 );
+	};
+	BENCHMARK( "to_mat44(Transform)", i )
+	{
+		return to_mat44( pick( transforms, i ) );
+	};
+}
@@ -0,0 +1,116 @@
+#include "results.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <cstdlib>
+#include <cstring>
+
+std::vector<BenchResult>& bench_results()
+{
+	static std::vector<BenchResult> results;
+	return results;
+}
+
+bool write_results( char const* aPath, std::vector<BenchResult> const& aResults )
+{
+	std::FILE* fout = std::fopen( aPath, "w" );
+	if( !fout )
+		return false;
+
+	std::fprintf( fout, "name,median_ns,mean_ns,low_ns,high_ns,stddev_ns,samples\n" );
+	for( auto const& res : aResults )
+	{
+		std::fprintf( fout, "\"%s\",%.3f,%.3f,%.3f,%.3f,%.3f,%zu\n", 
+			res.name.c_str(),
+			res.medianNs, res.meanNs, res.lowNs, res.highNs, res.stddevNs,
+			res.samples
+		);
+	}
+
+	bool const ok = !std::ferror( fout );
+	std::fclose( fout );
+	return ok;
+}
+
+bool read_results( char const* aPath, std::vector<BenchResult>& aResults )
+{
+	std::FILE* fin = std::fopen( aPath, "r" );
+	if( !fin )
+		return false;
+
+	char line[1024];
+	bool header = true;
+	while( std::fgets( line, sizeof(line), fin ) )
+	{
+		if( header )
+		{
+			header = false;
+			continue;
+		}
+
+		// The name is quoted, since it may contain commas.
+		if( '"' != line[0] )
+			continue;
+
+		char* quote = std::strchr( line+1, '"' );
+		if( !quote || ',' != quote[1] )
+			continue;
+
+		BenchResult res{};
+		res.name.assign( line+1, quote );
+
+		char* ptr = quote+2;
+		res.medianNs = std::strtod( ptr, &ptr ); ++ptr;
+		res.meanNs = std::strtod( ptr, &ptr ); ++ptr;
+		res.lowNs = std::strtod( ptr, &ptr ); ++ptr;
+		res.highNs = std::strtod( ptr, &ptr ); ++ptr;
+		res.stddevNs = std::strtod( ptr, &ptr ); ++ptr;
+		res.samples = std::strtoul( ptr, &ptr, 10 );
+
+		aResults.emplace_back( std::move(res) );
+	}
+
+	std::fclose( fin );
+	return true;
+}
+
+std::size_t compare_results( std::vector<BenchResult> const& aResults, std::vector<BenchResult> const& aBaseline, double aTolerance, std::FILE* aOut )
+{
+	std::unordered_map<std::string, BenchResult const*> baseline;
+	for( auto const& res : aBaseline )
+		baseline[res.name] = &res;
+
+	std::size_t width = 0;
+	for( auto const& res : aResults )
+		width = std::max( width, res.name.size() );
+
+	std::fprintf( aOut, "%-*s %12s %12s %8s\n", int(width), "benchmark (median)", "baseline ns", "current ns", "change" );
+
+	std::size_t regressions = 0;
+	for( auto const& res : aResults )
+	{
+		auto const it = baseline.find( res.name );
+		if( baseline.end() == it )
+		{
+			std::fprintf( aOut, "%-*s %12s %12.2f %8s\n", int(width), res.name.c_str(), "-", res.medianNs, "new" );
+			continue;
+		}
+
+		auto const& base = *it->second;
+		double const change = res.medianNs / base.medianNs - 1.0;
+
+		bool const regressed = change > aTolerance;
+		if( regressed )
+			++regressions;
+
+		std::fprintf( aOut, "%-*s %12.2f %12.2f %+7.1f%%%s\n", 
+			int(width), res.name.c_str(), 
+			base.medianNs, res.medianNs, 
+			100.0 * change,
+			regressed ? "  REGRESSION" : ""
+		);
+	}
+
+	return regressions;
+}
@@ -0,0 +1,52 @@
+#ifndef RESULTS_HPP_FF9780D9_F657_49DF_AB34_691D6D6A5190
+#define RESULTS_HPP_FF9780D9_F657_49DF_AB34_691D6D6A5190
+
+#include <string>
+#include <vector>
+
+#include <cstdio>
+#include <cstddef>
+
+/** BenchResult: timing of a single benchmark
+ *
+ * The name is "<test case>/<benchmark>", which is unique across the whole
+ * program. All times are per call of the benchmarked function, in
+ * nanoseconds. lowNs and highNs are the bounds of the confidence interval
+ * of the mean. The median of the samples is less sensitive to outliers
+ * (e.g., from other processes) than the mean, and is used for comparisons.
+ */
+struct BenchResult
+{
+	std::string name;
+
+	double medianNs;
+	double meanNs;
+	double lowNs;
+	double highNs;
+	double stddevNs;
+
+	std::size_t samples;
+};
+
+// Results collected during the current run (see main.cpp).
+std::vector<BenchResult>& bench_results();
+
+// Results are stored as CSV, with one header line and then one line per
+// benchmark:
+//   name,median_ns,mean_ns,low_ns,high_ns,stddev_ns,samples
+// The name is always quoted. Names must not contain double quotes.
+bool write_results( char const* aPath, std::vector<BenchResult> const& aResults );
+bool read_results( char const* aPath, std::vector<BenchResult>& aResults );
+
+// Compare aResults against aBaseline and print a table to aOut. A benchmark
+// has regressed if its median is more than aTolerance (relative, e.g. 0.1
+// for 10%) slower than the baseline. Benchmarks that are missing from the baseline are reported, but
+// are not considered regressions. Returns the number of regressions.
+std::size_t compare_results(
+	std::vector<BenchResult> const& aResults,
+	std::vector<BenchResult> const& aBaseline,
+	double aTolerance,
+	std::FILE* aOut
+);
+
+#endif // RESULTS_HPP_FF9780D9_F657_49DF_AB34_691D6D6A5190
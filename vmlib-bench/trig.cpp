@@ -0,0 +1,77 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <vector>
+
+#include <cmath>
+
+#include "inputs.hpp"
+
+#include "../vmlib/trig.hpp"
+
+namespace
+{
+	std::string name_( char const* aName, std::size_t aCount )
+	{
+		return std::string(aName) + " n=" + std::to_string( aCount );
+	}
+}
+
+// Benchmarks for trig.hpp, compared to the standard library
+TEST_CASE( "Trig", "[trig]" )
+{
+	auto const angles = make_inputs( [] { return random_float( -10.f, 10.f ); } );
+
+	BENCHMARK( "std::sin + std::cos", i )
+	{
+		float const a = pick( angles, i );
+		return std::sin( a ) + std::cos( a );
+	};
+	BENCHMARK( "sincos", i )
+	{
+		auto const sc = sincos( pick( angles, i ) );
+		return sc.sin + sc.cos;
+	};
+
+	BENCHMARK( "std::atan", i )
+	{
+		return std::atan( pick( angles, i ) );
+	};
+}
+
+TEST_CASE( "Trig batched", "[trig][batch]" )
+{
+	for( std::size_t const count : kBatchSizes )
+	{
+		std::vector<float> in( count ), s( count ), c( count );
+		for( auto& x : in )
+			x = random_float( -10.f, 10.f );
+
+		BENCHMARK( name_( "std::sin + std::cos loop", count ) )
+		{
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				s[i] = std::sin( in[i] );
+				c[i] = std::cos( in[i] );
+			}
+			return s.back() + c.back();
+		};
+		BENCHMARK( name_( "sincos_batch", count ) )
+		{
+			sincos_batch( in.data(), count, s.data(), c.data() );
+			return s.back() + c.back();
+		};
+
+		BENCHMARK( name_( "std::atan loop", count ) )
+		{
+			for( std::size_t i = 0; i < count; ++i )
+				s[i] = std::atan( in[i] );
+			return s.back();
+		};
+		BENCHMARK( name_( "atan_batch", count ) )
+		{
+			atan_batch( in.data(), count, s.data() );
+			return s.back();
+		};
+	}
+}
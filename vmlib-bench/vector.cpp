@@ -0,0 +1,44 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "inputs.hpp"
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/vec4.hpp"
+
+// Benchmarks for the Vec3f/Vec4f operations
+TEST_CASE( "Vec3f", "[vec3]" )
+{
+	auto const vectors = make_inputs( [] { return random_vec3(); } );
+
+	BENCHMARK( "dot", i )
+	{
+		return dot( pick( vectors, i ), pick( vectors, i+1 ) );
+	};
+	BENCHMARK( "cross", i )
+	{
+		return cross( pick( vectors, i ), pick( vectors, i+1 ) );
+	};
+	BENCHMARK( "length", i )
+	{
+		return length( pick( vectors, i ) );
+	};
+	BENCHMARK( "normalize", i )
+	{
+		return normalize( pick( vectors, i ) );
+	};
+}
+
+// Benchmarks for the accuracy policies (precision.hpp)
+TEST_CASE( "Vec3f FastMath", "[vec3][fastmath]" )
+{
+	auto const vectors = make_inputs( [] { return random_vec3(); } );
+
+	BENCHMARK( "length<FastMath>", i )
+	{
+		return length<FastMath>( pick( vectors, i ) );
+	};
+	BENCHMARK( "normalize<FastMath>", i )
+	{
+		return normalize<FastMath>( pick( vectors, i ) );
+	};
+}
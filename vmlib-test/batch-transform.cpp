@@ -0,0 +1,105 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+
+#include "../vmlib/batch.hpp"
+
+namespace
+{
+	// A handful of points with non-trivial coordinates. The count is not a
+	// multiple of four to exercise the non-SIMD tail.
+	std::vector<Vec3f> make_points_( std::size_t aCount )
+	{
+		std::vector<Vec3f> ret;
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float const f = float(i);
+			ret.emplace_back( Vec3f{ 0.5f*f - 1.f, 2.f - 0.25f*f, 0.125f*f*f } );
+		}
+		return ret;
+	}
+}
+
+// Test case to verify that transforming a batch of points matches
+// transforming the points one by one
+TEST_CASE( "Batched point transform", "[batch][mat44]" )
+{
+	static constexpr float kEps_ = 1e-6f;
+
+	using namespace Catch::Matchers;
+
+	auto const check = [] ( Mat44f const& aM ) {
+		auto points = make_points_( 11 );
+		auto const reference = points;
+
+		transform_points( aM, points.data(), points.data() + points.size() );
+
+		for( std::size_t i = 0; i < points.size(); ++i )
+		{
+			Vec3f const& p = reference[i];
+			Vec4f t = aM * Vec4f{ p.x, p.y, p.z, 1.f };
+			t /= t.w;
+
+			REQUIRE_THAT( points[i].x, WithinAbs( t.x, kEps_ ) );
+			REQUIRE_THAT( points[i].y, WithinAbs( t.y, kEps_ ) );
+			REQUIRE_THAT( points[i].z, WithinAbs( t.z, kEps_ ) );
+		}
+	};
+
+	// Affine matrix: the division by w is skipped
+	SECTION( "Affine" )
+	{
+		auto const M = make_translation( { 1.f, -2.f, 3.f } )
+			* make_rotation_y( 0.3f )
+			* make_scaling( 0.7f, 0.1f, 0.2f );
+		REQUIRE( is_affine( M ) );
+
+		check( M );
+	}
+
+	// Projective matrix: the result is divided by w
+	SECTION( "Projective" )
+	{
+		auto const M = make_perspective_projection( 1.f, 1.5f, 0.1f, 100.f )
+			* make_translation( { 0.f, 0.f, -5.f } );
+		REQUIRE( !is_affine( M ) );
+
+		check( M );
+	}
+
+	// Empty range is a no-op
+	SECTION( "Empty" )
+	{
+		Vec3f p{ 1.f, 2.f, 3.f };
+		transform_points( kIdentity44f, &p, &p );
+
+		REQUIRE_THAT( p.x, WithinAbs( 1.f, kEps_ ) );
+		REQUIRE_THAT( p.y, WithinAbs( 2.f, kEps_ ) );
+		REQUIRE_THAT( p.z, WithinAbs( 3.f, kEps_ ) );
+	}
+}
+
+// Test case to verify that transforming a batch of normals matches
+// transforming the normals one by one
+TEST_CASE( "Batched normal transform", "[batch][mat33]" )
+{
+	static constexpr float kEps_ = 1e-6f;
+
+	using namespace Catch::Matchers;
+
+	Mat33f const N = mat44_to_mat33( make_rotation_x( 0.7f ) * make_scaling( 2.f, 1.f, 0.5f ) );
+
+	auto normals = make_points_( 9 );
+	auto const reference = normals;
+
+	transform_normals( N, normals.data(), normals.data() + normals.size() );
+
+	for( std::size_t i = 0; i < normals.size(); ++i )
+	{
+		Vec3f const n = N * reference[i];
+
+		REQUIRE_THAT( normals[i].x, WithinAbs( n.x, kEps_ ) );
+		REQUIRE_THAT( normals[i].y, WithinAbs( n.y, kEps_ ) );
+		REQUIRE_THAT( normals[i].z, WithinAbs( n.z, kEps_ ) );
+	}
+}
@@ -0,0 +1,133 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/batch.hpp"
+
+namespace
+{
+	// Distance between two floats in ULPs (i.e., how many representable
+	// floats lie between them).
+	std::int64_t ulp_distance_( float aA, float aB )
+	{
+		auto const ordered = [] (float aX) {
+			std::int32_t i;
+			std::memcpy( &i, &aX, sizeof(i) );
+			return i < 0 ? std::int64_t(INT32_MIN) - i : std::int64_t(i);
+		};
+
+		auto const d = ordered( aA ) - ordered( aB );
+		return d < 0 ? -d : d;
+	}
+
+	std::vector<Vec3f> make_vectors_( std::size_t aCount )
+	{
+		std::minstd_rand rng( 3811 );
+		std::uniform_real_distribution<float> dist( -10.f, 10.f );
+
+		std::vector<Vec3f> ret;
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float const x = dist( rng );
+			float const y = dist( rng );
+			float const z = dist( rng );
+			ret.emplace_back( Vec3f{ x, y, z } );
+		}
+		return ret;
+	}
+}
+
+// Test case to verify the error bounds documented in precision.hpp
+TEST_CASE( "FastMath error", "[fastmath]" )
+{
+	// [1,4) covers all mantissas with both an even and an odd exponent. Every
+	// third float is enough to find the worst case, and keeps the test fast
+	// in debug builds.
+	SECTION( "rsqrt and sqrt" )
+	{
+		std::int64_t maxRsqrt = 0, maxSqrt = 0;
+		for( float x = 1.f; x < 4.f; x = std::nextafter( std::nextafter( std::nextafter( x, 5.f ), 5.f ), 5.f ) )
+		{
+			maxRsqrt = std::max( maxRsqrt, ulp_distance_( FastMath::rsqrt( x ), PreciseMath::rsqrt( x ) ) );
+			maxSqrt = std::max( maxSqrt, ulp_distance_( FastMath::sqrt( x ), PreciseMath::sqrt( x ) ) );
+		}
+
+		REQUIRE( maxRsqrt <= 5 );
+		REQUIRE( maxSqrt <= 4 );
+	}
+
+	SECTION( "normalize" )
+	{
+		std::int64_t maxUlp = 0;
+		for( auto const v : make_vectors_( 10000 ) )
+		{
+			Vec3f const p = normalize<PreciseMath>( v );
+			Vec3f const f = normalize<FastMath>( v );
+
+			for( std::size_t i = 0; i < 3; ++i )
+			{
+				if( std::abs( p[i] ) > 1e-3f )
+					maxUlp = std::max( maxUlp, ulp_distance_( f[i], p[i] ) );
+				else
+					REQUIRE( std::abs( f[i] - p[i] ) < 3e-7f );
+			}
+		}
+
+		REQUIRE( maxUlp <= 5 );
+	}
+
+	SECTION( "Zero" )
+	{
+		REQUIRE( 0.f == length<FastMath>( Vec3f{ 0.f, 0.f, 0.f } ) );
+		REQUIRE( 0.f == length<PreciseMath>( Vec3f{ 0.f, 0.f, 0.f } ) );
+	}
+}
+
+// Test case to verify that the batched versions match the scalar ones
+TEST_CASE( "Batched normalize/length", "[fastmath][batch]" )
+{
+	// 13: not a multiple of any SIMD width
+	auto const vectors = make_vectors_( 13 );
+
+	auto check_ = [&] (auto aMath) {
+		using Math_ = decltype(aMath);
+
+		auto aos = vectors;
+		normalize<Math_>( aos.data(), aos.data() + aos.size() );
+
+		auto soa = to_soa( vectors.data(), vectors.data() + vectors.size() );
+		std::vector<float> lengths( soa.size() );
+		length<Math_>( soa, lengths.data() );
+		normalize<Math_>( soa );
+
+		for( std::size_t i = 0; i < vectors.size(); ++i )
+		{
+			Vec3f const n = normalize<Math_>( vectors[i] );
+			REQUIRE( aos[i].x == n.x );
+			REQUIRE( aos[i].y == n.y );
+			REQUIRE( aos[i].z == n.z );
+
+			Vec3f const s = soa.get( i );
+			REQUIRE( s.x == n.x );
+			REQUIRE( s.y == n.y );
+			REQUIRE( s.z == n.z );
+
+			REQUIRE( lengths[i] == length<Math_>( vectors[i] ) );
+		}
+	};
+
+	SECTION( "Precise" )
+	{
+		check_( PreciseMath{} );
+	}
+	SECTION( "Fast" )
+	{
+		check_( FastMath{} );
+	}
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/mat44.hpp"
+
+// Test case to verify the different matrix inverses
+TEST_CASE( "4x4 matrix inverse", "[inverse][mat44]" )
+{
+	static constexpr float kEps_ = 1e-5f;
+
+	using namespace Catch::Matchers;
+
+	auto const check_identity = [] ( Mat44f const& aM ) {
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( aM.v[i], WithinAbs( kIdentity44f.v[i], kEps_ ) );
+	};
+
+	// Projective matrix: takes the general path
+	SECTION( "General" )
+	{
+		auto const M = make_perspective_projection( 1.f, 1.5f, 0.1f, 100.f )
+			* make_translation( { 1.f, 2.f, -5.f } );
+
+		check_identity( M * invert( M ) );
+		check_identity( invert( M ) * M );
+	}
+
+	// Affine matrix with non-uniform scaling
+	SECTION( "Affine" )
+	{
+		auto const M = make_translation( { 1.f, -2.f, 3.f } )
+			* make_rotation_z( 0.4f )
+			* make_scaling( 0.7f, 0.1f, 0.2f );
+
+		check_identity( M * invert_affine( M ) );
+		check_identity( invert_affine( M ) * M );
+	}
+
+	// Rotation and translation only
+	SECTION( "Rigid" )
+	{
+		auto const M = make_translation( { -5.7f, -0.6f, -2.f } )
+			* make_rotation_z( 1.5708f )
+			* make_rotation_y( 0.3f );
+
+		check_identity( M * invert_rigid( M ) );
+
+		auto const A = invert_affine( M );
+		auto const R = invert_rigid( M );
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( R.v[i], WithinAbs( A.v[i], kEps_ ) );
+	}
+}
+
+// Test case to verify that the normal matrix matches the inverse transpose
+TEST_CASE( "Normal matrix", "[inverse][mat33]" )
+{
+	static constexpr float kEps_ = 1e-5f;
+
+	using namespace Catch::Matchers;
+
+	auto const M = make_translation( { 4.f, 0.f, -1.f } )
+		* make_rotation_x( -0.8f )
+		* make_scaling( 0.2f, 0.1f, 0.1f );
+
+	// Reference: compute the full inverse with the general cofactor expansion.
+	// invert() forwards affine matrices to invert_affine(), so perturb the
+	// last row slightly to force the general path.
+	auto P = M;
+	P(3,0) = 1e-20f;
+	auto const reference = mat44_to_mat33( transpose( invert( P ) ) );
+
+	auto const N = make_normal_matrix( M );
+
+	for( std::size_t i = 0; i < 9; ++i )
+		REQUIRE_THAT( N.v[i], WithinRel( reference.v[i], kEps_ ) || WithinAbs( reference.v[i], kEps_ ) );
+}
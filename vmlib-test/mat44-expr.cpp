@@ -0,0 +1,125 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <type_traits>
+
+#include "../vmlib/mat44_expr.hpp"
+
+namespace
+{
+	constexpr float kEps_ = 1e-5f;
+
+	void require_equal_( Mat44f const& aA, Mat44f const& aB )
+	{
+		using namespace Catch::Matchers;
+
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( aA.v[i], WithinAbs( aB.v[i], kEps_ ) );
+	}
+	void require_equal_( Vec4f const& aA, Vec4f const& aB )
+	{
+		using namespace Catch::Matchers;
+
+		REQUIRE_THAT( aA.x, WithinAbs( aB.x, kEps_ ) );
+		REQUIRE_THAT( aA.y, WithinAbs( aB.y, kEps_ ) );
+		REQUIRE_THAT( aA.z, WithinAbs( aB.z, kEps_ ) );
+		REQUIRE_THAT( aA.w, WithinAbs( aB.w, kEps_ ) );
+	}
+}
+
+// Test case to verify that the known-structure products match the full ones
+TEST_CASE( "Structured 4x4 products", "[mat44][expr]" )
+{
+	Mat44f const M = make_rotation_x( 0.3f ) * make_rotation_y( -1.2f )
+		* make_translation( { 1.f, -2.f, 3.f } );
+
+	Translation44f const T{ { -24.5f, -0.97f, -54.f } };
+	Scaling44f const S{ { 2.f, 0.5f, 3.f } };
+	Perspective44f const P = make_perspective44f( 1.0472f, 1280.f/720.f, 0.1f, 100.f );
+
+	SECTION( "to_mat44" )
+	{
+		require_equal_( to_mat44( T ), make_translation( T.t ) );
+		require_equal_( to_mat44( S ), make_scaling( 2.f, 0.5f, 3.f ) );
+		require_equal_( to_mat44( P ), make_perspective_projection( 1.0472f, 1280.f/720.f, 0.1f, 100.f ) );
+		require_equal_( to_mat44( Identity44f{} ), kIdentity44f );
+	}
+
+	SECTION( "Left and right" )
+	{
+		require_equal_( T * M, to_mat44( T ) * M );
+		require_equal_( M * T, M * to_mat44( T ) );
+		require_equal_( S * M, to_mat44( S ) * M );
+		require_equal_( M * S, M * to_mat44( S ) );
+		require_equal_( P * M, to_mat44( P ) * M );
+		require_equal_( M * P, M * to_mat44( P ) );
+	}
+
+	SECTION( "Folding" )
+	{
+		static_assert( std::is_same_v<decltype(T * T), Translation44f> );
+		static_assert( std::is_same_v<decltype(S * S), Scaling44f> );
+		static_assert( std::is_same_v<decltype(Identity44f{} * P), Perspective44f> );
+
+		require_equal_( to_mat44( T * T ), to_mat44( T ) * to_mat44( T ) );
+		require_equal_( to_mat44( S * S ), to_mat44( S ) * to_mat44( S ) );
+		require_equal_( T * S, to_mat44( T ) * to_mat44( S ) );
+	}
+
+	SECTION( "Vectors" )
+	{
+		Vec4f const v{ 1.f, 2.f, -3.f, 1.f };
+		require_equal_( T * v, to_mat44( T ) * v );
+		require_equal_( S * v, to_mat44( S ) * v );
+		require_equal_( P * v, to_mat44( P ) * v );
+	}
+}
+
+// Test case to verify lazy product expressions
+TEST_CASE( "Lazy 4x4 products", "[mat44][expr]" )
+{
+	Mat44f const V = make_rotation_x( 0.3f ) * make_rotation_y( -1.2f )
+		* make_translation( { 1.f, -2.f, 3.f } );
+	Mat44f const M = make_rotation_z( 0.7f ) * make_scaling( 1.f, 2.f, 1.f );
+
+	Translation44f const T{ { -5.7f, -0.97f, -2.f } };
+	Perspective44f const P = make_perspective44f( 1.0472f, 1280.f/720.f, 0.1f, 100.f );
+
+	Mat44f const full = to_mat44( P ) * V * M * to_mat44( T );
+
+	SECTION( "Evaluation" )
+	{
+		auto const expr = lazy( P ) * V * M * T;
+		Mat44f const m = expr;
+		require_equal_( m, full );
+		require_equal_( to_mat44( eval( expr ) ), full );
+
+		// Nothing to multiply at all
+		static_assert( std::is_same_v<decltype(eval( lazy( T ) * T )), Translation44f> );
+	}
+
+	SECTION( "Vector" )
+	{
+		Vec4f const v{ 0.5f, -1.f, 2.f, 1.f };
+		require_equal_( lazy( P ) * V * M * T * v, full * v );
+		require_equal_( P * (lazy( V ) * M) * v, to_mat44( P ) * V * M * v );
+	}
+
+	// Temporaries are held by the expression; lvalues are referenced.
+	SECTION( "Temporaries" )
+	{
+		auto const make = [&] {
+			Mat44f const view = V;
+			return lazy( P ) * Mat44f( view ) * (make_rotation_z( 0.7f ) * make_scaling( 1.f, 2.f, 1.f )) * T;
+		};
+
+		auto const expr = make();
+		static_assert( !std::is_reference_v<decltype(expr.left.right)> );
+		static_assert( std::is_reference_v<decltype((lazy( P ) * V).right)> );
+
+		Mat44f const m = expr;
+		require_equal_( m, full );
+
+		Vec4f const v{ 0.5f, -1.f, 2.f, 1.f };
+		require_equal_( expr * v, full * v );
+	}
+}
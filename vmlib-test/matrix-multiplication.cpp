@@ -83,3 +83,38 @@ TEST_CASE( "4x4 matrix by vector multiplication", "[mat44][vec4]" )
 		REQUIRE_THAT( resultVector[3], WithinAbs( 107.f, kEps_ ) );
 	}
 }
+
+// Test case to verify that the 4x4 transpose is working correctly
+TEST_CASE( "4x4 matrix transpose", "[mat44]" )
+{
+	static constexpr float kEps_ = 1e-6f;
+
+	constexpr Mat44f testMatrix = { {
+		3.f, 1.f, 5.f, 2.f,
+		4.f, 6.f, 2.f, 1.f,
+		7.f, 3.f, 5.f, 2.f,
+		8.f, 5.f, 4.f, 2.f
+	} };
+
+	using namespace Catch::Matchers;
+
+	SECTION( "Standard transpose" )
+	{
+		auto const result = transpose( testMatrix );
+
+		for( std::size_t i = 0; i < 4; ++i )
+		{
+			for( std::size_t j = 0; j < 4; ++j )
+				REQUIRE_THAT( result(i,j), WithinAbs( testMatrix(j,i), kEps_ ) );
+		}
+	}
+
+	// Transposing twice should give back the original matrix
+	SECTION( "Double transpose" )
+	{
+		auto const result = transpose( transpose( testMatrix ) );
+
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( result.v[i], WithinAbs( testMatrix.v[i], kEps_ ) );
+	}
+}
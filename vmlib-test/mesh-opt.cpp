@@ -0,0 +1,161 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <array>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <cstdint>
+
+#include "../vmlib/mesh_opt.hpp"
+
+namespace
+{
+	// Regular grid of aN x aN quads (two triangles each) in the xy plane.
+	struct Grid_
+	{
+		std::vector<Vec3f> positions;
+		std::vector<std::uint32_t> indices;
+	};
+
+	Grid_ make_grid_( std::uint32_t aN )
+	{
+		Grid_ ret;
+		for( std::uint32_t y = 0; y <= aN; ++y )
+		{
+			for( std::uint32_t x = 0; x <= aN; ++x )
+				ret.positions.emplace_back( Vec3f{ float(x), float(y), 0.f } );
+		}
+
+		for( std::uint32_t y = 0; y < aN; ++y )
+		{
+			for( std::uint32_t x = 0; x < aN; ++x )
+			{
+				std::uint32_t const i = y*(aN+1) + x;
+				ret.indices.insert( ret.indices.end(), { i, i+1, i+aN+2 } );
+				ret.indices.insert( ret.indices.end(), { i, i+aN+2, i+aN+1 } );
+			}
+		}
+
+		return ret;
+	}
+
+	void shuffle_triangles_( std::vector<std::uint32_t>& aIndices )
+	{
+		std::vector<std::array<std::uint32_t,3>> tris;
+		for( std::size_t i = 0; i < aIndices.size(); i += 3 )
+			tris.push_back( { aIndices[i], aIndices[i+1], aIndices[i+2] } );
+
+		std::minstd_rand rng( 3811 );
+		std::shuffle( tris.begin(), tris.end(), rng );
+
+		aIndices.clear();
+		for( auto const& t : tris )
+			aIndices.insert( aIndices.end(), t.begin(), t.end() );
+	}
+
+	// Triangles as a sorted list, for comparing meshes regardless of the
+	// triangle order. Keeps the vertex order of each triangle (i.e., the
+	// winding), but starts each at its smallest index.
+	std::vector<std::array<std::uint32_t,3>> triangle_set_( std::vector<std::uint32_t> const& aIndices )
+	{
+		std::vector<std::array<std::uint32_t,3>> ret;
+		for( std::size_t i = 0; i < aIndices.size(); i += 3 )
+		{
+			std::array<std::uint32_t,3> t{ aIndices[i], aIndices[i+1], aIndices[i+2] };
+			std::rotate( t.begin(), std::min_element( t.begin(), t.end() ), t.end() );
+			ret.push_back( t );
+		}
+
+		std::sort( ret.begin(), ret.end() );
+		return ret;
+	}
+}
+
+TEST_CASE( "Vertex cache analysis", "[mesh-opt]" )
+{
+	using namespace Catch::Matchers;
+
+	static constexpr float kEps_ = 1e-6f;
+
+	SECTION( "Single triangle" )
+	{
+		std::uint32_t const indices[] = { 0, 1, 2 };
+		auto const stats = analyze_vertex_cache( indices, 3, 3 );
+		REQUIRE_THAT( stats.acmr, WithinAbs( 3.f, kEps_ ) );
+		REQUIRE_THAT( stats.atvr, WithinAbs( 1.f, kEps_ ) );
+	}
+
+	SECTION( "Shared edge" )
+	{
+		std::uint32_t const indices[] = { 0, 1, 2, 2, 1, 3 };
+		auto const stats = analyze_vertex_cache( indices, 6, 4 );
+		REQUIRE_THAT( stats.acmr, WithinAbs( 2.f, kEps_ ) );
+		REQUIRE_THAT( stats.atvr, WithinAbs( 1.f, kEps_ ) );
+	}
+
+	SECTION( "FIFO eviction" )
+	{
+		// With a cache of 3, vertex 0 is evicted by vertex 3.
+		std::uint32_t const indices[] = { 0, 1, 2, 1, 2, 3, 3, 2, 0 };
+		auto const stats = analyze_vertex_cache( indices, 9, 4, 3 );
+		REQUIRE_THAT( stats.acmr, WithinAbs( 5.f/3.f, kEps_ ) );
+		REQUIRE_THAT( stats.atvr, WithinAbs( 5.f/4.f, kEps_ ) );
+	}
+}
+
+TEST_CASE( "Mesh optimization", "[mesh-opt]" )
+{
+	auto grid = make_grid_( 64 );
+	auto const vertexCount = grid.positions.size();
+	auto const reference = triangle_set_( grid.indices );
+
+	shuffle_triangles_( grid.indices );
+	auto const shuffled = analyze_vertex_cache( grid.indices.data(), grid.indices.size(), vertexCount );
+	REQUIRE( shuffled.acmr > 2.5f );
+
+	optimize_vertex_cache( grid.indices.data(), grid.indices.size(), vertexCount );
+	auto const cached = analyze_vertex_cache( grid.indices.data(), grid.indices.size(), vertexCount );
+
+	SECTION( "Vertex cache" )
+	{
+		REQUIRE( reference == triangle_set_( grid.indices ) );
+		REQUIRE( cached.acmr < 0.75f );
+		REQUIRE( cached.atvr < 1.5f );
+	}
+
+	SECTION( "Overdraw" )
+	{
+		optimize_overdraw( grid.indices.data(), grid.indices.size(), grid.positions.data(), vertexCount );
+		auto const stats = analyze_vertex_cache( grid.indices.data(), grid.indices.size(), vertexCount );
+
+		REQUIRE( reference == triangle_set_( grid.indices ) );
+		REQUIRE( stats.acmr <= cached.acmr * 1.1f );
+	}
+
+	SECTION( "Vertex fetch" )
+	{
+		// Add an unused vertex
+		grid.positions.push_back( Vec3f{ -1.f, -1.f, -1.f } );
+		auto const oldIndices = grid.indices;
+
+		std::vector<std::uint32_t> remap( grid.positions.size() );
+		auto const used = optimize_vertex_fetch_remap( grid.indices.data(), grid.indices.size(), grid.positions.size(), remap.data() );
+
+		REQUIRE( vertexCount == used );
+		REQUIRE( kUnusedVertex == remap.back() );
+
+		// Vertices are numbered in order of first use
+		std::uint32_t highest = 0;
+		for( std::size_t i = 0; i < grid.indices.size(); ++i )
+		{
+			REQUIRE( grid.indices[i] == remap[oldIndices[i]] );
+			REQUIRE( grid.indices[i] <= highest + 1 );
+			highest = std::max( highest, grid.indices[i] );
+		}
+
+		// The cache order is unchanged
+		auto const stats = analyze_vertex_cache( grid.indices.data(), grid.indices.size(), used );
+		REQUIRE( stats.acmr == cached.acmr );
+	}
+}
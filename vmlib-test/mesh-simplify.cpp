@@ -0,0 +1,176 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdint>
+
+#include "../vmlib/mesh_simplify.hpp"
+
+namespace
+{
+	// Regular grid of aN x aN quads in the xy plane, with z = aHeight(x,y).
+	struct Grid_
+	{
+		std::vector<Vec3f> positions;
+		std::vector<std::uint32_t> indices;
+	};
+
+	template< typename tHeight >
+	Grid_ make_grid_( std::uint32_t aN, tHeight&& aHeight )
+	{
+		Grid_ ret;
+		for( std::uint32_t y = 0; y <= aN; ++y )
+		{
+			for( std::uint32_t x = 0; x <= aN; ++x )
+				ret.positions.emplace_back( Vec3f{ float(x), float(y), aHeight( float(x), float(y) ) } );
+		}
+
+		for( std::uint32_t y = 0; y < aN; ++y )
+		{
+			for( std::uint32_t x = 0; x < aN; ++x )
+			{
+				std::uint32_t const i = y*(aN+1) + x;
+				ret.indices.insert( ret.indices.end(), { i, i+1, i+aN+2 } );
+				ret.indices.insert( ret.indices.end(), { i, i+aN+2, i+aN+1 } );
+			}
+		}
+
+		return ret;
+	}
+
+	Vec3f triangle_normal_( Grid_ const& aGrid, std::vector<std::uint32_t> const& aIndices, std::size_t aTri )
+	{
+		Vec3f const a = aGrid.positions[aIndices[aTri*3+0]];
+		Vec3f const b = aGrid.positions[aIndices[aTri*3+1]];
+		Vec3f const c = aGrid.positions[aIndices[aTri*3+2]];
+		return cross( b - a, c - a );
+	}
+}
+
+TEST_CASE( "Mesh simplification", "[mesh-simplify]" )
+{
+	using namespace Catch::Matchers;
+
+	static constexpr float kEps_ = 1e-4f;
+
+	SECTION( "Flat grid" )
+	{
+		auto const grid = make_grid_( 32, [] (float, float) { return 0.f; } );
+		std::vector<std::uint32_t> out( grid.indices.size() );
+
+		float error = -1.f;
+		auto const count = simplify_mesh( out.data(), grid.indices.data(), grid.indices.size(), grid.positions.data(), grid.positions.size(), 0, 1e-3f, &error );
+		out.resize( count );
+
+		// A plane needs only a few triangles, and it stays the same plane
+		// with the same area and orientation.
+		REQUIRE( count > 0 );
+		REQUIRE( count <= grid.indices.size() / 20 );
+		REQUIRE_THAT( error, WithinAbs( 0.f, kEps_ ) );
+
+		float area = 0.f;
+		for( std::size_t t = 0; t < count / 3; ++t )
+		{
+			Vec3f const n = triangle_normal_( grid, out, t );
+			REQUIRE( n.z > 0.f );
+			area += 0.5f * n.z;
+		}
+		REQUIRE_THAT( area, WithinRel( 32.f*32.f, kEps_ ) );
+	}
+
+	SECTION( "Target index count" )
+	{
+		auto const grid = make_grid_( 32, [] (float aX, float aY) { return std::sin( 0.3f*aX ) * std::cos( 0.2f*aY ); } );
+		std::vector<std::uint32_t> out( grid.indices.size() );
+
+		std::size_t const target = grid.indices.size() / 4;
+		float error = -1.f;
+		auto const count = simplify_mesh( out.data(), grid.indices.data(), grid.indices.size(), grid.positions.data(), grid.positions.size(), target, 1e9f, &error );
+
+		REQUIRE( count <= target );
+		REQUIRE( count >= target / 2 );
+		REQUIRE( error > 0.f );
+		REQUIRE( error < 0.5f );
+
+		// No triangle is flipped
+		for( std::size_t t = 0; t < count / 3; ++t )
+			REQUIRE( triangle_normal_( grid, out, t ).z >= 0.f );
+	}
+
+	SECTION( "Target error" )
+	{
+		auto const grid = make_grid_( 32, [] (float aX, float aY) { return std::sin( 0.3f*aX ) * std::cos( 0.2f*aY ); } );
+		std::vector<std::uint32_t> out( grid.indices.size() );
+
+		// A zero error allows nothing on a curved surface.
+		float error = -1.f;
+		auto count = simplify_mesh( out.data(), grid.indices.data(), grid.indices.size(), grid.positions.data(), grid.positions.size(), 0, 0.f, &error );
+		REQUIRE( count == grid.indices.size() );
+		REQUIRE( 0.f == error );
+
+		// A larger one allows more.
+		auto const coarse = simplify_mesh( out.data(), grid.indices.data(), grid.indices.size(), grid.positions.data(), grid.positions.size(), 0, 0.01f, &error );
+		REQUIRE( error <= 0.01f );
+
+		auto const coarser = simplify_mesh( out.data(), grid.indices.data(), grid.indices.size(), grid.positions.data(), grid.positions.size(), 0, 0.1f, &error );
+		REQUIRE( error <= 0.1f );
+		REQUIRE( coarser < coarse );
+		REQUIRE( coarse < grid.indices.size() );
+	}
+
+	SECTION( "Seams" )
+	{
+		// Split the flat grid along x = 16 by giving the right half its own
+		// copies of the vertices on that line (e.g., for different texture
+		// coordinates).
+		std::uint32_t const n = 32;
+		auto grid = make_grid_( n, [] (float, float) { return 0.f; } );
+		std::uint32_t const firstCopy = std::uint32_t(grid.positions.size());
+		for( std::uint32_t y = 0; y <= n; ++y )
+			grid.positions.emplace_back( grid.positions[y*(n+1) + 16] );
+
+		for( std::size_t i = 0; i < grid.indices.size(); i += 3 )
+		{
+			std::uint32_t* tri = grid.indices.data() + i;
+			bool const right = std::max( { tri[0] % (n+1), tri[1] % (n+1), tri[2] % (n+1) } ) > 16;
+			for( std::size_t k = 0; right && k < 3; ++k )
+			{
+				if( 16 == tri[k] % (n+1) )
+					tri[k] = firstCopy + tri[k] / (n+1);
+			}
+		}
+
+		// Attributes: 0 on the left, 1 on the right
+		std::vector<float> side( grid.positions.size(), 0.f );
+		for( std::size_t v = 0; v < grid.positions.size(); ++v )
+			side[v] = (v >= firstCopy || grid.positions[v].x > 16.f) ? 1.f : 0.f;
+
+		float const weight = 1.f;
+		SimplifyAttributes attribs;
+		attribs.data = side.data();
+		attribs.stride = 1;
+		attribs.weights = &weight;
+		attribs.count = 1;
+
+		std::vector<std::uint32_t> out( grid.indices.size() );
+		auto const count = simplify_mesh( out.data(), grid.indices.data(), grid.indices.size(), grid.positions.data(), grid.positions.size(), 0, 1e-3f, nullptr, attribs );
+		REQUIRE( count <= grid.indices.size() / 10 );
+
+		// Each triangle stays on its side and uses that side's vertices
+		for( std::size_t t = 0; t < count / 3; ++t )
+		{
+			float const s = side[out[t*3]];
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				std::uint32_t const v = out[t*3+k];
+				REQUIRE( side[v] == s );
+				if( s > 0.5f )
+					REQUIRE( grid.positions[v].x >= 16.f );
+				else
+					REQUIRE( grid.positions[v].x <= 16.f );
+			}
+		}
+	}
+}
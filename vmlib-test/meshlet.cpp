@@ -0,0 +1,199 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdint>
+
+#include "../vmlib/meshlet.hpp"
+
+namespace
+{
+	// Regular grid of aN x aN quads in the xy plane, with z = aHeight(x,y).
+	struct Grid_
+	{
+		std::vector<Vec3f> positions;
+		std::vector<std::uint32_t> indices;
+	};
+
+	template< typename tHeight >
+	Grid_ make_grid_( std::uint32_t aN, tHeight&& aHeight )
+	{
+		Grid_ ret;
+		for( std::uint32_t y = 0; y <= aN; ++y )
+		{
+			for( std::uint32_t x = 0; x <= aN; ++x )
+				ret.positions.emplace_back( Vec3f{ float(x), float(y), aHeight( float(x), float(y) ) } );
+		}
+
+		for( std::uint32_t y = 0; y < aN; ++y )
+		{
+			for( std::uint32_t x = 0; x < aN; ++x )
+			{
+				std::uint32_t const i = y*(aN+1) + x;
+				ret.indices.insert( ret.indices.end(), { i, i+1, i+aN+2 } );
+				ret.indices.insert( ret.indices.end(), { i, i+aN+2, i+aN+1 } );
+			}
+		}
+
+		return ret;
+	}
+
+	// Triangles as sorted triples, to compare meshes regardless of order
+	std::vector<std::uint32_t> sorted_triangles_( std::vector<std::uint32_t> const& aIndices )
+	{
+		std::vector<std::uint32_t> ret;
+		for( std::size_t i = 0; i < aIndices.size(); i += 3 )
+		{
+			// Rotate such that the smallest index is first; keeps the winding.
+			std::size_t const m = std::min_element( aIndices.begin() + i, aIndices.begin() + i + 3 ) - (aIndices.begin() + i);
+			for( std::size_t k = 0; k < 3; ++k )
+				ret.emplace_back( aIndices[i + (m+k)%3] );
+		}
+
+		std::vector<std::size_t> order( ret.size() / 3 );
+		for( std::size_t i = 0; i < order.size(); ++i )
+			order[i] = i;
+		std::sort( order.begin(), order.end(), [&] (std::size_t aA, std::size_t aB) {
+			return std::lexicographical_compare( ret.begin() + aA*3, ret.begin() + aA*3 + 3, ret.begin() + aB*3, ret.begin() + aB*3 + 3 );
+		} );
+
+		std::vector<std::uint32_t> sorted;
+		for( auto const t : order )
+			sorted.insert( sorted.end(), ret.begin() + t*3, ret.begin() + t*3 + 3 );
+		return sorted;
+	}
+}
+
+TEST_CASE( "Meshlets", "[meshlet]" )
+{
+	using namespace Catch::Matchers;
+
+	static constexpr float kEps_ = 1e-4f;
+
+	SECTION( "Partition" )
+	{
+		auto grid = make_grid_( 48, [] (float aX, float aY) { return std::sin( 0.3f*aX ) * std::cos( 0.2f*aY ); } );
+		auto const original = grid.indices;
+
+		auto const meshlets = build_meshlets( grid.indices.data(), grid.indices.size(), grid.positions.data(), grid.positions.size() );
+
+		// Same triangles, with the same winding
+		REQUIRE( sorted_triangles_( grid.indices ) == sorted_triangles_( original ) );
+
+		// Contiguous ranges within the limits, and not too many of them
+		std::uint32_t next = 0;
+		for( auto const& m : meshlets )
+		{
+			REQUIRE( m.firstIndex == next );
+			REQUIRE( m.indexCount > 0 );
+			REQUIRE( m.indexCount % 3 == 0 );
+			REQUIRE( m.indexCount / 3 <= kMeshletMaxTriangles );
+			next += m.indexCount;
+
+			std::vector<std::uint32_t> verts( grid.indices.begin() + m.firstIndex, grid.indices.begin() + m.firstIndex + m.indexCount );
+			std::sort( verts.begin(), verts.end() );
+			verts.erase( std::unique( verts.begin(), verts.end() ), verts.end() );
+			REQUIRE( verts.size() <= kMeshletMaxVertices );
+
+			// The bounds contain the cluster's vertices
+			for( auto const v : verts )
+			{
+				Vec3f const p = grid.positions[v];
+				REQUIRE( length( p - m.center ) <= m.radius + kEps_ );
+				REQUIRE( p.x >= m.aabbMin.x ); REQUIRE( p.x <= m.aabbMax.x );
+				REQUIRE( p.y >= m.aabbMin.y ); REQUIRE( p.y <= m.aabbMax.y );
+				REQUIRE( p.z >= m.aabbMin.z ); REQUIRE( p.z <= m.aabbMax.z );
+			}
+
+			// ... and the normal cone contains the triangle normals
+			for( std::uint32_t i = m.firstIndex; i < m.firstIndex + m.indexCount; i += 3 )
+			{
+				Vec3f const a = grid.positions[grid.indices[i+0]];
+				Vec3f const b = grid.positions[grid.indices[i+1]];
+				Vec3f const c = grid.positions[grid.indices[i+2]];
+				Vec3f const n = normalize( cross( b - a, c - a ) );
+				REQUIRE( dot( n, m.coneAxis ) >= m.coneCos - kEps_ );
+			}
+		}
+		REQUIRE( next == grid.indices.size() );
+
+		// Clusters are compact: on a grid, 64 vertices hold about 90 triangles.
+		std::size_t const triangles = grid.indices.size() / 3;
+		REQUIRE( meshlets.size() <= triangles / 64 );
+	}
+
+	SECTION( "Disconnected triangles" )
+	{
+		// Every triangle has its own vertices, as at hard edges. Clusters
+		// still fill up to the vertex limit instead of ending at each
+		// triangle, and stay spatially compact.
+		auto const grid = make_grid_( 16, [] (float, float) { return 0.f; } );
+
+		std::vector<Vec3f> positions;
+		std::vector<std::uint32_t> indices;
+		for( auto const i : grid.indices )
+		{
+			indices.emplace_back( std::uint32_t(positions.size()) );
+			positions.emplace_back( grid.positions[i] );
+		}
+
+		auto const meshlets = build_meshlets( indices.data(), indices.size(), positions.data(), positions.size() );
+
+		std::size_t const perMeshlet = kMeshletMaxVertices / 3;
+		std::size_t const minimum = (indices.size() / 3 + perMeshlet - 1) / perMeshlet;
+		REQUIRE( meshlets.size() <= minimum + minimum / 5 );
+
+		for( auto const& m : meshlets )
+		{
+			REQUIRE( m.radius < 6.f );
+			REQUIRE_THAT( m.coneCos, WithinAbs( 1.f, kEps_ ) );
+		}
+	}
+
+	SECTION( "Back-face culling" )
+	{
+		// Flat grid facing +z
+		auto grid = make_grid_( 6, [] (float, float) { return 0.f; } );
+		auto const meshlets = build_meshlets( grid.indices.data(), grid.indices.size(), grid.positions.data(), grid.positions.size() );
+		REQUIRE( 1 == meshlets.size() );
+
+		auto const& m = meshlets.front();
+		REQUIRE_THAT( m.coneAxis.z, WithinAbs( 1.f, kEps_ ) );
+		REQUIRE_THAT( m.coneCos, WithinAbs( 1.f, kEps_ ) );
+
+		REQUIRE( !meshlet_backfacing( m, Vec3f{ 3.f, 3.f, 10.f } ) );
+		REQUIRE( meshlet_backfacing( m, Vec3f{ 3.f, 3.f, -10.f } ) );
+
+		// Below the plane but close to it: some point of the bounding
+		// sphere may see the front.
+		REQUIRE( !meshlet_backfacing( m, Vec3f{ 3.f, 3.f, -1.f } ) );
+		REQUIRE( !meshlet_backfacing( m, Vec3f{ 40.f, 3.f, -1.f } ) );
+
+		// A cone wider than a half space is never culled.
+		Meshlet wide = m;
+		wide.coneCos = -0.1f;
+		REQUIRE( !meshlet_backfacing( wide, Vec3f{ 3.f, 3.f, -10.f } ) );
+	}
+
+	SECTION( "Frustum" )
+	{
+		// Camera at the origin looking down -z
+		Frustum const frustum = make_frustum( make_perspective_projection( 3.1415926f/2.f, 1.f, 1.f, 100.f ) );
+
+		REQUIRE( sphere_in_frustum( frustum, Vec3f{ 0.f, 0.f, -10.f }, 1.f ) );
+		REQUIRE( !sphere_in_frustum( frustum, Vec3f{ 0.f, 0.f, 10.f }, 1.f ) );
+		REQUIRE( !sphere_in_frustum( frustum, Vec3f{ 0.f, 0.f, -200.f }, 1.f ) );
+
+		// Fov 90 degrees: the side planes are at 45 degrees.
+		REQUIRE( !sphere_in_frustum( frustum, Vec3f{ 12.f, 0.f, -10.f }, 1.f ) );
+		REQUIRE( sphere_in_frustum( frustum, Vec3f{ 12.f, 0.f, -10.f }, 2.f ) );
+		REQUIRE( !sphere_in_frustum( frustum, Vec3f{ 0.f, -12.f, -10.f }, 1.f ) );
+
+		// Planes in model space: move the model, not the camera.
+		Frustum const moved = make_frustum( make_perspective_projection( 3.1415926f/2.f, 1.f, 1.f, 100.f ) * make_translation( { 0.f, 0.f, -50.f } ) );
+		REQUIRE( sphere_in_frustum( moved, Vec3f{ 0.f, 0.f, 10.f }, 1.f ) );
+		REQUIRE( !sphere_in_frustum( moved, Vec3f{ 0.f, 0.f, 60.f }, 1.f ) );
+	}
+}
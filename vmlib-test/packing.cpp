@@ -0,0 +1,203 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <limits>
+#include <random>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__)
+#	include <immintrin.h>
+#endif
+
+#include "../vmlib/packing.hpp"
+
+// Test case to verify the error bounds documented in packing.hpp
+TEST_CASE( "Half floats", "[packing]" )
+{
+	using namespace Catch::Matchers;
+
+	SECTION( "Round trip of all halfs" )
+	{
+		for( std::uint32_t h = 0; h < 0x10000u; ++h )
+		{
+			float const f = unpack_half( std::uint16_t(h) );
+			if( std::isnan( f ) )
+			{
+				REQUIRE( std::isnan( unpack_half( pack_half( f ) ) ) );
+				continue;
+			}
+
+			REQUIRE( h == pack_half( f ) );
+		}
+	}
+
+	SECTION( "Special values" )
+	{
+		REQUIRE( 0x0000u == pack_half( 0.f ) );
+		REQUIRE( 0x8000u == pack_half( -0.f ) );
+		REQUIRE( 0x3c00u == pack_half( 1.f ) );
+		REQUIRE( 0xc000u == pack_half( -2.f ) );
+		REQUIRE( 0x7bffu == pack_half( 65504.f ) );
+		REQUIRE( 0x7bffu == pack_half( 65519.f ) );
+		REQUIRE( 0x7c00u == pack_half( 65520.f ) );
+		REQUIRE( 0xfc00u == pack_half( -std::numeric_limits<float>::infinity() ) );
+		REQUIRE( std::isnan( unpack_half( pack_half( std::numeric_limits<float>::quiet_NaN() ) ) ) );
+
+		// Smallest denormal, and values that round to it or to zero
+		REQUIRE( 0x0001u == pack_half( std::ldexp( 1.f, -24 ) ) );
+		REQUIRE( 0x0001u == pack_half( std::ldexp( 1.5f, -25 ) ) );
+		REQUIRE( 0x0000u == pack_half( std::ldexp( 1.f, -25 ) ) ); // tie, to even
+		REQUIRE( 0x0000u == pack_half( std::ldexp( 1.f, -30 ) ) );
+	}
+
+	SECTION( "Round to nearest even" )
+	{
+		float const ulp = std::ldexp( 1.f, -10 );
+		REQUIRE( 0x3c00u == pack_half( 1.f + 0.5f*ulp ) );
+		REQUIRE( 0x3c02u == pack_half( 1.f + 1.5f*ulp ) );
+		REQUIRE( 0x3c01u == pack_half( 1.f + 0.75f*ulp ) );
+		REQUIRE( 0x3c00u == pack_half( 1.f + 0.25f*ulp ) );
+	}
+
+	SECTION( "Relative error" )
+	{
+		static constexpr float kEps_ = 1.f / 2048.f;
+
+		std::minstd_rand rng( 3811 );
+		std::uniform_real_distribution<float> dist( -60000.f, 60000.f );
+
+		for( int i = 0; i < 20000; ++i )
+		{
+			float const f = dist( rng );
+			float const r = unpack_half( pack_half( f ) );
+			REQUIRE( std::abs( r - f ) <= kEps_ * std::abs( f ) );
+		}
+	}
+
+#	if defined(__F16C__)
+	SECTION( "Same as F16C" )
+	{
+		// Walk through the float range around the half range with a step that
+		// hits all kinds of rounding cases.
+		for( std::uint32_t bits = 0x30000000u; bits < 0x48000000u; bits += 0x1235u )
+		{
+			float f;
+			std::memcpy( &f, &bits, sizeof(float) );
+			auto const ref = std::uint16_t(_cvtss_sh( f, _MM_FROUND_TO_NEAREST_INT ));
+			REQUIRE( ref == pack_half( f ) );
+			REQUIRE( (ref | 0x8000u) == pack_half( -f ) );
+			REQUIRE( _cvtsh_ss( ref ) == unpack_half( ref ) );
+		}
+	}
+#	endif
+}
+
+TEST_CASE( "Normalized integers", "[packing]" )
+{
+	using namespace Catch::Matchers;
+
+	SECTION( "unorm8" )
+	{
+		for( std::uint32_t i = 0; i < 256; ++i )
+		{
+			std::uint32_t const p = i | ((255-i) << 8) | (i << 16) | ((i/2) << 24);
+			REQUIRE( p == pack_unorm8x4( unpack_unorm8x4( p ) ) );
+		}
+
+		Vec4f const v = unpack_unorm8x4( pack_unorm8x4( { 0.f, 1.f, 0.4f, 0.2f } ) );
+		REQUIRE( 0.f == v.x );
+		REQUIRE( 1.f == v.y );
+		REQUIRE_THAT( v.z, WithinAbs( 0.4f, 1.f/510.f ) );
+		REQUIRE_THAT( v.w, WithinAbs( 0.2f, 1.f/510.f ) );
+
+		// Clamped
+		REQUIRE( 0x00ff00ffu == pack_unorm8x4( { 2.f, -1.f, 1e9f, -0.f } ) );
+	}
+
+	SECTION( "snorm 2:10:10:10" )
+	{
+		static constexpr float kEps_ = 1.f / 1022.f;
+
+		REQUIRE( 0u == pack_snorm_2_10_10_10_rev( { 0.f, 0.f, 0.f, 0.f } ) );
+		REQUIRE( 0x5ff805ffu == pack_snorm_2_10_10_10_rev( { 1.f, -1.f, 1.f, 1.f } ) );
+
+		Vec4f const e = unpack_snorm_2_10_10_10_rev( 0x5ff805ffu );
+		REQUIRE( 1.f == e.x );
+		REQUIRE( -1.f == e.y );
+		REQUIRE( 1.f == e.z );
+		REQUIRE( 1.f == e.w );
+
+		// -512 is clamped to -1
+		REQUIRE( -1.f == unpack_snorm_2_10_10_10_rev( 0x200u ).x );
+		REQUIRE( -1.f == unpack_snorm_2_10_10_10_rev( 0x80000000u ).w );
+
+		std::minstd_rand rng( 3811 );
+		std::uniform_real_distribution<float> dist( -1.f, 1.f );
+
+		for( int i = 0; i < 10000; ++i )
+		{
+			Vec4f const v{ dist( rng ), dist( rng ), dist( rng ), -1.f };
+			Vec4f const r = unpack_snorm_2_10_10_10_rev( pack_snorm_2_10_10_10_rev( v ) );
+			REQUIRE_THAT( r.x, WithinAbs( v.x, kEps_ ) );
+			REQUIRE_THAT( r.y, WithinAbs( v.y, kEps_ ) );
+			REQUIRE_THAT( r.z, WithinAbs( v.z, kEps_ ) );
+			REQUIRE( -1.f == r.w );
+		}
+	}
+}
+
+TEST_CASE( "Octahedral normals", "[packing]" )
+{
+	using namespace Catch::Matchers;
+
+	static constexpr float kEps_ = 6e-5f;
+
+	SECTION( "Axes" )
+	{
+		Vec3f const axes[] = {
+			{ 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f },
+			{ 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f },
+			{ 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f }
+		};
+
+		for( auto const n : axes )
+		{
+			Vec3f const r = unpack_oct_snorm16( pack_oct_snorm16( n ) );
+			REQUIRE( n.x == r.x );
+			REQUIRE( n.y == r.y );
+			REQUIRE( n.z == r.z );
+		}
+	}
+
+	SECTION( "Random unit vectors" )
+	{
+		std::minstd_rand rng( 3811 );
+		std::normal_distribution<float> dist( 0.f, 1.f );
+
+		for( int i = 0; i < 20000; ++i )
+		{
+			Vec3f const n = normalize( Vec3f{ dist( rng ), dist( rng ), dist( rng ) } );
+
+			// Unquantized mapping
+			Vec3f const e = oct_decode( oct_encode( n ) );
+			REQUIRE_THAT( e.x, WithinAbs( n.x, 1e-6f ) );
+			REQUIRE_THAT( e.y, WithinAbs( n.y, 1e-6f ) );
+			REQUIRE_THAT( e.z, WithinAbs( n.z, 1e-6f ) );
+
+			Vec3f const r = unpack_oct_snorm16( pack_oct_snorm16( n ) );
+			REQUIRE_THAT( r.x, WithinAbs( n.x, kEps_ ) );
+			REQUIRE_THAT( r.y, WithinAbs( n.y, kEps_ ) );
+			REQUIRE_THAT( r.z, WithinAbs( n.z, kEps_ ) );
+		}
+	}
+
+	SECTION( "Does not require unit length" )
+	{
+		Vec3f const r = unpack_oct_snorm16( pack_oct_snorm16( { 0.f, -3.f, 4.f } ) );
+		REQUIRE_THAT( r.x, WithinAbs( 0.f, kEps_ ) );
+		REQUIRE_THAT( r.y, WithinAbs( -0.6f, kEps_ ) );
+		REQUIRE_THAT( r.z, WithinAbs( 0.8f, kEps_ ) );
+	}
+}
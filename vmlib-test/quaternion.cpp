@@ -0,0 +1,149 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "../vmlib/quat.hpp"
+#include "../vmlib/transform.hpp"
+
+namespace
+{
+	constexpr float kEps_ = 1e-6f;
+
+	void require_equal_( Mat44f const& aA, Mat44f const& aB )
+	{
+		using namespace Catch::Matchers;
+
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( aA.v[i], WithinAbs( aB.v[i], kEps_ ) );
+	}
+}
+
+// Test case to verify that quaternion rotations match the rotation matrices
+TEST_CASE( "Quaternion rotations", "[rotation][quat]" )
+{
+	SECTION( "Identity" )
+	{
+		require_equal_( to_mat44( kIdentityQuatf ), kIdentity44f );
+		require_equal_( to_mat44( make_quat_rotation_x( 0.f ) ), kIdentity44f );
+	}
+
+	// Rotating 90 degrees = pi/2 radians.
+	SECTION( "90 degrees" )
+	{
+		require_equal_( to_mat44( make_quat_rotation_x( 3.1415926f/2.f ) ), make_rotation_x( 3.1415926f/2.f ) );
+		require_equal_( to_mat44( make_quat_rotation_y( 3.1415926f/2.f ) ), make_rotation_y( 3.1415926f/2.f ) );
+		require_equal_( to_mat44( make_quat_rotation_z( 3.1415926f/2.f ) ), make_rotation_z( 3.1415926f/2.f ) );
+	}
+
+	// Rotating -90 degrees = -pi/2 radians.
+	SECTION( "-90 degrees" )
+	{
+		require_equal_( to_mat44( make_quat_rotation_x( -3.1415926f/2.f ) ), make_rotation_x( -3.1415926f/2.f ) );
+		require_equal_( to_mat44( make_quat_rotation_y( -3.1415926f/2.f ) ), make_rotation_y( -3.1415926f/2.f ) );
+		require_equal_( to_mat44( make_quat_rotation_z( -3.1415926f/2.f ) ), make_rotation_z( -3.1415926f/2.f ) );
+	}
+
+	// Arbitrary axis: rotating around the y axis should match make_rotation_y
+	SECTION( "Axis-angle" )
+	{
+		require_equal_( to_mat44( make_quat_rotation( { 0.f, 1.f, 0.f }, 0.7f ) ), make_rotation_y( 0.7f ) );
+	}
+
+	// Products of quaternions combine rotations like matrix products
+	SECTION( "Composition" )
+	{
+		auto const q = make_quat_rotation_z( 1.5708f ) * make_quat_rotation_y( 0.3f );
+		require_equal_( to_mat44( q ), make_rotation_z( 1.5708f ) * make_rotation_y( 0.3f ) );
+	}
+
+	// Rotating a vector directly matches rotating it with the matrix
+	SECTION( "Vector rotation" )
+	{
+		using namespace Catch::Matchers;
+
+		auto const q = make_quat_rotation_x( 0.4f ) * make_quat_rotation_z( -1.1f );
+		Vec3f const v = q * Vec3f{ 1.f, 2.f, 3.f };
+		Vec4f const w = to_mat44( q ) * Vec4f{ 1.f, 2.f, 3.f, 1.f };
+
+		REQUIRE_THAT( v.x, WithinAbs( w.x, 1e-5f ) );
+		REQUIRE_THAT( v.y, WithinAbs( w.y, 1e-5f ) );
+		REQUIRE_THAT( v.z, WithinAbs( w.z, 1e-5f ) );
+	}
+}
+
+// Test case to verify quaternion interpolation
+TEST_CASE( "Quaternion interpolation", "[quat]" )
+{
+	using namespace Catch::Matchers;
+
+	auto const a = make_quat_rotation_y( 0.2f );
+	auto const b = make_quat_rotation_y( 1.4f );
+
+	SECTION( "Endpoints" )
+	{
+		require_equal_( to_mat44( slerp( a, b, 0.f ) ), to_mat44( a ) );
+		require_equal_( to_mat44( slerp( a, b, 1.f ) ), to_mat44( b ) );
+		require_equal_( to_mat44( nlerp( a, b, 0.f ) ), to_mat44( a ) );
+		require_equal_( to_mat44( nlerp( a, b, 1.f ) ), to_mat44( b ) );
+	}
+
+	// slerp interpolates the angle linearly
+	SECTION( "slerp midpoint" )
+	{
+		require_equal_( to_mat44( slerp( a, b, 0.25f ) ), make_rotation_y( 0.5f ) );
+	}
+
+	// nlerp and slerp agree at the midpoint
+	SECTION( "nlerp midpoint" )
+	{
+		require_equal_( to_mat44( nlerp( a, b, 0.5f ) ), make_rotation_y( 0.8f ) );
+	}
+
+	// q and -q are the same rotation; interpolation takes the short way
+	SECTION( "Shortest path" )
+	{
+		Quatf const nb{ -b.x, -b.y, -b.z, -b.w };
+		require_equal_( to_mat44( slerp( a, nb, 0.25f ) ), make_rotation_y( 0.5f ) );
+	}
+}
+
+// Test case to verify the TRS transform
+TEST_CASE( "TRS transforms", "[transform]" )
+{
+	Transform const A{
+		{ -5.7f, -0.6f, -2.f },
+		make_quat_rotation_z( 1.5708f ) * make_quat_rotation_y( 0.3f ),
+		{ 2.f, 2.f, 2.f }
+	};
+	Transform const B{
+		{ 1.f, 0.5f, 0.f },
+		make_quat_rotation_x( -0.6f ),
+		{ 0.7f, 0.1f, 0.1f }
+	};
+
+	auto const matA = make_translation( A.t )
+		* make_rotation_z( 1.5708f ) * make_rotation_y( 0.3f )
+		* make_scaling( 2.f, 2.f, 2.f );
+
+	SECTION( "to_mat44" )
+	{
+		require_equal_( to_mat44( kIdentityTransform ), kIdentity44f );
+		require_equal_( to_mat44( A ), matA );
+	}
+
+	SECTION( "Composition" )
+	{
+		require_equal_( to_mat44( A * B ), to_mat44( A ) * to_mat44( B ) );
+	}
+
+	SECTION( "Inverse" )
+	{
+		require_equal_( to_mat44( A * invert( A ) ), kIdentity44f );
+		require_equal_( to_mat44( invert( A ) ), invert( to_mat44( A ) ) );
+	}
+
+	SECTION( "Interpolation" )
+	{
+		require_equal_( to_mat44( interpolate( A, B, 0.f ) ), to_mat44( A ) );
+		require_equal_( to_mat44( interpolate( A, B, 1.f ) ), to_mat44( B ) );
+		require_equal_( to_mat44( interpolate_fast( A, B, 1.f ) ), to_mat44( B ) );
+	}
+}
@@ -0,0 +1,143 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "../vmlib/range_allocator.hpp"
+
+TEST_CASE( "Range allocator", "[range-allocator]" )
+{
+	using namespace Catch::Matchers;
+
+	static constexpr float kEps_ = 1e-6f;
+
+	SECTION( "Allocate until full" )
+	{
+		RangeAllocator alloc( 100 );
+
+		auto const a = alloc.allocate( 40 );
+		auto const b = alloc.allocate( 60 );
+		REQUIRE( 0 == a.offset );
+		REQUIRE( 40 == b.offset );
+		REQUIRE( 100 == alloc.used() );
+		REQUIRE( 0 == alloc.free_range_count() );
+
+		auto const c = alloc.allocate( 1 );
+		REQUIRE( RangeAllocator::kInvalidOffset == c.offset );
+
+		alloc.free( a );
+		REQUIRE( 60 == alloc.used() );
+		REQUIRE( 40 == alloc.largest_free() );
+		REQUIRE( RangeAllocator::kInvalidOffset == alloc.allocate( 41 ).offset );
+	}
+
+	SECTION( "Alignment" )
+	{
+		RangeAllocator alloc( 100 );
+
+		auto const a = alloc.allocate( 5 );
+		auto const b = alloc.allocate( 10, 12 );
+		REQUIRE( 0 == a.offset );
+		REQUIRE( 12 == b.offset );
+
+		// The padding (5 ... 12) stays free and is used by a later allocation
+		REQUIRE( 15 == alloc.used() );
+		auto const c = alloc.allocate( 7 );
+		REQUIRE( 5 == c.offset );
+		REQUIRE( 22 == alloc.used() );
+	}
+
+	SECTION( "Best fit" )
+	{
+		RangeAllocator alloc( 100 );
+
+		auto const a = alloc.allocate( 30 );
+		auto const b = alloc.allocate( 10 );
+		auto const c = alloc.allocate( 20 );
+		alloc.allocate( 40 );
+
+		// Free ranges of 30 and 20; a request of 15 goes into the smaller one
+		alloc.free( a );
+		alloc.free( c );
+		(void)b;
+		REQUIRE( 2 == alloc.free_range_count() );
+
+		auto const d = alloc.allocate( 15 );
+		REQUIRE( 40 == d.offset );
+	}
+
+	SECTION( "Merging and fragmentation" )
+	{
+		RangeAllocator alloc( 1000 );
+
+		std::vector<RangeAllocation> ranges;
+		for( int i = 0; i < 10; ++i )
+			ranges.emplace_back( alloc.allocate( 100 ) );
+
+		REQUIRE_THAT( alloc.fragmentation(), WithinAbs( 0.f, kEps_ ) );
+
+		// Every other range: five free ranges of 100 each
+		for( std::size_t i = 0; i < ranges.size(); i += 2 )
+			alloc.free( ranges[i] );
+
+		REQUIRE( 5 == alloc.free_range_count() );
+		REQUIRE( 100 == alloc.largest_free() );
+		REQUIRE_THAT( alloc.fragmentation(), WithinAbs( 0.8f, kEps_ ) );
+
+		// The rest, in random order: everything merges back into one range
+		std::vector<RangeAllocation> rest;
+		for( std::size_t i = 1; i < ranges.size(); i += 2 )
+			rest.emplace_back( ranges[i] );
+
+		std::minstd_rand rng( 42 );
+		std::shuffle( rest.begin(), rest.end(), rng );
+		for( auto const& range : rest )
+			alloc.free( range );
+
+		REQUIRE( 0 == alloc.used() );
+		REQUIRE( 1 == alloc.free_range_count() );
+		REQUIRE( 1000 == alloc.largest_free() );
+		REQUIRE_THAT( alloc.fragmentation(), WithinAbs( 0.f, kEps_ ) );
+	}
+
+	SECTION( "Random allocations do not overlap" )
+	{
+		RangeAllocator alloc( 1 << 16 );
+		std::minstd_rand rng( 7 );
+
+		std::vector<RangeAllocation> live;
+		for( int i = 0; i < 2000; ++i )
+		{
+			if( !live.empty() && rng() % 3 == 0 )
+			{
+				std::size_t const k = rng() % live.size();
+				alloc.free( live[k] );
+				live.erase( live.begin() + std::ptrdiff_t(k) );
+				continue;
+			}
+
+			std::size_t const alignment = 1 + rng() % 16;
+			auto const range = alloc.allocate( 1 + rng() % 500, alignment );
+			if( RangeAllocator::kInvalidOffset == range.offset )
+				continue;
+
+			REQUIRE( range.offset % alignment == 0 );
+			REQUIRE( range.offset + range.size <= alloc.capacity() );
+			live.emplace_back( range );
+		}
+
+		std::sort( live.begin(), live.end(), [] (RangeAllocation const& aA, RangeAllocation const& aB) {
+			return aA.offset < aB.offset;
+		} );
+
+		std::size_t used = 0;
+		for( std::size_t i = 0; i < live.size(); ++i )
+		{
+			used += live[i].size;
+			if( i > 0 )
+				REQUIRE( live[i-1].offset + live[i-1].size <= live[i].offset );
+		}
+		REQUIRE( used == alloc.used() );
+	}
+}
@@ -0,0 +1,147 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+
+#include <cstdint>
+
+#include "../vmlib/batch.hpp"
+
+namespace
+{
+	// 13 elements: not a multiple of any SIMD width, so that both the padding
+	// and the scalar tails are exercised.
+	std::vector<Vec3f> make_vectors_()
+	{
+		std::vector<Vec3f> ret;
+		for( std::size_t i = 0; i < 13; ++i )
+		{
+			float const f = float(i);
+			ret.emplace_back( Vec3f{ 0.5f*f - 3.f, 2.f - 0.25f*f, 0.125f*f*f + 1.f } );
+		}
+		return ret;
+	}
+}
+
+// Test case to verify the SoA container and the conversions
+TEST_CASE( "Vec3fSoA", "[soa]" )
+{
+	static constexpr float kEps_ = 1e-6f;
+
+	using namespace Catch::Matchers;
+
+	auto const aos = make_vectors_();
+
+	SECTION( "Layout" )
+	{
+		auto const soa = to_soa( aos.data(), aos.data() + aos.size() );
+
+		REQUIRE( soa.size() == aos.size() );
+		REQUIRE( soa.padded_size() % Vec3fSoA::kBlock == 0 );
+		REQUIRE( soa.padded_size() >= soa.size() );
+		REQUIRE( reinterpret_cast<std::uintptr_t>(soa.x()) % Vec3fSoA::kAlign == 0 );
+		REQUIRE( reinterpret_cast<std::uintptr_t>(soa.y()) % Vec3fSoA::kAlign == 0 );
+		REQUIRE( reinterpret_cast<std::uintptr_t>(soa.z()) % Vec3fSoA::kAlign == 0 );
+
+		for( std::size_t i = 0; i < aos.size(); ++i )
+		{
+			REQUIRE_THAT( soa.x()[i], WithinAbs( aos[i].x, kEps_ ) );
+			REQUIRE_THAT( soa.y()[i], WithinAbs( aos[i].y, kEps_ ) );
+			REQUIRE_THAT( soa.z()[i], WithinAbs( aos[i].z, kEps_ ) );
+		}
+	}
+
+	SECTION( "Round trip" )
+	{
+		auto const soa = to_soa( aos.data(), aos.data() + aos.size() );
+
+		std::vector<Vec3f> back( soa.size() );
+		from_soa( soa, back.data() );
+
+		for( std::size_t i = 0; i < aos.size(); ++i )
+		{
+			REQUIRE_THAT( back[i].x, WithinAbs( aos[i].x, kEps_ ) );
+			REQUIRE_THAT( back[i].y, WithinAbs( aos[i].y, kEps_ ) );
+			REQUIRE_THAT( back[i].z, WithinAbs( aos[i].z, kEps_ ) );
+		}
+	}
+
+	SECTION( "Resize" )
+	{
+		Vec3fSoA soa( 3 );
+		soa.set( 2, { 1.f, 2.f, 3.f } );
+		soa.resize( 11 );
+
+		REQUIRE_THAT( soa.get( 2 ).z, WithinAbs( 3.f, kEps_ ) );
+		for( std::size_t i = 3; i < 11; ++i )
+			REQUIRE_THAT( soa.get( i ).x, WithinAbs( 0.f, kEps_ ) );
+	}
+}
+
+// Test case to verify that the SoA bulk operations match the AoS ones
+TEST_CASE( "Vec3fSoA bulk operations", "[soa][batch]" )
+{
+	static constexpr float kEps_ = 1e-6f;
+
+	using namespace Catch::Matchers;
+
+	auto const check = [] ( Vec3fSoA const& aSoA, std::vector<Vec3f> const& aExpected ) {
+		REQUIRE( aSoA.size() == aExpected.size() );
+		for( std::size_t i = 0; i < aExpected.size(); ++i )
+		{
+			REQUIRE_THAT( aSoA.get( i ).x, WithinAbs( aExpected[i].x, kEps_ ) );
+			REQUIRE_THAT( aSoA.get( i ).y, WithinAbs( aExpected[i].y, kEps_ ) );
+			REQUIRE_THAT( aSoA.get( i ).z, WithinAbs( aExpected[i].z, kEps_ ) );
+		}
+	};
+
+	auto aos = make_vectors_();
+	auto soa = to_soa( aos.data(), aos.data() + aos.size() );
+
+	SECTION( "Point transform" )
+	{
+		auto const M = make_perspective_projection( 1.f, 1.5f, 0.1f, 100.f )
+			* make_translation( { 0.f, 0.f, -5.f } );
+
+		transform_points( M, aos.data(), aos.data() + aos.size() );
+		transform_points( M, soa );
+		check( soa, aos );
+	}
+
+	SECTION( "Normal transform" )
+	{
+		auto const N = make_normal_matrix( make_rotation_y( 0.3f ) * make_scaling( 1.f, 2.f, 3.f ) );
+
+		transform_normals( N, aos.data(), aos.data() + aos.size() );
+		transform_normals( N, soa );
+		check( soa, aos );
+	}
+
+	SECTION( "Normalize" )
+	{
+		for( auto& v : aos )
+			v = normalize( v );
+
+		normalize( soa );
+		check( soa, aos );
+	}
+
+	SECTION( "Bounds" )
+	{
+		auto const a = compute_bounds( aos.data(), aos.data() + aos.size() );
+		auto const b = compute_bounds( soa );
+
+		REQUIRE_THAT( a.min.x, WithinAbs( -3.f, kEps_ ) );
+		REQUIRE_THAT( a.max.x, WithinAbs( 3.f, kEps_ ) );
+		REQUIRE_THAT( a.min.y, WithinAbs( -1.f, kEps_ ) );
+		REQUIRE_THAT( a.max.y, WithinAbs( 2.f, kEps_ ) );
+		REQUIRE_THAT( a.min.z, WithinAbs( 1.f, kEps_ ) );
+		REQUIRE_THAT( a.max.z, WithinAbs( 19.f, kEps_ ) );
+
+		REQUIRE_THAT( b.min.x, WithinAbs( a.min.x, kEps_ ) );
+		REQUIRE_THAT( b.min.y, WithinAbs( a.min.y, kEps_ ) );
+		REQUIRE_THAT( b.min.z, WithinAbs( a.min.z, kEps_ ) );
+		REQUIRE_THAT( b.max.x, WithinAbs( a.max.x, kEps_ ) );
+		REQUIRE_THAT( b.max.y, WithinAbs( a.max.y, kEps_ ) );
+		REQUIRE_THAT( b.max.z, WithinAbs( a.max.z, kEps_ ) );
+	}
+}
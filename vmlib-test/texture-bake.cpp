@@ -0,0 +1,272 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include "../vmlib/texture_bake.hpp"
+
+namespace
+{
+	// Root mean square error per channel over the first aChannels channels
+	float rms_error_( std::uint8_t const* aA, std::uint8_t const* aB, std::size_t aPixels, std::size_t aChannels )
+	{
+		double sum = 0.0;
+		for( std::size_t i = 0; i < aPixels; ++i )
+		{
+			for( std::size_t c = 0; c < aChannels; ++c )
+			{
+				double const d = double(aA[4*i + c]) - double(aB[4*i + c]);
+				sum += d * d;
+			}
+		}
+		return float(std::sqrt( sum / double(aPixels * aChannels) ));
+	}
+
+	// A smooth, opaque block: colour ramps, as in most photographs
+	void gradient_block_( std::uint8_t* aPixels )
+	{
+		for( std::size_t y = 0; y < 4; ++y )
+		{
+			for( std::size_t x = 0; x < 4; ++x )
+			{
+				std::uint8_t* p = aPixels + 4*(4*y + x);
+				p[0] = std::uint8_t(40 + 30*x + 5*y);
+				p[1] = std::uint8_t(90 + 20*x + 10*y);
+				p[2] = std::uint8_t(200 - 25*x);
+				p[3] = 255;
+			}
+		}
+	}
+}
+
+TEST_CASE( "sRGB conversion", "[texture]" )
+{
+	SECTION( "Round trip" )
+	{
+		for( int i = 0; i < 256; ++i )
+			REQUIRE( i == linear_to_srgb( srgb_to_linear( std::uint8_t(i) ) ) );
+	}
+
+	SECTION( "End points and clamping" )
+	{
+		REQUIRE( 0.f == srgb_to_linear( 0 ) );
+		REQUIRE( 1.f == srgb_to_linear( 255 ) );
+		REQUIRE( 0 == linear_to_srgb( -1.f ) );
+		REQUIRE( 255 == linear_to_srgb( 2.f ) );
+	}
+
+	SECTION( "Middle grey" )
+	{
+		// Linear 0.5 is sRGB 0.735
+		REQUIRE( 188 == linear_to_srgb( 0.5f ) );
+	}
+}
+
+TEST_CASE( "Mipmap downsampling", "[texture]" )
+{
+	SECTION( "Level counts" )
+	{
+		REQUIRE( 1 == mip_level_count( 1, 1 ) );
+		REQUIRE( 13 == mip_level_count( 4096, 4096 ) );
+		REQUIRE( 3 == mip_level_count( 5, 3 ) ); // 5x3, 2x1, 1x1
+		REQUIRE( 11 == mip_level_count( 1024, 1 ) );
+	}
+
+	SECTION( "Averages in linear space" )
+	{
+		// Black and white checkers become middle grey, not sRGB 128
+		std::uint8_t const src[16] = {
+			0, 0, 0, 255,      255, 255, 255, 255,
+			255, 255, 255, 0,  0, 0, 0, 0
+		};
+		std::uint8_t dst[4] = {};
+		downsample_srgb( src, 2, 2, dst, 0, 1 );
+
+		REQUIRE( 188 == dst[0] );
+		REQUIRE( 188 == dst[1] );
+		REQUIRE( 188 == dst[2] );
+		REQUIRE( 128 == dst[3] ); // alpha is linear: (255+255+0+0)/4
+	}
+
+	SECTION( "Uniform images stay the same" )
+	{
+		std::vector<std::uint8_t> src( 4 * 6 * 5 );
+		for( std::size_t i = 0; i < src.size(); i += 4 )
+		{
+			src[i+0] = 17; src[i+1] = 99; src[i+2] = 230; src[i+3] = 77;
+		}
+
+		std::vector<std::uint8_t> dst( 4 * 3 * 2 );
+		downsample_srgb( src.data(), 6, 5, dst.data(), 0, 2 );
+		for( std::size_t i = 0; i < dst.size(); i += 4 )
+		{
+			REQUIRE( 17 == dst[i+0] );
+			REQUIRE( 99 == dst[i+1] );
+			REQUIRE( 230 == dst[i+2] );
+			REQUIRE( 77 == dst[i+3] );
+		}
+	}
+
+	SECTION( "Rows can be filled separately" )
+	{
+		std::mt19937 rng( 3 );
+		std::vector<std::uint8_t> src( 4 * 9 * 7 );
+		for( auto& v : src )
+			v = std::uint8_t(rng());
+
+		std::vector<std::uint8_t> whole( 4 * 4 * 3 ), split( whole.size() );
+		downsample_srgb( src.data(), 9, 7, whole.data(), 0, 3 );
+		downsample_srgb( src.data(), 9, 7, split.data(), 2, 1 );
+		downsample_srgb( src.data(), 9, 7, split.data(), 0, 2 );
+
+		REQUIRE( whole == split );
+	}
+
+	SECTION( "Single column" )
+	{
+		std::uint8_t const src[12] = { 10, 20, 30, 40,  50, 60, 70, 80,  90, 100, 110, 120 };
+		std::uint8_t dst[4] = {};
+		downsample_srgb( src, 1, 3, dst, 0, 1 );
+
+		// Rows 0 and 1 only; the column is repeated
+		REQUIRE( linear_to_srgb( 0.5f * (srgb_to_linear( 10 ) + srgb_to_linear( 50 )) ) == dst[0] );
+		REQUIRE( 60 == dst[3] );
+	}
+}
+
+TEST_CASE( "BC1 blocks", "[texture]" )
+{
+	std::uint8_t block[8], decoded[kBlockPixelBytes];
+
+	SECTION( "Solid colour" )
+	{
+		// Representable in RGB565
+		std::uint8_t pixels[kBlockPixelBytes];
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			pixels[4*i+0] = 255; pixels[4*i+1] = 130; pixels[4*i+2] = 66; pixels[4*i+3] = 255;
+		}
+
+		encode_bc1_block( pixels, block );
+		decode_bc1_block( block, decoded );
+
+		REQUIRE( 0.f == rms_error_( pixels, decoded, 16, 4 ) );
+	}
+
+	SECTION( "Gradient" )
+	{
+		std::uint8_t pixels[kBlockPixelBytes];
+		gradient_block_( pixels );
+
+		encode_bc1_block( pixels, block );
+		decode_bc1_block( block, decoded );
+
+		// Four colour mode (c0 > c1), so everything stays opaque
+		REQUIRE( (block[0] | (block[1] << 8)) > (block[2] | (block[3] << 8)) );
+		REQUIRE( rms_error_( pixels, decoded, 16, 3 ) < 8.f );
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE( 255 == decoded[4*i+3] );
+	}
+}
+
+TEST_CASE( "BC7 blocks", "[texture]" )
+{
+	std::uint8_t block[16], decoded[kBlockPixelBytes];
+
+	SECTION( "Solid colour" )
+	{
+		std::uint8_t pixels[kBlockPixelBytes];
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			pixels[4*i+0] = 201; pixels[4*i+1] = 14; pixels[4*i+2] = 97; pixels[4*i+3] = 255;
+		}
+
+		encode_bc7_block( pixels, block );
+		decode_bc7_block( block, decoded );
+
+		REQUIRE( 0x40 == (block[0] & 0x7f) ); // mode 6
+		for( std::size_t i = 0; i < kBlockPixelBytes; ++i )
+			REQUIRE( std::abs( int(pixels[i]) - int(decoded[i]) ) <= 1 );
+	}
+
+	SECTION( "Ramp with alpha" )
+	{
+		// Colour and alpha on one line: only the endpoint and weight
+		// quantization remain.
+		std::uint8_t pixels[kBlockPixelBytes];
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			pixels[4*i+0] = std::uint8_t(30 + 12*i);
+			pixels[4*i+1] = std::uint8_t(200 - 8*i);
+			pixels[4*i+2] = std::uint8_t(100 + 3*i);
+			pixels[4*i+3] = std::uint8_t(17*i);
+		}
+
+		encode_bc7_block( pixels, block );
+		decode_bc7_block( block, decoded );
+
+		REQUIRE( rms_error_( pixels, decoded, 16, 4 ) < 2.f );
+	}
+
+	SECTION( "Better than BC1" )
+	{
+		std::mt19937 rng( 7 );
+		std::uint8_t pixels[kBlockPixelBytes], bc1[kBlockPixelBytes];
+		std::uint8_t small[8];
+		for( int n = 0; n < 64; ++n )
+		{
+			// Noisy gradients
+			gradient_block_( pixels );
+			for( std::size_t i = 0; i < 16; ++i )
+			{
+				for( std::size_t c = 0; c < 3; ++c )
+					pixels[4*i+c] = std::uint8_t(std::min( 255, pixels[4*i+c] + int(rng() % 16) ));
+			}
+
+			encode_bc1_block( pixels, small );
+			decode_bc1_block( small, bc1 );
+			encode_bc7_block( pixels, block );
+			decode_bc7_block( block, decoded );
+
+			REQUIRE( rms_error_( pixels, decoded, 16, 3 ) <= rms_error_( pixels, bc1, 16, 3 ) );
+		}
+	}
+}
+
+TEST_CASE( "Block compressed images", "[texture]" )
+{
+	REQUIRE( 8 == compressed_size( BlockFormat::bc1, 1, 1 ) );
+	REQUIRE( 4 * 16 == compressed_size( BlockFormat::bc7, 5, 8 ) );
+	REQUIRE( 1024 * 1024 * 8 == compressed_size( BlockFormat::bc1, 4096, 4096 ) );
+
+	// 5x5: the blocks past the edge repeat the last column and row
+	std::uint8_t src[4*5*5];
+	for( std::size_t i = 0; i < 25; ++i )
+	{
+		src[4*i+0] = std::uint8_t(i * 10);
+		src[4*i+1] = std::uint8_t(i * 10);
+		src[4*i+2] = std::uint8_t(i * 10);
+		src[4*i+3] = 255;
+	}
+
+	for( auto const format : { BlockFormat::bc1, BlockFormat::bc7 } )
+	{
+		std::vector<std::uint8_t> blocks( compressed_size( format, 5, 5 ) );
+		encode_blocks( format, src, 5, 5, blocks.data(), 0, 2 );
+
+		// Bottom right block: a single pixel, repeated
+		std::uint8_t decoded[kBlockPixelBytes];
+		std::uint8_t const* last = blocks.data() + 3 * block_bytes( format );
+		if( BlockFormat::bc1 == format )
+			decode_bc1_block( last, decoded );
+		else
+			decode_bc7_block( last, decoded );
+
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE( std::abs( int(decoded[4*i]) - 240 ) <= 4 );
+	}
+}
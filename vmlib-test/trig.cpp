@@ -0,0 +1,150 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <limits>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "../vmlib/trig.hpp"
+
+namespace
+{
+	std::int64_t ulp_distance_( float aA, float aB )
+	{
+		auto const ordered = [] (float aX) {
+			std::int32_t i;
+			std::memcpy( &i, &aX, sizeof(i) );
+			return i < 0 ? std::int64_t(INT32_MIN) - i : std::int64_t(i);
+		};
+
+		auto const d = ordered( aA ) - ordered( aB );
+		return d < 0 ? -d : d;
+	}
+
+	bool same_bits_( float aA, float aB )
+	{
+		return 0 == std::memcmp( &aA, &aB, sizeof(float) );
+	}
+}
+
+// Test case to verify the error bounds documented in trig.hpp
+TEST_CASE( "sin/cos", "[trig]" )
+{
+	using namespace Catch::Matchers;
+
+	SECTION( "Special angles" )
+	{
+		static constexpr float kEps_ = 1.2e-7f;
+
+		REQUIRE( 0.f == sincos( 0.f ).sin );
+		REQUIRE( 1.f == sincos( 0.f ).cos );
+		REQUIRE( std::signbit( sincos( -0.f ).sin ) );
+
+		REQUIRE_THAT( sincos( 3.1415926f/2.f ).sin, WithinAbs( 1.f, kEps_ ) );
+		REQUIRE_THAT( sincos( 3.1415926f/2.f ).cos, WithinAbs( 0.f, kEps_ ) );
+		REQUIRE_THAT( sincos( -3.1415926f/2.f ).sin, WithinAbs( -1.f, kEps_ ) );
+		REQUIRE_THAT( sincos( 3.1415926f ).cos, WithinAbs( -1.f, kEps_ ) );
+	}
+
+	// Batched and scalar versions must agree exactly, which also covers the
+	// non-SIMD tail (the count is odd).
+	SECTION( "Error and batch" )
+	{
+		std::vector<float> angles;
+		for( float x = -8192.f; x <= 8192.f; x += 0.731f )
+			angles.emplace_back( x );
+
+		std::vector<float> s( angles.size() ), c( angles.size() );
+		sincos_batch( angles.data(), angles.size(), s.data(), c.data() );
+
+		double maxErr = 0.0;
+		std::size_t mismatches = 0;
+		for( std::size_t i = 0; i < angles.size(); ++i )
+		{
+			double const x = angles[i];
+			maxErr = std::max( maxErr, std::abs( s[i] - std::sin( x ) ) );
+			maxErr = std::max( maxErr, std::abs( c[i] - std::cos( x ) ) );
+
+			auto const sc = sincos( angles[i] );
+			if( !same_bits_( sc.sin, s[i] ) || !same_bits_( sc.cos, c[i] ) )
+				++mismatches;
+		}
+
+		REQUIRE( maxErr <= 1.2e-7 );
+		REQUIRE( 0 == mismatches );
+	}
+
+	// Beyond 8192, the angle is reduced in double; the octant must never be
+	// computed from an out-of-range int32 conversion.
+	SECTION( "Large and non-finite angles" )
+	{
+		std::vector<float> angles{
+			8192.5f, -1e4f, 123456.7f, 1e6f, -3.3e9f, 4e9f, 1e10f, -1e20f,
+			std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+			std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+			std::numeric_limits<float>::quiet_NaN(),
+			1.f, -2.f, 3.f // in range, in the same SIMD vector as the above
+		};
+
+		std::vector<float> s( angles.size() ), c( angles.size() );
+		sincos_batch( angles.data(), angles.size(), s.data(), c.data() );
+
+		for( std::size_t i = 0; i < angles.size(); ++i )
+		{
+			auto const sc = sincos( angles[i] );
+			REQUIRE( same_bits_( sc.sin, s[i] ) );
+			REQUIRE( same_bits_( sc.cos, c[i] ) );
+
+			double const x = angles[i];
+			if( !std::isfinite( x ) )
+			{
+				REQUIRE( std::isnan( sc.sin ) );
+				REQUIRE( std::isnan( sc.cos ) );
+				continue;
+			}
+
+			REQUIRE( std::abs( sc.sin ) <= 1.f );
+			REQUIRE( std::abs( sc.cos ) <= 1.f );
+			REQUIRE_THAT( double(sc.sin)*sc.sin + double(sc.cos)*sc.cos, WithinAbs( 1.0, 1e-6 ) );
+
+			// Documented bound
+			double const eps = 3e-7 + std::abs( x ) * 5e-17;
+			REQUIRE_THAT( sc.sin, WithinAbs( std::sin( x ), eps ) );
+			REQUIRE_THAT( sc.cos, WithinAbs( std::cos( x ), eps ) );
+		}
+	}
+}
+
+TEST_CASE( "atan", "[trig]" )
+{
+	std::vector<float> xs;
+	for( float x = 1e-6f; x < 1e7f; x *= 1.001f )
+	{
+		xs.emplace_back( x );
+		xs.emplace_back( -x );
+	}
+	xs.emplace_back( 0.f );
+	xs.emplace_back( INFINITY );
+	xs.emplace_back( -INFINITY );
+
+	std::vector<float> out( xs.size() );
+	atan_batch( xs.data(), xs.size(), out.data() );
+
+	std::int64_t maxUlp = 0;
+	std::size_t mismatches = 0;
+	for( std::size_t i = 0; i < xs.size(); ++i )
+	{
+		float const ref = float(std::atan( double(xs[i]) ));
+		maxUlp = std::max( maxUlp, ulp_distance_( out[i], ref ) );
+
+		float single;
+		atan_batch( &xs[i], 1, &single );
+		if( !same_bits_( single, out[i] ) )
+			++mismatches;
+	}
+
+	REQUIRE( maxUlp <= 3 );
+	REQUIRE( 0 == mismatches );
+}
@@ -0,0 +1,491 @@
+#include "batch.hpp"
+
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+
+#include "simd.hpp"
+#include "simd_float.hpp"
+
+namespace
+{
+#	if defined(VMLIB_SIMD_SSE)
+	// Load four consecutive Vec3fs and de-interleave them into separate
+	// x, y and z registers (i.e., go from AoS to SoA).
+	//   a = x0 y0 z0 x1,  b = y1 z1 x2 y2,  c = z2 x3 y3 z3
+	inline
+	void load_xyz4_( Vec3f const* aSrc, __m128& aX, __m128& aY, __m128& aZ ) noexcept
+	{
+		float const* src = &aSrc->x;
+		__m128 const a = _mm_loadu_ps( src + 0 );
+		__m128 const b = _mm_loadu_ps( src + 4 );
+		__m128 const c = _mm_loadu_ps( src + 8 );
+
+		__m128 const x2x3 = _mm_shuffle_ps( b, c, _MM_SHUFFLE(1,1,2,2) );
+		aX = _mm_shuffle_ps( a, x2x3, _MM_SHUFFLE(2,0,3,0) );
+
+		__m128 const y0y1 = _mm_shuffle_ps( a, b, _MM_SHUFFLE(0,0,1,1) );
+		__m128 const y2y3 = _mm_shuffle_ps( b, c, _MM_SHUFFLE(2,2,3,3) );
+		aY = _mm_shuffle_ps( y0y1, y2y3, _MM_SHUFFLE(2,0,2,0) );
+
+		__m128 const z0z1 = _mm_shuffle_ps( a, b, _MM_SHUFFLE(1,1,2,2) );
+		__m128 const z2z3 = _mm_shuffle_ps( c, c, _MM_SHUFFLE(3,3,0,0) );
+		aZ = _mm_shuffle_ps( z0z1, z2z3, _MM_SHUFFLE(2,0,2,0) );
+	}
+
+	// Inverse of load_xyz4_(): interleave x, y and z registers into four
+	// consecutive Vec3fs.
+	inline
+	void store_xyz4_( Vec3f* aDst, __m128 aX, __m128 aY, __m128 aZ ) noexcept
+	{
+		__m128 const xy01 = _mm_unpacklo_ps( aX, aY ); // x0 y0 x1 y1
+		__m128 const xy23 = _mm_unpackhi_ps( aX, aY ); // x2 y2 x3 y3
+
+		__m128 const z0x1 = _mm_shuffle_ps( aZ, xy01, _MM_SHUFFLE(2,2,0,0) );
+		__m128 const a = _mm_shuffle_ps( xy01, z0x1, _MM_SHUFFLE(2,0,1,0) );
+
+		__m128 const y1z1 = _mm_shuffle_ps( xy01, aZ, _MM_SHUFFLE(1,1,3,3) );
+		__m128 const b = _mm_shuffle_ps( y1z1, xy23, _MM_SHUFFLE(1,0,2,0) );
+
+		__m128 const z2x3 = _mm_shuffle_ps( aZ, xy23, _MM_SHUFFLE(2,2,2,2) );
+		__m128 const y3z3 = _mm_shuffle_ps( xy23, aZ, _MM_SHUFFLE(3,3,3,3) );
+		__m128 const c = _mm_shuffle_ps( z2x3, y3z3, _MM_SHUFFLE(2,0,2,0) );
+
+		float* dst = &aDst->x;
+		_mm_storeu_ps( dst + 0, a );
+		_mm_storeu_ps( dst + 4, b );
+		_mm_storeu_ps( dst + 8, c );
+	}
+
+	// Computes one row of a matrix-vector product for four vectors at once.
+	// Same order of operations as the scalar code.
+	inline
+	__m128 row3_( float const* aRow, __m128 aX, __m128 aY, __m128 aZ ) noexcept
+	{
+		__m128 acc = _mm_mul_ps( _mm_set1_ps( aRow[0] ), aX );
+		acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( aRow[1] ), aY ) );
+		acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( aRow[2] ), aZ ) );
+		return acc;
+	}
+#	endif // ~ VMLIB_SIMD_SSE
+
+	template< bool tAffine >
+	void transform_points_( Mat44f const& aM, Vec3f* aFirst, Vec3f* aLast ) noexcept
+	{
+		Vec3f* it = aFirst;
+
+#		if defined(VMLIB_SIMD_SSE)
+		for( ; aLast - it >= 4; it += 4 )
+		{
+			__m128 x, y, z;
+			load_xyz4_( it, x, y, z );
+
+			__m128 tx = _mm_add_ps( row3_( aM.v + 0, x, y, z ), _mm_set1_ps( aM.v[3] ) );
+			__m128 ty = _mm_add_ps( row3_( aM.v + 4, x, y, z ), _mm_set1_ps( aM.v[7] ) );
+			__m128 tz = _mm_add_ps( row3_( aM.v + 8, x, y, z ), _mm_set1_ps( aM.v[11] ) );
+
+			if constexpr( !tAffine )
+			{
+				__m128 const tw = _mm_add_ps( row3_( aM.v + 12, x, y, z ), _mm_set1_ps( aM.v[15] ) );
+				tx = _mm_div_ps( tx, tw );
+				ty = _mm_div_ps( ty, tw );
+				tz = _mm_div_ps( tz, tw );
+			}
+
+			store_xyz4_( it, tx, ty, tz );
+		}
+#		endif // ~ VMLIB_SIMD_SSE
+
+		for( ; it != aLast; ++it )
+		{
+			Vec3f const p = *it;
+			float tx = aM.v[0]*p.x + aM.v[1]*p.y + aM.v[2]*p.z + aM.v[3];
+			float ty = aM.v[4]*p.x + aM.v[5]*p.y + aM.v[6]*p.z + aM.v[7];
+			float tz = aM.v[8]*p.x + aM.v[9]*p.y + aM.v[10]*p.z + aM.v[11];
+
+			if constexpr( !tAffine )
+			{
+				float const tw = aM.v[12]*p.x + aM.v[13]*p.y + aM.v[14]*p.z + aM.v[15];
+				tx /= tw;
+				ty /= tw;
+				tz /= tw;
+			}
+
+			*it = Vec3f{ tx, ty, tz };
+		}
+	}
+}
+
+void transform_points( Mat44f const& aM, Vec3f* aFirst, Vec3f* aLast ) noexcept
+{
+	if( is_affine( aM ) )
+		transform_points_<true>( aM, aFirst, aLast );
+	else
+		transform_points_<false>( aM, aFirst, aLast );
+}
+
+void transform_normals( Mat33f const& aN, Vec3f* aFirst, Vec3f* aLast ) noexcept
+{
+	Vec3f* it = aFirst;
+
+#	if defined(VMLIB_SIMD_SSE)
+	for( ; aLast - it >= 4; it += 4 )
+	{
+		__m128 x, y, z;
+		load_xyz4_( it, x, y, z );
+
+		__m128 const tx = row3_( aN.v + 0, x, y, z );
+		__m128 const ty = row3_( aN.v + 3, x, y, z );
+		__m128 const tz = row3_( aN.v + 6, x, y, z );
+
+		store_xyz4_( it, tx, ty, tz );
+	}
+#	endif // ~ VMLIB_SIMD_SSE
+
+	for( ; it != aLast; ++it )
+		*it = aN * *it;
+}
+
+Aabb3f compute_bounds( Vec3f const* aFirst, Vec3f const* aLast ) noexcept
+{
+	constexpr float kInf = std::numeric_limits<float>::infinity();
+	Aabb3f ret{ { kInf, kInf, kInf }, { -kInf, -kInf, -kInf } };
+
+	for( auto it = aFirst; it != aLast; ++it )
+	{
+		ret.min = Vec3f{ std::min( ret.min.x, it->x ), std::min( ret.min.y, it->y ), std::min( ret.min.z, it->z ) };
+		ret.max = Vec3f{ std::max( ret.max.x, it->x ), std::max( ret.max.y, it->y ), std::max( ret.max.z, it->z ) };
+	}
+
+	return ret;
+}
+
+
+template< typename tMath >
+void normalize( Vec3f* aFirst, Vec3f* aLast ) noexcept
+{
+	Vec3f* it = aFirst;
+
+#	if defined(VMLIB_SIMD_SSE)
+	for( ; aLast - it >= 4; it += 4 )
+	{
+		__m128 x, y, z;
+		load_xyz4_( it, x, y, z );
+
+		__m128 const d = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+
+		if constexpr( std::is_same_v<tMath, FastMath> )
+		{
+			// See FastMath::rsqrt()
+			__m128 const r = _mm_rsqrt_ps( d );
+			__m128 const rr = _mm_mul_ps( _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( 0.5f ), d ), r ), r );
+			__m128 const s = _mm_mul_ps( r, _mm_sub_ps( _mm_set1_ps( 1.5f ), rr ) );
+			store_xyz4_( it, _mm_mul_ps( x, s ), _mm_mul_ps( y, s ), _mm_mul_ps( z, s ) );
+		}
+		else
+		{
+			__m128 const l = _mm_sqrt_ps( d );
+			store_xyz4_( it, _mm_div_ps( x, l ), _mm_div_ps( y, l ), _mm_div_ps( z, l ) );
+		}
+	}
+#	endif // ~ VMLIB_SIMD_SSE
+
+	for( ; it != aLast; ++it )
+		*it = normalize<tMath>( *it );
+}
+
+template void normalize<PreciseMath>( Vec3f*, Vec3f* ) noexcept;
+template void normalize<FastMath>( Vec3f*, Vec3f* ) noexcept;
+
+
+Vec3fSoA to_soa( Vec3f const* aFirst, Vec3f const* aLast )
+{
+	std::size_t const count = std::size_t(aLast - aFirst);
+	Vec3fSoA ret( count );
+
+	float* x = ret.x();
+	float* y = ret.y();
+	float* z = ret.z();
+
+	std::size_t i = 0;
+#	if defined(VMLIB_SIMD_SSE)
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 vx, vy, vz;
+		load_xyz4_( aFirst + i, vx, vy, vz );
+		_mm_store_ps( x + i, vx );
+		_mm_store_ps( y + i, vy );
+		_mm_store_ps( z + i, vz );
+	}
+#	endif // ~ VMLIB_SIMD_SSE
+
+	for( ; i < count; ++i )
+	{
+		x[i] = aFirst[i].x;
+		y[i] = aFirst[i].y;
+		z[i] = aFirst[i].z;
+	}
+
+	return ret;
+}
+
+void from_soa( Vec3fSoA const& aSoA, Vec3f* aOut ) noexcept
+{
+	std::size_t const count = aSoA.size();
+
+	float const* x = aSoA.x();
+	float const* y = aSoA.y();
+	float const* z = aSoA.z();
+
+	std::size_t i = 0;
+#	if defined(VMLIB_SIMD_SSE)
+	for( ; i + 4 <= count; i += 4 )
+		store_xyz4_( aOut + i, _mm_load_ps( x + i ), _mm_load_ps( y + i ), _mm_load_ps( z + i ) );
+#	endif // ~ VMLIB_SIMD_SSE
+
+	for( ; i < count; ++i )
+		aOut[i] = Vec3f{ x[i], y[i], z[i] };
+}
+
+void transform_points( Mat44f const& aM, Vec3fSoA& aPoints ) noexcept
+{
+	bool const affine = is_affine( aM );
+
+	float* x = aPoints.x();
+	float* y = aPoints.y();
+	float* z = aPoints.z();
+
+#	if defined(VMLIB_SIMD_SSE)
+	using namespace simd;
+
+	// Vec3fSoA pads to kBlock, which is a multiple of the SIMD width.
+	static_assert( Vec3fSoA::kBlock % kWidth == 0 );
+
+	for( std::size_t i = 0; i < aPoints.padded_size(); i += kWidth )
+	{
+		Float const px = load( x + i );
+		Float const py = load( y + i );
+		Float const pz = load( z + i );
+
+		auto const row = [&] ( float const* aRow ) {
+			Float acc = mul( set1( aRow[0] ), px );
+			acc = add( acc, mul( set1( aRow[1] ), py ) );
+			acc = add( acc, mul( set1( aRow[2] ), pz ) );
+			return add( acc, set1( aRow[3] ) );
+		};
+
+		Float tx = row( aM.v + 0 );
+		Float ty = row( aM.v + 4 );
+		Float tz = row( aM.v + 8 );
+
+		if( !affine )
+		{
+			Float const tw = row( aM.v + 12 );
+			tx = div( tx, tw );
+			ty = div( ty, tw );
+			tz = div( tz, tw );
+		}
+
+		store( x + i, tx );
+		store( y + i, ty );
+		store( z + i, tz );
+	}
+#	else // scalar
+	for( std::size_t i = 0; i < aPoints.size(); ++i )
+	{
+		float tx = aM.v[0]*x[i] + aM.v[1]*y[i] + aM.v[2]*z[i] + aM.v[3];
+		float ty = aM.v[4]*x[i] + aM.v[5]*y[i] + aM.v[6]*z[i] + aM.v[7];
+		float tz = aM.v[8]*x[i] + aM.v[9]*y[i] + aM.v[10]*z[i] + aM.v[11];
+
+		if( !affine )
+		{
+			float const tw = aM.v[12]*x[i] + aM.v[13]*y[i] + aM.v[14]*z[i] + aM.v[15];
+			tx /= tw;
+			ty /= tw;
+			tz /= tw;
+		}
+
+		x[i] = tx;
+		y[i] = ty;
+		z[i] = tz;
+	}
+#	endif
+}
+
+void transform_normals( Mat33f const& aN, Vec3fSoA& aNormals ) noexcept
+{
+	float* x = aNormals.x();
+	float* y = aNormals.y();
+	float* z = aNormals.z();
+
+#	if defined(VMLIB_SIMD_SSE)
+	using namespace simd;
+
+	for( std::size_t i = 0; i < aNormals.padded_size(); i += kWidth )
+	{
+		Float const nx = load( x + i );
+		Float const ny = load( y + i );
+		Float const nz = load( z + i );
+
+		auto const row = [&] ( float const* aRow ) {
+			Float acc = mul( set1( aRow[0] ), nx );
+			acc = add( acc, mul( set1( aRow[1] ), ny ) );
+			return add( acc, mul( set1( aRow[2] ), nz ) );
+		};
+
+		store( x + i, row( aN.v + 0 ) );
+		store( y + i, row( aN.v + 3 ) );
+		store( z + i, row( aN.v + 6 ) );
+	}
+#	else // scalar
+	for( std::size_t i = 0; i < aNormals.size(); ++i )
+	{
+		Vec3f const n = aN * Vec3f{ x[i], y[i], z[i] };
+		x[i] = n.x;
+		y[i] = n.y;
+		z[i] = n.z;
+	}
+#	endif
+}
+
+Aabb3f compute_bounds( Vec3fSoA const& aPoints ) noexcept
+{
+	constexpr float kInf = std::numeric_limits<float>::infinity();
+
+	float const* x = aPoints.x();
+	float const* y = aPoints.y();
+	float const* z = aPoints.z();
+
+	float minX = kInf, minY = kInf, minZ = kInf;
+	float maxX = -kInf, maxY = -kInf, maxZ = -kInf;
+
+	std::size_t i = 0;
+#	if defined(VMLIB_SIMD_SSE)
+	using namespace simd;
+
+	// The padding may contain anything, so only full SIMD registers of valid
+	// elements are processed here. The rest is handled below.
+	Float vminX = set1( kInf ), vminY = set1( kInf ), vminZ = set1( kInf );
+	Float vmaxX = set1( -kInf ), vmaxY = set1( -kInf ), vmaxZ = set1( -kInf );
+
+	for( ; i + kWidth <= aPoints.size(); i += kWidth )
+	{
+		Float const px = load( x + i );
+		Float const py = load( y + i );
+		Float const pz = load( z + i );
+
+		vminX = simd::min( vminX, px );
+		vminY = simd::min( vminY, py );
+		vminZ = simd::min( vminZ, pz );
+		vmaxX = simd::max( vmaxX, px );
+		vmaxY = simd::max( vmaxY, py );
+		vmaxZ = simd::max( vmaxZ, pz );
+	}
+
+	minX = hmin( vminX );
+	minY = hmin( vminY );
+	minZ = hmin( vminZ );
+	maxX = hmax( vmaxX );
+	maxY = hmax( vmaxY );
+	maxZ = hmax( vmaxZ );
+#	endif // ~ VMLIB_SIMD_SSE
+
+	for( ; i < aPoints.size(); ++i )
+	{
+		minX = std::min( minX, x[i] );
+		minY = std::min( minY, y[i] );
+		minZ = std::min( minZ, z[i] );
+		maxX = std::max( maxX, x[i] );
+		maxY = std::max( maxY, y[i] );
+		maxZ = std::max( maxZ, z[i] );
+	}
+
+	return Aabb3f{ { minX, minY, minZ }, { maxX, maxY, maxZ } };
+}
+
+template< typename tMath >
+void normalize( Vec3fSoA& aVectors ) noexcept
+{
+	float* x = aVectors.x();
+	float* y = aVectors.y();
+	float* z = aVectors.z();
+
+#	if defined(VMLIB_SIMD_SSE)
+	using namespace simd;
+
+	for( std::size_t i = 0; i < aVectors.padded_size(); i += kWidth )
+	{
+		Float const vx = load( x + i );
+		Float const vy = load( y + i );
+		Float const vz = load( z + i );
+
+		Float const d = add( add( mul( vx, vx ), mul( vy, vy ) ), mul( vz, vz ) );
+
+		if constexpr( std::is_same_v<tMath, FastMath> )
+		{
+			Float const r = simd::rsqrt( d );
+			store( x + i, mul( vx, r ) );
+			store( y + i, mul( vy, r ) );
+			store( z + i, mul( vz, r ) );
+		}
+		else
+		{
+			Float const l = simd::sqrt( d );
+			store( x + i, div( vx, l ) );
+			store( y + i, div( vy, l ) );
+			store( z + i, div( vz, l ) );
+		}
+	}
+#	else // scalar
+	for( std::size_t i = 0; i < aVectors.size(); ++i )
+	{
+		Vec3f const n = normalize<tMath>( Vec3f{ x[i], y[i], z[i] } );
+		x[i] = n.x;
+		y[i] = n.y;
+		z[i] = n.z;
+	}
+#	endif
+}
+
+template< typename tMath >
+void length( Vec3fSoA const& aVectors, float* aOut ) noexcept
+{
+	float const* x = aVectors.x();
+	float const* y = aVectors.y();
+	float const* z = aVectors.z();
+
+	std::size_t i = 0;
+
+#	if defined(VMLIB_SIMD_SSE)
+	using namespace simd;
+
+	// aOut has only aVectors.size() elements, so there is a scalar tail.
+	for( ; i + kWidth <= aVectors.size(); i += kWidth )
+	{
+		Float const vx = load( x + i );
+		Float const vy = load( y + i );
+		Float const vz = load( z + i );
+
+		Float const d = add( add( mul( vx, vx ), mul( vy, vy ) ), mul( vz, vz ) );
+
+		if constexpr( std::is_same_v<tMath, FastMath> )
+		{
+			Float const dmin = set1( std::numeric_limits<float>::min() );
+			storeu( aOut + i, mul( d, simd::rsqrt( simd::max( d, dmin ) ) ) );
+		}
+		else
+		{
+			storeu( aOut + i, simd::sqrt( d ) );
+		}
+	}
+#	endif // ~ VMLIB_SIMD_SSE
+
+	for( ; i < aVectors.size(); ++i )
+		aOut[i] = length<tMath>( Vec3f{ x[i], y[i], z[i] } );
+}
+
+template void normalize<PreciseMath>( Vec3fSoA& ) noexcept;
+template void normalize<FastMath>( Vec3fSoA& ) noexcept;
+
+template void length<PreciseMath>( Vec3fSoA const&, float* ) noexcept;
+template void length<FastMath>( Vec3fSoA const&, float* ) noexcept;
@@ -0,0 +1,81 @@
+#ifndef BATCH_HPP_66C40224_11FA_46B5_8DCD_86B46DEBD494
+#define BATCH_HPP_66C40224_11FA_46B5_8DCD_86B46DEBD494
+
+#include "vec3.hpp"
+#include "mat33.hpp"
+#include "mat44.hpp"
+#include "vec3soa.hpp"
+#include "precision.hpp"
+
+/* Batched operations
+ *
+ * These functions work on whole arrays of Vec3f, mostly in place. They are meant
+ * for e.g. mesh generation, where every vertex is transformed with the same
+ * matrix. Compared to transforming one Vec3f at a time (via Vec4f), they
+ * process several vertices at once with SIMD (see simd.hpp).
+ *
+ * The results are identical to transforming each element individually, i.e.,
+ *   Vec4f t = aM * Vec4f{ p.x, p.y, p.z, 1.f };
+ *   t /= t.w;
+ *   p = Vec3f{ t.x, t.y, t.z };
+ * for points and
+ *   n = aN * n;
+ * for normals.
+ *
+ * Example:
+ *   std::vector<Vec3f> pos = ...;
+ *   transform_points( M, pos.data(), pos.data() + pos.size() );
+ *
+ * Most functions also have an overload that works on a Vec3fSoA. These run at
+ * the full SIMD width without any de-interleaving and are the better choice
+ * when several operations are applied to the same data.
+ */
+
+// Axis-aligned bounding box. An empty box has min = +inf and max = -inf.
+struct Aabb3f
+{
+	Vec3f min;
+	Vec3f max;
+};
+
+// Transform points [aFirst, aLast) by aM. The division by w is skipped if
+// the matrix is affine (see is_affine()).
+void transform_points( Mat44f const& aM, Vec3f* aFirst, Vec3f* aLast ) noexcept;
+
+// Transform normals [aFirst, aLast) by aN. aN is typically the normal matrix,
+// i.e., the transpose of the inverse of the upper 3x3 part of the matrix used
+// to transform the points. The normals are not re-normalized.
+void transform_normals( Mat33f const& aN, Vec3f* aFirst, Vec3f* aLast ) noexcept;
+
+// Bounding box of the points [aFirst, aLast).
+Aabb3f compute_bounds( Vec3f const* aFirst, Vec3f const* aLast ) noexcept;
+
+// Normalize each element of [aFirst, aLast). Same results as calling
+// normalize<tMath>() on each. tMath is PreciseMath or FastMath (see
+// precision.hpp).
+template< typename tMath = DefaultMath >
+void normalize( Vec3f* aFirst, Vec3f* aLast ) noexcept;
+
+
+// Conversion between the interleaved layout (e.g., SimpleMeshData, or what
+// is uploaded to OpenGL) and the SoA layout. from_soa() writes aSoA.size()
+// elements to aOut.
+Vec3fSoA to_soa( Vec3f const* aFirst, Vec3f const* aLast );
+void from_soa( Vec3fSoA const& aSoA, Vec3f* aOut ) noexcept;
+
+// SoA versions of the functions above.
+void transform_points( Mat44f const& aM, Vec3fSoA& aPoints ) noexcept;
+void transform_normals( Mat33f const& aN, Vec3fSoA& aNormals ) noexcept;
+Aabb3f compute_bounds( Vec3fSoA const& aPoints ) noexcept;
+
+// Normalize each element. Same results as calling normalize<tMath>() on
+// each.
+template< typename tMath = DefaultMath >
+void normalize( Vec3fSoA& aVectors ) noexcept;
+
+// Length of each element. Writes aVectors.size() values to aOut. Same
+// results as calling length<tMath>() on each.
+template< typename tMath = DefaultMath >
+void length( Vec3fSoA const& aVectors, float* aOut ) noexcept;
+
+#endif // BATCH_HPP_66C40224_11FA_46B5_8DCD_86B46DEBD494
@@ -81,4 +81,32 @@ Mat33f mat44_to_mat33( Mat44f const& aM )
 	return ret;
 }
 
+// Normal matrix for the transformation aM, i.e., the transpose of the inverse
+// of the upper 3x3 block of aM. This is equivalent to
+//   mat44_to_mat33( transpose( invert( aM ) ) )
+// for affine matrices, but only needs to work on the 3x3 block. The inverse
+// transpose is computed directly as the cofactor matrix divided by the
+// determinant.
+inline
+Mat33f make_normal_matrix( Mat44f const& aM ) noexcept
+{
+	Mat33f ret;
+	ret(0,0) = aM(1,1)*aM(2,2) - aM(1,2)*aM(2,1);
+	ret(0,1) = aM(1,2)*aM(2,0) - aM(1,0)*aM(2,2);
+	ret(0,2) = aM(1,0)*aM(2,1) - aM(1,1)*aM(2,0);
+	ret(1,0) = aM(0,2)*aM(2,1) - aM(0,1)*aM(2,2);
+	ret(1,1) = aM(0,0)*aM(2,2) - aM(0,2)*aM(2,0);
+	ret(1,2) = aM(0,1)*aM(2,0) - aM(0,0)*aM(2,1);
+	ret(2,0) = aM(0,1)*aM(1,2) - aM(0,2)*aM(1,1);
+	ret(2,1) = aM(0,2)*aM(1,0) - aM(0,0)*aM(1,2);
+	ret(2,2) = aM(0,0)*aM(1,1) - aM(0,1)*aM(1,0);
+
+	float const d = aM(0,0) * ret(0,0) + aM(0,1) * ret(0,1) + aM(0,2) * ret(0,2);
+
+	for( auto& v : ret.v )
+		v /= d;
+
+	return ret;
+}
+
 #endif // MAT33_HPP_61F3107B_CBE4_48DE_9F39_EA959B4BF694
@@ -1,7 +1,35 @@
 #include "mat44.hpp"
 
+#include "mat33.hpp"
+
+namespace
+{
+	// Builds the inverse of an affine matrix from the inverse of its upper 3x3
+	// block.
+	Mat44f affine_from_inverse_block_( Mat44f const& aM, Mat33f const& aInv ) noexcept
+	{
+		Mat44f ret;
+		for( std::size_t i = 0; i < 3; ++i )
+		{
+			ret(i,0) = aInv(i,0);
+			ret(i,1) = aInv(i,1);
+			ret(i,2) = aInv(i,2);
+			ret(i,3) = -(aInv(i,0)*aM(0,3) + aInv(i,1)*aM(1,3) + aInv(i,2)*aM(2,3));
+		}
+
+		ret(3,0) = 0.f;
+		ret(3,1) = 0.f;
+		ret(3,2) = 0.f;
+		ret(3,3) = 1.f;
+		return ret;
+	}
+}
+
 Mat44f invert( Mat44f const& aM ) noexcept
 {
+	if( is_affine( aM ) )
+		return invert_affine( aM );
+
 	// We could implement this with any number of methods, including Gaussian
 	// Elimination or similar. However, a straigth line solution exists for
 	// small matrices, including 4x4 ones.
@@ -67,3 +95,33 @@ Mat44f invert( Mat44f const& aM ) noexcept
 	return ret;
 }
 
+Mat44f invert_affine( Mat44f const& aM ) noexcept
+{
+	assert( is_affine( aM ) );
+
+	// The normal matrix is the inverse transpose of the 3x3 block.
+	Mat33f const N = make_normal_matrix( aM );
+
+	Mat33f inv;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		for( std::size_t j = 0; j < 3; ++j )
+			inv(i,j) = N(j,i);
+	}
+
+	return affine_from_inverse_block_( aM, inv );
+}
+
+Mat44f invert_rigid( Mat44f const& aM ) noexcept
+{
+	assert( is_affine( aM ) );
+
+	Mat33f inv;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		for( std::size_t j = 0; j < 3; ++j )
+			inv(i,j) = aM(j,i);
+	}
+
+	return affine_from_inverse_block_( aM, inv );
+}
@@ -7,6 +7,7 @@
 
 #include "vec3.hpp"
 #include "vec4.hpp"
+#include "simd.hpp"
 
 /** Mat44f: 4x4 matrix with floats
  *
@@ -26,8 +27,11 @@
  *   ⎜ 1,0  1,1  1,2  1,3 ⎟
  *   ⎜ 2,0  2,1  2,2  2,3 ⎟
  *   ⎝ 3,0  3,1  3,2  3,3 ⎠
+ *
+ * The matrix is aligned to 16 bytes, so that each row can be loaded directly
+ * into a SSE register by the SIMD implementations below.
  */
-struct Mat44f
+struct alignas(16) Mat44f
 {
 	float v[16];
 
@@ -56,51 +60,153 @@ constexpr Mat44f kIdentity44f = { {
 constexpr Vec4f kIdentity4f = { 0.0f, 0.0f, 0.0f, 1.0f };
 
 // Common operators for Mat44f.
-// Note that you will need to implement these yourself.
+//
+// The products and transpose() select a SIMD implementation at compile time
+// (see simd.hpp). The SIMD versions are not constexpr, so neither are these
+// functions. Each version produces bit-identical results to the scalar one.
 
-constexpr
+inline
 Mat44f operator*( Mat44f const& aLeft, Mat44f const& aRight ) noexcept
 {
-	Mat44f result = kIdentity44f;
-
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            result(i, j) = 0.0f;
-            for (int k = 0; k < 4; ++k) {
-                result(i, j) += aLeft(i, k) * aRight(k, j);
-            }
-        }
-    }
-    return result;
+	Mat44f result;
+
+#	if defined(VMLIB_SIMD_AVX)
+	// Two result rows at a time. Each row of the result is a linear
+	// combination of the rows of aRight, weighted by the elements of the
+	// corresponding row of aLeft. The permute broadcasts element k of each
+	// row of aLeft within its 128-bit lane.
+	__m256 const r0 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(aRight.v + 0) );
+	__m256 const r1 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(aRight.v + 4) );
+	__m256 const r2 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(aRight.v + 8) );
+	__m256 const r3 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(aRight.v + 12) );
+
+	for( std::size_t i = 0; i < 4; i += 2 )
+	{
+		__m256 const l = _mm256_loadu_ps( aLeft.v + i*4 );
+
+		__m256 acc = _mm256_mul_ps( _mm256_permute_ps( l, 0x00 ), r0 );
+		acc = _mm256_add_ps( acc, _mm256_mul_ps( _mm256_permute_ps( l, 0x55 ), r1 ) );
+		acc = _mm256_add_ps( acc, _mm256_mul_ps( _mm256_permute_ps( l, 0xaa ), r2 ) );
+		acc = _mm256_add_ps( acc, _mm256_mul_ps( _mm256_permute_ps( l, 0xff ), r3 ) );
+
+		_mm256_storeu_ps( result.v + i*4, acc );
+	}
+#	elif defined(VMLIB_SIMD_SSE)
+	// As above, but one result row at a time.
+	__m128 const r0 = _mm_load_ps( aRight.v + 0 );
+	__m128 const r1 = _mm_load_ps( aRight.v + 4 );
+	__m128 const r2 = _mm_load_ps( aRight.v + 8 );
+	__m128 const r3 = _mm_load_ps( aRight.v + 12 );
+
+	for( std::size_t i = 0; i < 4; ++i )
+	{
+		__m128 acc = _mm_mul_ps( _mm_set1_ps( aLeft.v[i*4+0] ), r0 );
+		acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( aLeft.v[i*4+1] ), r1 ) );
+		acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( aLeft.v[i*4+2] ), r2 ) );
+		acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( aLeft.v[i*4+3] ), r3 ) );
+
+		_mm_store_ps( result.v + i*4, acc );
+	}
+#	else // scalar
+	for( std::size_t i = 0; i < 4; ++i )
+	{
+		for( std::size_t j = 0; j < 4; ++j )
+		{
+			float acc = aLeft.v[i*4+0] * aRight.v[0*4+j];
+			acc += aLeft.v[i*4+1] * aRight.v[1*4+j];
+			acc += aLeft.v[i*4+2] * aRight.v[2*4+j];
+			acc += aLeft.v[i*4+3] * aRight.v[3*4+j];
+			result.v[i*4+j] = acc;
+		}
+	}
+#	endif
+
+	return result;
 }
 
-constexpr
+inline
 Vec4f operator*( Mat44f const& aLeft, Vec4f const& aRight ) noexcept
 {
-	Vec4f result = kIdentity4f;
-
-    for (int i = 0; i < 4; ++i) {
-        result[i] = 0.0f;
-        for (int j = 0; j < 4; ++j) {
-            result[i] += aLeft(i, j) * aRight[j];
-        }
-    }
-    return result;
+	Vec4f result;
+
+#	if defined(VMLIB_SIMD_SSE)
+	// Transpose to get the columns of aLeft; the result is then a linear
+	// combination of the columns. Accumulating column by column keeps the
+	// same order of operations as the scalar code.
+	__m128 c0 = _mm_load_ps( aLeft.v + 0 );
+	__m128 c1 = _mm_load_ps( aLeft.v + 4 );
+	__m128 c2 = _mm_load_ps( aLeft.v + 8 );
+	__m128 c3 = _mm_load_ps( aLeft.v + 12 );
+	_MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+
+	__m128 acc = _mm_mul_ps( c0, _mm_set1_ps( aRight.x ) );
+	acc = _mm_add_ps( acc, _mm_mul_ps( c1, _mm_set1_ps( aRight.y ) ) );
+	acc = _mm_add_ps( acc, _mm_mul_ps( c2, _mm_set1_ps( aRight.z ) ) );
+	acc = _mm_add_ps( acc, _mm_mul_ps( c3, _mm_set1_ps( aRight.w ) ) );
+
+	_mm_store_ps( &result.x, acc );
+#	else // scalar
+	for( std::size_t i = 0; i < 4; ++i )
+	{
+		float acc = aLeft.v[i*4+0] * aRight.x;
+		acc += aLeft.v[i*4+1] * aRight.y;
+		acc += aLeft.v[i*4+2] * aRight.z;
+		acc += aLeft.v[i*4+3] * aRight.w;
+		result[i] = acc;
+	}
+#	endif
+
+	return result;
 }
 
 // Functions:
 
+// General inverse. Affine matrices (see is_affine()) are automatically
+// forwarded to invert_affine().
 Mat44f invert( Mat44f const& aM ) noexcept;
 
+// Inverse of an affine matrix. Only the upper 3x3 block needs to be inverted;
+// the translation is then transformed by the result.
+Mat44f invert_affine( Mat44f const& aM ) noexcept;
+
+// Inverse of a rigid transformation (rotation and translation only). The
+// upper 3x3 block is orthonormal, so its inverse is its transpose. The result
+// is undefined if the matrix contains any scaling or shearing.
+Mat44f invert_rigid( Mat44f const& aM ) noexcept;
+
+// Check if the matrix is affine, i.e., if its last row is (0, 0, 0, 1). An
+// affine matrix maps points with w = 1 to points with w = 1, so there is no
+// need to divide by w after the transformation.
+constexpr
+bool is_affine( Mat44f const& aM ) noexcept
+{
+	return 0.f == aM.v[12] && 0.f == aM.v[13] && 0.f == aM.v[14] && 1.f == aM.v[15];
+}
+
 inline
 Mat44f transpose( Mat44f const& aM ) noexcept
 {
 	Mat44f ret;
+
+#	if defined(VMLIB_SIMD_SSE)
+	__m128 r0 = _mm_load_ps( aM.v + 0 );
+	__m128 r1 = _mm_load_ps( aM.v + 4 );
+	__m128 r2 = _mm_load_ps( aM.v + 8 );
+	__m128 r3 = _mm_load_ps( aM.v + 12 );
+	_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+
+	_mm_store_ps( ret.v + 0, r0 );
+	_mm_store_ps( ret.v + 4, r1 );
+	_mm_store_ps( ret.v + 8, r2 );
+	_mm_store_ps( ret.v + 12, r3 );
+#	else // scalar
 	for( std::size_t i = 0; i < 4; ++i )
 	{
 		for( std::size_t j = 0; j < 4; ++j )
 			ret(j,i) = aM(i,j);
 	}
+#	endif
+
 	return ret;
 }
 
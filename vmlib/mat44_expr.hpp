@@ -0,0 +1,406 @@
+#ifndef MAT44_EXPR_HPP_0CDF83BA_FF1E_47A2_98C4_72DF008B9734
+#define MAT44_EXPR_HPP_0CDF83BA_FF1E_47A2_98C4_72DF008B9734
+
+#include <utility>
+#include <type_traits>
+
+#include <cmath>
+
+#include "vec3.hpp"
+#include "vec4.hpp"
+#include "mat44.hpp"
+
+/* Known-structure matrices and lazy matrix products
+ *
+ * This header is opt-in; nothing in vmlib depends on it.
+ *
+ * Known-structure matrices
+ * ------------------------
+ * Many of the matrices built with the make_*() functions in mat44.hpp are
+ * mostly zeros. The types below store only the non-trivial elements:
+ *
+ *   Identity44f    : identity
+ *   Translation44f : make_translation()
+ *   Scaling44f     : make_scaling()
+ *   Perspective44f : make_perspective_projection()
+ *
+ * Their products with a Mat44f (and with a Vec4f) are specialized at compile
+ * time and skip all terms that are known to be zero. For example,
+ * Perspective44f * Mat44f only scales two rows and combines the other two,
+ * instead of doing the full 64-multiply product. The results are the same as
+ * the full product (up to the sign of zero elements). Products of two
+ * translations or two scalings are folded into a single translation/scaling.
+ * Use to_mat44() to get a full Mat44f.
+ *
+ * Lazy products
+ * -------------
+ * lazy() starts a product expression. Multiplying it by further operands does
+ * not compute anything; instead the operands are recorded in a Mat44Product.
+ * The expression is evaluated
+ *   - when converted to Mat44f (or by eval()): the products are computed left
+ *     to right, using the structured products above where possible;
+ *   - when multiplied by a Vec4f: the vector is transformed by each operand in
+ *     turn, from right to left, and the matrices are never multiplied. For a
+ *     chain of three matrices, this is 3 matrix-vector products instead of
+ *     two matrix-matrix products and one matrix-vector product.
+ *
+ * Mat44f lvalues are stored by reference, to avoid copying 64 bytes per
+ * operand into the expression; an expression must not outlive them. Mat44f
+ * temporaries are moved into the expression, so that the expression can be
+ * kept in an auto variable (or returned from a function):
+ *   auto ok = lazy( P ) * make_rotation_x( a ); // holds the rotation
+ * The other operands (structured matrices, nested products) are small and are
+ * always stored by value.
+ *
+ * Example:
+ *   Perspective44f const proj = make_perspective44f( fov, aspect, 0.1f, 100.f );
+ *   Mat44f const projView = proj * world2camera;   // 16 instead of 64 mults
+ *   Mat44f const mvp = projView * Translation44f{ pos }; // 12 mults
+ *   Vec4f const clip = lazy( proj ) * world2camera * model2world * p;
+ */
+
+struct Identity44f
+{};
+
+struct Translation44f
+{
+	Vec3f t;
+};
+
+struct Scaling44f
+{
+	Vec3f s;
+};
+
+// Only the non-zero elements of make_perspective_projection():
+//   ⎛ sx  0  0  0 ⎞
+//   ⎜  0 sy  0  0 ⎟
+//   ⎜  0  0  a  b ⎟
+//   ⎝  0  0 -1  0 ⎠
+struct Perspective44f
+{
+	float sx, sy;
+	float a, b;
+};
+
+template< typename tLeft, typename tRight >
+struct Mat44Product;
+
+
+// Traits:
+
+template< typename tType >
+struct is_structured44 : std::false_type {};
+
+template<> struct is_structured44<Identity44f> : std::true_type {};
+template<> struct is_structured44<Translation44f> : std::true_type {};
+template<> struct is_structured44<Scaling44f> : std::true_type {};
+template<> struct is_structured44<Perspective44f> : std::true_type {};
+
+// Matrices, i.e., Mat44f and the structured types
+template< typename tType >
+struct is_mat44_matrix : is_structured44<tType> {};
+
+template<> struct is_mat44_matrix<Mat44f> : std::true_type {};
+
+// Anything that can appear in a product: matrices and Mat44Products
+template< typename tType >
+struct is_mat44_operand : is_mat44_matrix<tType> {};
+
+template< typename tLeft, typename tRight >
+struct is_mat44_operand<Mat44Product<tLeft,tRight>> : std::true_type {};
+
+template< typename tType >
+constexpr bool is_structured44_v = is_structured44<tType>::value;
+template< typename tType >
+constexpr bool is_mat44_matrix_v = is_mat44_matrix<tType>::value;
+template< typename tType >
+constexpr bool is_mat44_operand_v = is_mat44_operand<tType>::value;
+
+// How a Mat44Product stores an operand passed as tType&&: Mat44f lvalues by
+// reference, everything else by value.
+template< typename tType >
+using mat44_operand_storage_t = std::conditional_t<
+	std::is_lvalue_reference_v<tType> && std::is_same_v<std::decay_t<tType>,Mat44f>,
+	Mat44f const&,
+	std::decay_t<tType>
+>;
+
+
+// Functions:
+
+// Same parameters and result as make_perspective_projection().
+inline
+Perspective44f make_perspective44f( float aFovInRadians, float aAspect, float aNear, float aFar ) noexcept
+{
+	float s = 1/(std::tan(aFovInRadians / 2.0f));
+	float a = -((aFar+aNear)/(aFar-aNear));
+	float b = -2*((aFar*aNear)/(aFar-aNear));
+	return Perspective44f{ s/aAspect, s, a, b };
+}
+
+constexpr
+Mat44f to_mat44( Mat44f const& aM ) noexcept
+{
+	return aM;
+}
+constexpr
+Mat44f to_mat44( Identity44f ) noexcept
+{
+	return kIdentity44f;
+}
+constexpr
+Mat44f to_mat44( Translation44f const& aT ) noexcept
+{
+	return Mat44f{ {
+		1.f, 0.f, 0.f, aT.t.x,
+		0.f, 1.f, 0.f, aT.t.y,
+		0.f, 0.f, 1.f, aT.t.z,
+		0.f, 0.f, 0.f, 1.f
+	} };
+}
+constexpr
+Mat44f to_mat44( Scaling44f const& aS ) noexcept
+{
+	return Mat44f{ {
+		aS.s.x, 0.f, 0.f, 0.f,
+		0.f, aS.s.y, 0.f, 0.f,
+		0.f, 0.f, aS.s.z, 0.f,
+		0.f, 0.f, 0.f, 1.f
+	} };
+}
+constexpr
+Mat44f to_mat44( Perspective44f const& aP ) noexcept
+{
+	return Mat44f{ {
+		aP.sx, 0.f, 0.f, 0.f,
+		0.f, aP.sy, 0.f, 0.f,
+		0.f, 0.f, aP.a, aP.b,
+		0.f, 0.f, -1.f, 0.f
+	} };
+}
+
+
+// Structured products. Each only computes the elements that differ from the
+// other operand.
+
+template< typename tType, typename = std::enable_if_t<is_mat44_matrix_v<tType>> > constexpr
+tType operator*( Identity44f, tType const& aM ) noexcept
+{
+	return aM;
+}
+template< typename tType, typename = std::enable_if_t<is_mat44_matrix_v<tType> && !std::is_same_v<tType,Identity44f>> > constexpr
+tType operator*( tType const& aM, Identity44f ) noexcept
+{
+	return aM;
+}
+
+constexpr
+Translation44f operator*( Translation44f const& aLeft, Translation44f const& aRight ) noexcept
+{
+	return Translation44f{ aLeft.t + aRight.t };
+}
+constexpr
+Scaling44f operator*( Scaling44f const& aLeft, Scaling44f const& aRight ) noexcept
+{
+	return Scaling44f{ { aLeft.s.x * aRight.s.x, aLeft.s.y * aRight.s.y, aLeft.s.z * aRight.s.z } };
+}
+
+// Translation: adds a multiple of the last row to the first three rows.
+constexpr
+Mat44f operator*( Translation44f const& aLeft, Mat44f const& aRight ) noexcept
+{
+	Mat44f ret = aRight;
+	for( std::size_t j = 0; j < 4; ++j )
+	{
+		ret(0,j) = aRight(0,j) + aLeft.t.x * aRight(3,j);
+		ret(1,j) = aRight(1,j) + aLeft.t.y * aRight(3,j);
+		ret(2,j) = aRight(2,j) + aLeft.t.z * aRight(3,j);
+	}
+	return ret;
+}
+// ... and only changes the last column when on the right.
+constexpr
+Mat44f operator*( Mat44f const& aLeft, Translation44f const& aRight ) noexcept
+{
+	Mat44f ret = aLeft;
+	for( std::size_t i = 0; i < 4; ++i )
+	{
+		ret(i,3) = aLeft(i,0) * aRight.t.x
+			+ aLeft(i,1) * aRight.t.y
+			+ aLeft(i,2) * aRight.t.z
+			+ aLeft(i,3);
+	}
+	return ret;
+}
+
+// Scaling: scales the first three rows (left) or columns (right).
+constexpr
+Mat44f operator*( Scaling44f const& aLeft, Mat44f const& aRight ) noexcept
+{
+	Mat44f ret = aRight;
+	for( std::size_t j = 0; j < 4; ++j )
+	{
+		ret(0,j) = aLeft.s.x * aRight(0,j);
+		ret(1,j) = aLeft.s.y * aRight(1,j);
+		ret(2,j) = aLeft.s.z * aRight(2,j);
+	}
+	return ret;
+}
+constexpr
+Mat44f operator*( Mat44f const& aLeft, Scaling44f const& aRight ) noexcept
+{
+	Mat44f ret = aLeft;
+	for( std::size_t i = 0; i < 4; ++i )
+	{
+		ret(i,0) = aLeft(i,0) * aRight.s.x;
+		ret(i,1) = aLeft(i,1) * aRight.s.y;
+		ret(i,2) = aLeft(i,2) * aRight.s.z;
+	}
+	return ret;
+}
+
+// Perspective: 16 multiplies instead of 64.
+constexpr
+Mat44f operator*( Perspective44f const& aLeft, Mat44f const& aRight ) noexcept
+{
+	Mat44f ret{};
+	for( std::size_t j = 0; j < 4; ++j )
+	{
+		ret(0,j) = aLeft.sx * aRight(0,j);
+		ret(1,j) = aLeft.sy * aRight(1,j);
+		ret(2,j) = aLeft.a * aRight(2,j) + aLeft.b * aRight(3,j);
+		ret(3,j) = -aRight(2,j);
+	}
+	return ret;
+}
+constexpr
+Mat44f operator*( Mat44f const& aLeft, Perspective44f const& aRight ) noexcept
+{
+	Mat44f ret{};
+	for( std::size_t i = 0; i < 4; ++i )
+	{
+		ret(i,0) = aLeft(i,0) * aRight.sx;
+		ret(i,1) = aLeft(i,1) * aRight.sy;
+		ret(i,2) = aLeft(i,2) * aRight.a - aLeft(i,3);
+		ret(i,3) = aLeft(i,2) * aRight.b;
+	}
+	return ret;
+}
+
+// Remaining combinations of two structured matrices (e.g., a translation
+// times a scaling): expand the left one.
+template<
+	typename tLeft, typename tRight,
+	typename = std::enable_if_t<
+		is_structured44_v<tLeft> && is_structured44_v<tRight>
+		&& !std::is_same_v<tLeft,Identity44f> && !std::is_same_v<tRight,Identity44f>
+		&& !std::is_same_v<tLeft,tRight>
+	>
+> constexpr
+Mat44f operator*( tLeft const& aLeft, tRight const& aRight ) noexcept
+{
+	return to_mat44( aLeft ) * aRight;
+}
+
+
+// Structured matrix-vector products.
+
+constexpr
+Vec4f operator*( Identity44f, Vec4f const& aV ) noexcept
+{
+	return aV;
+}
+constexpr
+Vec4f operator*( Translation44f const& aT, Vec4f const& aV ) noexcept
+{
+	return Vec4f{ aV.x + aT.t.x * aV.w, aV.y + aT.t.y * aV.w, aV.z + aT.t.z * aV.w, aV.w };
+}
+constexpr
+Vec4f operator*( Scaling44f const& aS, Vec4f const& aV ) noexcept
+{
+	return Vec4f{ aS.s.x * aV.x, aS.s.y * aV.y, aS.s.z * aV.z, aV.w };
+}
+constexpr
+Vec4f operator*( Perspective44f const& aP, Vec4f const& aV ) noexcept
+{
+	return Vec4f{ aP.sx * aV.x, aP.sy * aV.y, aP.a * aV.z + aP.b * aV.w, -aV.z };
+}
+
+
+// Lazy products:
+
+/** Mat44Product: unevaluated product tLeft * tRight
+ *
+ * Created by lazy() and by multiplying a Mat44Product with further operands.
+ * The operand types are those of mat44_operand_storage_t, i.e., either
+ * Mat44f const& or a value type. See the comment at the top of this file.
+ */
+template< typename tLeft, typename tRight >
+struct Mat44Product
+{
+	tLeft left;
+	tRight right;
+
+	// Evaluate to a full matrix.
+	operator Mat44f() const noexcept;
+};
+
+// Start a lazy product expression.
+template< typename tType, typename = std::enable_if_t<is_mat44_operand_v<std::decay_t<tType>>> > constexpr
+Mat44Product<Identity44f, mat44_operand_storage_t<tType>> lazy( tType&& aM ) noexcept
+{
+	return { Identity44f{}, std::forward<tType>(aM) };
+}
+
+template<
+	typename tLeft, typename tRight, typename tOther,
+	typename = std::enable_if_t<is_mat44_operand_v<std::decay_t<tOther>>>
+> constexpr
+Mat44Product<Mat44Product<tLeft,tRight>, mat44_operand_storage_t<tOther>> operator*( Mat44Product<tLeft,tRight> const& aLeft, tOther&& aRight ) noexcept
+{
+	return { aLeft, std::forward<tOther>(aRight) };
+}
+template<
+	typename tOther, typename tLeft, typename tRight,
+	typename = std::enable_if_t<is_mat44_operand_v<std::decay_t<tOther>> && !std::is_same_v<std::decay_t<tOther>,Identity44f>>
+> constexpr
+Mat44Product<mat44_operand_storage_t<tOther>, Mat44Product<tLeft,tRight>> operator*( tOther&& aLeft, Mat44Product<tLeft,tRight> const& aRight ) noexcept
+{
+	return { std::forward<tOther>(aLeft), aRight };
+}
+
+// Evaluate a product left to right. The result is the most specific type
+// possible, e.g., lazy( Translation44f{a} ) * Translation44f{b} evaluates to
+// a Translation44f.
+template< typename tType, typename = std::enable_if_t<is_mat44_matrix_v<tType>> > constexpr
+tType const& eval( tType const& aM ) noexcept
+{
+	return aM;
+}
+template< typename tLeft, typename tRight > constexpr
+auto eval( Mat44Product<tLeft,tRight> const& aP ) noexcept
+{
+	return eval( aP.left ) * eval( aP.right );
+}
+
+template< typename tLeft, typename tRight > inline
+Mat44Product<tLeft,tRight>::operator Mat44f() const noexcept
+{
+	// Return the Mat44f directly if possible. Going through to_mat44() adds a
+	// copy, which GCC turns into scalar stores followed by a wide load (i.e.,
+	// a store-forwarding stall).
+	if constexpr( std::is_same_v<decltype(eval( *this )), Mat44f> )
+		return eval( *this );
+	else
+		return to_mat44( eval( *this ) );
+}
+
+// Apply the product to a vector, right to left: (A * B) * v = A * (B * v).
+template< typename tLeft, typename tRight > inline
+Vec4f operator*( Mat44Product<tLeft,tRight> const& aP, Vec4f const& aV ) noexcept
+{
+	return aP.left * (aP.right * aV);
+}
+
+#endif // MAT44_EXPR_HPP_0CDF83BA_FF1E_47A2_98C4_72DF008B9734
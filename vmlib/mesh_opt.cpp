@@ -0,0 +1,291 @@
+#include "mesh_opt.hpp"
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include <cassert>
+
+namespace
+{
+	// FIFO cache simulation with timestamps: a vertex is in the cache if
+	// fewer than aCacheSize misses happened since it was last loaded.
+	// Returns the number of misses for the triangle.
+	inline
+	unsigned update_cache_( std::uint32_t const* aTri, std::size_t aCacheSize, std::uint32_t* aTimes, std::uint32_t& aNow ) noexcept
+	{
+		unsigned misses = 0;
+		for( std::size_t i = 0; i < 3; ++i )
+		{
+			std::uint32_t const v = aTri[i];
+			if( aNow - aTimes[v] > aCacheSize )
+			{
+				aTimes[v] = aNow++;
+				++misses;
+			}
+		}
+		return misses;
+	}
+
+	// Vertex -> triangle adjacency in compressed form: the triangles of
+	// vertex v are mTriangles[mOffsets[v] ... mOffsets[v+1]).
+	struct Adjacency_
+	{
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> triangles;
+	};
+
+	Adjacency_ build_adjacency_( std::uint32_t const* aIndices, std::size_t aIndexCount, std::size_t aVertexCount )
+	{
+		Adjacency_ ret;
+		ret.offsets.assign( aVertexCount + 1, 0 );
+		for( std::size_t i = 0; i < aIndexCount; ++i )
+			++ret.offsets[aIndices[i] + 1];
+
+		std::partial_sum( ret.offsets.begin(), ret.offsets.end(), ret.offsets.begin() );
+
+		std::vector<std::uint32_t> fill( ret.offsets.begin(), ret.offsets.end() - 1 );
+		ret.triangles.resize( aIndexCount );
+		for( std::size_t i = 0; i < aIndexCount; ++i )
+			ret.triangles[fill[aIndices[i]]++] = std::uint32_t(i / 3);
+
+		return ret;
+	}
+}
+
+VertexCacheStats analyze_vertex_cache( std::uint32_t const* aIndices, std::size_t aIndexCount, std::size_t aVertexCount, std::size_t aCacheSize )
+{
+	assert( aIndexCount % 3 == 0 );
+	if( 0 == aIndexCount )
+		return VertexCacheStats{ 0.f, 0.f };
+
+	std::vector<std::uint32_t> times( aVertexCount, 0 );
+	std::uint32_t now = std::uint32_t(aCacheSize + 1);
+
+	std::size_t misses = 0;
+	for( std::size_t i = 0; i < aIndexCount; i += 3 )
+		misses += update_cache_( aIndices + i, aCacheSize, times.data(), now );
+
+	return VertexCacheStats{
+		float(misses) / float(aIndexCount / 3),
+		aVertexCount ? float(misses) / float(aVertexCount) : 0.f
+	};
+}
+
+void optimize_vertex_cache( std::uint32_t* aIndices, std::size_t aIndexCount, std::size_t aVertexCount, std::size_t aCacheSize )
+{
+	assert( aIndexCount % 3 == 0 );
+	if( 0 == aIndexCount )
+		return;
+
+	std::size_t const triCount = aIndexCount / 3;
+	Adjacency_ const adj = build_adjacency_( aIndices, aIndexCount, aVertexCount );
+
+	// Number of not yet emitted triangles of each vertex
+	std::vector<std::uint32_t> live( aVertexCount );
+	for( std::size_t v = 0; v < aVertexCount; ++v )
+		live[v] = adj.offsets[v+1] - adj.offsets[v];
+
+	std::vector<std::uint32_t> times( aVertexCount, 0 );
+	std::vector<bool> emitted( triCount, false );
+	std::vector<std::uint32_t> deadEnd; // stack of recently used vertices
+	std::vector<std::uint32_t> candidates;
+
+	std::vector<std::uint32_t> out;
+	out.reserve( aIndexCount );
+
+	std::size_t const k = aCacheSize;
+	std::size_t now = k + 1;
+	std::size_t cursor = 0; // for the scan in the dead-end fallback
+
+	std::int64_t fan = 0;
+	while( fan >= 0 )
+	{
+		// Emit all remaining triangles around the fanning vertex
+		candidates.clear();
+		for( std::uint32_t j = adj.offsets[fan]; j < adj.offsets[fan+1]; ++j )
+		{
+			std::uint32_t const t = adj.triangles[j];
+			if( emitted[t] )
+				continue;
+
+			for( std::size_t i = 0; i < 3; ++i )
+			{
+				std::uint32_t const v = aIndices[t*3+i];
+				out.emplace_back( v );
+				deadEnd.emplace_back( v );
+				candidates.emplace_back( v );
+				--live[v];
+
+				if( now - times[v] > k )
+					times[v] = std::uint32_t(now++);
+			}
+
+			emitted[t] = true;
+		}
+
+		// Next fanning vertex: the candidate that has been in the cache the
+		// longest and will still be in it after emitting its triangles.
+		fan = -1;
+		std::int64_t best = -1;
+		for( auto const v : candidates )
+		{
+			if( 0 == live[v] )
+				continue;
+
+			std::int64_t priority = 0;
+			if( now - times[v] + 2*live[v] <= k )
+				priority = std::int64_t(now - times[v]);
+
+			if( priority > best )
+			{
+				best = priority;
+				fan = v;
+			}
+		}
+
+		// Dead end: go back to a recently used vertex, or else to the next
+		// vertex with remaining triangles.
+		while( fan < 0 && !deadEnd.empty() )
+		{
+			std::uint32_t const v = deadEnd.back();
+			deadEnd.pop_back();
+			if( live[v] > 0 )
+				fan = v;
+		}
+		for( ; fan < 0 && cursor < aVertexCount; ++cursor )
+		{
+			if( live[cursor] > 0 )
+				fan = std::int64_t(cursor);
+		}
+	}
+
+	assert( out.size() == aIndexCount );
+	std::copy( out.begin(), out.end(), aIndices );
+}
+
+void optimize_overdraw( std::uint32_t* aIndices, std::size_t aIndexCount, Vec3f const* aPositions, std::size_t aVertexCount, float aThreshold, std::size_t aCacheSize )
+{
+	assert( aIndexCount % 3 == 0 );
+	std::size_t const triCount = aIndexCount / 3;
+	if( triCount < 2 )
+		return;
+
+	std::vector<std::uint32_t> times( aVertexCount, 0 );
+	std::uint32_t now = std::uint32_t(aCacheSize + 1);
+	auto const flush = [&] { now += std::uint32_t(aCacheSize + 1); };
+
+	// Hard boundaries: triangles that miss all three vertices usually start
+	// a new, disjoint patch (e.g., a new Tipsify fan sequence).
+	std::vector<std::uint32_t> hard;
+	for( std::size_t t = 0; t < triCount; ++t )
+	{
+		if( 3 == update_cache_( aIndices + t*3, aCacheSize, times.data(), now ) || 0 == t )
+			hard.emplace_back( std::uint32_t(t) );
+	}
+	hard.emplace_back( std::uint32_t(triCount) );
+
+	// Soft boundaries: split each hard cluster where the ACMR from the start
+	// of the current piece is within aThreshold of the cluster's ACMR. The
+	// cache is flushed at each split, so this bounds the cost of reordering.
+	std::vector<std::uint32_t> clusters;
+	for( std::size_t h = 0; h + 1 < hard.size(); ++h )
+	{
+		std::uint32_t const start = hard[h], end = hard[h+1];
+
+		flush();
+		std::size_t misses = 0;
+		for( std::uint32_t t = start; t < end; ++t )
+			misses += update_cache_( aIndices + t*3, aCacheSize, times.data(), now );
+
+		float const limit = aThreshold * float(misses) / float(end - start);
+
+		clusters.emplace_back( start );
+		flush();
+
+		std::size_t runMisses = 0, runTris = 0;
+		for( std::uint32_t t = start; t < end; ++t )
+		{
+			runMisses += update_cache_( aIndices + t*3, aCacheSize, times.data(), now );
+			++runTris;
+
+			if( float(runMisses) <= limit * float(runTris) && t + 1 < end )
+			{
+				clusters.emplace_back( t + 1 );
+				flush();
+				runMisses = runTris = 0;
+			}
+		}
+
+		// The last piece may have a high ACMR; merge it with the previous one
+		// in that case.
+		if( runTris > 0 && float(runMisses) > limit * float(runTris) && clusters.back() != start )
+			clusters.pop_back();
+	}
+	clusters.emplace_back( std::uint32_t(triCount) );
+
+	// Sort key of each cluster: how much it faces away from the mesh center.
+	// Clusters on the outside are drawn first and occlude the rest.
+	Vec3f meshCenter{ 0.f, 0.f, 0.f };
+	for( std::size_t i = 0; i < aIndexCount; ++i )
+		meshCenter += aPositions[aIndices[i]];
+	meshCenter /= float(aIndexCount);
+
+	std::size_t const clusterCount = clusters.size() - 1;
+	std::vector<float> keys( clusterCount );
+	for( std::size_t c = 0; c < clusterCount; ++c )
+	{
+		Vec3f center{ 0.f, 0.f, 0.f }, normal{ 0.f, 0.f, 0.f };
+		float area = 0.f;
+
+		for( std::uint32_t t = clusters[c]; t < clusters[c+1]; ++t )
+		{
+			Vec3f const a = aPositions[aIndices[t*3+0]];
+			Vec3f const b = aPositions[aIndices[t*3+1]];
+			Vec3f const d = aPositions[aIndices[t*3+2]];
+
+			Vec3f const n = cross( b - a, d - a ); // length = 2 * area
+			float const ta = length( n );
+
+			center += (a + b + d) * (ta / 3.f);
+			normal += n;
+			area += ta;
+		}
+
+		float const nl = length( normal );
+		if( area > 0.f && nl > 0.f )
+			keys[c] = dot( center / area - meshCenter, normal / nl );
+		else
+			keys[c] = 0.f;
+	}
+
+	std::vector<std::uint32_t> order( clusterCount );
+	std::iota( order.begin(), order.end(), 0u );
+	std::stable_sort( order.begin(), order.end(), [&keys] (std::uint32_t aA, std::uint32_t aB) {
+		return keys[aA] > keys[aB];
+	} );
+
+	std::vector<std::uint32_t> out;
+	out.reserve( aIndexCount );
+	for( auto const c : order )
+		out.insert( out.end(), aIndices + clusters[c]*3, aIndices + clusters[c+1]*3 );
+
+	std::copy( out.begin(), out.end(), aIndices );
+}
+
+std::size_t optimize_vertex_fetch_remap( std::uint32_t* aIndices, std::size_t aIndexCount, std::size_t aVertexCount, std::uint32_t* aRemap )
+{
+	std::fill_n( aRemap, aVertexCount, kUnusedVertex );
+
+	std::uint32_t next = 0;
+	for( std::size_t i = 0; i < aIndexCount; ++i )
+	{
+		std::uint32_t& r = aRemap[aIndices[i]];
+		if( kUnusedVertex == r )
+			r = next++;
+
+		aIndices[i] = r;
+	}
+
+	return next;
+}
@@ -0,0 +1,81 @@
+#ifndef MESH_OPT_HPP_F08D8306_EA00_472C_8962_0817B4FF8A09
+#define MESH_OPT_HPP_F08D8306_EA00_472C_8962_0817B4FF8A09
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vec3.hpp"
+
+/* Index buffer optimization
+ *
+ * Reorders the triangles of an indexed triangle mesh for the GPU's
+ * post-transform vertex cache and for less overdraw, and reorders the
+ * vertices for locality of the vertex fetch. The usual order is:
+ *
+ *   optimize_vertex_cache( indices, ic, vc );
+ *   optimize_overdraw( indices, ic, positions, vc );
+ *   optimize_vertex_fetch_remap( indices, ic, vc, remap );
+ *   // ... then move each vertex attribute v to remap[v]
+ *
+ * Only the order of the triangles changes; each triangle keeps its vertices
+ * in the same order (and thus its winding).
+ *
+ * The vertex cache is modelled as a FIFO with aCacheSize entries. The
+ * quality of an order is measured as
+ *   ACMR: average cache miss ratio, vertex shader invocations per triangle
+ *         (0.5 is ideal for large regular grids, 3 is the worst case)
+ *   ATVR: average transformed vertex ratio, vertex shader invocations per
+ *         vertex (1 is ideal).
+ *
+ * optimize_vertex_cache() implements Tipsify (Sander et al., "Fast Triangle
+ * Reordering for Vertex Locality and Reduced Overdraw", SIGGRAPH 2007), which
+ * runs in linear time. optimize_overdraw() splits the result into clusters
+ * that are cheap to reorder (at most aThreshold times the ACMR) and sorts
+ * them such that clusters facing away from the mesh center come first.
+ */
+constexpr std::size_t kVertexCacheSize = 16;
+
+struct VertexCacheStats
+{
+	float acmr;
+	float atvr;
+};
+
+// Simulate a FIFO vertex cache of aCacheSize entries. aVertexCount is the
+// number of vertices in the vertex buffer (used for the ATVR).
+VertexCacheStats analyze_vertex_cache(
+	std::uint32_t const* aIndices, std::size_t aIndexCount,
+	std::size_t aVertexCount,
+	std::size_t aCacheSize = kVertexCacheSize
+);
+
+// Reorder the triangles in place for vertex cache locality.
+void optimize_vertex_cache(
+	std::uint32_t* aIndices, std::size_t aIndexCount,
+	std::size_t aVertexCount,
+	std::size_t aCacheSize = kVertexCacheSize
+);
+
+// Reorder the triangles in place to reduce overdraw. Expects the output of
+// optimize_vertex_cache(); the ACMR grows by at most a factor of about
+// aThreshold.
+void optimize_overdraw(
+	std::uint32_t* aIndices, std::size_t aIndexCount,
+	Vec3f const* aPositions, std::size_t aVertexCount,
+	float aThreshold = 1.05f,
+	std::size_t aCacheSize = kVertexCacheSize
+);
+
+// Renumber the vertices in the order in which they are first used and
+// rewrite aIndices accordingly. aRemap receives aVertexCount entries:
+// the new index of each old vertex, or kUnusedVertex for vertices that are
+// not referenced. Returns the number of referenced vertices.
+constexpr std::uint32_t kUnusedVertex = ~std::uint32_t(0);
+
+std::size_t optimize_vertex_fetch_remap(
+	std::uint32_t* aIndices, std::size_t aIndexCount,
+	std::size_t aVertexCount,
+	std::uint32_t* aRemap
+);
+
+#endif // MESH_OPT_HPP_F08D8306_EA00_472C_8962_0817B4FF8A09
@@ -0,0 +1,571 @@
+#include "mesh_simplify.hpp"
+
+#include <array>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+	// Border and seam quadrics, relative to the face quadrics: a unit step
+	// off a border costs as much as kFeatureWeight_ times a unit step off a
+	// face of the same size.
+	constexpr double kFeatureWeight_ = 10.0;
+
+	constexpr std::uint32_t kNone_ = ~std::uint32_t(0);
+
+	// Feature types of an edge. A vertex whose two feature edges differ in
+	// type gets kMixedFeature_.
+	constexpr std::uint8_t kBorder_ = 1, kSeam_ = 2, kMixedFeature_ = 3;
+
+	// A collapse is rejected if it turns a triangle by more than about 75
+	// degrees (cos = 0.25); this also rejects flips.
+	constexpr float kMaxFlipCos_ = 0.25f;
+
+	// Symmetric 4x4 matrix Q = sum_i w_i (n_i, d_i)(n_i, d_i)^T of the planes
+	// n_i . x + d_i = 0, as its upper triangle, and the total weight.
+	struct Quadric_
+	{
+		double xx, xy, xz, xd;
+		double yy, yz, yd;
+		double zz, zd;
+		double dd;
+		double w;
+	};
+
+	Quadric_ plane_quadric_( Vec3f aN, float aD, double aWeight ) noexcept
+	{
+		double const x = aN.x, y = aN.y, z = aN.z, d = aD;
+		return Quadric_{
+			aWeight*x*x, aWeight*x*y, aWeight*x*z, aWeight*x*d,
+			aWeight*y*y, aWeight*y*z, aWeight*y*d,
+			aWeight*z*z, aWeight*z*d,
+			aWeight*d*d,
+			aWeight
+		};
+	}
+
+	Quadric_& operator+=( Quadric_& aQ, Quadric_ const& aR ) noexcept
+	{
+		aQ.xx += aR.xx; aQ.xy += aR.xy; aQ.xz += aR.xz; aQ.xd += aR.xd;
+		aQ.yy += aR.yy; aQ.yz += aR.yz; aQ.yd += aR.yd;
+		aQ.zz += aR.zz; aQ.zd += aR.zd;
+		aQ.dd += aR.dd;
+		aQ.w += aR.w;
+		return aQ;
+	}
+
+	// Weighted mean squared distance of aP to the planes of the quadric
+	float error2_( Quadric_ const& aQ, Vec3f aP ) noexcept
+	{
+		if( aQ.w <= 0.0 )
+			return 0.f;
+
+		double const x = aP.x, y = aP.y, z = aP.z;
+		double const e = aQ.xx*x*x + aQ.yy*y*y + aQ.zz*z*z
+			+ 2.0 * (aQ.xy*x*y + aQ.xz*x*z + aQ.yz*y*z)
+			+ 2.0 * (aQ.xd*x + aQ.yd*y + aQ.zd*z)
+			+ aQ.dd;
+
+		return float(std::max( e, 0.0 ) / aQ.w);
+	}
+
+	float attribute_error2_( SimplifyAttributes const& aAttribs, std::uint32_t aA, std::uint32_t aB ) noexcept
+	{
+		float ret = 0.f;
+		for( std::size_t i = 0; i < aAttribs.count; ++i )
+		{
+			float const d = aAttribs.weights[i] * (aAttribs.data[aA*aAttribs.stride+i] - aAttribs.data[aB*aAttribs.stride+i]);
+			ret += d*d;
+		}
+		return ret;
+	}
+
+	// For each vertex, the first vertex with the same position. -0 and +0
+	// count as the same.
+	std::vector<std::uint32_t> weld_positions_( Vec3f const* aPositions, std::size_t aVertexCount )
+	{
+		using Key_ = std::array<std::uint32_t,3>;
+		auto const key = [aPositions] (std::uint32_t aV) {
+			Vec3f const p{ aPositions[aV].x + 0.f, aPositions[aV].y + 0.f, aPositions[aV].z + 0.f };
+			Key_ ret;
+			std::memcpy( ret.data(), &p, sizeof(Key_) );
+			return ret;
+		};
+
+		std::vector<std::uint32_t> order( aVertexCount );
+		std::iota( order.begin(), order.end(), 0u );
+		std::sort( order.begin(), order.end(), [&key] (std::uint32_t aA, std::uint32_t aB) {
+			Key_ const a = key( aA ), b = key( aB );
+			return a != b ? a < b : aA < aB;
+		} );
+
+		std::vector<std::uint32_t> ret( aVertexCount );
+		for( std::size_t i = 0; i < aVertexCount; ++i )
+		{
+			std::uint32_t const v = order[i];
+			ret[v] = (i > 0 && key( order[i-1] ) == key( v )) ? ret[order[i-1]] : v;
+		}
+		return ret;
+	}
+
+	enum class VertexKind_ : std::uint8_t
+	{
+		manifold, // interior vertex; collapses in any direction
+		feature,  // on a border or seam line; collapses along it only
+		locked    // never removed
+	};
+
+	struct Candidate_
+	{
+		float cost;
+		std::uint32_t from, to; // positions
+		std::uint32_t fromWedge, toWedge;
+	};
+
+	class Simplifier_
+	{
+		public:
+			Simplifier_( std::uint32_t const*, std::size_t, Vec3f const*, std::size_t, SimplifyAttributes const& );
+
+		public:
+			// One round of non-overlapping collapses. Returns false if no
+			// collapse was possible.
+			bool pass( std::size_t aTargetTriangles, float aLimit2 );
+
+			std::vector<std::uint32_t> const& indices() const noexcept { return mIndices; }
+			float error2() const noexcept { return mError2; }
+
+		private:
+			void classify_();
+			void add_feature_edge_( std::uint32_t, std::uint32_t, Vec3f aFaceNormal, std::uint8_t aType );
+
+			std::uint32_t resolve_( std::uint32_t ) noexcept;
+
+			void add_candidate_( std::uint32_t aFromWedge, std::uint32_t aToWedge, float aLimit2 );
+			bool collapse_( Candidate_ const&, float aLimit2, std::size_t& aRemovedTriangles );
+
+		private:
+			Vec3f const* mPositions;
+			SimplifyAttributes mAttribs;
+
+			std::vector<std::uint32_t> mIndices;
+			std::vector<std::uint32_t> mPos; // vertex -> position (first vertex with that position)
+
+			// Per position:
+			std::vector<Quadric_> mQuadrics;
+			std::vector<float> mAttribError2; // accumulated attribute error
+			std::vector<VertexKind_> mKinds;
+			std::vector<std::array<std::uint32_t,2>> mNeighbours; // along the feature line
+			std::vector<std::uint8_t> mFeatureTypes; // kBorder_, kSeam_, ...
+			std::vector<std::uint32_t> mCollapsed; // target of removed positions
+
+			// Per pass:
+			std::vector<std::uint32_t> mAdjOffsets, mAdjTriangles; // position -> triangles
+			std::vector<std::uint32_t> mWedgeRemap;
+			std::vector<std::uint8_t> mTouched;
+			std::vector<Candidate_> mCandidates;
+			std::vector<std::array<std::uint32_t,2>> mMapping;
+
+			float mError2 = 0.f;
+	};
+
+	Simplifier_::Simplifier_( std::uint32_t const* aIndices, std::size_t aIndexCount, Vec3f const* aPositions, std::size_t aVertexCount, SimplifyAttributes const& aAttribs )
+		: mPositions( aPositions )
+		, mAttribs( aAttribs )
+		, mPos( weld_positions_( aPositions, aVertexCount ) )
+		, mQuadrics( aVertexCount, Quadric_{} )
+		, mAttribError2( aVertexCount, 0.f )
+		, mKinds( aVertexCount, VertexKind_::manifold )
+		, mNeighbours( aVertexCount, { 0, 0 } )
+		, mFeatureTypes( aVertexCount, 0 )
+		, mCollapsed( aVertexCount )
+		, mWedgeRemap( aVertexCount )
+		, mTouched( aVertexCount )
+	{
+		std::iota( mCollapsed.begin(), mCollapsed.end(), 0u );
+
+		// Triangles that are degenerate in position are invisible; drop them.
+		mIndices.reserve( aIndexCount );
+		for( std::size_t i = 0; i < aIndexCount; i += 3 )
+		{
+			std::uint32_t const a = aIndices[i], b = aIndices[i+1], c = aIndices[i+2];
+			if( mPos[a] == mPos[b] || mPos[b] == mPos[c] || mPos[c] == mPos[a] )
+				continue;
+
+			mIndices.insert( mIndices.end(), { a, b, c } );
+		}
+
+		// Face quadrics, weighted by area
+		for( std::size_t i = 0; i < mIndices.size(); i += 3 )
+		{
+			Vec3f const a = mPositions[mIndices[i]];
+			Vec3f const n = cross( mPositions[mIndices[i+1]] - a, mPositions[mIndices[i+2]] - a );
+			float const len = length( n );
+			if( len <= 0.f )
+				continue;
+
+			Quadric_ const q = plane_quadric_( n / len, -dot( n / len, a ), 0.5 * len );
+			for( std::size_t k = 0; k < 3; ++k )
+				mQuadrics[mPos[mIndices[i+k]]] += q;
+		}
+
+		classify_();
+	}
+
+	void Simplifier_::classify_()
+	{
+		// All edges, sorted by their (unordered) pair of positions
+		struct Edge_
+		{
+			std::uint64_t key;
+			std::uint32_t from, to; // wedges, in the triangle's order
+			std::uint32_t triangle;
+		};
+
+		std::vector<Edge_> edges;
+		edges.reserve( mIndices.size() );
+		for( std::size_t i = 0; i < mIndices.size(); ++i )
+		{
+			std::uint32_t const a = mIndices[i];
+			std::uint32_t const b = mIndices[i - i%3 + (i+1)%3];
+			std::uint64_t const pa = mPos[a], pb = mPos[b];
+			edges.emplace_back( Edge_{ std::min( pa, pb ) << 32 | std::max( pa, pb ), a, b, std::uint32_t(i/3) } );
+		}
+
+		std::sort( edges.begin(), edges.end(), [] (Edge_ const& aA, Edge_ const& aB) {
+			return aA.key != aB.key ? aA.key < aB.key : aA.triangle < aB.triangle;
+		} );
+
+		auto const normal = [this] (std::uint32_t aTri) {
+			Vec3f const a = mPositions[mIndices[aTri*3]];
+			return cross( mPositions[mIndices[aTri*3+1]] - a, mPositions[mIndices[aTri*3+2]] - a );
+		};
+
+		for( std::size_t i = 0; i < edges.size(); )
+		{
+			std::size_t j = i + 1;
+			while( j < edges.size() && edges[j].key == edges[i].key )
+				++j;
+
+			Edge_ const& e = edges[i];
+			std::uint32_t const pa = mPos[e.from], pb = mPos[e.to];
+
+			if( 1 == j - i )
+			{
+				add_feature_edge_( pa, pb, normal( e.triangle ), kBorder_ );
+			}
+			else if( 2 == j - i && mPos[edges[i+1].from] == pb )
+			{
+				// Manifold edge. If the two triangles use different wedges
+				// for either end, it is on a seam.
+				Edge_ const& f = edges[i+1];
+				if( e.from != f.to || e.to != f.from )
+					add_feature_edge_( pa, pb, normal( e.triangle ), kSeam_ );
+			}
+			else
+			{
+				// Non-manifold or inconsistently oriented
+				mKinds[pa] = mKinds[pb] = VertexKind_::locked;
+			}
+
+			i = j;
+		}
+
+		// Positions with exactly two feature edges of the same type lie on a
+		// feature line; others with feature edges are corners.
+		for( std::size_t p = 0; p < mKinds.size(); ++p )
+		{
+			if( VertexKind_::locked == mKinds[p] || 0 == mFeatureTypes[p] )
+				continue;
+
+			// See add_feature_edge_()
+			bool const line = kMixedFeature_ != mFeatureTypes[p] && kNone_ != mNeighbours[p][1];
+			mKinds[p] = line ? VertexKind_::feature : VertexKind_::locked;
+		}
+	}
+
+	void Simplifier_::add_feature_edge_( std::uint32_t aA, std::uint32_t aB, Vec3f aFaceNormal, std::uint8_t aType )
+	{
+		// Plane through the edge, perpendicular to the face
+		Vec3f const pa = mPositions[aA];
+		Vec3f const edge = mPositions[aB] - pa;
+		Vec3f const n = cross( edge, aFaceNormal );
+		float const len = length( n );
+		if( len > 0.f )
+		{
+			double const el2 = double(dot( edge, edge ));
+			Quadric_ const q = plane_quadric_( n / len, -dot( n / len, pa ), kFeatureWeight_ * el2 );
+			mQuadrics[aA] += q;
+			mQuadrics[aB] += q;
+		}
+
+		for( auto const p : { aA, aB } )
+		{
+			std::uint32_t const other = p == aA ? aB : aA;
+
+			// The first feature edge sets neighbour 0 and marks neighbour 1 as
+			// missing; the second sets neighbour 1; a third locks the vertex.
+			if( 0 == mFeatureTypes[p] )
+			{
+				mFeatureTypes[p] = aType;
+				mNeighbours[p] = { other, kNone_ };
+			}
+			else if( kNone_ == mNeighbours[p][1] )
+			{
+				mNeighbours[p][1] = other;
+				if( mFeatureTypes[p] != aType )
+					mFeatureTypes[p] = kMixedFeature_;
+			}
+			else
+			{
+				mKinds[p] = VertexKind_::locked;
+			}
+		}
+	}
+
+	std::uint32_t Simplifier_::resolve_( std::uint32_t aP ) noexcept
+	{
+		while( mCollapsed[aP] != aP )
+		{
+			mCollapsed[aP] = mCollapsed[mCollapsed[aP]];
+			aP = mCollapsed[aP];
+		}
+		return aP;
+	}
+
+	void Simplifier_::add_candidate_( std::uint32_t aFromWedge, std::uint32_t aToWedge, float aLimit2 )
+	{
+		std::uint32_t const from = mPos[aFromWedge], to = mPos[aToWedge];
+
+		if( VertexKind_::locked == mKinds[from] )
+			return;
+		if( VertexKind_::feature == mKinds[from] && to != resolve_( mNeighbours[from][0] ) && to != resolve_( mNeighbours[from][1] ) )
+			return;
+
+		Quadric_ q = mQuadrics[from];
+		q += mQuadrics[to];
+
+		float const cost = error2_( q, mPositions[to] ) + mAttribError2[from] + attribute_error2_( mAttribs, aFromWedge, aToWedge );
+		if( cost <= aLimit2 )
+			mCandidates.emplace_back( Candidate_{ cost, from, to, aFromWedge, aToWedge } );
+	}
+
+	bool Simplifier_::pass( std::size_t aTargetTriangles, float aLimit2 )
+	{
+		std::size_t const triCount = mIndices.size() / 3;
+		std::size_t const posCount = mPos.size();
+
+		// Position -> triangle adjacency
+		mAdjOffsets.assign( posCount + 1, 0 );
+		for( auto const v : mIndices )
+			++mAdjOffsets[mPos[v] + 1];
+
+		std::partial_sum( mAdjOffsets.begin(), mAdjOffsets.end(), mAdjOffsets.begin() );
+
+		std::vector<std::uint32_t> fill( mAdjOffsets.begin(), mAdjOffsets.end() - 1 );
+		mAdjTriangles.resize( mIndices.size() );
+		for( std::size_t i = 0; i < mIndices.size(); ++i )
+			mAdjTriangles[fill[mPos[mIndices[i]]]++] = std::uint32_t(i / 3);
+
+		// Candidates: both directions of each edge of each triangle. Interior
+		// edges thus appear twice per direction; the duplicate is skipped
+		// below since its vertices are then touched.
+		mCandidates.clear();
+		for( std::size_t i = 0; i < mIndices.size(); ++i )
+		{
+			std::uint32_t const a = mIndices[i];
+			std::uint32_t const b = mIndices[i - i%3 + (i+1)%3];
+			add_candidate_( a, b, aLimit2 );
+			add_candidate_( b, a, aLimit2 );
+		}
+
+		if( mCandidates.empty() )
+			return false;
+
+		std::sort( mCandidates.begin(), mCandidates.end(), [] (Candidate_ const& aA, Candidate_ const& aB) {
+			if( aA.cost != aB.cost ) return aA.cost < aB.cost;
+			if( aA.from != aB.from ) return aA.from < aB.from;
+			return aA.to < aB.to;
+		} );
+
+		// Each collapse removes about two triangles, and each edge appears
+		// about four times. Only go somewhat past the cost of the collapse
+		// that would reach the target, so that later passes can still pick
+		// cheaper collapses that were blocked in this one.
+		std::size_t const goal = triCount - aTargetTriangles;
+		float const passLimit = 1.5f * mCandidates[std::min( goal, mCandidates.size() - 1 )].cost;
+
+		std::iota( mWedgeRemap.begin(), mWedgeRemap.end(), 0u );
+		std::fill( mTouched.begin(), mTouched.end(), std::uint8_t(0) );
+
+		std::size_t removed = 0, collapses = 0;
+		for( auto const& c : mCandidates )
+		{
+			if( removed >= goal || c.cost > passLimit )
+				break;
+			if( mTouched[c.from] || mTouched[c.to] )
+				continue;
+
+			if( collapse_( c, aLimit2, removed ) )
+				++collapses;
+		}
+
+		if( 0 == collapses )
+			return false;
+
+		// Apply the wedge remap and drop the collapsed triangles
+		std::size_t out = 0;
+		for( std::size_t i = 0; i < mIndices.size(); i += 3 )
+		{
+			std::uint32_t const a = mWedgeRemap[mIndices[i]];
+			std::uint32_t const b = mWedgeRemap[mIndices[i+1]];
+			std::uint32_t const c = mWedgeRemap[mIndices[i+2]];
+			if( mPos[a] == mPos[b] || mPos[b] == mPos[c] || mPos[c] == mPos[a] )
+				continue;
+
+			mIndices[out++] = a;
+			mIndices[out++] = b;
+			mIndices[out++] = c;
+		}
+		mIndices.resize( out );
+
+		return true;
+	}
+
+	bool Simplifier_::collapse_( Candidate_ const& aC, float aLimit2, std::size_t& aRemovedTriangles )
+	{
+		std::uint32_t const p = aC.from, q = aC.to;
+		Vec3f const target = mPositions[q];
+
+		// Check the triangles around p in their current state. Triangles
+		// with both p and q disappear and tell which wedge of q each wedge
+		// of p becomes; the others must not flip.
+		mMapping.clear();
+		std::size_t removedTris = 0;
+		for( std::uint32_t j = mAdjOffsets[p]; j < mAdjOffsets[p+1]; ++j )
+		{
+			std::uint32_t const t = mAdjTriangles[j];
+			std::uint32_t w[3], pos[3];
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				w[k] = mWedgeRemap[mIndices[t*3+k]];
+				pos[k] = mPos[w[k]];
+			}
+
+			if( pos[0] == pos[1] || pos[1] == pos[2] || pos[2] == pos[0] )
+				continue;
+
+			std::size_t const kp = pos[0] == p ? 0 : pos[1] == p ? 1 : 2;
+			assert( pos[kp] == p );
+
+			std::size_t const k1 = (kp+1) % 3, k2 = (kp+2) % 3;
+			if( pos[k1] == q || pos[k2] == q )
+			{
+				std::uint32_t const qw = w[pos[k1] == q ? k1 : k2];
+				auto const it = std::find_if( mMapping.begin(), mMapping.end(), [&] (auto const& aM) { return aM[0] == w[kp]; } );
+				if( it == mMapping.end() )
+					mMapping.push_back( { w[kp], qw } );
+				else if( (*it)[1] != qw )
+					return false;
+
+				++removedTris;
+				continue;
+			}
+
+			Vec3f const a = mPositions[w[k1]], b = mPositions[w[k2]];
+			Vec3f const n0 = cross( a - mPositions[w[kp]], b - mPositions[w[kp]] );
+			Vec3f const n1 = cross( a - target, b - target );
+			if( dot( n0, n1 ) <= kMaxFlipCos_ * length( n0 ) * length( n1 ) )
+				return false;
+		}
+
+		// Every wedge of p that is still in use must have a counterpart
+		for( std::uint32_t j = mAdjOffsets[p]; j < mAdjOffsets[p+1]; ++j )
+		{
+			std::uint32_t const t = mAdjTriangles[j];
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				std::uint32_t const w = mWedgeRemap[mIndices[t*3+k]];
+				if( mPos[w] != p )
+					continue;
+
+				auto const it = std::find_if( mMapping.begin(), mMapping.end(), [&] (auto const& aM) { return aM[0] == w; } );
+				if( it == mMapping.end() )
+					return false;
+			}
+		}
+
+		if( mMapping.empty() )
+			return false;
+
+		// Exact attribute error with the final mapping
+		float attribError2 = 0.f;
+		for( auto const& m : mMapping )
+			attribError2 = std::max( attribError2, attribute_error2_( mAttribs, m[0], m[1] ) );
+
+		Quadric_ merged = mQuadrics[p];
+		merged += mQuadrics[q];
+
+		float const cost = error2_( merged, target ) + mAttribError2[p] + attribError2;
+		if( cost > aLimit2 )
+			return false;
+
+		// Apply
+		for( auto const& m : mMapping )
+			mWedgeRemap[m[0]] = m[1];
+
+		mCollapsed[p] = q;
+		mQuadrics[q] = merged;
+		mAttribError2[q] = std::max( mAttribError2[q], mAttribError2[p] + attribError2 );
+
+		if( VertexKind_::feature == mKinds[p] && VertexKind_::feature == mKinds[q] )
+		{
+			// q takes over p's other neighbour on the feature line
+			std::uint32_t const other = resolve_( mNeighbours[p][0] ) == q ? mNeighbours[p][1] : mNeighbours[p][0];
+			for( auto& n : mNeighbours[q] )
+			{
+				if( resolve_( n ) == q )
+					n = other;
+			}
+
+			// A loop of two is all that is left of a hole; keep it.
+			if( resolve_( mNeighbours[q][0] ) == resolve_( mNeighbours[q][1] ) )
+				mKinds[q] = VertexKind_::locked;
+		}
+
+		mError2 = std::max( mError2, cost );
+		mTouched[p] = mTouched[q] = 1;
+		aRemovedTriangles += removedTris;
+		return true;
+	}
+}
+
+std::size_t simplify_mesh( std::uint32_t* aDest, std::uint32_t const* aIndices, std::size_t aIndexCount, Vec3f const* aPositions, std::size_t aVertexCount, std::size_t aTargetIndexCount, float aTargetError, float* aResultError, SimplifyAttributes const& aAttributes )
+{
+	assert( aIndexCount % 3 == 0 );
+	assert( 0 == aAttributes.count || (aAttributes.data && aAttributes.weights && aAttributes.stride >= aAttributes.count) );
+
+	Simplifier_ simplifier( aIndices, aIndexCount, aPositions, aVertexCount, aAttributes );
+
+	std::size_t const targetTriangles = aTargetIndexCount / 3;
+	float const limit2 = aTargetError * aTargetError;
+
+	while( simplifier.indices().size() / 3 > targetTriangles )
+	{
+		if( !simplifier.pass( targetTriangles, limit2 ) )
+			break;
+	}
+
+	auto const& indices = simplifier.indices();
+	std::copy( indices.begin(), indices.end(), aDest );
+
+	if( aResultError )
+		*aResultError = std::sqrt( simplifier.error2() );
+
+	return indices.size();
+}
@@ -0,0 +1,60 @@
+#ifndef MESH_SIMPLIFY_HPP_8F53F260_D9F6_4EB6_8AD6_6979378494DD
+#define MESH_SIMPLIFY_HPP_8F53F260_D9F6_4EB6_8AD6_6979378494DD
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vec3.hpp"
+
+/* Mesh simplification
+ *
+ * Reduces the number of triangles of an indexed triangle mesh by edge
+ * collapses ordered by the quadric error metric (Garland & Heckbert,
+ * "Surface Simplification Using Quadric Error Metrics", SIGGRAPH 1997).
+ *
+ * Only a new index buffer is produced. Each collapse moves a vertex onto a
+ * neighbour (a half-edge collapse), so the simplified mesh uses a subset of
+ * the original vertices, and several levels of detail can share one vertex
+ * buffer.
+ *
+ * Vertices with bitwise identical positions are treated as one position
+ * with several "wedges" (e.g., different normals or texture coordinates on
+ * either side of a seam). Seams and open borders are preserved: their
+ * vertices only collapse along the seam/border, and extra quadrics keep the
+ * seam/border in place. Positions where seams/borders meet are never moved,
+ * and neither are the vertices of non-manifold edges.
+ *
+ * The error is measured in the units of the positions. It is the square
+ * root of the quadric error (the area weighted mean squared distance to the
+ * original planes), plus the attribute error if attributes are given. It
+ * estimates the geometric deviation; it is not a strict bound.
+ */
+
+// Optional vertex attributes that the simplification should preserve
+// (e.g., normals and texture coordinates). Vertex v's attributes are
+// data[v*stride ... v*stride+count). The weights convert attribute
+// differences to position units: collapsing vertex a onto vertex b costs
+// at least sum_i (weights[i] * (a_i - b_i))^2 (squared).
+struct SimplifyAttributes
+{
+	float const* data = nullptr;
+	std::size_t stride = 0;
+	float const* weights = nullptr;
+	std::size_t count = 0;
+};
+
+// Simplify until at most aTargetIndexCount indices remain, or until the
+// next collapse would exceed aTargetError. Writes the new indices to aDest
+// (room for aIndexCount indices; aDest may equal aIndices) and returns
+// their number. aResultError (optional) receives the error of the result.
+std::size_t simplify_mesh(
+	std::uint32_t* aDest,
+	std::uint32_t const* aIndices, std::size_t aIndexCount,
+	Vec3f const* aPositions, std::size_t aVertexCount,
+	std::size_t aTargetIndexCount,
+	float aTargetError,
+	float* aResultError = nullptr,
+	SimplifyAttributes const& aAttributes = SimplifyAttributes{}
+);
+
+#endif // MESH_SIMPLIFY_HPP_8F53F260_D9F6_4EB6_8AD6_6979378494DD
@@ -0,0 +1,398 @@
+#include "meshlet.hpp"
+
+#include <numeric>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "mesh_opt.hpp"
+
+namespace
+{
+	constexpr std::uint32_t kNone_ = ~std::uint32_t(0);
+
+	// Disconnected triangles join a cluster only if their normal is within
+	// 60 degrees of the cluster's average normal, so that the cluster keeps
+	// a normal cone narrow enough for back-face culling.
+	constexpr float kJoinMinCos_ = 0.5f;
+	constexpr std::size_t kJoinWindow_ = 64;
+
+	Vec3f unit_normal_( std::uint32_t const* aTri, Vec3f const* aPositions ) noexcept
+	{
+		Vec3f const n = cross( aPositions[aTri[1]] - aPositions[aTri[0]], aPositions[aTri[2]] - aPositions[aTri[0]] );
+		float const l = length( n );
+		return l > 0.f ? n / l : Vec3f{ 0.f, 0.f, 0.f };
+	}
+
+	// Vertex -> triangle adjacency in compressed form: the triangles of
+	// vertex v are triangles[offsets[v] ... offsets[v+1]).
+	struct Adjacency_
+	{
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> triangles;
+	};
+
+	Adjacency_ build_adjacency_( std::uint32_t const* aIndices, std::size_t aIndexCount, std::size_t aVertexCount )
+	{
+		Adjacency_ ret;
+		ret.offsets.assign( aVertexCount + 1, 0 );
+		for( std::size_t i = 0; i < aIndexCount; ++i )
+			++ret.offsets[aIndices[i] + 1];
+
+		std::partial_sum( ret.offsets.begin(), ret.offsets.end(), ret.offsets.begin() );
+
+		std::vector<std::uint32_t> fill( ret.offsets.begin(), ret.offsets.end() - 1 );
+		ret.triangles.resize( aIndexCount );
+		for( std::size_t i = 0; i < aIndexCount; ++i )
+			ret.triangles[fill[aIndices[i]]++] = std::uint32_t(i / 3);
+
+		return ret;
+	}
+
+	Vec3f min_( Vec3f aA, Vec3f aB ) noexcept
+	{
+		return Vec3f{ std::min( aA.x, aB.x ), std::min( aA.y, aB.y ), std::min( aA.z, aB.z ) };
+	}
+	Vec3f max_( Vec3f aA, Vec3f aB ) noexcept
+	{
+		return Vec3f{ std::max( aA.x, aB.x ), std::max( aA.y, aB.y ), std::max( aA.z, aB.z ) };
+	}
+
+	// Spreads the lower 10 bits of aX to every third bit.
+	std::uint32_t spread_bits_( std::uint32_t aX ) noexcept
+	{
+		aX &= 0x3ff;
+		aX = (aX | (aX << 16)) & 0x30000ff;
+		aX = (aX | (aX << 8)) & 0x300f00f;
+		aX = (aX | (aX << 4)) & 0x30c30c3;
+		aX = (aX | (aX << 2)) & 0x9249249;
+		return aX;
+	}
+
+	// Triangles sorted by the Morton code of their centroids: triangles
+	// that are close in this order are close in space.
+	std::vector<std::uint32_t> spatial_order_( std::uint32_t const* aIndices, std::size_t aIndexCount, Vec3f const* aPositions )
+	{
+		std::size_t const triangleCount = aIndexCount / 3;
+
+		std::vector<Vec3f> centroids( triangleCount );
+		for( std::size_t t = 0; t < triangleCount; ++t )
+			centroids[t] = (aPositions[aIndices[t*3+0]] + aPositions[aIndices[t*3+1]] + aPositions[aIndices[t*3+2]]) / 3.f;
+
+		Vec3f lo = centroids.front(), hi = lo;
+		for( auto const& c : centroids )
+		{
+			lo = min_( lo, c );
+			hi = max_( hi, c );
+		}
+
+		// Same scale on all axes, so that the cells are cubes
+		float const extent = std::max( { hi.x - lo.x, hi.y - lo.y, hi.z - lo.z } );
+		float const scale = extent > 0.f ? 1023.f / extent : 0.f;
+
+		std::vector<std::uint32_t> codes( triangleCount );
+		for( std::size_t t = 0; t < triangleCount; ++t )
+		{
+			Vec3f const q = (centroids[t] - lo) * scale;
+			codes[t] = spread_bits_( std::uint32_t(q.x) ) | (spread_bits_( std::uint32_t(q.y) ) << 1) | (spread_bits_( std::uint32_t(q.z) ) << 2);
+		}
+
+		std::vector<std::uint32_t> ret( triangleCount );
+		std::iota( ret.begin(), ret.end(), 0u );
+		std::stable_sort( ret.begin(), ret.end(), [&codes] (std::uint32_t aA, std::uint32_t aB) {
+			return codes[aA] < codes[aB];
+		} );
+		return ret;
+	}
+
+	void compute_bounds_( Meshlet& aMeshlet, std::uint32_t const* aIndices, Vec3f const* aPositions ) noexcept
+	{
+		std::uint32_t const* const begin = aIndices + aMeshlet.firstIndex;
+		std::uint32_t const* const end = begin + aMeshlet.indexCount;
+
+		aMeshlet.aabbMin = aMeshlet.aabbMax = aPositions[*begin];
+		for( auto it = begin; it != end; ++it )
+		{
+			aMeshlet.aabbMin = min_( aMeshlet.aabbMin, aPositions[*it] );
+			aMeshlet.aabbMax = max_( aMeshlet.aabbMax, aPositions[*it] );
+		}
+
+		aMeshlet.center = 0.5f * (aMeshlet.aabbMin + aMeshlet.aabbMax);
+		aMeshlet.radius = 0.f;
+		for( auto it = begin; it != end; ++it )
+			aMeshlet.radius = std::max( aMeshlet.radius, length( aPositions[*it] - aMeshlet.center ) );
+
+		// Normal cone: the axis is the average of the (unit) triangle
+		// normals; the cone is as wide as the normal furthest from it.
+		// Degenerate triangles have no normal and are ignored.
+		Vec3f sum{ 0.f, 0.f, 0.f };
+		for( auto it = begin; it != end; it += 3 )
+		{
+			Vec3f const n = cross( aPositions[it[1]] - aPositions[it[0]], aPositions[it[2]] - aPositions[it[0]] );
+			float const l = length( n );
+			if( l > 0.f )
+				sum += n / l;
+		}
+
+		float const sumLength = length( sum );
+		if( sumLength <= 1e-6f )
+		{
+			aMeshlet.coneAxis = Vec3f{ 0.f, 0.f, 1.f };
+			aMeshlet.coneCos = -1.f;
+			return;
+		}
+
+		aMeshlet.coneAxis = sum / sumLength;
+		aMeshlet.coneCos = 1.f;
+		for( auto it = begin; it != end; it += 3 )
+		{
+			Vec3f const n = cross( aPositions[it[1]] - aPositions[it[0]], aPositions[it[2]] - aPositions[it[0]] );
+			float const l = length( n );
+			if( l > 0.f )
+				aMeshlet.coneCos = std::min( aMeshlet.coneCos, dot( aMeshlet.coneAxis, n ) / l );
+		}
+	}
+}
+
+std::vector<Meshlet> build_meshlets( std::uint32_t* aIndices, std::size_t aIndexCount, Vec3f const* aPositions, std::size_t aVertexCount, std::size_t aMaxVertices, std::size_t aMaxTriangles )
+{
+	assert( aIndexCount % 3 == 0 );
+	assert( aMaxVertices >= 3 && aMaxTriangles >= 1 );
+
+	std::vector<Meshlet> ret;
+	if( 0 == aIndexCount )
+		return ret;
+
+	std::size_t const triangleCount = aIndexCount / 3;
+	std::vector<std::uint32_t> const source( aIndices, aIndices + aIndexCount );
+	Adjacency_ const adj = build_adjacency_( source.data(), aIndexCount, aVertexCount );
+	std::vector<std::uint32_t> const order = spatial_order_( source.data(), aIndexCount, aPositions );
+
+	// Per vertex and triangle: the last cluster that used the vertex, or
+	// that has the triangle among its candidates.
+	std::vector<std::uint32_t> vertexCluster( aVertexCount, kNone_ );
+	std::vector<std::uint32_t> candidateCluster( triangleCount, kNone_ );
+	std::vector<char> emitted( triangleCount, 0 );
+
+	std::vector<std::uint32_t> candidates, local, reordered;
+	std::size_t out = 0, cursor = 0;
+
+	while( out < aIndexCount )
+	{
+		std::uint32_t const id = std::uint32_t(ret.size());
+
+		Meshlet meshlet{};
+		meshlet.firstIndex = std::uint32_t(out);
+
+		// Seed: a remaining neighbour of the previous cluster, so that
+		// consecutive clusters stay close. Otherwise the next remaining
+		// triangle in spatial order.
+		std::uint32_t tri = kNone_;
+		for( auto const t : candidates )
+		{
+			if( !emitted[t] )
+			{
+				tri = t;
+				break;
+			}
+		}
+		candidates.clear();
+
+		if( kNone_ == tri )
+		{
+			while( emitted[order[cursor]] )
+				++cursor;
+			tri = order[cursor];
+		}
+
+		std::size_t vertexCount = 0, clusterTriangles = 0;
+		Vec3f sum{ 0.f, 0.f, 0.f }, normalSum{ 0.f, 0.f, 0.f };
+		Vec3f lo = aPositions[source[tri*3]], hi = lo;
+		while( kNone_ != tri )
+		{
+			std::copy( source.data() + tri*3, source.data() + tri*3 + 3, aIndices + out );
+			out += 3;
+			emitted[tri] = 1;
+			++clusterTriangles;
+			normalSum += unit_normal_( source.data() + tri*3, aPositions );
+
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				std::uint32_t const v = source[tri*3+k];
+				if( id == vertexCluster[v] )
+					continue;
+
+				vertexCluster[v] = id;
+				++vertexCount;
+				sum += aPositions[v];
+				lo = min_( lo, aPositions[v] );
+				hi = max_( hi, aPositions[v] );
+
+				for( std::uint32_t i = adj.offsets[v]; i < adj.offsets[v+1]; ++i )
+				{
+					std::uint32_t const t = adj.triangles[i];
+					if( !emitted[t] && id != candidateCluster[t] )
+					{
+						candidateCluster[t] = id;
+						candidates.emplace_back( t );
+					}
+				}
+			}
+
+			if( clusterTriangles == aMaxTriangles )
+				break;
+
+			// Next: the candidate with the fewest new vertices that still
+			// fits, closest to the cluster's centroid. Drop emitted ones.
+			Vec3f const centroid = sum / float(vertexCount);
+
+			tri = kNone_;
+			unsigned bestNew = 4;
+			float bestDistance = 0.f;
+
+			std::size_t keep = 0;
+			for( auto const t : candidates )
+			{
+				if( emitted[t] )
+					continue;
+
+				candidates[keep++] = t;
+
+				std::uint32_t const* const ti = source.data() + t*3;
+				unsigned const newVertices = unsigned(id != vertexCluster[ti[0]]) + unsigned(id != vertexCluster[ti[1]]) + unsigned(id != vertexCluster[ti[2]]);
+				if( vertexCount + newVertices > aMaxVertices )
+					continue;
+
+				Vec3f const d = (aPositions[ti[0]] + aPositions[ti[1]] + aPositions[ti[2]]) / 3.f - centroid;
+				float const distance = dot( d, d );
+				if( newVertices < bestNew || (newVertices == bestNew && distance < bestDistance) )
+				{
+					tri = t;
+					bestNew = newVertices;
+					bestDistance = distance;
+				}
+			}
+			candidates.resize( keep );
+
+			// Disconnected parts (e.g., split by seams): continue with the
+			// closest remaining triangle among the next kJoinWindow_ in
+			// spatial order that fits, faces the same way and is not further
+			// from the cluster's centroid than the cluster is large.
+			if( 0 == keep )
+			{
+				bestDistance = dot( hi - lo, hi - lo );
+
+				while( cursor < triangleCount && emitted[order[cursor]] )
+					++cursor;
+
+				float const normalLength = length( normalSum );
+				std::size_t const end = std::min( triangleCount, cursor + kJoinWindow_ );
+				for( std::size_t i = cursor; i < end && normalLength > 0.f; ++i )
+				{
+					std::uint32_t const t = order[i];
+					if( emitted[t] )
+						continue;
+
+					std::uint32_t const* const ti = source.data() + t*3;
+					unsigned const newVertices = unsigned(id != vertexCluster[ti[0]]) + unsigned(id != vertexCluster[ti[1]]) + unsigned(id != vertexCluster[ti[2]]);
+					if( vertexCount + newVertices > aMaxVertices || dot( unit_normal_( ti, aPositions ), normalSum ) < kJoinMinCos_ * normalLength )
+						continue;
+
+					Vec3f const d = (aPositions[ti[0]] + aPositions[ti[1]] + aPositions[ti[2]]) / 3.f - centroid;
+					float const distance = dot( d, d );
+					if( distance <= bestDistance )
+					{
+						tri = t;
+						bestDistance = distance;
+					}
+				}
+			}
+		}
+
+		meshlet.indexCount = std::uint32_t(out - meshlet.firstIndex);
+
+		// The growth order is compact but often not cache friendly: the
+		// front of a growing cluster can be larger than the cache. Reorder
+		// the cluster's triangles on their own, with local vertex indices,
+		// and keep the better order.
+		std::uint32_t* const clusterIndices = aIndices + meshlet.firstIndex;
+		local.clear();
+		for( std::size_t i = 0; i < meshlet.indexCount; ++i )
+		{
+			std::uint32_t const v = clusterIndices[i];
+			auto const it = std::find( local.begin(), local.end(), v );
+			clusterIndices[i] = std::uint32_t(it - local.begin());
+			if( local.end() == it )
+				local.emplace_back( v );
+		}
+
+		reordered.assign( clusterIndices, clusterIndices + meshlet.indexCount );
+		optimize_vertex_cache( reordered.data(), reordered.size(), local.size() );
+
+		if( analyze_vertex_cache( reordered.data(), reordered.size(), local.size() ).acmr < analyze_vertex_cache( clusterIndices, meshlet.indexCount, local.size() ).acmr )
+			std::copy( reordered.begin(), reordered.end(), clusterIndices );
+
+		for( std::size_t i = 0; i < meshlet.indexCount; ++i )
+			clusterIndices[i] = local[clusterIndices[i]];
+
+		compute_bounds_( meshlet, aIndices, aPositions );
+		ret.emplace_back( meshlet );
+	}
+
+	return ret;
+}
+
+
+Frustum make_frustum( Mat44f const& aProjCameraModel ) noexcept
+{
+	auto const row = [&aProjCameraModel] (std::size_t aI) {
+		return Vec4f{ aProjCameraModel(aI,0), aProjCameraModel(aI,1), aProjCameraModel(aI,2), aProjCameraModel(aI,3) };
+	};
+
+	// A point is inside if -w <= x,y,z <= w in clip space.
+	Vec4f const w = row( 3 );
+
+	Frustum ret;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		ret.planes[2*i+0] = w + row( i );
+		ret.planes[2*i+1] = w - row( i );
+	}
+
+	for( auto& plane : ret.planes )
+		plane /= length( Vec3f{ plane.x, plane.y, plane.z } );
+
+	return ret;
+}
+
+bool sphere_in_frustum( Frustum const& aFrustum, Vec3f aCenter, float aRadius ) noexcept
+{
+	for( auto const& plane : aFrustum.planes )
+	{
+		if( plane.x*aCenter.x + plane.y*aCenter.y + plane.z*aCenter.z + plane.w < -aRadius )
+			return false;
+	}
+	return true;
+}
+
+bool meshlet_backfacing( Meshlet const& aMeshlet, Vec3f aCameraPos ) noexcept
+{
+	if( aMeshlet.coneCos <= 0.f )
+		return false;
+
+	Vec3f const d = aMeshlet.center - aCameraPos;
+	float const distance = length( d );
+	if( distance <= aMeshlet.radius )
+		return false;
+
+	// A triangle with normal n faces away if dot(p - aCameraPos, n) > 0 for
+	// its points p. With the angle b between d and the cone axis and the
+	// cone's half angle a, the smallest dot(d, n) is |d| cos(b + a), and the
+	// sphere's points change dot(p - aCameraPos, n) by at most the radius.
+	float const cosB = dot( d, aMeshlet.coneAxis ) / distance;
+	float const sinB = std::sqrt( std::max( 0.f, 1.f - cosB*cosB ) );
+	float const sinA = std::sqrt( std::max( 0.f, 1.f - aMeshlet.coneCos*aMeshlet.coneCos ) );
+
+	return cosB * aMeshlet.coneCos - sinB * sinA > aMeshlet.radius / distance;
+}
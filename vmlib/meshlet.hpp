@@ -0,0 +1,80 @@
+#ifndef MESHLET_HPP_7800599C_BC2F_4665_A885_5C0101F70179
+#define MESHLET_HPP_7800599C_BC2F_4665_A885_5C0101F70179
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vec3.hpp"
+#include "vec4.hpp"
+#include "mat44.hpp"
+
+/* Meshlets (clusters)
+ *
+ * build_meshlets() reorders the triangles of an indexed triangle mesh into
+ * clusters of at most aMaxTriangles triangles that use at most aMaxVertices
+ * distinct vertices. Each cluster is a contiguous range of the index
+ * buffer, so that it can be drawn (or skipped) on its own. Clusters are
+ * grown from a seed triangle by adding the adjacent triangle that brings in
+ * the fewest new vertices (ties: the one closest to the cluster), which
+ * keeps them compact. Without adjacent triangles (e.g., at seams), growth
+ * continues with the next triangle in spatial (Morton) order that faces
+ * roughly the same way. Finally, each cluster's triangles are reordered
+ * for the vertex cache (see mesh_opt.hpp).
+ *
+ * Each cluster stores bounds for culling:
+ *   - a bounding sphere and an axis aligned bounding box, and
+ *   - a normal cone: all triangle normals are within acos(coneCos) of
+ *     coneAxis. If coneCos <= 0, the cone spans a half space or more and
+ *     the cluster can not be back-face culled.
+ *
+ * The culling tests work in model space: make_frustum() extracts the planes
+ * from the full projection * camera * model matrix (Gribb & Hartmann,
+ * "Fast Extraction of Viewing Frustum Planes from the World-View-Projection
+ * Matrix"), and the camera position has to be transformed into model space
+ * as well. Both tests are conservative.
+ */
+constexpr std::size_t kMeshletMaxVertices = 64;
+constexpr std::size_t kMeshletMaxTriangles = 124;
+
+struct Meshlet
+{
+	std::uint32_t firstIndex, indexCount;
+
+	Vec3f center;
+	float radius;
+
+	Vec3f aabbMin, aabbMax;
+
+	Vec3f coneAxis;
+	float coneCos;
+};
+
+// Reorders the triangles in place and returns the clusters in index buffer
+// order. Each triangle keeps its vertices in the same order.
+std::vector<Meshlet> build_meshlets(
+	std::uint32_t* aIndices, std::size_t aIndexCount,
+	Vec3f const* aPositions, std::size_t aVertexCount,
+	std::size_t aMaxVertices = kMeshletMaxVertices,
+	std::size_t aMaxTriangles = kMeshletMaxTriangles
+);
+
+
+// Planes (xyz: normal pointing inwards, w: offset) of the view frustum,
+// normalized such that dot(xyz, p) + w is the signed distance of p.
+struct Frustum
+{
+	Vec4f planes[6];
+};
+
+Frustum make_frustum( Mat44f const& aProjCameraModel ) noexcept;
+
+// False if the bounding sphere is entirely outside of one of the planes.
+bool sphere_in_frustum( Frustum const&, Vec3f aCenter, float aRadius ) noexcept;
+
+// True if every triangle of the cluster faces away from aCameraPos (front
+// faces are counter-clockwise), for any point of the bounding sphere.
+bool meshlet_backfacing( Meshlet const&, Vec3f aCameraPos ) noexcept;
+
+#endif // MESHLET_HPP_7800599C_BC2F_4665_A885_5C0101F70179
@@ -0,0 +1,218 @@
+#ifndef PACKING_HPP_B6935B12_03F7_4C14_875C_D674C09C434B
+#define PACKING_HPP_B6935B12_03F7_4C14_875C_D674C09C434B
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "vec2.hpp"
+#include "vec3.hpp"
+#include "vec4.hpp"
+
+/* Packed vertex attribute formats
+ *
+ * Encoding and decoding of the compact formats that OpenGL can read directly
+ * as vertex attributes:
+ *
+ *   half floats        GL_HALF_FLOAT            2 bytes per component
+ *   unorm8             GL_UNSIGNED_BYTE (*)     1 byte per component
+ *   snorm 10:10:10:2   GL_INT_2_10_10_10_REV    4 bytes for a whole Vec4f
+ *   octahedral normal  GL_SHORT (*), 2 comp.    4 bytes for a unit Vec3f
+ *
+ * (*) with normalized = GL_TRUE.
+ *
+ * The first three are decoded by OpenGL, i.e., the vertex shader sees plain
+ * floats. Octahedral normals map the unit sphere onto the square [-1,1]^2
+ * (Cigolle et al., "A Survey of Efficient Representations for Independent
+ * Unit Vectors", JCGT 2014) and are decoded in the vertex shader with
+ * oct_decode() (see assets/default.vert).
+ *
+ * The pack_*() functions return the bits as they are stored in the vertex
+ * buffer: the first component is in the lowest bits, which on a little-endian
+ * machine is the first byte in memory (as expected by OpenGL). The unorm and
+ * snorm conversions follow the OpenGL 4.2+ rules (round to nearest, -1 and +1
+ * are exact).
+ *
+ * Worst-case error of a round trip (see vmlib-test/packing.cpp):
+ *   half         : 2^-11 relative for normal values (round to nearest even)
+ *   unorm8       : 1/510
+ *   snorm10      : 1/1022
+ *   octahedral   : 6e-5 per component of the decoded unit vector
+ */
+
+// Implementation details of the functions below; not part of the interface.
+namespace detail
+{
+	inline std::uint32_t float_bits( float aX ) noexcept
+	{
+		std::uint32_t ret;
+		std::memcpy( &ret, &aX, sizeof(float) );
+		return ret;
+	}
+	inline float bits_float( std::uint32_t aBits ) noexcept
+	{
+		float ret;
+		std::memcpy( &ret, &aBits, sizeof(float) );
+		return ret;
+	}
+
+	inline float clamp_unit( float aX, float aLow ) noexcept
+	{
+		// Written such that NaN maps to aLow.
+		return aX >= aLow ? (aX <= 1.f ? aX : 1.f) : aLow;
+	}
+
+	inline std::uint32_t to_unorm( float aX, float aMax ) noexcept
+	{
+		return std::uint32_t(std::lround( clamp_unit( aX, 0.f ) * aMax ));
+	}
+	inline std::int32_t to_snorm( float aX, float aMax ) noexcept
+	{
+		return std::int32_t(std::lround( clamp_unit( aX, -1.f ) * aMax ));
+	}
+	inline float from_snorm( std::int32_t aX, float aMax ) noexcept
+	{
+		float const ret = float(aX) / aMax;
+		return ret >= -1.f ? ret : -1.f;
+	}
+
+	inline float sign_not_zero( float aX ) noexcept
+	{
+		return aX >= 0.f ? 1.f : -1.f;
+	}
+}
+
+// Functions:
+
+// IEEE 754 binary16 ("half float"). Rounds to nearest even. Values too large
+// for a half become infinity, NaNs stay NaNs.
+inline std::uint16_t pack_half( float aX ) noexcept
+{
+	std::uint32_t bits = detail::float_bits( aX );
+	std::uint32_t const sign = (bits >> 16) & 0x8000u;
+	bits &= 0x7fffffffu;
+
+	if( bits >= 0x47800000u ) // >= 65536, inf or NaN
+		return std::uint16_t(sign | (bits > 0x7f800000u ? 0x7e00u : 0x7c00u));
+
+	if( bits < 0x38800000u ) // < 2^-14, denormal (or zero) as half
+	{
+		// Adding 0.5f aligns the mantissa such that the half's bits end up in
+		// the low bits; the FPU does the rounding.
+		float const f = detail::bits_float( bits ) + 0.5f;
+		return std::uint16_t(sign | (detail::float_bits( f ) - 0x3f000000u));
+	}
+
+	// Rebias the exponent and round to nearest even. The carry from rounding
+	// may propagate into the exponent, which gives the right result (up to
+	// infinity for values >= 65520).
+	std::uint32_t const odd = (bits >> 13) & 1u;
+	bits += ((15u - 127u) << 23) + 0xfffu + odd;
+	return std::uint16_t(sign | (bits >> 13));
+}
+inline float unpack_half( std::uint16_t aH ) noexcept
+{
+	std::uint32_t const sign = std::uint32_t(aH & 0x8000u) << 16;
+	std::uint32_t const exp = aH & 0x7c00u;
+	std::uint32_t bits = std::uint32_t(aH & 0x7fffu) << 13;
+
+	if( 0x7c00u == exp ) // inf or NaN
+		bits += (255u - 31u) << 23;
+	else if( 0 == exp ) // zero or denormal
+		bits = detail::float_bits( detail::bits_float( bits + (113u << 23) ) - detail::bits_float( 113u << 23 ) );
+	else
+		bits += (127u - 15u) << 23;
+
+	return detail::bits_float( bits | sign );
+}
+
+// Four unsigned normalized bytes, e.g. for RGBA colours. Components are
+// clamped to [0,1].
+inline std::uint32_t pack_unorm8x4( Vec4f aV ) noexcept
+{
+	return detail::to_unorm( aV.x, 255.f )
+		| (detail::to_unorm( aV.y, 255.f ) << 8)
+		| (detail::to_unorm( aV.z, 255.f ) << 16)
+		| (detail::to_unorm( aV.w, 255.f ) << 24)
+	;
+}
+inline Vec4f unpack_unorm8x4( std::uint32_t aP ) noexcept
+{
+	return Vec4f{
+		float(aP & 0xffu) / 255.f,
+		float((aP >> 8) & 0xffu) / 255.f,
+		float((aP >> 16) & 0xffu) / 255.f,
+		float(aP >> 24) / 255.f
+	};
+}
+
+// Signed normalized 10:10:10:2, as read by GL_INT_2_10_10_10_REV (x in the
+// lowest bits). Components are clamped to [-1,1]; w can only be -1, 0 or 1.
+inline std::uint32_t pack_snorm_2_10_10_10_rev( Vec4f aV ) noexcept
+{
+	return (std::uint32_t(detail::to_snorm( aV.x, 511.f )) & 0x3ffu)
+		| ((std::uint32_t(detail::to_snorm( aV.y, 511.f )) & 0x3ffu) << 10)
+		| ((std::uint32_t(detail::to_snorm( aV.z, 511.f )) & 0x3ffu) << 20)
+		| ((std::uint32_t(detail::to_snorm( aV.w, 1.f )) & 0x3u) << 30)
+	;
+}
+inline Vec4f unpack_snorm_2_10_10_10_rev( std::uint32_t aP ) noexcept
+{
+	// Sign-extend each field by moving it to the top of an int32 and shifting
+	// it back down (arithmetic shift).
+	auto const field = [aP] (unsigned aShift, unsigned aBits) {
+		return std::int32_t(aP << (32u - aShift - aBits)) >> (32u - aBits);
+	};
+
+	return Vec4f{
+		detail::from_snorm( field( 0, 10 ), 511.f ),
+		detail::from_snorm( field( 10, 10 ), 511.f ),
+		detail::from_snorm( field( 20, 10 ), 511.f ),
+		detail::from_snorm( field( 30, 2 ), 1.f )
+	};
+}
+
+// Octahedral mapping of a unit vector to [-1,1]^2 and back. oct_encode()
+// does not require aN to be exactly unit length (it must not be zero).
+// oct_decode() returns a unit vector.
+inline Vec2f oct_encode( Vec3f aN ) noexcept
+{
+	float const invL1 = 1.f / (std::abs(aN.x) + std::abs(aN.y) + std::abs(aN.z));
+	float const x = aN.x * invL1;
+	float const y = aN.y * invL1;
+
+	if( aN.z >= 0.f )
+		return Vec2f{ x, y };
+
+	// Lower hemisphere: fold the triangles over the diagonals.
+	return Vec2f{
+		(1.f - std::abs(y)) * detail::sign_not_zero( x ),
+		(1.f - std::abs(x)) * detail::sign_not_zero( y )
+	};
+}
+inline Vec3f oct_decode( Vec2f aE ) noexcept
+{
+	Vec3f n{ aE.x, aE.y, 1.f - std::abs(aE.x) - std::abs(aE.y) };
+	float const t = n.z < 0.f ? -n.z : 0.f;
+	n.x += n.x >= 0.f ? -t : t;
+	n.y += n.y >= 0.f ? -t : t;
+	return normalize( n );
+}
+
+// Octahedral normal stored as two snorm16 values (GL_SHORT, normalized).
+inline std::uint32_t pack_oct_snorm16( Vec3f aN ) noexcept
+{
+	Vec2f const e = oct_encode( aN );
+	return (std::uint32_t(detail::to_snorm( e.x, 32767.f )) & 0xffffu)
+		| (std::uint32_t(detail::to_snorm( e.y, 32767.f )) << 16)
+	;
+}
+inline Vec3f unpack_oct_snorm16( std::uint32_t aP ) noexcept
+{
+	return oct_decode( Vec2f{
+		detail::from_snorm( std::int16_t(aP & 0xffffu), 32767.f ),
+		detail::from_snorm( std::int16_t(aP >> 16), 32767.f )
+	} );
+}
+
+#endif // PACKING_HPP_B6935B12_03F7_4C14_875C_D674C09C434B
@@ -0,0 +1,81 @@
+#ifndef PRECISION_HPP_4E70F8C3_E5E7_483B_AAE0_BEFE7ACFFCF1
+#define PRECISION_HPP_4E70F8C3_E5E7_483B_AAE0_BEFE7ACFFCF1
+
+#include <limits>
+#include <algorithm>
+
+#include <cmath>
+
+#include "simd.hpp"
+
+/* Accuracy policies
+ *
+ * Functions such as length() and normalize() take an (optional) policy as
+ * template argument, which selects how square roots are computed:
+ *
+ *   PreciseMath : std::sqrt() and a division. Correctly rounded.
+ *   FastMath    : hardware reciprocal square root estimate, refined with
+ *                 one Newton-Raphson step. Avoids the (slow) sqrt and
+ *                 division instructions.
+ *
+ * The default is DefaultMath, which is PreciseMath unless VMLIB_FAST_MATH is
+ * defined (e.g., via the build system). The policy can also be chosen per
+ * call:
+ *   Vec3f n = normalize<FastMath>( v );
+ *
+ * Error of FastMath (measured against PreciseMath over all floats in [1,4),
+ * which covers all mantissas for both exponent parities):
+ *   rsqrt()                 : at most 5 ULP
+ *   sqrt()                  : at most 4 ULP
+ *   normalize() components  : at most 5 ULP (for components larger than
+ *                             1e-3 in magnitude; smaller ones have at most
+ *                             the same absolute error, i.e., about 3e-7)
+ * See vmlib-test/fast-math.cpp.
+ *
+ * FastMath::sqrt( 0 ) returns 0 (as does PreciseMath). Inputs below
+ * FLT_MIN (denormals) are flushed towards zero. normalize() of a zero vector
+ * gives NaNs with either policy.
+ *
+ * Without SSE (see simd.hpp), FastMath falls back to the PreciseMath
+ * implementation.
+ */
+struct PreciseMath
+{
+	static float rsqrt( float aX ) noexcept
+	{
+		return 1.f / std::sqrt( aX );
+	}
+	static float sqrt( float aX ) noexcept
+	{
+		return std::sqrt( aX );
+	}
+};
+
+struct FastMath
+{
+	static float rsqrt( float aX ) noexcept
+	{
+#		if defined(VMLIB_SIMD_SSE)
+		float const y = _mm_cvtss_f32( _mm_rsqrt_ss( _mm_set_ss( aX ) ) );
+		return y * (1.5f - 0.5f * aX * y * y);
+#		else // scalar
+		return PreciseMath::rsqrt( aX );
+#		endif
+	}
+	static float sqrt( float aX ) noexcept
+	{
+#		if defined(VMLIB_SIMD_SSE)
+		return aX * rsqrt( std::max( aX, std::numeric_limits<float>::min() ) );
+#		else // scalar
+		return PreciseMath::sqrt( aX );
+#		endif
+	}
+};
+
+#if defined(VMLIB_FAST_MATH)
+using DefaultMath = FastMath;
+#else
+using DefaultMath = PreciseMath;
+#endif
+
+#endif // PRECISION_HPP_4E70F8C3_E5E7_483B_AAE0_BEFE7ACFFCF1
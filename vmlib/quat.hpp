@@ -0,0 +1,186 @@
+#ifndef QUAT_HPP_5CE0408A_241D_4BC5_8F40_9033641623C2
+#define QUAT_HPP_5CE0408A_241D_4BC5_8F40_9033641623C2
+
+#include <cmath>
+
+#include "vec3.hpp"
+#include "mat33.hpp"
+#include "mat44.hpp"
+
+/** Quatf: quaternion with floats
+ *
+ * Like the vector types, Quatf is a POD type. It stores the vector part in
+ * (x, y, z) and the scalar part in w. Quaternions that represent rotations
+ * are unit length.
+ *
+ * The rotations follow the same conventions as the make_rotation_*()
+ * functions in mat44.hpp. A product of quaternions combines rotations in the
+ * same order as the corresponding matrix product, e.g.,
+ *   to_mat44( make_quat_rotation_z( a ) * make_quat_rotation_y( b ) )
+ * equals (up to rounding)
+ *   make_rotation_z( a ) * make_rotation_y( b )
+ *
+ * Composing rotations as quaternions is cheaper than with matrices (16
+ * multiplications vs. 64), so keep rotations in this form and convert them
+ * to a matrix once, when needed.
+ */
+struct Quatf
+{
+	float x, y, z, w;
+};
+
+// Identity rotation
+constexpr Quatf kIdentityQuatf = { 0.f, 0.f, 0.f, 1.f };
+
+// Common operators for Quatf.
+
+constexpr
+Quatf operator*( Quatf aLeft, Quatf aRight ) noexcept
+{
+	return Quatf{
+		aLeft.w*aRight.x + aLeft.x*aRight.w + aLeft.y*aRight.z - aLeft.z*aRight.y,
+		aLeft.w*aRight.y - aLeft.x*aRight.z + aLeft.y*aRight.w + aLeft.z*aRight.x,
+		aLeft.w*aRight.z + aLeft.x*aRight.y - aLeft.y*aRight.x + aLeft.z*aRight.w,
+		aLeft.w*aRight.w - aLeft.x*aRight.x - aLeft.y*aRight.y - aLeft.z*aRight.z
+	};
+}
+
+// Rotate the vector aRight by the (unit) quaternion aLeft.
+constexpr
+Vec3f operator*( Quatf aLeft, Vec3f aRight ) noexcept
+{
+	// v' = v + w*t + q x t, where t = 2 * (q x v)
+	Vec3f const q{ aLeft.x, aLeft.y, aLeft.z };
+	Vec3f const t = 2.f * cross( q, aRight );
+	return aRight + aLeft.w * t + cross( q, t );
+}
+
+// Functions:
+
+constexpr
+float dot( Quatf aLeft, Quatf aRight ) noexcept
+{
+	return aLeft.x * aRight.x
+		+ aLeft.y * aRight.y
+		+ aLeft.z * aRight.z
+		+ aLeft.w * aRight.w
+	;
+}
+
+// Conjugate. For unit quaternions, this is also the inverse rotation.
+constexpr
+Quatf conjugate( Quatf aQ ) noexcept
+{
+	return Quatf{ -aQ.x, -aQ.y, -aQ.z, aQ.w };
+}
+
+inline
+Quatf normalize( Quatf aQ ) noexcept
+{
+	float const l = std::sqrt( dot( aQ, aQ ) );
+	return Quatf{ aQ.x / l, aQ.y / l, aQ.z / l, aQ.w / l };
+}
+
+// Rotation by aAngle radians around aAxis. aAxis must be unit length.
+inline
+Quatf make_quat_rotation( Vec3f aAxis, float aAngle ) noexcept
+{
+	float const s = std::sin( aAngle * 0.5f );
+	return Quatf{ aAxis.x * s, aAxis.y * s, aAxis.z * s, std::cos( aAngle * 0.5f ) };
+}
+
+inline
+Quatf make_quat_rotation_x( float aAngle ) noexcept
+{
+	return Quatf{ std::sin( aAngle * 0.5f ), 0.f, 0.f, std::cos( aAngle * 0.5f ) };
+}
+
+inline
+Quatf make_quat_rotation_y( float aAngle ) noexcept
+{
+	return Quatf{ 0.f, std::sin( aAngle * 0.5f ), 0.f, std::cos( aAngle * 0.5f ) };
+}
+
+inline
+Quatf make_quat_rotation_z( float aAngle ) noexcept
+{
+	return Quatf{ 0.f, 0.f, std::sin( aAngle * 0.5f ), std::cos( aAngle * 0.5f ) };
+}
+
+// Normalized linear interpolation. Cheaper than slerp(), but does not
+// interpolate with constant angular velocity. Takes the shortest path.
+inline
+Quatf nlerp( Quatf aFrom, Quatf aTo, float aT ) noexcept
+{
+	// q and -q represent the same rotation; pick the one closer to aFrom.
+	float const sign = dot( aFrom, aTo ) < 0.f ? -1.f : 1.f;
+	float const s = 1.f - aT;
+	float const t = aT * sign;
+
+	return normalize( Quatf{
+		s * aFrom.x + t * aTo.x,
+		s * aFrom.y + t * aTo.y,
+		s * aFrom.z + t * aTo.z,
+		s * aFrom.w + t * aTo.w
+	} );
+}
+
+// Spherical linear interpolation. Interpolates with constant angular
+// velocity along the shortest path.
+inline
+Quatf slerp( Quatf aFrom, Quatf aTo, float aT ) noexcept
+{
+	float d = dot( aFrom, aTo );
+	if( d < 0.f )
+	{
+		d = -d;
+		aTo = Quatf{ -aTo.x, -aTo.y, -aTo.z, -aTo.w };
+	}
+
+	// For nearly identical rotations, sin(theta) approaches zero. nlerp() is
+	// indistinguishable from slerp() in that case.
+	if( d > 0.9995f )
+		return nlerp( aFrom, aTo, aT );
+
+	float const theta = std::acos( d );
+	float const sinTheta = std::sin( theta );
+	float const s = std::sin( (1.f - aT) * theta ) / sinTheta;
+	float const t = std::sin( aT * theta ) / sinTheta;
+
+	return Quatf{
+		s * aFrom.x + t * aTo.x,
+		s * aFrom.y + t * aTo.y,
+		s * aFrom.z + t * aTo.z,
+		s * aFrom.w + t * aTo.w
+	};
+}
+
+// Rotation matrix for the unit quaternion aQ.
+constexpr
+Mat33f to_mat33( Quatf aQ ) noexcept
+{
+	float const xx = aQ.x*aQ.x, yy = aQ.y*aQ.y, zz = aQ.z*aQ.z;
+	float const xy = aQ.x*aQ.y, xz = aQ.x*aQ.z, yz = aQ.y*aQ.z;
+	float const wx = aQ.w*aQ.x, wy = aQ.w*aQ.y, wz = aQ.w*aQ.z;
+
+	return Mat33f{ {
+		1.f - 2.f*(yy + zz), 2.f*(xy - wz), 2.f*(xz + wy),
+		2.f*(xy + wz), 1.f - 2.f*(xx + zz), 2.f*(yz - wx),
+		2.f*(xz - wy), 2.f*(yz + wx), 1.f - 2.f*(xx + yy)
+	} };
+}
+
+constexpr
+Mat44f to_mat44( Quatf aQ ) noexcept
+{
+	Mat33f const r = to_mat33( aQ );
+
+	return Mat44f{ {
+		r.v[0], r.v[1], r.v[2], 0.f,
+		r.v[3], r.v[4], r.v[5], 0.f,
+		r.v[6], r.v[7], r.v[8], 0.f,
+		0.f, 0.f, 0.f, 1.f
+	} };
+}
+
+#endif // QUAT_HPP_5CE0408A_241D_4BC5_8F40_9033641623C2
@@ -0,0 +1,98 @@
+#include "range_allocator.hpp"
+
+#include <algorithm>
+
+#include <cassert>
+
+RangeAllocator::RangeAllocator( std::size_t aCapacity )
+	: mCapacity( aCapacity )
+	, mUsed( 0 )
+{
+	if( aCapacity )
+		mFree.emplace( 0, aCapacity );
+}
+
+RangeAllocation RangeAllocator::allocate( std::size_t aSize, std::size_t aAlignment )
+{
+	assert( aSize > 0 && aAlignment > 0 );
+
+	// Best fit: the smallest free range that holds the aligned allocation
+	auto best = mFree.end();
+	for( auto it = mFree.begin(); it != mFree.end(); ++it )
+	{
+		std::size_t const aligned = (it->first + aAlignment - 1) / aAlignment * aAlignment;
+		std::size_t const padding = aligned - it->first;
+		if( padding + aSize > it->second )
+			continue;
+
+		if( mFree.end() == best || it->second < best->second )
+			best = it;
+	}
+
+	if( mFree.end() == best )
+		return RangeAllocation{ kInvalidOffset, 0 };
+
+	std::size_t const start = best->first, size = best->second;
+	std::size_t const offset = (start + aAlignment - 1) / aAlignment * aAlignment;
+	mFree.erase( best );
+
+	// Keep what is left on either side
+	if( offset > start )
+		mFree.emplace( start, offset - start );
+	if( start + size > offset + aSize )
+		mFree.emplace( offset + aSize, start + size - (offset + aSize) );
+
+	mUsed += aSize;
+	return RangeAllocation{ offset, aSize };
+}
+
+void RangeAllocator::free( RangeAllocation const& aRange )
+{
+	assert( kInvalidOffset != aRange.offset && aRange.size > 0 );
+	assert( aRange.offset + aRange.size <= mCapacity );
+	assert( aRange.size <= mUsed );
+
+	auto const [it, inserted] = mFree.emplace( aRange.offset, aRange.size );
+	assert( inserted );
+	(void)inserted;
+
+	mUsed -= aRange.size;
+
+	// Merge with the following range ...
+	auto next = std::next( it );
+	assert( mFree.end() == next || it->first + it->second <= next->first );
+	if( mFree.end() != next && it->first + it->second == next->first )
+	{
+		it->second += next->second;
+		mFree.erase( next );
+	}
+
+	// ... and with the preceding one
+	if( mFree.begin() != it )
+	{
+		auto prev = std::prev( it );
+		assert( prev->first + prev->second <= it->first );
+		if( prev->first + prev->second == it->first )
+		{
+			prev->second += it->second;
+			mFree.erase( it );
+		}
+	}
+}
+
+std::size_t RangeAllocator::largest_free() const noexcept
+{
+	std::size_t ret = 0;
+	for( auto const& range : mFree )
+		ret = std::max( ret, range.second );
+	return ret;
+}
+
+float RangeAllocator::fragmentation() const noexcept
+{
+	std::size_t const freeSize = free_size();
+	if( 0 == freeSize )
+		return 0.f;
+
+	return 1.f - float(largest_free()) / float(freeSize);
+}
@@ -0,0 +1,59 @@
+#ifndef RANGE_ALLOCATOR_HPP_91E582B6_4D0D_4FBF_8BBD_BFFEA8F0E88C
+#define RANGE_ALLOCATOR_HPP_91E582B6_4D0D_4FBF_8BBD_BFFEA8F0E88C
+
+#include <map>
+
+#include <cstddef>
+
+// A range [offset, offset + size) handed out by a RangeAllocator. An offset
+// of RangeAllocator::kInvalidOffset means that the allocation failed.
+struct RangeAllocation
+{
+	std::size_t offset, size;
+};
+
+/** RangeAllocator: sub-allocates ranges of a fixed capacity
+ *
+ * Only does the bookkeeping of offsets (e.g., bytes of a GPU buffer). The
+ * free ranges are kept sorted by offset; allocate() picks the smallest one
+ * that fits (best fit), free() merges a range with its free neighbours.
+ * Both run in time linear in the number of free ranges, which stays small
+ * for the intended use (a few dozen meshes per buffer).
+ *
+ * fragmentation() is 1 - largest free range / free space: 0 if all free
+ * space is in one range, and close to 1 if it is split into many small
+ * ranges.
+ */
+class RangeAllocator final
+{
+	public:
+		static constexpr std::size_t kInvalidOffset = ~std::size_t(0);
+
+	public:
+		explicit RangeAllocator( std::size_t aCapacity = 0 );
+
+	public:
+		// Allocates aSize (> 0) units at an offset that is a multiple of
+		// aAlignment (any value > 0, not only powers of two). Space skipped
+		// for the alignment stays free.
+		RangeAllocation allocate( std::size_t aSize, std::size_t aAlignment = 1 );
+
+		// Frees a range returned by allocate().
+		void free( RangeAllocation const& );
+
+	public:
+		std::size_t capacity() const noexcept { return mCapacity; }
+		std::size_t used() const noexcept { return mUsed; }
+		std::size_t free_size() const noexcept { return mCapacity - mUsed; }
+
+		std::size_t largest_free() const noexcept;
+		std::size_t free_range_count() const noexcept { return mFree.size(); }
+
+		float fragmentation() const noexcept;
+
+	private:
+		std::map<std::size_t, std::size_t> mFree; // offset -> size
+		std::size_t mCapacity, mUsed;
+};
+
+#endif // RANGE_ALLOCATOR_HPP_91E582B6_4D0D_4FBF_8BBD_BFFEA8F0E88C
@@ -0,0 +1,41 @@
+#ifndef SIMD_HPP_2FE88DC2_827F_434E_B4A2_C717681E78E4
+#define SIMD_HPP_2FE88DC2_827F_434E_B4A2_C717681E78E4
+
+/* Compile-time SIMD selection
+ *
+ * Some of the hot vmlib functions (e.g., the Mat44f products) have SIMD
+ * implementations. Which one is used is decided at compile time, based on
+ * the instruction sets that the compiler may target. With GCC and clang this
+ * follows -march (the premake setup uses -march=native). MSVC always has
+ * SSE2 available when targeting x64.
+ *
+ * The following macros are defined:
+ *   VMLIB_SIMD_SSE  : SSE (128-bit) implementations are enabled
+ *   VMLIB_SIMD_AVX  : AVX (256-bit) implementations are enabled
+ *
+ * Define VMLIB_NO_SIMD (e.g., via the build system) to force the plain scalar
+ * implementations everywhere. This is useful when debugging or to compare
+ * results between the two.
+ *
+ * Note: the SIMD code uses separate multiplies and adds (never FMA), and
+ * accumulates in the same order as the scalar code. Results are therefore
+ * identical between the scalar and SIMD paths, provided that the compiler
+ * does not contract the scalar code into FMAs. The premake setup passes
+ * -ffp-contract=off to vmlib, vmlib-test and vmlib-bench for this reason.
+ * Inline scalar code compiled as part of other projects may be contracted
+ * and then differ from the SIMD results in the last bits.
+ */
+#if !defined(VMLIB_NO_SIMD)
+#	if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#		define VMLIB_SIMD_SSE 1
+#	endif
+#	if defined(VMLIB_SIMD_SSE) && defined(__AVX__)
+#		define VMLIB_SIMD_AVX 1
+#	endif
+#endif // ~ VMLIB_NO_SIMD
+
+#if defined(VMLIB_SIMD_SSE)
+#	include <immintrin.h>
+#endif // ~ VMLIB_SIMD_SSE
+
+#endif // SIMD_HPP_2FE88DC2_827F_434E_B4A2_C717681E78E4
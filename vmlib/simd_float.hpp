@@ -0,0 +1,133 @@
+#ifndef SIMD_FLOAT_HPP_4B7E7313_A359_4457_A239_1FB46462976E
+#define SIMD_FLOAT_HPP_4B7E7313_A359_4457_A239_1FB46462976E
+
+#include <cstddef>
+
+#include "simd.hpp"
+
+/* Thin wrapper around the widest available float SIMD register
+ *
+ * Used by the bulk functions (batch.cpp) to write one loop body that works
+ * with AVX (8 lanes) or SSE (4 lanes). See simd.hpp for how the instruction
+ * set is selected. Only defined if VMLIB_SIMD_SSE is.
+ *
+ * This is an implementation detail of vmlib and not meant to be used by
+ * other code.
+ */
+#if defined(VMLIB_SIMD_SSE)
+namespace simd
+{
+#	if defined(VMLIB_SIMD_AVX)
+	using Float = __m256;
+	constexpr std::size_t kWidth = 8;
+
+	inline Float load( float const* aPtr ) noexcept { return _mm256_load_ps( aPtr ); }
+	inline Float loadu( float const* aPtr ) noexcept { return _mm256_loadu_ps( aPtr ); }
+	inline void store( float* aPtr, Float aV ) noexcept { _mm256_store_ps( aPtr, aV ); }
+	inline void storeu( float* aPtr, Float aV ) noexcept { _mm256_storeu_ps( aPtr, aV ); }
+
+	inline Float set1( float aX ) noexcept { return _mm256_set1_ps( aX ); }
+
+	inline Float add( Float aA, Float aB ) noexcept { return _mm256_add_ps( aA, aB ); }
+	inline Float sub( Float aA, Float aB ) noexcept { return _mm256_sub_ps( aA, aB ); }
+	inline Float mul( Float aA, Float aB ) noexcept { return _mm256_mul_ps( aA, aB ); }
+	inline Float div( Float aA, Float aB ) noexcept { return _mm256_div_ps( aA, aB ); }
+	inline Float sqrt( Float aA ) noexcept { return _mm256_sqrt_ps( aA ); }
+	inline Float rsqrt_estimate( Float aA ) noexcept { return _mm256_rsqrt_ps( aA ); }
+
+	// Bitwise operations and comparisons. Comparisons return a mask with all
+	// bits set in the lanes where the comparison is true.
+	inline Float bit_and( Float aA, Float aB ) noexcept { return _mm256_and_ps( aA, aB ); }
+	inline Float bit_andnot( Float aA, Float aB ) noexcept { return _mm256_andnot_ps( aA, aB ); }
+	inline Float bit_or( Float aA, Float aB ) noexcept { return _mm256_or_ps( aA, aB ); }
+	inline Float bit_xor( Float aA, Float aB ) noexcept { return _mm256_xor_ps( aA, aB ); }
+
+	inline Float cmp_eq( Float aA, Float aB ) noexcept { return _mm256_cmp_ps( aA, aB, _CMP_EQ_OQ ); }
+	inline Float cmp_gt( Float aA, Float aB ) noexcept { return _mm256_cmp_ps( aA, aB, _CMP_GT_OQ ); }
+	inline Float cmp_ge( Float aA, Float aB ) noexcept { return _mm256_cmp_ps( aA, aB, _CMP_GE_OQ ); }
+
+	// Round towards zero. Only valid for |aA| < 2^31.
+	inline Float truncate( Float aA ) noexcept { return _mm256_cvtepi32_ps( _mm256_cvttps_epi32( aA ) ); }
+	inline bool all_lanes( Float aMask ) noexcept { return 0xff == _mm256_movemask_ps( aMask ); }
+	inline Float min( Float aA, Float aB ) noexcept { return _mm256_min_ps( aA, aB ); }
+	inline Float max( Float aA, Float aB ) noexcept { return _mm256_max_ps( aA, aB ); }
+
+	// Horizontal reductions
+	inline float hmin( Float aA ) noexcept
+	{
+		__m128 m = _mm_min_ps( _mm256_castps256_ps128( aA ), _mm256_extractf128_ps( aA, 1 ) );
+		m = _mm_min_ps( m, _mm_movehl_ps( m, m ) );
+		m = _mm_min_ss( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE(1,1,1,1) ) );
+		return _mm_cvtss_f32( m );
+	}
+	inline float hmax( Float aA ) noexcept
+	{
+		__m128 m = _mm_max_ps( _mm256_castps256_ps128( aA ), _mm256_extractf128_ps( aA, 1 ) );
+		m = _mm_max_ps( m, _mm_movehl_ps( m, m ) );
+		m = _mm_max_ss( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE(1,1,1,1) ) );
+		return _mm_cvtss_f32( m );
+	}
+#	else // SSE
+	using Float = __m128;
+	constexpr std::size_t kWidth = 4;
+
+	inline Float load( float const* aPtr ) noexcept { return _mm_load_ps( aPtr ); }
+	inline Float loadu( float const* aPtr ) noexcept { return _mm_loadu_ps( aPtr ); }
+	inline void store( float* aPtr, Float aV ) noexcept { _mm_store_ps( aPtr, aV ); }
+	inline void storeu( float* aPtr, Float aV ) noexcept { _mm_storeu_ps( aPtr, aV ); }
+
+	inline Float set1( float aX ) noexcept { return _mm_set1_ps( aX ); }
+
+	inline Float add( Float aA, Float aB ) noexcept { return _mm_add_ps( aA, aB ); }
+	inline Float sub( Float aA, Float aB ) noexcept { return _mm_sub_ps( aA, aB ); }
+	inline Float mul( Float aA, Float aB ) noexcept { return _mm_mul_ps( aA, aB ); }
+	inline Float div( Float aA, Float aB ) noexcept { return _mm_div_ps( aA, aB ); }
+	inline Float sqrt( Float aA ) noexcept { return _mm_sqrt_ps( aA ); }
+	inline Float rsqrt_estimate( Float aA ) noexcept { return _mm_rsqrt_ps( aA ); }
+
+	inline Float bit_and( Float aA, Float aB ) noexcept { return _mm_and_ps( aA, aB ); }
+	inline Float bit_andnot( Float aA, Float aB ) noexcept { return _mm_andnot_ps( aA, aB ); }
+	inline Float bit_or( Float aA, Float aB ) noexcept { return _mm_or_ps( aA, aB ); }
+	inline Float bit_xor( Float aA, Float aB ) noexcept { return _mm_xor_ps( aA, aB ); }
+
+	inline Float cmp_eq( Float aA, Float aB ) noexcept { return _mm_cmpeq_ps( aA, aB ); }
+	inline Float cmp_gt( Float aA, Float aB ) noexcept { return _mm_cmpgt_ps( aA, aB ); }
+	inline Float cmp_ge( Float aA, Float aB ) noexcept { return _mm_cmpge_ps( aA, aB ); }
+
+	inline Float truncate( Float aA ) noexcept { return _mm_cvtepi32_ps( _mm_cvttps_epi32( aA ) ); }
+	inline bool all_lanes( Float aMask ) noexcept { return 0xf == _mm_movemask_ps( aMask ); }
+	inline Float min( Float aA, Float aB ) noexcept { return _mm_min_ps( aA, aB ); }
+	inline Float max( Float aA, Float aB ) noexcept { return _mm_max_ps( aA, aB ); }
+
+	inline float hmin( Float aA ) noexcept
+	{
+		__m128 m = _mm_min_ps( aA, _mm_movehl_ps( aA, aA ) );
+		m = _mm_min_ss( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE(1,1,1,1) ) );
+		return _mm_cvtss_f32( m );
+	}
+	inline float hmax( Float aA ) noexcept
+	{
+		__m128 m = _mm_max_ps( aA, _mm_movehl_ps( aA, aA ) );
+		m = _mm_max_ss( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE(1,1,1,1) ) );
+		return _mm_cvtss_f32( m );
+	}
+#	endif
+
+	// Per-lane aMask ? aA : aB
+	inline Float select( Float aMask, Float aA, Float aB ) noexcept
+	{
+		return bit_or( bit_and( aMask, aA ), bit_andnot( aMask, aB ) );
+	}
+
+	// Reciprocal square root with one Newton-Raphson step. Same operations
+	// as FastMath::rsqrt() (see precision.hpp).
+	inline Float rsqrt( Float aA ) noexcept
+	{
+		Float const y = rsqrt_estimate( aA );
+		Float const yy = mul( mul( mul( set1( 0.5f ), aA ), y ), y );
+		return mul( y, sub( set1( 1.5f ), yy ) );
+	}
+}
+#endif // ~ VMLIB_SIMD_SSE
+
+#endif // SIMD_FLOAT_HPP_4B7E7313_A359_4457_A239_1FB46462976E
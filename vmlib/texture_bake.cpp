@@ -0,0 +1,613 @@
+#include "texture_bake.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+#include <cstring>
+
+#include "simd.hpp"
+
+namespace
+{
+	// sRGB transfer function (IEC 61966-2-1)
+	float srgb_decode_( float aS ) noexcept
+	{
+		return aS <= 0.04045f ? aS / 12.92f : std::pow( (aS + 0.055f) / 1.055f, 2.4f );
+	}
+	float srgb_encode_( float aL ) noexcept
+	{
+		return aL <= 0.0031308f ? aL * 12.92f : 1.055f * std::pow( aL, 1.f/2.4f ) - 0.055f;
+	}
+
+	// linear_to_srgb() looks the value up in steps of 1/65535, which is
+	// finer than the smallest sRGB step (about 1/3300, near black).
+	constexpr std::size_t kEncodeSteps_ = 65536;
+
+	struct SrgbTables_
+	{
+		float decode[256];
+		std::uint8_t encode[kEncodeSteps_];
+
+		SrgbTables_() noexcept
+		{
+			for( int i = 0; i < 256; ++i )
+				decode[i] = srgb_decode_( float(i) / 255.f );
+			for( std::size_t i = 0; i < kEncodeSteps_; ++i )
+				encode[i] = std::uint8_t(srgb_encode_( float(i) / float(kEncodeSteps_-1) ) * 255.f + 0.5f);
+		}
+	};
+
+	SrgbTables_ const& srgb_tables_() noexcept
+	{
+		static SrgbTables_ const tables;
+		return tables;
+	}
+
+
+	// Range fit: the extremes of the pixels projected onto the principal
+	// axis (power iteration on the covariance) through their mean.
+	template< std::size_t tN >
+	void range_fit_( float const (&aPixels)[16][tN], float (&aLo)[tN], float (&aHi)[tN] ) noexcept
+	{
+		float mean[tN] = {};
+		for( auto const& p : aPixels )
+		{
+			for( std::size_t c = 0; c < tN; ++c )
+				mean[c] += p[c];
+		}
+		for( auto& m : mean )
+			m /= 16.f;
+
+		float cov[tN][tN] = {};
+		for( auto const& p : aPixels )
+		{
+			for( std::size_t a = 0; a < tN; ++a )
+			{
+				for( std::size_t b = 0; b < tN; ++b )
+					cov[a][b] += (p[a] - mean[a]) * (p[b] - mean[b]);
+			}
+		}
+
+		// Start from the row of the channel that varies most
+		std::size_t widest = 0;
+		for( std::size_t c = 1; c < tN; ++c )
+		{
+			if( cov[c][c] > cov[widest][widest] )
+				widest = c;
+		}
+
+		std::copy( mean, mean + tN, aLo );
+		std::copy( mean, mean + tN, aHi );
+		if( cov[widest][widest] <= 0.f )
+			return; // a single colour
+
+		float axis[tN];
+		std::copy( cov[widest], cov[widest] + tN, axis );
+		for( int iter = 0; iter < 8; ++iter )
+		{
+			float next[tN] = {};
+			float scale = 0.f;
+			for( std::size_t a = 0; a < tN; ++a )
+			{
+				for( std::size_t b = 0; b < tN; ++b )
+					next[a] += cov[a][b] * axis[b];
+				scale = std::max( scale, std::abs( next[a] ) );
+			}
+			if( scale <= 0.f )
+				break;
+			for( std::size_t a = 0; a < tN; ++a )
+				axis[a] = next[a] / scale;
+		}
+
+		float axisLen2 = 0.f;
+		for( auto const a : axis )
+			axisLen2 += a * a;
+
+		float tmin = 0.f, tmax = 0.f;
+		for( auto const& p : aPixels )
+		{
+			float t = 0.f;
+			for( std::size_t c = 0; c < tN; ++c )
+				t += (p[c] - mean[c]) * axis[c];
+			tmin = std::min( tmin, t );
+			tmax = std::max( tmax, t );
+		}
+
+		for( std::size_t c = 0; c < tN; ++c )
+		{
+			aLo[c] = std::clamp( mean[c] + tmin / axisLen2 * axis[c], 0.f, 255.f );
+			aHi[c] = std::clamp( mean[c] + tmax / axisLen2 * axis[c], 0.f, 255.f );
+		}
+	}
+
+	// Least-squares endpoints for given interpolation weights (0: aLo, 1:
+	// aHi). False if the weights do not determine both endpoints.
+	template< std::size_t tN >
+	bool least_squares_( float const (&aPixels)[16][tN], float const (&aWeights)[16], float (&aLo)[tN], float (&aHi)[tN] ) noexcept
+	{
+		float aa = 0.f, ab = 0.f, bb = 0.f;
+		float ra[tN] = {}, rb[tN] = {};
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			float const w = aWeights[i], v = 1.f - w;
+			aa += v * v;
+			ab += v * w;
+			bb += w * w;
+			for( std::size_t c = 0; c < tN; ++c )
+			{
+				ra[c] += v * aPixels[i][c];
+				rb[c] += w * aPixels[i][c];
+			}
+		}
+
+		float const det = aa * bb - ab * ab;
+		if( std::abs( det ) < 1e-6f )
+			return false;
+
+		for( std::size_t c = 0; c < tN; ++c )
+		{
+			aLo[c] = std::clamp( (bb * ra[c] - ab * rb[c]) / det, 0.f, 255.f );
+			aHi[c] = std::clamp( (aa * rb[c] - ab * ra[c]) / det, 0.f, 255.f );
+		}
+		return true;
+	}
+
+	template< std::size_t tN >
+	void load_block_( std::uint8_t const* aPixels, float (&aOut)[16][tN] ) noexcept
+	{
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			for( std::size_t c = 0; c < tN; ++c )
+				aOut[i][c] = float(aPixels[4*i + c]);
+		}
+	}
+
+	template< std::size_t tN >
+	float distance2_( float const (&aPixel)[tN], int const* aColor ) noexcept
+	{
+		float d2 = 0.f;
+		for( std::size_t c = 0; c < tN; ++c )
+		{
+			float const d = aPixel[c] - float(aColor[c]);
+			d2 += d * d;
+		}
+		return d2;
+	}
+
+
+	// BC1
+	std::uint16_t pack_565_( float const (&aColor)[3] ) noexcept
+	{
+		auto const q = [] (float aV, int aMax) { return unsigned(aV * float(aMax) / 255.f + 0.5f); };
+		return std::uint16_t((q( aColor[0], 31 ) << 11) | (q( aColor[1], 63 ) << 5) | q( aColor[2], 31 ));
+	}
+
+	void unpack_565_( std::uint16_t aColor, int (&aOut)[3] ) noexcept
+	{
+		int const r = (aColor >> 11) & 31, g = (aColor >> 5) & 63, b = aColor & 31;
+		aOut[0] = (r << 3) | (r >> 2);
+		aOut[1] = (g << 2) | (g >> 4);
+		aOut[2] = (b << 3) | (b >> 2);
+	}
+
+	void bc1_palette_( std::uint16_t aC0, std::uint16_t aC1, int (&aPalette)[4][3] ) noexcept
+	{
+		unpack_565_( aC0, aPalette[0] );
+		unpack_565_( aC1, aPalette[1] );
+		for( std::size_t c = 0; c < 3; ++c )
+		{
+			if( aC0 > aC1 )
+			{
+				aPalette[2][c] = (2*aPalette[0][c] + aPalette[1][c]) / 3;
+				aPalette[3][c] = (aPalette[0][c] + 2*aPalette[1][c]) / 3;
+			}
+			else
+			{
+				aPalette[2][c] = (aPalette[0][c] + aPalette[1][c]) / 2;
+				aPalette[3][c] = 0;
+			}
+		}
+	}
+
+	// Weight of aHi (c1) for each index in four colour mode
+	constexpr float kBc1Weights_[4] = { 0.f, 1.f, 1.f/3.f, 2.f/3.f };
+
+	struct Bc1Fit_
+	{
+		std::uint16_t c0, c1;
+		std::uint8_t indices[16];
+		float error;
+	};
+
+	// Indices for the endpoints (from aLo to aHi); keeps four colour mode
+	// (c0 > c1) unless both endpoints are the same.
+	Bc1Fit_ fit_bc1_( float const (&aPixels)[16][3], float const (&aLo)[3], float const (&aHi)[3] ) noexcept
+	{
+		Bc1Fit_ fit{ pack_565_( aHi ), pack_565_( aLo ), {}, 0.f };
+		if( fit.c0 < fit.c1 )
+			std::swap( fit.c0, fit.c1 );
+
+		int palette[4][3];
+		bc1_palette_( fit.c0, fit.c1, palette );
+
+		std::size_t const entries = fit.c0 > fit.c1 ? 4 : 1;
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			float best = distance2_( aPixels[i], palette[0] );
+			fit.indices[i] = 0;
+			for( std::size_t e = 1; e < entries; ++e )
+			{
+				float const d2 = distance2_( aPixels[i], palette[e] );
+				if( d2 < best )
+				{
+					best = d2;
+					fit.indices[i] = std::uint8_t(e);
+				}
+			}
+			fit.error += best;
+		}
+		return fit;
+	}
+
+
+	// BC7 mode 6
+	constexpr int kBc7Weights_[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct Bc7Endpoint_
+	{
+		int q[4]; // 7 bits
+		int p;    // p-bit
+	};
+
+	// The 7-bit values and p-bit closest to the 8-bit endpoint
+	Bc7Endpoint_ quantize_bc7_( float const (&aColor)[4] ) noexcept
+	{
+		Bc7Endpoint_ best{};
+		float bestError = -1.f;
+		for( int p = 0; p < 2; ++p )
+		{
+			Bc7Endpoint_ e{ {}, p };
+			float error = 0.f;
+			for( std::size_t c = 0; c < 4; ++c )
+			{
+				e.q[c] = std::clamp( int(std::floor( (aColor[c] - float(p)) / 2.f + 0.5f )), 0, 127 );
+				float const d = float(2*e.q[c] + p) - aColor[c];
+				error += d * d;
+			}
+			if( bestError < 0.f || error < bestError )
+			{
+				best = e;
+				bestError = error;
+			}
+		}
+		return best;
+	}
+
+	struct Bc7Fit_
+	{
+		Bc7Endpoint_ e0, e1;
+		std::uint8_t indices[16];
+		float error;
+	};
+
+	Bc7Fit_ fit_bc7_( float const (&aPixels)[16][4], float const (&aLo)[4], float const (&aHi)[4] ) noexcept
+	{
+		Bc7Fit_ fit{ quantize_bc7_( aLo ), quantize_bc7_( aHi ), {}, 0.f };
+
+		int palette[16][4];
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			for( std::size_t c = 0; c < 4; ++c )
+			{
+				int const a = 2*fit.e0.q[c] + fit.e0.p, b = 2*fit.e1.q[c] + fit.e1.p;
+				palette[i][c] = ((64 - kBc7Weights_[i]) * a + kBc7Weights_[i] * b + 32) >> 6;
+			}
+		}
+
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			float best = distance2_( aPixels[i], palette[0] );
+			fit.indices[i] = 0;
+			for( std::size_t e = 1; e < 16; ++e )
+			{
+				float const d2 = distance2_( aPixels[i], palette[e] );
+				if( d2 < best )
+				{
+					best = d2;
+					fit.indices[i] = std::uint8_t(e);
+				}
+			}
+			fit.error += best;
+		}
+		return fit;
+	}
+
+	// Bits of a block, least significant bit of byte 0 first
+	struct BitWriter_
+	{
+		std::uint8_t* out;
+		std::size_t bit;
+
+		void put( unsigned aValue, std::size_t aBits ) noexcept
+		{
+			for( std::size_t i = 0; i < aBits; ++i, ++bit )
+			{
+				if( (aValue >> i) & 1u )
+					out[bit >> 3] |= std::uint8_t(1u << (bit & 7));
+			}
+		}
+	};
+
+	struct BitReader_
+	{
+		std::uint8_t const* in;
+		std::size_t bit;
+
+		unsigned get( std::size_t aBits ) noexcept
+		{
+			unsigned ret = 0;
+			for( std::size_t i = 0; i < aBits; ++i, ++bit )
+				ret |= unsigned((in[bit >> 3] >> (bit & 7)) & 1u) << i;
+			return ret;
+		}
+	};
+
+
+#	if defined(VMLIB_SIMD_SSE)
+	inline
+	__m128 load_linear_( SrgbTables_ const& aTables, std::uint8_t const* aPixel ) noexcept
+	{
+		return _mm_setr_ps( aTables.decode[aPixel[0]], aTables.decode[aPixel[1]], aTables.decode[aPixel[2]], float(aPixel[3]) );
+	}
+#	endif // ~ VMLIB_SIMD_SSE
+}
+
+std::size_t mip_level_count( std::size_t aWidth, std::size_t aHeight ) noexcept
+{
+	std::size_t levels = 1;
+	while( aWidth > 1 || aHeight > 1 )
+	{
+		aWidth = mip_extent( aWidth );
+		aHeight = mip_extent( aHeight );
+		++levels;
+	}
+	return levels;
+}
+
+std::size_t compressed_size( BlockFormat aFormat, std::size_t aWidth, std::size_t aHeight ) noexcept
+{
+	return block_count( aWidth ) * block_count( aHeight ) * block_bytes( aFormat );
+}
+
+float srgb_to_linear( std::uint8_t aValue ) noexcept
+{
+	return srgb_tables_().decode[aValue];
+}
+
+std::uint8_t linear_to_srgb( float aValue ) noexcept
+{
+	float const clamped = std::clamp( aValue, 0.f, 1.f );
+	return srgb_tables_().encode[std::size_t(clamped * float(kEncodeSteps_-1) + 0.5f)];
+}
+
+void downsample_srgb( std::uint8_t const* aSrc, std::size_t aSrcWidth, std::size_t aSrcHeight, std::uint8_t* aDst, std::size_t aFirstRow, std::size_t aRowCount ) noexcept
+{
+	assert( aSrc && aDst );
+
+	std::size_t const width = mip_extent( aSrcWidth );
+	assert( aFirstRow + aRowCount <= mip_extent( aSrcHeight ) );
+
+	SrgbTables_ const& tables = srgb_tables_();
+
+	// Colour: average of the linear values, as a table index. Alpha: plain
+	// average.
+	constexpr float kColorScale = 0.25f * float(kEncodeSteps_-1);
+	constexpr float kAlphaScale = 0.25f;
+
+	for( std::size_t y = aFirstRow; y < aFirstRow + aRowCount; ++y )
+	{
+		std::uint8_t const* row0 = aSrc + 4 * aSrcWidth * std::min( 2*y, aSrcHeight-1 );
+		std::uint8_t const* row1 = aSrc + 4 * aSrcWidth * std::min( 2*y+1, aSrcHeight-1 );
+		std::uint8_t* out = aDst + 4 * width * y;
+
+		for( std::size_t x = 0; x < width; ++x, out += 4 )
+		{
+			std::size_t const x0 = 4 * std::min( 2*x, aSrcWidth-1 );
+			std::size_t const x1 = 4 * std::min( 2*x+1, aSrcWidth-1 );
+
+#			if defined(VMLIB_SIMD_SSE)
+			__m128 const sum = _mm_add_ps(
+				_mm_add_ps( load_linear_( tables, row0 + x0 ), load_linear_( tables, row0 + x1 ) ),
+				_mm_add_ps( load_linear_( tables, row1 + x0 ), load_linear_( tables, row1 + x1 ) )
+			);
+			__m128 const scaled = _mm_add_ps( _mm_mul_ps( sum, _mm_setr_ps( kColorScale, kColorScale, kColorScale, kAlphaScale ) ), _mm_set1_ps( 0.5f ) );
+
+			alignas(16) std::int32_t idx[4];
+			_mm_store_si128( reinterpret_cast<__m128i*>(idx), _mm_cvttps_epi32( scaled ) );
+
+			out[0] = tables.encode[idx[0]];
+			out[1] = tables.encode[idx[1]];
+			out[2] = tables.encode[idx[2]];
+			out[3] = std::uint8_t(idx[3]);
+#			else // scalar
+			for( std::size_t c = 0; c < 3; ++c )
+			{
+				float const sum = (tables.decode[row0[x0+c]] + tables.decode[row0[x1+c]]) + (tables.decode[row1[x0+c]] + tables.decode[row1[x1+c]]);
+				out[c] = tables.encode[std::size_t(sum * kColorScale + 0.5f)];
+			}
+
+			float const alpha = (float(row0[x0+3]) + float(row0[x1+3])) + (float(row1[x0+3]) + float(row1[x1+3]));
+			out[3] = std::uint8_t(alpha * kAlphaScale + 0.5f);
+#			endif // ~ VMLIB_SIMD_SSE
+		}
+	}
+}
+
+void encode_bc1_block( std::uint8_t const* aPixels, std::uint8_t* aBlock ) noexcept
+{
+	float pixels[16][3];
+	load_block_( aPixels, pixels );
+
+	float lo[3], hi[3];
+	range_fit_( pixels, lo, hi );
+	Bc1Fit_ fit = fit_bc1_( pixels, lo, hi );
+
+	// Refine with the weights of the chosen indices
+	if( fit.c0 > fit.c1 && fit.error > 0.f )
+	{
+		// (lo: c0, hi: c1; the order does not matter to fit_bc1_())
+		float weights[16];
+		for( std::size_t i = 0; i < 16; ++i )
+			weights[i] = kBc1Weights_[fit.indices[i]];
+
+		if( least_squares_( pixels, weights, lo, hi ) )
+		{
+			Bc1Fit_ const refined = fit_bc1_( pixels, lo, hi );
+			if( refined.error < fit.error )
+				fit = refined;
+		}
+	}
+
+	unsigned indices = 0;
+	for( std::size_t i = 0; i < 16; ++i )
+		indices |= unsigned(fit.indices[i]) << (2*i);
+
+	aBlock[0] = std::uint8_t(fit.c0);
+	aBlock[1] = std::uint8_t(fit.c0 >> 8);
+	aBlock[2] = std::uint8_t(fit.c1);
+	aBlock[3] = std::uint8_t(fit.c1 >> 8);
+	for( std::size_t i = 0; i < 4; ++i )
+		aBlock[4+i] = std::uint8_t(indices >> (8*i));
+}
+
+void encode_bc7_block( std::uint8_t const* aPixels, std::uint8_t* aBlock ) noexcept
+{
+	float pixels[16][4];
+	load_block_( aPixels, pixels );
+
+	float lo[4], hi[4];
+	range_fit_( pixels, lo, hi );
+	Bc7Fit_ fit = fit_bc7_( pixels, lo, hi );
+
+	if( fit.error > 0.f )
+	{
+		float weights[16];
+		for( std::size_t i = 0; i < 16; ++i )
+			weights[i] = float(kBc7Weights_[fit.indices[i]]) / 64.f;
+
+		if( least_squares_( pixels, weights, lo, hi ) )
+		{
+			Bc7Fit_ const refined = fit_bc7_( pixels, lo, hi );
+			if( refined.error < fit.error )
+				fit = refined;
+		}
+	}
+
+	// The first index has an implicit zero top bit
+	if( fit.indices[0] >= 8 )
+	{
+		std::swap( fit.e0, fit.e1 );
+		for( auto& index : fit.indices )
+			index = std::uint8_t(15 - index);
+	}
+
+	std::memset( aBlock, 0, 16 );
+	BitWriter_ out{ aBlock, 0 };
+
+	out.put( 1u << 6, 7 ); // mode 6
+	for( std::size_t c = 0; c < 4; ++c )
+	{
+		out.put( unsigned(fit.e0.q[c]), 7 );
+		out.put( unsigned(fit.e1.q[c]), 7 );
+	}
+	out.put( unsigned(fit.e0.p), 1 );
+	out.put( unsigned(fit.e1.p), 1 );
+
+	out.put( fit.indices[0], 3 );
+	for( std::size_t i = 1; i < 16; ++i )
+		out.put( fit.indices[i], 4 );
+
+	assert( 128 == out.bit );
+}
+
+void decode_bc1_block( std::uint8_t const* aBlock, std::uint8_t* aPixels ) noexcept
+{
+	std::uint16_t const c0 = std::uint16_t(aBlock[0] | (aBlock[1] << 8));
+	std::uint16_t const c1 = std::uint16_t(aBlock[2] | (aBlock[3] << 8));
+
+	int palette[4][3];
+	bc1_palette_( c0, c1, palette );
+
+	for( std::size_t i = 0; i < 16; ++i )
+	{
+		unsigned const index = (aBlock[4 + i/4] >> (2*(i%4))) & 3u;
+		for( std::size_t c = 0; c < 3; ++c )
+			aPixels[4*i + c] = std::uint8_t(palette[index][c]);
+
+		// Index 3 is transparent black in three colour mode
+		aPixels[4*i + 3] = (c0 <= c1 && 3 == index) ? 0 : 255;
+	}
+}
+
+void decode_bc7_block( std::uint8_t const* aBlock, std::uint8_t* aPixels ) noexcept
+{
+	BitReader_ in{ aBlock, 0 };
+	if( (1u << 6) != in.get( 7 ) )
+	{
+		assert( false && "decode_bc7_block(): only mode 6 is supported" );
+		std::memset( aPixels, 0, kBlockPixelBytes );
+		return;
+	}
+
+	unsigned q[2][4];
+	for( std::size_t c = 0; c < 4; ++c )
+	{
+		q[0][c] = in.get( 7 );
+		q[1][c] = in.get( 7 );
+	}
+	unsigned const p0 = in.get( 1 ), p1 = in.get( 1 );
+
+	for( std::size_t i = 0; i < 16; ++i )
+	{
+		unsigned const index = in.get( 0 == i ? 3 : 4 );
+		int const w = kBc7Weights_[index];
+		for( std::size_t c = 0; c < 4; ++c )
+		{
+			int const a = int(2*q[0][c] + p0), b = int(2*q[1][c] + p1);
+			aPixels[4*i + c] = std::uint8_t(((64 - w) * a + w * b + 32) >> 6);
+		}
+	}
+}
+
+void encode_blocks( BlockFormat aFormat, std::uint8_t const* aSrc, std::size_t aWidth, std::size_t aHeight, std::uint8_t* aDst, std::size_t aFirstBlockRow, std::size_t aBlockRowCount ) noexcept
+{
+	assert( aSrc && aDst );
+	assert( aFirstBlockRow + aBlockRowCount <= block_count( aHeight ) );
+
+	std::size_t const blocksX = block_count( aWidth );
+	std::size_t const bytes = block_bytes( aFormat );
+
+	std::uint8_t pixels[kBlockPixelBytes];
+	for( std::size_t by = aFirstBlockRow; by < aFirstBlockRow + aBlockRowCount; ++by )
+	{
+		for( std::size_t bx = 0; bx < blocksX; ++bx )
+		{
+			for( std::size_t j = 0; j < 4; ++j )
+			{
+				std::size_t const sy = std::min( 4*by + j, aHeight-1 );
+				for( std::size_t i = 0; i < 4; ++i )
+				{
+					std::size_t const sx = std::min( 4*bx + i, aWidth-1 );
+					std::memcpy( pixels + 16*j + 4*i, aSrc + 4*(sy*aWidth + sx), 4 );
+				}
+			}
+
+			std::uint8_t* const block = aDst + (by * blocksX + bx) * bytes;
+			if( BlockFormat::bc1 == aFormat )
+				encode_bc1_block( pixels, block );
+			else
+				encode_bc7_block( pixels, block );
+		}
+	}
+}
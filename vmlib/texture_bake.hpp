@@ -0,0 +1,86 @@
+#ifndef TEXTURE_BAKE_HPP_16AE7E90_184B_48AE_8CA4_AD86E68DE2DD
+#define TEXTURE_BAKE_HPP_16AE7E90_184B_48AE_8CA4_AD86E68DE2DD
+
+#include <cstddef>
+#include <cstdint>
+
+/* Texture baking: sRGB mipmaps and block compression
+ *
+ * Images are RGBA8, sRGB colour with linear alpha, rows tightly packed.
+ * mip_extent() gives the size of the next level (half, at least 1), as in
+ * OpenGL.
+ *
+ * downsample_srgb() makes the next level with a 2x2 box filter in linear
+ * space: the colour is converted from sRGB, averaged and converted back, so
+ * that the smaller levels do not get darker (as they do when the sRGB
+ * values are averaged directly). The last column/row of odd sizes is
+ * dropped, except for sizes of 1. It fills the destination rows
+ * [aFirstRow, aFirstRow+aRowCount) only, so that a level can be split
+ * between threads.
+ *
+ * The block encoders compress one 4x4 block (64 bytes, row by row):
+ *   - BC1: two RGB565 endpoints and 2-bit indices, 8 bytes. Opaque (four
+ *     colour mode); alpha is ignored.
+ *   - BC7: mode 6 only, i.e., RGBA 7.7.7.7 endpoints with one p-bit each
+ *     and 4-bit indices, 16 bytes.
+ * Both fit the endpoints to the principal axis of the block's colours
+ * (range fit), pick the nearest palette entry for each pixel, then refine
+ * the endpoints once by least squares. Errors are measured on the stored
+ * (sRGB) values. encode_blocks() compresses the block rows [aFirstBlockRow,
+ * aFirstBlockRow+aBlockRowCount) of an image; blocks that reach past the
+ * edge repeat the last column/row. The decoders are the inverse (BC7: mode
+ * 6 blocks only).
+ */
+enum class BlockFormat : std::uint8_t
+{
+	bc1,
+	bc7
+};
+
+constexpr std::size_t kBlockPixelBytes = 4*4*4;
+
+constexpr std::size_t block_bytes( BlockFormat aFormat ) noexcept
+{
+	return BlockFormat::bc1 == aFormat ? 8 : 16;
+}
+
+constexpr std::size_t block_count( std::size_t aPixels ) noexcept
+{
+	return (aPixels + 3) / 4;
+}
+
+constexpr std::size_t mip_extent( std::size_t aExtent ) noexcept
+{
+	return aExtent > 1 ? aExtent / 2 : 1;
+}
+
+// Number of levels down to 1x1
+std::size_t mip_level_count( std::size_t aWidth, std::size_t aHeight ) noexcept;
+
+// Bytes of one level of aWidth x aHeight pixels
+std::size_t compressed_size( BlockFormat, std::size_t aWidth, std::size_t aHeight ) noexcept;
+
+float srgb_to_linear( std::uint8_t ) noexcept;
+std::uint8_t linear_to_srgb( float ) noexcept; // clamps to [0,1]
+
+void downsample_srgb(
+	std::uint8_t const* aSrc, std::size_t aSrcWidth, std::size_t aSrcHeight,
+	std::uint8_t* aDst,
+	std::size_t aFirstRow, std::size_t aRowCount
+) noexcept;
+
+void encode_bc1_block( std::uint8_t const* aPixels, std::uint8_t* aBlock ) noexcept;
+void encode_bc7_block( std::uint8_t const* aPixels, std::uint8_t* aBlock ) noexcept;
+
+void decode_bc1_block( std::uint8_t const* aBlock, std::uint8_t* aPixels ) noexcept;
+void decode_bc7_block( std::uint8_t const* aBlock, std::uint8_t* aPixels ) noexcept;
+
+// aDst is the start of the level (compressed_size() bytes)
+void encode_blocks(
+	BlockFormat,
+	std::uint8_t const* aSrc, std::size_t aWidth, std::size_t aHeight,
+	std::uint8_t* aDst,
+	std::size_t aFirstBlockRow, std::size_t aBlockRowCount
+) noexcept;
+
+#endif // TEXTURE_BAKE_HPP_16AE7E90_184B_48AE_8CA4_AD86E68DE2DD
@@ -0,0 +1,114 @@
+#ifndef TRANSFORM_HPP_425F6273_05E2_4E1E_9124_6A48239749C5
+#define TRANSFORM_HPP_425F6273_05E2_4E1E_9124_6A48239749C5
+
+#include "vec3.hpp"
+#include "quat.hpp"
+#include "mat44.hpp"
+
+/** Transform: translation, rotation and scale
+ *
+ * Compact representation of an affine transformation that first scales
+ * (component-wise by s), then rotates (by r) and finally translates (by t).
+ * That is, a Transform corresponds to the matrix
+ *   make_translation( t ) * to_mat44( r ) * make_scaling( s.x, s.y, s.z )
+ *
+ * Transforms are cheap to compose, invert and interpolate. Keep animated
+ * objects and cameras in this form and use to_mat44() once per object and
+ * frame to get the matrix for rendering.
+ *
+ * Note: a Transform cannot represent shearing. Composing (or inverting)
+ * transforms with non-uniform scaling and rotation can introduce shearing,
+ * which is dropped. The results are exact if the scaling of the left-hand
+ * transform (or of the inverted transform) is uniform.
+ */
+struct Transform
+{
+	Vec3f t;
+	Quatf r;
+	Vec3f s;
+};
+
+constexpr Transform kIdentityTransform = {
+	{ 0.f, 0.f, 0.f },
+	kIdentityQuatf,
+	{ 1.f, 1.f, 1.f }
+};
+
+// Common operators for Transform.
+
+// Apply the transformation to the point aRight.
+constexpr
+Vec3f operator*( Transform const& aLeft, Vec3f aRight ) noexcept
+{
+	Vec3f const scaled{ aLeft.s.x * aRight.x, aLeft.s.y * aRight.y, aLeft.s.z * aRight.z };
+	return aLeft.t + aLeft.r * scaled;
+}
+
+// Compose transformations: (aLeft * aRight) * p == aLeft * (aRight * p). See
+// the note on shearing above.
+constexpr
+Transform operator*( Transform const& aLeft, Transform const& aRight ) noexcept
+{
+	return Transform{
+		aLeft * aRight.t,
+		aLeft.r * aRight.r,
+		Vec3f{ aLeft.s.x * aRight.s.x, aLeft.s.y * aRight.s.y, aLeft.s.z * aRight.s.z }
+	};
+}
+
+// Functions:
+
+// Inverse transformation. See the note on shearing above.
+constexpr
+Transform invert( Transform const& aT ) noexcept
+{
+	Quatf const r = conjugate( aT.r );
+	Vec3f const s{ 1.f / aT.s.x, 1.f / aT.s.y, 1.f / aT.s.z };
+	Vec3f const t = r * -aT.t;
+
+	return Transform{
+		Vec3f{ s.x * t.x, s.y * t.y, s.z * t.z },
+		r,
+		s
+	};
+}
+
+// Interpolate between two transformations. Translation and scale are
+// interpolated linearly, rotation with slerp().
+inline
+Transform interpolate( Transform const& aFrom, Transform const& aTo, float aT ) noexcept
+{
+	return Transform{
+		aFrom.t + aT * (aTo.t - aFrom.t),
+		slerp( aFrom.r, aTo.r, aT ),
+		aFrom.s + aT * (aTo.s - aFrom.s)
+	};
+}
+
+// As interpolate(), but uses nlerp() for the rotation.
+inline
+Transform interpolate_fast( Transform const& aFrom, Transform const& aTo, float aT ) noexcept
+{
+	return Transform{
+		aFrom.t + aT * (aTo.t - aFrom.t),
+		nlerp( aFrom.r, aTo.r, aT ),
+		aFrom.s + aT * (aTo.s - aFrom.s)
+	};
+}
+
+// Matrix for the transformation. Built directly from the rotation matrix,
+// without any matrix-matrix products.
+constexpr
+Mat44f to_mat44( Transform const& aT ) noexcept
+{
+	Mat33f const r = to_mat33( aT.r );
+
+	return Mat44f{ {
+		r.v[0] * aT.s.x, r.v[1] * aT.s.y, r.v[2] * aT.s.z, aT.t.x,
+		r.v[3] * aT.s.x, r.v[4] * aT.s.y, r.v[5] * aT.s.z, aT.t.y,
+		r.v[6] * aT.s.x, r.v[7] * aT.s.y, r.v[8] * aT.s.z, aT.t.z,
+		0.f, 0.f, 0.f, 1.f
+	} };
+}
+
+#endif // TRANSFORM_HPP_425F6273_05E2_4E1E_9124_6A48239749C5
@@ -0,0 +1,225 @@
+#include "trig.hpp"
+
+#include <limits>
+
+#include <cmath>
+#include <cstdint>
+
+#include "simd.hpp"
+#include "simd_float.hpp"
+
+namespace
+{
+	// Range reduction for sin/cos: pi/4 split into three parts, such that
+	// j * kDP1_ and j * kDP2_ are exact for the j that occur in practice.
+	// Larger angles are reduced in double first (see sincos_large_()); this
+	// also keeps j well within the range of an int32.
+	constexpr float kMaxReducedAngle_ = 8192.f;
+	constexpr double kTwoPi_ = 6.283185307179586;
+	constexpr float kFourOverPi_ = 1.27323954473516f;
+	constexpr float kDP1_ = 0.78515625f;
+	constexpr float kDP2_ = 2.4187564849853515625e-4f;
+	constexpr float kDP3_ = 3.77489497744594108e-8f;
+
+	// sin(z) ~ z + z^3 * P(z^2) and cos(z) ~ 1 - z^2/2 + z^4 * Q(z^2) for
+	// z in [-pi/4, pi/4]
+	constexpr float kSin0_ = -1.9515295891e-4f;
+	constexpr float kSin1_ = 8.3321608736e-3f;
+	constexpr float kSin2_ = -1.6666654611e-1f;
+
+	constexpr float kCos0_ = 2.443315711809948e-5f;
+	constexpr float kCos1_ = -1.388731625493765e-3f;
+	constexpr float kCos2_ = 4.166664568298827e-2f;
+
+	// atan: the argument is reduced to [0, tan(pi/8)]
+	constexpr float kTan3PiOver8_ = 2.414213562373095f;
+	constexpr float kTanPiOver8_ = 0.4142135623730950f;
+	constexpr float kPiOver2_ = 1.5707963267948966f;
+	constexpr float kPiOver4_ = 0.7853981633974483f;
+
+	constexpr float kAtan0_ = 8.05374449538e-2f;
+	constexpr float kAtan1_ = -1.38776856032e-1f;
+	constexpr float kAtan2_ = 1.99777106478e-1f;
+	constexpr float kAtan3_ = -3.33329491539e-1f;
+
+	// Scalar atan; see atan_batch()
+	float atan_( float aX ) noexcept
+	{
+		float const x = std::abs( aX );
+		bool const big = x > kTan3PiOver8_;
+		bool const mid = x > kTanPiOver8_;
+
+		// atan(x) = pi/2 + atan(-1/x) = pi/4 + atan((x-1)/(x+1))
+		float const num = big ? -1.f : (mid ? x - 1.f : x);
+		float const den = big ? x : (mid ? x + 1.f : 1.f);
+		float const y0 = big ? kPiOver2_ : (mid ? kPiOver4_ : 0.f);
+
+		float const t = num / den;
+		float const z = t * t;
+
+		float y = kAtan0_ * z;
+		y = (y + kAtan1_) * z;
+		y = (y + kAtan2_) * z;
+		y = (y + kAtan3_) * z;
+		y = y * t + t;
+
+		return std::copysign( y + y0, aX );
+	}
+
+	// sincos() of |aAngle| > kMaxReducedAngle_, infinity or NaN
+	SinCosf sincos_large_( float aAngle ) noexcept
+	{
+		if( !std::isfinite( aAngle ) )
+			return SinCosf{ std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN() };
+
+		// Exact remainder of the (exact) double of the angle; the error is
+		// that of kTwoPi_ times the number of turns.
+		return sincos( float(std::remainder( double(aAngle), kTwoPi_ )) );
+	}
+}
+
+SinCosf sincos( float aAngle ) noexcept
+{
+	float const x = std::abs( aAngle );
+	if( !(x <= kMaxReducedAngle_) ) // also NaN
+		return sincos_large_( aAngle );
+
+	// Octant, rounded up to an even number: x = j * pi/4 + z
+	float j = float(std::int32_t( x * kFourOverPi_ ));
+	j = j + (j - 2.f * float(std::int32_t( j * 0.5f )));
+
+	float const q = j - 8.f * float(std::int32_t( j * 0.125f ));
+
+	float const z = ((x - j * kDP1_) - j * kDP2_) - j * kDP3_;
+	float const zz = z * z;
+
+	float s = kSin0_ * zz;
+	s = (s + kSin1_) * zz;
+	s = (s + kSin2_) * zz;
+	s = s * z + z;
+
+	float c = kCos0_ * zz;
+	c = (c + kCos1_) * zz;
+	c = (c + kCos2_) * zz;
+	c = c * zz - 0.5f * zz + 1.f;
+
+	// q is 0, 2, 4 or 6. Shifting by pi/2 swaps sin and cos.
+	bool const swap = 2.f == q || 6.f == q;
+	float rs = swap ? c : s;
+	float rc = swap ? s : c;
+
+	if( q >= 4.f )
+		rs = -rs;
+	if( 2.f == q || 4.f == q )
+		rc = -rc;
+	if( std::signbit( aAngle ) )
+		rs = -rs;
+
+	return SinCosf{ rs, rc };
+}
+
+void sincos_batch( float const* aAngles, std::size_t aCount, float* aSin, float* aCos ) noexcept
+{
+	std::size_t i = 0;
+
+#	if defined(VMLIB_SIMD_SSE)
+	using namespace simd;
+
+	Float const signBit = set1( -0.f );
+	Float const two = set1( 2.f ), four = set1( 4.f ), six = set1( 6.f );
+
+	for( ; i + kWidth <= aCount; i += kWidth )
+	{
+		Float const a = loadu( aAngles + i );
+		Float const x = bit_andnot( signBit, a );
+
+		// Large angles, infinity or NaN: the scalar version handles these
+		if( !all_lanes( cmp_ge( set1( kMaxReducedAngle_ ), x ) ) )
+		{
+			for( std::size_t k = i; k < i + kWidth; ++k )
+			{
+				SinCosf const sc = sincos( aAngles[k] );
+				aSin[k] = sc.sin;
+				aCos[k] = sc.cos;
+			}
+			continue;
+		}
+
+		Float j = truncate( mul( x, set1( kFourOverPi_ ) ) );
+		j = add( j, sub( j, mul( two, truncate( mul( j, set1( 0.5f ) ) ) ) ) );
+
+		Float const q = sub( j, mul( set1( 8.f ), truncate( mul( j, set1( 0.125f ) ) ) ) );
+
+		Float z = sub( x, mul( j, set1( kDP1_ ) ) );
+		z = sub( z, mul( j, set1( kDP2_ ) ) );
+		z = sub( z, mul( j, set1( kDP3_ ) ) );
+		Float const zz = mul( z, z );
+
+		Float s = mul( set1( kSin0_ ), zz );
+		s = mul( add( s, set1( kSin1_ ) ), zz );
+		s = mul( add( s, set1( kSin2_ ) ), zz );
+		s = add( mul( s, z ), z );
+
+		Float c = mul( set1( kCos0_ ), zz );
+		c = mul( add( c, set1( kCos1_ ) ), zz );
+		c = mul( add( c, set1( kCos2_ ) ), zz );
+		c = add( sub( mul( c, zz ), mul( set1( 0.5f ), zz ) ), set1( 1.f ) );
+
+		Float const swap = bit_or( cmp_eq( q, two ), cmp_eq( q, six ) );
+		Float rs = select( swap, c, s );
+		Float rc = select( swap, s, c );
+
+		Float const negS = bit_xor( bit_and( cmp_ge( q, four ), signBit ), bit_and( a, signBit ) );
+		Float const negC = bit_and( bit_or( cmp_eq( q, two ), cmp_eq( q, four ) ), signBit );
+
+		storeu( aSin + i, bit_xor( rs, negS ) );
+		storeu( aCos + i, bit_xor( rc, negC ) );
+	}
+#	endif // ~ VMLIB_SIMD_SSE
+
+	for( ; i < aCount; ++i )
+	{
+		SinCosf const sc = sincos( aAngles[i] );
+		aSin[i] = sc.sin;
+		aCos[i] = sc.cos;
+	}
+}
+
+void atan_batch( float const* aX, std::size_t aCount, float* aOut ) noexcept
+{
+	std::size_t i = 0;
+
+#	if defined(VMLIB_SIMD_SSE)
+	using namespace simd;
+
+	Float const signBit = set1( -0.f );
+	Float const one = set1( 1.f );
+
+	for( ; i + kWidth <= aCount; i += kWidth )
+	{
+		Float const a = loadu( aX + i );
+		Float const x = bit_andnot( signBit, a );
+
+		Float const big = cmp_gt( x, set1( kTan3PiOver8_ ) );
+		Float const mid = cmp_gt( x, set1( kTanPiOver8_ ) );
+
+		Float const num = select( big, set1( -1.f ), select( mid, sub( x, one ), x ) );
+		Float const den = select( big, x, select( mid, add( x, one ), one ) );
+		Float const y0 = select( big, set1( kPiOver2_ ), bit_and( mid, set1( kPiOver4_ ) ) );
+
+		Float const t = div( num, den );
+		Float const z = mul( t, t );
+
+		Float y = mul( set1( kAtan0_ ), z );
+		y = mul( add( y, set1( kAtan1_ ) ), z );
+		y = mul( add( y, set1( kAtan2_ ) ), z );
+		y = mul( add( y, set1( kAtan3_ ) ), z );
+		y = add( mul( y, t ), t );
+
+		storeu( aOut + i, bit_xor( add( y, y0 ), bit_and( a, signBit ) ) );
+	}
+#	endif // ~ VMLIB_SIMD_SSE
+
+	for( ; i < aCount; ++i )
+		aOut[i] = atan_( aX[i] );
+}
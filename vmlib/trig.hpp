@@ -0,0 +1,50 @@
+#ifndef TRIG_HPP_AF0A24C7_B3D8_4B31_B605_E6ACA73DAD50
+#define TRIG_HPP_AF0A24C7_B3D8_4B31_B605_E6ACA73DAD50
+
+#include <cstddef>
+
+/* Trigonometric functions
+ *
+ * Polynomial approximations of sin, cos and atan (after the Cephes library),
+ * in a scalar version and in batched versions that compute many values at
+ * once with SIMD (see simd.hpp). The batched versions give exactly the same
+ * results as the scalar ones.
+ *
+ * These are meant for procedural generation (e.g., the angles around a
+ * cylinder) and animation, where many angles are needed at once. There, the
+ * batched versions are 6-25 times faster than calling the standard library
+ * functions in a loop. For a single angle, std::sin()/std::cos() are faster
+ * (GCC merges the two into one sincosf() call); sincos() is mainly provided
+ * as reference for the batched versions and for convenience.
+ *
+ * Error, measured against the correctly rounded result (see
+ * vmlib-test/trig.cpp):
+ *   sin, cos : absolute error at most 1.2e-7 for |x| <= 8192. Larger
+ *              angles are first reduced modulo 2pi in double precision
+ *              (slower; the batched versions fall back to the scalar one
+ *              for them), with an absolute error of at most
+ *              3e-7 + 5e-17 |x|. Infinity and NaN give NaN.
+ *   atan     : at most 3 ULP for all inputs (including +-infinity).
+ *
+ * Example:
+ *   SinCosf const sc = sincos( angle );
+ *   Mat22f const rot{ sc.cos, -sc.sin, sc.sin, sc.cos };
+ */
+struct SinCosf
+{
+	float sin;
+	float cos;
+};
+
+// Sine and cosine of aAngle (radians) in one call.
+SinCosf sincos( float aAngle ) noexcept;
+
+// Sine and cosine of the aCount angles in aAngles. aSin and aCos receive
+// aCount values each; either may alias aAngles.
+void sincos_batch( float const* aAngles, std::size_t aCount, float* aSin, float* aCos ) noexcept;
+
+// Arctangent of the aCount values in aX. aOut receives aCount values and may
+// alias aX.
+void atan_batch( float const* aX, std::size_t aCount, float* aOut ) noexcept;
+
+#endif // TRIG_HPP_AF0A24C7_B3D8_4B31_B605_E6ACA73DAD50
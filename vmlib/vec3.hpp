@@ -1,10 +1,14 @@
 #ifndef VEC3_HPP_5710DADF_17EF_453C_A9C8_4A73DC66B1CD
 #define VEC3_HPP_5710DADF_17EF_453C_A9C8_4A73DC66B1CD
 
+#include <type_traits>
+
 #include <cmath>
 #include <cassert>
 #include <cstdlib>
 
+#include "precision.hpp"
+
 struct Vec3f
 {
 	float x, y, z;
@@ -127,20 +131,29 @@ float dot( Vec3f aLeft, Vec3f aRight ) noexcept
 	;
 }
 
-inline
+// length() and normalize() take an optional accuracy policy (PreciseMath or
+// FastMath); see precision.hpp.
+template< typename tMath = DefaultMath > inline
 float length( Vec3f aVec ) noexcept
 {
 	// The standard function std::sqrt() is not marked as constexpr. length()
 	// calls std::sqrt() unconditionally, so length() cannot be marked
 	// constexpr itself.
-	return std::sqrt( dot( aVec, aVec ) );
+	return tMath::sqrt( dot( aVec, aVec ) );
 }
 
-inline
+template< typename tMath = DefaultMath > inline
 Vec3f normalize( Vec3f aVec ) noexcept
 {
-	auto const l = length( aVec );
-	return aVec / l;
+	// FastMath: multiply by the reciprocal length, avoiding both the sqrt and
+	// the division.
+	if constexpr( std::is_same_v<tMath, FastMath> )
+		return aVec * FastMath::rsqrt( dot( aVec, aVec ) );
+	else
+	{
+		auto const l = length<tMath>( aVec );
+		return aVec / l;
+	}
 }
 
 constexpr Vec3f cross(const Vec3f& a, const Vec3f& b) noexcept {
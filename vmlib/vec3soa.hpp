@@ -0,0 +1,145 @@
+#ifndef VEC3SOA_HPP_46F169E0_CED5_4B44_AC31_AEE949742B13
+#define VEC3SOA_HPP_46F169E0_CED5_4B44_AC31_AEE949742B13
+
+#include <new>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+
+#include "vec3.hpp"
+
+/** AlignedAllocator: std::allocator replacement with custom alignment
+ *
+ * Allocates memory aligned to tAlign bytes, using the C++17 aligned
+ * operator new. Used for the SoA streams below, so that each stream can be
+ * loaded with aligned SIMD loads.
+ */
+template< typename tType, std::size_t tAlign >
+struct AlignedAllocator
+{
+	using value_type = tType;
+
+	template< typename tOther >
+	struct rebind { using other = AlignedAllocator<tOther, tAlign>; };
+
+	AlignedAllocator() noexcept = default;
+	template< typename tOther >
+	AlignedAllocator( AlignedAllocator<tOther, tAlign> const& ) noexcept {}
+
+	tType* allocate( std::size_t aCount )
+	{
+		return static_cast<tType*>(::operator new( aCount * sizeof(tType), std::align_val_t(tAlign) ));
+	}
+	void deallocate( tType* aPtr, std::size_t ) noexcept
+	{
+		::operator delete( aPtr, std::align_val_t(tAlign) );
+	}
+};
+
+template< typename tA, typename tB, std::size_t tAlign > constexpr
+bool operator==( AlignedAllocator<tA,tAlign> const&, AlignedAllocator<tB,tAlign> const& ) noexcept
+{
+	return true;
+}
+template< typename tA, typename tB, std::size_t tAlign > constexpr
+bool operator!=( AlignedAllocator<tA,tAlign> const&, AlignedAllocator<tB,tAlign> const& ) noexcept
+{
+	return false;
+}
+
+
+/** Vec3fSoA: array of Vec3f in structure-of-arrays layout
+ *
+ * std::vector<Vec3f> stores x0 y0 z0 x1 y1 z1 ... (array-of-structures). This
+ * is what OpenGL wants for vertex data, but it is awkward for SIMD code. The
+ * Vec3fSoA instead stores three separate streams: x0 x1 x2 ..., y0 y1 y2 ...
+ * and z0 z1 z2 .... Each stream is aligned to kAlign bytes and padded to a
+ * multiple of kBlock elements. Bulk functions can therefore process all
+ * elements (including the padding) at full SIMD width, with aligned loads and
+ * no scalar tail. The values in the padding are unspecified, since bulk
+ * functions may overwrite them.
+ *
+ * See batch.hpp for bulk operations and for conversion from/to the
+ * interleaved layout.
+ *
+ * Example:
+ *   Vec3fSoA soa = to_soa( mesh.positions.data(), mesh.positions.data() + n );
+ *   transform_points( M, soa );
+ *   from_soa( soa, mesh.positions.data() );
+ */
+class Vec3fSoA final
+{
+	public:
+		static constexpr std::size_t kBlock = 8;
+		static constexpr std::size_t kAlign = kBlock * sizeof(float);
+
+		using Stream = std::vector<float, AlignedAllocator<float, kAlign>>;
+
+	public:
+		Vec3fSoA() = default;
+
+		explicit Vec3fSoA( std::size_t aCount )
+		{
+			resize( aCount );
+		}
+
+	public:
+		std::size_t size() const noexcept { return mSize; }
+		bool empty() const noexcept { return 0 == mSize; }
+
+		// Number of elements including the padding. Always a multiple of
+		// kBlock.
+		std::size_t padded_size() const noexcept { return mX.size(); }
+
+		// Resizes the streams. New elements are zero.
+		void resize( std::size_t aCount )
+		{
+			std::size_t const padded = (aCount + kBlock - 1) / kBlock * kBlock;
+
+			// Clear the old padding; it may become part of the valid range.
+			for( std::size_t i = mSize; i < mX.size(); ++i )
+				mX[i] = mY[i] = mZ[i] = 0.f;
+
+			mX.resize( padded, 0.f );
+			mY.resize( padded, 0.f );
+			mZ.resize( padded, 0.f );
+			mSize = aCount;
+		}
+
+		void clear() noexcept
+		{
+			mX.clear();
+			mY.clear();
+			mZ.clear();
+			mSize = 0;
+		}
+
+	public:
+		float* x() noexcept { return mX.data(); }
+		float* y() noexcept { return mY.data(); }
+		float* z() noexcept { return mZ.data(); }
+
+		float const* x() const noexcept { return mX.data(); }
+		float const* y() const noexcept { return mY.data(); }
+		float const* z() const noexcept { return mZ.data(); }
+
+		Vec3f get( std::size_t aI ) const noexcept
+		{
+			assert( aI < mSize );
+			return Vec3f{ mX[aI], mY[aI], mZ[aI] };
+		}
+		void set( std::size_t aI, Vec3f aV ) noexcept
+		{
+			assert( aI < mSize );
+			mX[aI] = aV.x;
+			mY[aI] = aV.y;
+			mZ[aI] = aV.z;
+		}
+
+	private:
+		std::size_t mSize = 0;
+		Stream mX, mY, mZ;
+};
+
+#endif // VEC3SOA_HPP_46F169E0_CED5_4B44_AC31_AEE949742B13
@@ -5,7 +5,9 @@
 #include <cassert>
 #include <cstdlib>
 
-struct Vec4f
+// Vec4f is aligned to 16 bytes, such that it can be loaded directly into a
+// SSE register (see simd.hpp). This does not change its size.
+struct alignas(16) Vec4f
 {
 	float x, y, z, w;
 